@@ -0,0 +1,216 @@
+// Benchmark de E/S do cliente: caminho antigo (ifstream -> vetor -> chunk,
+// ofstream no download) x novo (mmap -> chunk, escrita direta com fallocate)
+//
+// Uso: client_io_bench [arquivo] [tamanho_MB] [chunk_KB] [repeticoes]
+// Sem arquivo, um arquivo temporário de tamanho_MB (padrão 256) é gerado.
+// O upload inclui o CRC-32 e a serialização de cada FileChunk (a cópia que
+// o gRPC faz de qualquer forma); o download grava o conteúdo das mensagens
+// recebidas. Cache de páginas quente: mede o custo de CPU do cliente.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include <zlib.h>
+#include "file_processor.pb.h"
+#include "file_io.h"
+
+namespace {
+
+struct Cost {
+    double wall_seconds = 0.0;
+    double cpu_seconds = 0.0;
+};
+
+double cpuSeconds() {
+#ifndef _WIN32
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+#else
+    return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
+template<typename Func>
+Cost measure(int repetitions, Func body) {
+    Cost best;
+    for (int i = 0; i < repetitions; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        double cpu_start = cpuSeconds();
+        body();
+        Cost cost;
+        cost.cpu_seconds = cpuSeconds() - cpu_start;
+        cost.wall_seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+        if (i == 0 || cost.cpu_seconds < best.cpu_seconds) {
+            best = cost;
+        }
+    }
+    return best;
+}
+
+void printCost(const std::string& label, const Cost& cost, size_t bytes) {
+    double megabytes = bytes / (1024.0 * 1024.0);
+    std::cout << std::left << std::setw(18) << label << std::fixed << std::setprecision(3)
+              << " wall=" << cost.wall_seconds << "s cpu=" << cost.cpu_seconds << "s"
+              << std::setprecision(0) << " (" << megabytes / std::max(cost.wall_seconds, 1e-9)
+              << " MB/s)" << std::endl;
+}
+
+void addIntegrity(file_processor::FileChunk& chunk, const char* data, size_t length,
+                  size_t offset) {
+    file_processor::ChunkIntegrity* integrity = chunk.mutable_integrity();
+    integrity->set_offset(static_cast<int64_t>(offset));
+    integrity->set_crc32(static_cast<uint32_t>(
+        crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(data),
+              static_cast<uInt>(length))));
+}
+
+// Caminho antigo do sendFile
+size_t uploadStream(const std::string& path, size_t chunk_bytes, std::string& wire) {
+    std::ifstream file(path, std::ios::binary);
+    std::vector<char> buffer;
+    file_processor::FileChunk chunk;
+    size_t offset = 0;
+    while (true) {
+        buffer.resize(chunk_bytes);
+        if (!file.read(buffer.data(), buffer.size()) && file.gcount() == 0) {
+            break;
+        }
+        size_t length = static_cast<size_t>(file.gcount());
+        chunk.set_content(buffer.data(), length);
+        addIntegrity(chunk, buffer.data(), length, offset);
+        chunk.SerializeToString(&wire);
+        offset += length;
+    }
+    return offset;
+}
+
+size_t uploadMapped(const std::string& path, size_t chunk_bytes, std::string& wire) {
+    MappedInput file;
+    if (!file.open(path)) {
+        return 0;
+    }
+    file_processor::FileChunk chunk;
+    size_t offset = 0;
+    while (offset < file.size()) {
+        size_t length = std::min(chunk_bytes, file.size() - offset);
+        const char* data = file.data() + offset;
+        chunk.mutable_content()->assign(data, length);
+        addIntegrity(chunk, data, length, offset);
+        chunk.SerializeToString(&wire);
+        offset += length;
+    }
+    return offset;
+}
+
+// Mensagens "recebidas": o conteúdo já está em FileChunk, como após o Read
+void downloadStream(const std::string& path,
+                    const std::vector<file_processor::FileChunk>& chunks) {
+    std::ofstream file(path, std::ios::binary);
+    for (const file_processor::FileChunk& chunk : chunks) {
+        file.write(chunk.content().c_str(), chunk.content().size());
+    }
+}
+
+void downloadPreallocated(const std::string& path,
+                          const std::vector<file_processor::FileChunk>& chunks,
+                          size_t size_hint) {
+    PreallocatedOutput file;
+    file.open(path, size_hint);
+    for (const file_processor::FileChunk& chunk : chunks) {
+        file.write(chunk.content().data(), chunk.content().size());
+    }
+    file.close();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string input_path = argc > 1 ? argv[1] : "";
+    size_t size_mb = argc > 2 ? static_cast<size_t>(std::max(1, std::atoi(argv[2]))) : 256;
+    size_t chunk_bytes = (argc > 3 ? static_cast<size_t>(std::max(1, std::atoi(argv[3]))) : 64)
+                         * 1024;
+    int repetitions = argc > 4 ? std::max(1, std::atoi(argv[4])) : 3;
+
+    const std::string temp_dir = std::filesystem::temp_directory_path().string();
+    bool generated = input_path.empty() || input_path == "-";
+    if (generated) {
+        input_path = temp_dir + "/client_io_bench_input.bin";
+        std::ofstream file(input_path, std::ios::binary | std::ios::trunc);
+        std::vector<char> block(1024 * 1024);
+        for (size_t i = 0; i < block.size(); ++i) {
+            block[i] = static_cast<char>((i * 2654435761u) >> 13);
+        }
+        for (size_t i = 0; i < size_mb; ++i) {
+            file.write(block.data(), block.size());
+        }
+    }
+
+    std::error_code error;
+    size_t file_size = static_cast<size_t>(std::filesystem::file_size(input_path, error));
+    if (error || file_size == 0) {
+        std::cerr << "Cannot read " << input_path << std::endl;
+        return 1;
+    }
+    std::cout << "Input: " << input_path << " (" << file_size / (1024 * 1024) << " MB), "
+              << chunk_bytes / 1024 << " KB chunks, best of " << repetitions << std::endl;
+
+    std::string wire;
+    Cost upload_stream = measure(repetitions, [&]() {
+        uploadStream(input_path, chunk_bytes, wire);
+    });
+    Cost upload_mapped = measure(repetitions, [&]() {
+        uploadMapped(input_path, chunk_bytes, wire);
+    });
+    printCost("upload/ifstream", upload_stream, file_size);
+    printCost("upload/mmap", upload_mapped, file_size);
+
+    std::vector<file_processor::FileChunk> chunks;
+    {
+        MappedInput file;
+        file.open(input_path);
+        for (size_t offset = 0; offset < file.size(); offset += chunk_bytes) {
+            chunks.emplace_back();
+            chunks.back().set_content(file.data() + offset,
+                                      std::min(chunk_bytes, file.size() - offset));
+        }
+    }
+    const std::string output_path = temp_dir + "/client_io_bench_output.bin";
+    Cost download_stream = measure(repetitions, [&]() {
+        downloadStream(output_path, chunks);
+    });
+    Cost download_prealloc = measure(repetitions, [&]() {
+        downloadPreallocated(output_path, chunks, file_size);
+    });
+    printCost("download/ofstream", download_stream, file_size);
+    printCost("download/fallocate", download_prealloc, file_size);
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "CPU saved: upload "
+              << 100.0 * (1.0 - upload_mapped.cpu_seconds /
+                                std::max(upload_stream.cpu_seconds, 1e-9))
+              << "%, download "
+              << 100.0 * (1.0 - download_prealloc.cpu_seconds /
+                                std::max(download_stream.cpu_seconds, 1e-9))
+              << "%" << std::endl;
+
+    std::filesystem::remove(output_path, error);
+    if (generated) {
+        std::filesystem::remove(input_path, error);
+    }
+    return 0;
+}
@@ -0,0 +1,506 @@
+// Gerador de carga para as quatro RPCs de arquivo
+//
+// Uso: file_processor_bench [server] [opções] [arquivos[@peso]...]
+//   --concurrency=N   requisições simultâneas (padrão 4)
+//   --duration=S      duração da medição em segundos (padrão 10)
+//   --requests=N      encerrar após N requisições (substitui --duration)
+//   --warmup=N        requisições descartadas antes da medição (padrão 0)
+//   --mix=op=peso,... operações sorteadas (compress, txt, convert, resize)
+//   --input-dir=DIR   arquivos de entrada (padrão tests/test_files)
+//   --channels=N      conexões HTTP/2 independentes (padrão 1)
+//   --timeout=S       deadline por requisição (padrão 60)
+//   --chunk-size=N    chunk fixo de N bytes (padrão: adaptativo, FP_CHUNK_*_BYTES)
+//   --buffer-hint=0   cada Write espera o transporte (sem agrupar chunks)
+//   --output=ARQUIVO  relatório JSON (padrão: stdout)
+//
+// PDFs alimentam compress/txt e imagens alimentam convert/resize; o peso
+// após '@' controla a mistura de tamanhos. O relatório traz QPS, latência
+// p50/p95/p99, bytes/s e taxa de erro, no total e por operação. Janela e
+// BDP do HTTP/2 seguem as variáveis FP_HTTP2_* (como no cliente).
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <grpcpp/grpcpp.h>
+#include "file_processor.grpc.pb.h"
+#include "transfer_tuning.h"
+
+namespace {
+
+using FileStream = grpc::ClientReaderWriter<file_processor::FileChunk,
+                                            file_processor::FileChunk>;
+using Stub = file_processor::FileProcessorService::Stub;
+
+struct Operation {
+    std::string name;
+    std::string rpc;
+    bool pdf_input;
+    std::unique_ptr<FileStream> (*start)(Stub& stub, grpc::ClientContext* context);
+};
+
+const Operation kOperations[] = {
+    {"compress", "CompressPDF", true,
+     [](Stub& stub, grpc::ClientContext* context) { return stub.CompressPDF(context); }},
+    {"txt", "ConvertToTXT", true,
+     [](Stub& stub, grpc::ClientContext* context) { return stub.ConvertToTXT(context); }},
+    {"convert", "ConvertImageFormat", false,
+     [](Stub& stub, grpc::ClientContext* context) {
+         return stub.ConvertImageFormat(context);
+     }},
+    {"resize", "ResizeImage", false,
+     [](Stub& stub, grpc::ClientContext* context) { return stub.ResizeImage(context); }},
+};
+const size_t kOperationCount = sizeof(kOperations) / sizeof(kOperations[0]);
+
+struct InputFile {
+    std::string path;
+    std::string content;
+    double weight;
+    bool pdf;
+};
+
+struct Options {
+    std::string server = "localhost:50051";
+    size_t concurrency = 4;
+    double duration_seconds = 10.0;
+    size_t max_requests = 0;
+    size_t warmup = 0;
+    size_t channels = 1;
+    int timeout_seconds = 60;
+    TransferTuning tuning = TransferTuning::fromEnvironment();
+    bool buffer_hint = true;
+    std::string input_dir = "tests/test_files";
+    std::string output_path;
+    double mix[kOperationCount] = {1.0, 1.0, 1.0, 1.0};
+    std::vector<std::pair<std::string, double>> files;
+};
+
+struct Sample {
+    size_t operation;
+    double latency_ms;
+    size_t bytes_sent;
+    size_t bytes_received;
+    grpc::StatusCode code;
+};
+
+struct Summary {
+    size_t requests = 0;
+    size_t errors = 0;
+    size_t bytes_sent = 0;
+    size_t bytes_received = 0;
+    std::vector<double> latencies;
+    std::map<std::string, size_t> status_codes;
+};
+
+const char* statusName(grpc::StatusCode code) {
+    switch (code) {
+        case grpc::StatusCode::OK: return "OK";
+        case grpc::StatusCode::CANCELLED: return "CANCELLED";
+        case grpc::StatusCode::UNKNOWN: return "UNKNOWN";
+        case grpc::StatusCode::INVALID_ARGUMENT: return "INVALID_ARGUMENT";
+        case grpc::StatusCode::DEADLINE_EXCEEDED: return "DEADLINE_EXCEEDED";
+        case grpc::StatusCode::NOT_FOUND: return "NOT_FOUND";
+        case grpc::StatusCode::RESOURCE_EXHAUSTED: return "RESOURCE_EXHAUSTED";
+        case grpc::StatusCode::FAILED_PRECONDITION: return "FAILED_PRECONDITION";
+        case grpc::StatusCode::ABORTED: return "ABORTED";
+        case grpc::StatusCode::UNIMPLEMENTED: return "UNIMPLEMENTED";
+        case grpc::StatusCode::INTERNAL: return "INTERNAL";
+        case grpc::StatusCode::UNAVAILABLE: return "UNAVAILABLE";
+        default: return "OTHER";
+    }
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [server] [--concurrency=N] [--duration=S]"
+              << " [--requests=N] [--warmup=N] [--mix=compress=1,txt=1,convert=1,resize=1]"
+              << " [--input-dir=DIR] [--channels=N] [--timeout=S] [--chunk-size=N]"
+              << " [--buffer-hint=0|1] [--output=FILE]"
+              << " [files[@weight]...]" << std::endl;
+}
+
+bool parseMix(const std::string& spec, double* mix) {
+    std::fill(mix, mix + kOperationCount, 0.0);
+    std::stringstream entries(spec);
+    std::string entry;
+    while (std::getline(entries, entry, ',')) {
+        size_t separator = entry.find('=');
+        std::string name = entry.substr(0, separator);
+        double weight = separator == std::string::npos
+            ? 1.0 : std::atof(entry.c_str() + separator + 1);
+
+        size_t index = 0;
+        while (index < kOperationCount && kOperations[index].name != name) {
+            ++index;
+        }
+        if (index == kOperationCount || weight < 0) {
+            return false;
+        }
+        mix[index] = weight;
+    }
+    return true;
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    bool server_set = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&arg](const char* prefix) -> const char* {
+            size_t length = std::char_traits<char>::length(prefix);
+            return arg.compare(0, length, prefix) == 0 ? arg.c_str() + length : nullptr;
+        };
+
+        if (const char* v = value("--concurrency=")) {
+            options.concurrency = std::max(1, std::atoi(v));
+        } else if (const char* v = value("--duration=")) {
+            options.duration_seconds = std::max(0.1, std::atof(v));
+        } else if (const char* v = value("--requests=")) {
+            options.max_requests = static_cast<size_t>(std::max(0, std::atoi(v)));
+        } else if (const char* v = value("--warmup=")) {
+            options.warmup = static_cast<size_t>(std::max(0, std::atoi(v)));
+        } else if (const char* v = value("--channels=")) {
+            options.channels = std::max(1, std::atoi(v));
+        } else if (const char* v = value("--timeout=")) {
+            options.timeout_seconds = std::max(1, std::atoi(v));
+        } else if (const char* v = value("--chunk-size=")) {
+            size_t chunk_size = static_cast<size_t>(std::max(1024, std::atoi(v)));
+            options.tuning.chunk_min_bytes = chunk_size;
+            options.tuning.chunk_max_bytes = chunk_size;
+        } else if (const char* v = value("--buffer-hint=")) {
+            options.buffer_hint = std::atoi(v) != 0;
+        } else if (const char* v = value("--input-dir=")) {
+            options.input_dir = v;
+        } else if (const char* v = value("--output=")) {
+            options.output_path = v;
+        } else if (const char* v = value("--mix=")) {
+            if (!parseMix(v, options.mix)) {
+                std::cerr << "Invalid --mix: " << v << std::endl;
+                return false;
+            }
+        } else if (arg.compare(0, 2, "--") == 0) {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        } else if (!server_set && arg.find('@') == std::string::npos &&
+                   !std::filesystem::exists(arg)) {
+            options.server = arg;
+            server_set = true;
+        } else {
+            size_t at = arg.rfind('@');
+            double weight = 1.0;
+            if (at != std::string::npos && !std::filesystem::exists(arg)) {
+                weight = std::atof(arg.c_str() + at + 1);
+                arg = arg.substr(0, at);
+            }
+            options.files.emplace_back(arg, weight);
+        }
+    }
+    return true;
+}
+
+bool isPdf(const std::string& path) {
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == ".pdf";
+}
+
+bool isImage(const std::string& path) {
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == ".jpg" || extension == ".jpeg" || extension == ".png" ||
+           extension == ".gif" || extension == ".bmp" || extension == ".tiff" ||
+           extension == ".webp";
+}
+
+bool loadInputs(const Options& options, std::vector<InputFile>& inputs) {
+    std::vector<std::pair<std::string, double>> files = options.files;
+    if (files.empty()) {
+        std::error_code error;
+        for (const auto& entry :
+             std::filesystem::directory_iterator(options.input_dir, error)) {
+            if (entry.is_regular_file()) {
+                files.emplace_back(entry.path().string(), 1.0);
+            }
+        }
+        std::sort(files.begin(), files.end());
+    }
+
+    for (const auto& file : files) {
+        if (!isPdf(file.first) && !isImage(file.first)) {
+            continue;
+        }
+        std::ifstream stream(file.first, std::ios::binary);
+        if (!stream.is_open()) {
+            std::cerr << "Cannot open input " << file.first << std::endl;
+            return false;
+        }
+        std::ostringstream content;
+        content << stream.rdbuf();
+        inputs.push_back({file.first, content.str(), file.second, isPdf(file.first)});
+    }
+    return true;
+}
+
+// Enviar o arquivo em chunks e receber a resposta inteira
+Sample runRequest(Stub& stub, size_t operation, const InputFile& input,
+                  const Options& options) {
+    Sample sample{operation, 0.0, 0, 0, grpc::StatusCode::OK};
+    auto start = std::chrono::steady_clock::now();
+
+    grpc::ClientContext context;
+    context.set_deadline(std::chrono::system_clock::now() +
+                         std::chrono::seconds(options.timeout_seconds));
+    std::unique_ptr<FileStream> stream = kOperations[operation].start(stub, &context);
+
+    // Mesmo envio do cliente: chunks adaptativos e buffer_hint exceto no último
+    AdaptiveChunkSizer sizer(options.tuning, input.content.size());
+    file_processor::FileChunk chunk;
+    size_t offset = 0;
+    while (offset < input.content.size()) {
+        size_t length = std::min(sizer.next(), input.content.size() - offset);
+        chunk.set_content(input.content.data() + offset, length);
+        grpc::WriteOptions write_options;
+        if (options.buffer_hint && offset + length < input.content.size()) {
+            write_options.set_buffer_hint();
+        }
+        auto write_start = std::chrono::steady_clock::now();
+        if (!stream->Write(chunk, write_options)) {
+            break;
+        }
+        sizer.record(length, std::chrono::steady_clock::now() - write_start);
+        offset += length;
+        sample.bytes_sent += length;
+    }
+    stream->WritesDone();
+
+    while (stream->Read(&chunk)) {
+        sample.bytes_received += chunk.content().size();
+    }
+    sample.code = stream->Finish().error_code();
+    sample.latency_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    return sample;
+}
+
+double percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+void writeSummary(std::ostream& out, Summary& summary, double elapsed_seconds,
+                  const std::string& indent) {
+    std::sort(summary.latencies.begin(), summary.latencies.end());
+    double total = 0.0;
+    for (double latency : summary.latencies) {
+        total += latency;
+    }
+
+    out << indent << "\"requests\": " << summary.requests << ",\n"
+        << indent << "\"errors\": " << summary.errors << ",\n"
+        << indent << "\"error_rate\": "
+        << (summary.requests ? static_cast<double>(summary.errors) / summary.requests : 0.0)
+        << ",\n"
+        << indent << "\"qps\": " << summary.requests / elapsed_seconds << ",\n"
+        << indent << "\"bytes_sent\": " << summary.bytes_sent << ",\n"
+        << indent << "\"bytes_received\": " << summary.bytes_received << ",\n"
+        << indent << "\"bytes_per_second\": "
+        << (summary.bytes_sent + summary.bytes_received) / elapsed_seconds << ",\n"
+        << indent << "\"latency_ms\": {"
+        << "\"mean\": " << (summary.latencies.empty() ? 0.0 : total / summary.latencies.size())
+        << ", \"p50\": " << percentile(summary.latencies, 0.50)
+        << ", \"p95\": " << percentile(summary.latencies, 0.95)
+        << ", \"p99\": " << percentile(summary.latencies, 0.99)
+        << ", \"max\": " << (summary.latencies.empty() ? 0.0 : summary.latencies.back())
+        << "},\n"
+        << indent << "\"status_codes\": {";
+    bool first = true;
+    for (const auto& entry : summary.status_codes) {
+        out << (first ? "" : ", ") << "\"" << entry.first << "\": " << entry.second;
+        first = false;
+    }
+    out << "}";
+}
+
+void accumulate(Summary& summary, const Sample& sample) {
+    ++summary.requests;
+    if (sample.code != grpc::StatusCode::OK) {
+        ++summary.errors;
+    }
+    summary.bytes_sent += sample.bytes_sent;
+    summary.bytes_received += sample.bytes_received;
+    summary.latencies.push_back(sample.latency_ms);
+    ++summary.status_codes[statusName(sample.code)];
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<InputFile> inputs;
+    if (!loadInputs(options, inputs)) {
+        return 1;
+    }
+
+    // Entradas compatíveis com cada operação; sem entrada, a operação sai da mistura
+    std::vector<size_t> candidates[kOperationCount];
+    for (size_t op = 0; op < kOperationCount; ++op) {
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            if (inputs[i].pdf == kOperations[op].pdf_input && inputs[i].weight > 0) {
+                candidates[op].push_back(i);
+            }
+        }
+        if (candidates[op].empty()) {
+            options.mix[op] = 0.0;
+        }
+    }
+    if (std::all_of(options.mix, options.mix + kOperationCount,
+                    [](double weight) { return weight <= 0.0; })) {
+        std::cerr << "No input files for the selected operations (run "
+                  << "scripts/prepare_test_files.sh or pass files)" << std::endl;
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    grpc::ChannelArguments args;
+    args.SetMaxReceiveMessageSize(100 * 1024 * 1024);
+    args.SetMaxSendMessageSize(100 * 1024 * 1024);
+    // Cada canal com a própria conexão em vez de compartilhar o subchannel
+    args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+    options.tuning.apply(args);
+
+    std::vector<std::unique_ptr<Stub>> stubs;
+    for (size_t i = 0; i < options.channels; ++i) {
+        stubs.push_back(file_processor::FileProcessorService::NewStub(
+            grpc::CreateCustomChannel(options.server, grpc::InsecureChannelCredentials(),
+                                      args)));
+    }
+
+    std::cerr << "Benchmarking " << options.server << " with " << inputs.size()
+              << " input files, concurrency " << options.concurrency << std::endl;
+
+    std::atomic<size_t> issued(0);
+    std::atomic<bool> stop(false);
+    std::vector<std::vector<Sample>> samples(options.concurrency);
+
+    // limit 0: roda até o fim de --duration; record false descarta as amostras
+    auto worker = [&](size_t index, size_t limit, bool record) {
+        std::mt19937 random(static_cast<unsigned>(index * 7919 + (record ? 17 : 3)));
+        std::discrete_distribution<size_t> pick_operation(options.mix,
+                                                          options.mix + kOperationCount);
+        std::vector<std::discrete_distribution<size_t>> pick_input;
+        for (size_t op = 0; op < kOperationCount; ++op) {
+            std::vector<double> weights;
+            for (size_t input : candidates[op]) {
+                weights.push_back(inputs[input].weight);
+            }
+            pick_input.emplace_back(weights.begin(), weights.end());
+        }
+
+        Stub& stub = *stubs[index % stubs.size()];
+        while (!stop.load()) {
+            if (limit > 0 && issued.fetch_add(1) >= limit) {
+                break;
+            }
+            size_t op = pick_operation(random);
+            const InputFile& input = inputs[candidates[op][pick_input[op](random)]];
+            Sample sample = runRequest(stub, op, input, options);
+            if (record) {
+                samples[index].push_back(sample);
+            }
+        }
+    };
+
+    auto runPhase = [&](size_t limit, bool record) {
+        issued.store(0);
+        stop.store(false);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < options.concurrency; ++i) {
+            threads.emplace_back(worker, i, limit, record);
+        }
+        if (limit == 0) {
+            std::this_thread::sleep_for(
+                std::chrono::duration<double>(options.duration_seconds));
+            stop.store(true);
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    };
+
+    // Aquecimento (conexões, pools e caches do servidor), fora da medição
+    if (options.warmup > 0) {
+        runPhase(options.warmup, false);
+    }
+
+    auto measure_start = std::chrono::steady_clock::now();
+    runPhase(options.max_requests, true);
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - measure_start).count();
+
+    Summary total;
+    Summary per_operation[kOperationCount];
+    for (const auto& thread_samples : samples) {
+        for (const Sample& sample : thread_samples) {
+            accumulate(total, sample);
+            accumulate(per_operation[sample.operation], sample);
+        }
+    }
+
+    std::ofstream file;
+    if (!options.output_path.empty()) {
+        file.open(options.output_path, std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Cannot write " << options.output_path << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = file.is_open() ? file : std::cout;
+
+    out << "{\n"
+        << "  \"server\": \"" << options.server << "\",\n"
+        << "  \"concurrency\": " << options.concurrency << ",\n"
+        << "  \"channels\": " << options.channels << ",\n"
+        << "  \"input_files\": " << inputs.size() << ",\n"
+        << "  \"chunk_bytes\": {\"min\": " << options.tuning.chunk_min_bytes
+        << ", \"max\": " << options.tuning.chunk_max_bytes << "},\n"
+        << "  \"buffer_hint\": " << (options.buffer_hint ? "true" : "false") << ",\n"
+        << "  \"http2_window_bytes\": " << options.tuning.http2_window_bytes << ",\n"
+        << "  \"elapsed_seconds\": " << elapsed << ",\n";
+    writeSummary(out, total, elapsed, "  ");
+    out << ",\n  \"operations\": {";
+    bool first = true;
+    for (size_t op = 0; op < kOperationCount; ++op) {
+        if (per_operation[op].requests == 0) {
+            continue;
+        }
+        out << (first ? "\n" : ",\n") << "    \"" << kOperations[op].rpc << "\": {\n";
+        writeSummary(out, per_operation[op], elapsed, "      ");
+        out << "\n    }";
+        first = false;
+    }
+    out << (first ? "}" : "\n  }") << "\n}\n";
+
+    if (file.is_open()) {
+        std::cerr << "Report written to " << options.output_path << std::endl;
+    }
+    return total.errors == 0 ? 0 : 2;
+}
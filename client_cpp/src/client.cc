@@ -3,11 +3,26 @@
 #include <memory>
 #include <string>
 #include <iomanip>
+#include <sstream>
 #include <chrono>
 #include <vector>
+#include <map>
+#include <thread>
+#include <filesystem>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <random>
 
 #include <grpcpp/grpcpp.h>
+#include <zlib.h>
 #include "file_processor.grpc.pb.h"
+#include "transfer_tuning.h"
+#include "file_io.h"
+#include "output_paths.h"
 
 #ifdef _WIN32
 #include <sys/stat.h>
@@ -18,12 +33,63 @@
 
 class FileProcessorClient {
 public:
-    FileProcessorClient(std::shared_ptr<grpc::Channel> channel)
-        : stub_(file_processor::FileProcessorService::NewStub(channel)) {}
+    // Arquivos a partir deste tamanho usam upload retomável
+    static constexpr size_t kResumableThreshold = 8 * 1024 * 1024;
+    // Primeira chamada de um upload retomável: o servidor gera o token
+    static constexpr const char* kNewUploadId = "new";
+    static constexpr int kMaxAttempts = 5;
+
+    FileProcessorClient(std::shared_ptr<grpc::Channel> channel,
+                        const TransferTuning& tuning = TransferTuning())
+        : stub_(file_processor::FileProcessorService::NewStub(channel)),
+          tuning_(tuning),
+          quiet_(false),
+          null_stream_(nullptr) {}
+
+    // Sem o progresso de cada arquivo no stdout (modo paralelo); o erro da
+    // última operação fica em lastError()
+    void setQuiet(bool quiet) { quiet_ = quiet; }
+    const std::string& lastError() const { return last_error_; }
+
+    // Operação do lote aplicada a um único arquivo (RPC de arquivo)
+    bool Process(file_processor::Operation operation,
+                 const std::string& input_path,
+                 const std::string& output_path,
+                 const std::string& format,
+                 int width, int height) {
+        last_error_.clear();
+        switch (operation) {
+            case file_processor::COMPRESS_PDF:
+                return CompressPDF(input_path, output_path);
+            case file_processor::CONVERT_TO_TXT:
+                return ConvertToTXT(input_path, output_path);
+            case file_processor::CONVERT_IMAGE_FORMAT:
+                return ConvertImageFormat(input_path, output_path,
+                                          format.empty() ? "png" : format);
+            case file_processor::RESIZE_IMAGE:
+                return ResizeImage(input_path, output_path, width, height);
+            default:
+                reportError("Error: Unsupported operation");
+                return false;
+        }
+    }
+
+    static std::string batchExtension(file_processor::Operation operation,
+                                      const std::string& format) {
+        switch (operation) {
+            case file_processor::COMPRESS_PDF: return ".pdf";
+            case file_processor::CONVERT_TO_TXT: return ".txt";
+            case file_processor::CONVERT_IMAGE_FORMAT:
+                return "." + (format.empty() ? std::string("png") : format);
+            default: return ".jpg";
+        }
+    }
 
     bool CompressPDF(const std::string& input_path,
                      const std::string& output_path) {
-        return processFile("CompressPDF", input_path, output_path,
+        file_processor::RequestHeader header;
+        *header.mutable_compress_pdf()->mutable_metadata() = fileMetadata(input_path);
+        return processFile("CompressPDF", input_path, output_path, header,
                           [this](grpc::ClientContext* context) {
                               return stub_->CompressPDF(context);
                           });
@@ -31,7 +97,9 @@ public:
 
     bool ConvertToTXT(const std::string& input_path,
                       const std::string& output_path) {
-        return processFile("ConvertToTXT", input_path, output_path,
+        file_processor::RequestHeader header;
+        *header.mutable_convert_to_txt()->mutable_metadata() = fileMetadata(input_path);
+        return processFile("ConvertToTXT", input_path, output_path, header,
                           [this](grpc::ClientContext* context) {
                               return stub_->ConvertToTXT(context);
                           });
@@ -40,7 +108,11 @@ public:
     bool ConvertImageFormat(const std::string& input_path,
                            const std::string& output_path,
                            const std::string& format) {
-        return processFile("ConvertImageFormat", input_path, output_path,
+        file_processor::RequestHeader header;
+        auto* request = header.mutable_convert_image_format();
+        *request->mutable_metadata() = fileMetadata(input_path);
+        request->set_output_format(format);
+        return processFile("ConvertImageFormat", input_path, output_path, header,
                           [this](grpc::ClientContext* context) {
                               return stub_->ConvertImageFormat(context);
                           });
@@ -48,119 +120,455 @@ public:
 
     bool ResizeImage(const std::string& input_path,
                     const std::string& output_path,
-                    int width, int height) {
-        return processFile("ResizeImage", input_path, output_path,
+                    int width, int height,
+                    bool maintain_aspect_ratio = false) {
+        file_processor::RequestHeader header;
+        auto* request = header.mutable_resize_image();
+        *request->mutable_metadata() = fileMetadata(input_path);
+        request->set_width(width);
+        request->set_height(height);
+        request->set_maintain_aspect_ratio(maintain_aspect_ratio);
+        return processFile("ResizeImage", input_path, output_path, header,
                           [this](grpc::ClientContext* context) {
                               return stub_->ResizeImage(context);
                           });
     }
 
+    // Processar vários arquivos em um único stream; os resultados chegam
+    // na ordem em que ficam prontos e são gravados em output_dir
+    bool ProcessBatch(const std::vector<std::string>& input_paths,
+                      const std::string& output_dir,
+                      file_processor::Operation operation,
+                      const std::string& format,
+                      int width, int height) {
+        std::cout << "\n┌─────────────────────────────────────┐\n";
+        std::cout << "│ " << std::setw(35) << std::left
+                  << "ProcessBatch" << "│\n";
+        std::cout << "└─────────────────────────────────────┘\n\n";
+
+        std::error_code error;
+        std::filesystem::create_directories(output_dir, error);
+
+        // Caminho de saída de cada arquivo, indexado pelo file_id
+        std::map<uint64_t, std::string> output_paths;
+        std::vector<std::string> paths = batchOutputPaths(input_paths, output_dir,
+                                                          batchExtension(operation, format));
+        for (size_t i = 0; i < paths.size(); ++i) {
+            output_paths[i + 1] = paths[i];
+        }
+
+        std::cout << "📦 Files: " << input_paths.size() << std::endl;
+        auto start = std::chrono::high_resolution_clock::now();
+
+        // gzip na chamada; arquivos que não compensam vão sem compressão
+        std::vector<bool> compress_files;
+        for (const std::string& path : input_paths) {
+            compress_files.push_back(tuning_.compressUpload(path));
+        }
+
+        grpc::ClientContext context;
+        tuning_.prepareCall(context);
+        if (std::find(compress_files.begin(), compress_files.end(), true) !=
+            compress_files.end()) {
+            context.set_compression_algorithm(GRPC_COMPRESS_GZIP);
+        }
+        auto stream = stub_->ProcessBatch(&context);
+        if (!stream) {
+            std::cerr << "❌ Error: Failed to create stream" << std::endl;
+            return false;
+        }
+
+        // Envio em paralelo à recepção: o servidor pausa a leitura quando
+        // há muitos resultados pendentes
+        std::thread sender([&]() {
+            for (size_t i = 0; i < input_paths.size(); ++i) {
+                if (!sendBatchFile(stream.get(), i + 1, input_paths[i],
+                                   operation, format, width, height,
+                                   compress_files[i])) {
+                    std::cerr << "❌ Error: Failed to send " << input_paths[i]
+                              << std::endl;
+                    break;
+                }
+            }
+            stream->WritesDone();
+        });
+
+        std::map<uint64_t, PreallocatedOutput> outputs;
+        size_t succeeded = 0;
+        size_t failed = 0;
+        file_processor::BatchResponse response;
+        while (stream->Read(&response)) {
+            auto path = output_paths.find(response.file_id());
+            if (path == output_paths.end()) {
+                continue;
+            }
+
+            if (!response.content().empty()) {
+                PreallocatedOutput& file = outputs[response.file_id()];
+                if (!file.isOpen()) {
+                    file.open(path->second,
+                              getFileSize(input_paths[response.file_id() - 1]));
+                }
+                file.write(response.content().data(), response.content().size());
+            }
+
+            if (response.end_of_file()) {
+                outputs.erase(response.file_id());
+                if (response.status_code() == 0) {
+                    ++succeeded;
+                    std::cout << "✅ " << input_paths[response.file_id() - 1]
+                              << " -> " << path->second << std::endl;
+                } else {
+                    ++failed;
+                    std::cout << "❌ " << input_paths[response.file_id() - 1]
+                              << ": " << response.status_message() << std::endl;
+                }
+            }
+        }
+
+        sender.join();
+        grpc::Status status = stream->Finish();
+
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::high_resolution_clock::now() - start);
+        std::cout << "\n⏱️  Total time: " << duration.count() << "ms ("
+                  << succeeded << " succeeded, " << failed << " failed)" << std::endl;
+
+        if (!status.ok()) {
+            std::cerr << "❌ RPC failed: " << status.error_message() << std::endl;
+            std::chrono::milliseconds retry_after = retryAfter(context);
+            if (retry_after.count() > 0) {
+                std::cerr << "⏳ Server busy, retry after " << retry_after.count() << "ms"
+                          << std::endl;
+            }
+            return false;
+        }
+        printResponseCompression(context);
+        return failed == 0 && succeeded == input_paths.size();
+    }
+
 private:
+    bool sendBatchFile(grpc::ClientReaderWriter<file_processor::BatchRequest,
+                                                file_processor::BatchResponse>* stream,
+                       uint64_t file_id,
+                       const std::string& file_path,
+                       file_processor::Operation operation,
+                       const std::string& format,
+                       int width, int height, bool compress) {
+        MappedInput file;
+        bool readable = file.open(file_path);
+
+        // Cabeçalho na primeira mensagem do arquivo
+        file_processor::BatchRequest request;
+        request.set_file_id(file_id);
+        file_processor::BatchFileHeader* header = request.mutable_header();
+        header->set_operation(operation);
+        header->set_file_name(std::filesystem::path(file_path).filename().string());
+        header->set_output_format(format);
+        header->set_width(width);
+        header->set_height(height);
+
+        // Arquivo ilegível segue só com o cabeçalho e o fim, e o servidor
+        // reporta o erro pelo id. Os chunks podem ser agrupados pelo
+        // transporte: a mensagem de fim de arquivo esvazia o buffer
+        size_t file_size = readable ? file.size() : 0;
+        AdaptiveChunkSizer sizer(tuning_, file_size);
+        for (size_t offset = 0; offset < file_size;) {
+            size_t length = std::min(sizer.next(), file_size - offset);
+            request.mutable_content()->assign(file.data() + offset, length);
+            grpc::WriteOptions options;
+            options.set_buffer_hint();
+            if (!compress) {
+                options.set_no_compression();
+            }
+            auto started = std::chrono::steady_clock::now();
+            if (!stream->Write(request, options)) {
+                return false;
+            }
+            sizer.record(length, std::chrono::steady_clock::now() - started);
+            request.clear_header();
+            offset += length;
+        }
+
+        request.clear_content();
+        request.set_end_of_file(true);
+        return stream->Write(request);
+    }
+
+    std::ostream& out() { return quiet_ ? null_stream_ : std::cout; }
+
+    void reportError(const std::string& message) {
+        last_error_ = message;
+        if (!quiet_) {
+            std::cerr << "❌ " << message << std::endl;
+        }
+    }
+
     template<typename Func>
     bool processFile(const std::string& operation,
                     const std::string& input_path,
                     const std::string& output_path,
+                    const file_processor::RequestHeader& header,
                     Func rpc_call) {
         
-        std::cout << "\n┌─────────────────────────────────────┐\n";
-        std::cout << "│ " << std::setw(35) << std::left 
+        out() << "\n┌─────────────────────────────────────┐\n";
+        out() << "│ " << std::setw(35) << std::left 
                   << operation << "│\n";
-        std::cout << "└─────────────────────────────────────┘\n\n";
+        out() << "└─────────────────────────────────────┘\n\n";
         
         // Verificar arquivo de entrada
         if (!fileExists(input_path)) {
-            std::cerr << "❌ Error: Input file not found: " 
-                     << input_path << std::endl;
+            reportError("Error: Input file not found: " + input_path);
             return false;
         }
         
         auto file_size = getFileSize(input_path);
-        std::cout << "📄 Input file: " << input_path << std::endl;
-        std::cout << "📊 File size: " << formatFileSize(file_size) << std::endl;
-        
-        grpc::ClientContext context;
-        auto stream = rpc_call(&context);
-        
-        if (!stream) {
-            std::cerr << "❌ Error: Failed to create stream" << std::endl;
-            return false;
+        out() << "📄 Input file: " << input_path << std::endl;
+        out() << "📊 File size: " << formatFileSize(file_size) << std::endl;
+        
+        // Arquivos grandes usam upload retomável: se a conexão cair, a
+        // próxima tentativa continua do offset confirmado pelo servidor,
+        // com o token que ele devolveu no primeiro UploadStatus
+        file_processor::RequestHeader request_header = header;
+        if (file_size >= kResumableThreshold) {
+            request_header.set_upload_id(kNewUploadId);
         }
-        
-        // Enviar arquivo
-        std::cout << "⬆️  Uploading file..." << std::endl;
-        auto start_upload = std::chrono::high_resolution_clock::now();
-        
-        if (!sendFile(stream.get(), input_path)) {
-            std::cerr << "❌ Error: Failed to send file" << std::endl;
-            return false;
-        }
-        
-        stream->WritesDone();
-        
-        auto end_upload = std::chrono::high_resolution_clock::now();
-        auto upload_duration = std::chrono::duration_cast<
-            std::chrono::milliseconds>(end_upload - start_upload);
-        
-        std::cout << "✅ Upload completed in " << upload_duration.count() 
-                  << "ms" << std::endl;
-        
-        // Receber arquivo
-        std::cout << "⬇️  Downloading result..." << std::endl;
-        auto start_download = std::chrono::high_resolution_clock::now();
-        
-        if (!receiveFile(stream.get(), output_path)) {
-            std::cerr << "❌ Error: Failed to receive file" << std::endl;
-            return false;
+
+        // Entradas compressíveis (texto, BMP...) sobem com gzip
+        bool compress_upload = tuning_.compressUpload(input_path);
+        if (compress_upload) {
+            out() << "🗜️  Compressing upload (gzip)" << std::endl;
         }
-        
-        auto end_download = std::chrono::high_resolution_clock::now();
-        auto download_duration = std::chrono::duration_cast<
-            std::chrono::milliseconds>(end_download - start_download);
-        
-        grpc::Status status = stream->Finish();
-        
-        if (!status.ok()) {
-            std::cerr << "❌ RPC failed: " << status.error_message() << std::endl;
-            return false;
+
+        std::chrono::milliseconds upload_duration(0);
+        std::chrono::milliseconds download_duration(0);
+        for (int attempt = 1; ; ++attempt) {
+            grpc::ClientContext context;
+            tuning_.prepareCall(context);
+            if (compress_upload) {
+                context.set_compression_algorithm(GRPC_COMPRESS_GZIP);
+            }
+            auto stream = rpc_call(&context);
+
+            if (!stream) {
+                reportError("Error: Failed to create stream");
+                return false;
+            }
+
+            // Enviar arquivo
+            out() << "⬆️  Uploading file..." << std::endl;
+            auto start_upload = std::chrono::high_resolution_clock::now();
+            bool sent = sendFile(stream.get(), input_path, request_header);
+            stream->WritesDone();
+            upload_duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::high_resolution_clock::now() - start_upload);
+
+            // Receber arquivo
+            bool received = false;
+            auto start_download = std::chrono::high_resolution_clock::now();
+            if (sent) {
+                out() << "✅ Upload completed in " << upload_duration.count()
+                          << "ms" << std::endl;
+                out() << "⬇️  Downloading result..." << std::endl;
+                received = receiveFile(stream.get(), output_path, file_size);
+            }
+            download_duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::high_resolution_clock::now() - start_download);
+
+            grpc::Status status = stream->Finish();
+            if (status.ok() && received) {
+                printResponseCompression(context);
+                break;
+            }
+
+            // Servidor sobrecarregado: recusa antes do upload, com a espera
+            // sugerida no trailing metadata
+            std::chrono::milliseconds retry_after = retryAfter(context);
+            if (status.error_code() == grpc::StatusCode::RESOURCE_EXHAUSTED &&
+                retry_after.count() > 0 && attempt < kMaxAttempts) {
+                out() << "⏳ Server busy (" << status.error_message()
+                          << "), retrying in " << retry_after.count() << "ms (attempt "
+                          << attempt + 1 << "/" << kMaxAttempts << ")..." << std::endl;
+                std::this_thread::sleep_for(retry_after);
+                continue;
+            }
+
+            // Servidor sem suporte: repetir como upload simples
+            if (status.error_code() == grpc::StatusCode::UNIMPLEMENTED &&
+                !request_header.upload_id().empty()) {
+                out() << "ℹ️  Resumable uploads unavailable, sending the whole file"
+                          << std::endl;
+                request_header.clear_upload_id();
+                continue;
+            }
+
+            if (request_header.upload_id().empty() || attempt >= kMaxAttempts ||
+                !isRetryable(status)) {
+                if (!status.ok()) {
+                    reportError("RPC failed: " + status.error_message());
+                } else {
+                    reportError(std::string("Error: Failed to ") +
+                                (sent ? "receive" : "send") + " file");
+                }
+                return false;
+            }
+
+            out() << "🔁 Transfer interrupted (" << status.error_message()
+                      << "), resuming (attempt " << attempt + 1 << "/"
+                      << kMaxAttempts << ")..." << std::endl;
+            std::this_thread::sleep_for(std::chrono::milliseconds(500 * attempt));
         }
         
         auto output_size = getFileSize(output_path);
         
-        std::cout << "✅ Download completed in " << download_duration.count() 
+        out() << "✅ Download completed in " << download_duration.count() 
                   << "ms" << std::endl;
-        std::cout << "💾 Output file: " << output_path << std::endl;
-        std::cout << "📊 Output size: " << formatFileSize(output_size) << std::endl;
+        out() << "💾 Output file: " << output_path << std::endl;
+        out() << "📊 Output size: " << formatFileSize(output_size) << std::endl;
         
         auto total_duration = upload_duration + download_duration;
-        std::cout << "\n⏱️  Total time: " << total_duration.count() 
+        out() << "\n⏱️  Total time: " << total_duration.count() 
                   << "ms" << std::endl;
-        std::cout << "✅ Operation completed successfully!\n" << std::endl;
+        out() << "✅ Operation completed successfully!\n" << std::endl;
         
         return true;
     }
 
+    // Espera sugerida pelo servidor ao recusar uma requisição
+    // ("fp-retry-after-ms"), com até 20% a mais para espalhar as tentativas;
+    // zero se ausente
+    static std::chrono::milliseconds retryAfter(const grpc::ClientContext& context) {
+        const auto& trailers = context.GetServerTrailingMetadata();
+        auto entry = trailers.find("fp-retry-after-ms");
+        if (entry == trailers.end()) {
+            return std::chrono::milliseconds(0);
+        }
+        long long milliseconds = std::strtoll(
+            std::string(entry->second.data(), entry->second.size()).c_str(), nullptr, 10);
+        if (milliseconds <= 0) {
+            return std::chrono::milliseconds(0);
+        }
+        static thread_local std::mt19937 generator(std::random_device{}());
+        std::uniform_int_distribution<long long> jitter(0, milliseconds / 5);
+        return std::chrono::milliseconds(milliseconds + jitter(generator));
+    }
+
+    // Resumo da compressão das respostas enviado pelo servidor no trailing
+    // metadata "fp-compression" (compressed=N;estimated=M;uncompressed=K)
+    void printResponseCompression(const grpc::ClientContext& context) {
+        const auto& trailers = context.GetServerTrailingMetadata();
+        auto entry = trailers.find("fp-compression");
+        if (entry == trailers.end()) {
+            return;
+        }
+
+        std::map<std::string, size_t> values;
+        std::istringstream fields(std::string(entry->second.data(), entry->second.size()));
+        std::string field;
+        while (std::getline(fields, field, ';')) {
+            size_t separator = field.find('=');
+            if (separator != std::string::npos) {
+                values[field.substr(0, separator)] =
+                    std::strtoull(field.c_str() + separator + 1, nullptr, 10);
+            }
+        }
+
+        size_t compressed = values["compressed"];
+        if (compressed == 0) {
+            out() << "🗜️  Response sent uncompressed" << std::endl;
+            return;
+        }
+        size_t estimated = values["estimated"];
+        out() << "🗜️  Response compression: " << formatFileSize(compressed)
+                  << " -> ~" << formatFileSize(estimated) << " ("
+                  << std::fixed << std::setprecision(1)
+                  << 100.0 * (1.0 - static_cast<double>(estimated) / compressed)
+                  << "% saved)" << std::endl;
+    }
+
+    // Falhas de transporte e chunks rejeitados podem ser retomados
+    static bool isRetryable(const grpc::Status& status) {
+        switch (status.error_code()) {
+            case grpc::StatusCode::UNAVAILABLE:
+            case grpc::StatusCode::ABORTED:
+            case grpc::StatusCode::DATA_LOSS:
+            case grpc::StatusCode::DEADLINE_EXCEEDED:
+            case grpc::StatusCode::CANCELLED:
+            case grpc::StatusCode::UNKNOWN:
+                return true;
+            default:
+                return false;
+        }
+    }
+
     bool sendFile(grpc::ClientReaderWriter<file_processor::FileChunk,
                                            file_processor::FileChunk>* stream,
-                 const std::string& file_path) {
+                 const std::string& file_path,
+                 file_processor::RequestHeader& header) {
         
-        std::ifstream file(file_path, std::ios::binary);
-        if (!file) {
+        MappedInput file;
+        if (!file.open(file_path)) {
             return false;
         }
+
+        // Cabeçalho com metadados e parâmetros na primeira mensagem
+        file_processor::FileChunk header_chunk;
+        *header_chunk.mutable_header() = header;
+        if (!stream->Write(header_chunk)) {
+            return false;
+        }
+
+        // Upload retomável: o servidor informa quantos bytes já tem
+        size_t offset = 0;
+        if (!header.upload_id().empty()) {
+            file_processor::FileChunk status;
+            if (!stream->Read(&status) || !status.has_upload_status()) {
+                return false;
+            }
+            offset = static_cast<size_t>(status.upload_status().committed_offset());
+            // Token do upload para as próximas tentativas
+            if (!status.upload_status().upload_id().empty()) {
+                header.set_upload_id(status.upload_status().upload_id());
+            }
+            if (offset > 0) {
+                out() << "↪️  Resuming upload at " << formatFileSize(offset)
+                      << std::endl;
+            }
+        }
         
-        const size_t chunk_size = 64 * 1024; // 64KB
-        std::vector<char> buffer(chunk_size);
-        size_t total_sent = 0;
+        // Chunks ajustados à vazão; todos menos o último vão com
+        // buffer_hint, e o Write retorna com até FP_HTTP2_WRITE_BUFFER_BYTES
+        // ainda pendentes no transporte (mais de um chunk em trânsito)
+        // A mensagem é reaproveitada: cada chunk é copiado direto do
+        // mapeamento para a capacidade já alocada de content
+        size_t file_size = file.size();
+        AdaptiveChunkSizer sizer(tuning_, file_size);
+        file_processor::FileChunk chunk;
         
-        while (file.read(buffer.data(), chunk_size) || file.gcount() > 0) {
-            file_processor::FileChunk chunk;
-            chunk.set_content(buffer.data(), file.gcount());
+        while (offset < file_size) {
+            size_t length = std::min(sizer.next(), file_size - offset);
+            const char* data = file.data() + offset;
+            chunk.mutable_content()->assign(data, length);
+
+            // Offset e CRC-32 permitem ao servidor rejeitar chunks corrompidos
+            file_processor::ChunkIntegrity* integrity = chunk.mutable_integrity();
+            integrity->set_offset(static_cast<int64_t>(offset));
+            integrity->set_crc32(static_cast<uint32_t>(
+                crc32(crc32(0L, Z_NULL, 0),
+                      reinterpret_cast<const Bytef*>(data),
+                      static_cast<uInt>(length))));
             
-            if (!stream->Write(chunk)) {
+            grpc::WriteOptions options;
+            if (offset + length < file_size) {
+                options.set_buffer_hint();
+            }
+            auto started = std::chrono::steady_clock::now();
+            if (!stream->Write(chunk, options)) {
                 return false;
             }
+            sizer.record(length, std::chrono::steady_clock::now() - started);
             
-            total_sent += file.gcount();
+            offset += length;
         }
         
         return true;
@@ -168,26 +576,32 @@ private:
 
     bool receiveFile(grpc::ClientReaderWriter<file_processor::FileChunk,
                                               file_processor::FileChunk>* stream,
-                    const std::string& file_path) {
+                    const std::string& file_path,
+                    size_t size_hint) {
         
-        std::ofstream file(file_path, std::ios::binary);
-        if (!file) {
+        // Escrita direta do conteúdo de cada mensagem, com espaço reservado
+        // à frente (o tamanho da entrada é a primeira estimativa)
+        PreallocatedOutput file;
+        if (!file.open(file_path, size_hint)) {
             return false;
         }
         
         file_processor::FileChunk chunk;
-        size_t total_received = 0;
         
         while (stream->Read(&chunk)) {
-            file.write(chunk.content().c_str(), chunk.content().size());
-            total_received += chunk.content().size();
-            
-            if (!file.good()) {
+            if (!file.write(chunk.content().data(), chunk.content().size())) {
                 return false;
             }
         }
         
-        return true;
+        return file.close();
+    }
+
+    file_processor::FileMetadata fileMetadata(const std::string& path) {
+        file_processor::FileMetadata metadata;
+        metadata.set_file_name(std::filesystem::path(path).filename().string());
+        metadata.set_file_size(static_cast<int64_t>(getFileSize(path)));
+        return metadata;
     }
 
     bool fileExists(const std::string& path) {
@@ -220,6 +634,11 @@ private:
     }
 
     std::unique_ptr<file_processor::FileProcessorService::Stub> stub_;
+    TransferTuning tuning_;
+    bool quiet_;
+    std::string last_error_;
+    // Descarta a saída no modo silencioso (sem streambuf)
+    std::ostream null_stream_;
 };
 
 void printMenu() {
@@ -235,23 +654,282 @@ void printMenu() {
     std::cout << "\nChoose an option: ";
 }
 
+void printBatchUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [server] --batch <compress|txt|convert|resize>"
+              << " <output_dir> <files...> [--format=png] [--size=800x600]" << std::endl;
+}
+
+void printParallelUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [server] --parallel <compress|txt|convert|resize>"
+              << " <output_dir> <files|dirs|@manifest...> [--in-flight=4] [--channels=1]"
+              << " [--format=png] [--size=800x600]" << std::endl;
+}
+
+bool parseOperation(const std::string& name, file_processor::Operation& operation) {
+    const std::map<std::string, file_processor::Operation> operations = {
+        {"compress", file_processor::COMPRESS_PDF},
+        {"txt", file_processor::CONVERT_TO_TXT},
+        {"convert", file_processor::CONVERT_IMAGE_FORMAT},
+        {"resize", file_processor::RESIZE_IMAGE},
+    };
+    auto entry = operations.find(name);
+    if (entry == operations.end()) {
+        return false;
+    }
+    operation = entry->second;
+    return true;
+}
+
+// Arquivos de entrada: caminhos, diretórios (arquivos regulares, em ordem)
+// e manifestos "@lista.txt" com um caminho por linha ('#' comenta)
+bool collectInputs(const std::string& source, std::vector<std::string>& inputs) {
+    std::error_code error;
+    if (!source.empty() && source[0] == '@') {
+        std::ifstream manifest(source.substr(1));
+        if (!manifest) {
+            std::cerr << "❌ Error: Cannot read manifest " << source.substr(1) << std::endl;
+            return false;
+        }
+        std::string line;
+        while (std::getline(manifest, line)) {
+            line.erase(line.find_last_not_of(" \t\r") + 1);
+            if (!line.empty() && line[0] != '#') {
+                inputs.push_back(line);
+            }
+        }
+        return true;
+    }
+
+    if (std::filesystem::is_directory(source, error)) {
+        std::vector<std::string> files;
+        for (const auto& entry : std::filesystem::directory_iterator(source, error)) {
+            if (entry.is_regular_file(error)) {
+                files.push_back(entry.path().string());
+            }
+        }
+        std::sort(files.begin(), files.end());
+        inputs.insert(inputs.end(), files.begin(), files.end());
+        return true;
+    }
+
+    inputs.push_back(source);
+    return true;
+}
+
+// Modo lote: file_processor_client [server] --batch <operação> <saída> <arquivos...>
+int runBatch(FileProcessorClient& client, const std::vector<std::string>& args,
+             const char* program) {
+    if (args.size() < 3) {
+        printBatchUsage(program);
+        return 1;
+    }
+
+    file_processor::Operation operation;
+    if (!parseOperation(args[0], operation)) {
+        printBatchUsage(program);
+        return 1;
+    }
+
+    std::string format;
+    int width = 0;
+    int height = 0;
+    std::vector<std::string> inputs;
+    for (size_t i = 2; i < args.size(); ++i) {
+        if (args[i].rfind("--format=", 0) == 0) {
+            format = args[i].substr(9);
+        } else if (args[i].rfind("--size=", 0) == 0) {
+            if (std::sscanf(args[i].c_str() + 7, "%dx%d", &width, &height) != 2) {
+                printBatchUsage(program);
+                return 1;
+            }
+        } else {
+            inputs.push_back(args[i]);
+        }
+    }
+    if (inputs.empty()) {
+        printBatchUsage(program);
+        return 1;
+    }
+
+    return client.ProcessBatch(inputs, args[1], operation, format,
+                               width, height) ? 0 : 1;
+}
+
+// Modo paralelo: file_processor_client [server] --parallel <operação> <saída>
+// <arquivos|diretórios|@manifesto...>. Cada arquivo é uma RPC própria (com
+// retomada e novas tentativas); até --in-flight chamadas simultâneas
+// distribuídas por --channels conexões HTTP/2, de modo que o upload de um
+// arquivo se sobrepõe ao processamento e ao download dos anteriores
+int runParallel(const std::string& server_address, const grpc::ChannelArguments& channel_args,
+                const TransferTuning& tuning, const std::vector<std::string>& args,
+                const char* program) {
+    if (args.size() < 3) {
+        printParallelUsage(program);
+        return 1;
+    }
+
+    file_processor::Operation operation;
+    if (!parseOperation(args[0], operation)) {
+        printParallelUsage(program);
+        return 1;
+    }
+
+    std::string format;
+    int width = 0;
+    int height = 0;
+    size_t in_flight = 4;
+    size_t channel_count = 1;
+    std::vector<std::string> inputs;
+    for (size_t i = 2; i < args.size(); ++i) {
+        if (args[i].rfind("--format=", 0) == 0) {
+            format = args[i].substr(9);
+        } else if (args[i].rfind("--size=", 0) == 0) {
+            if (std::sscanf(args[i].c_str() + 7, "%dx%d", &width, &height) != 2) {
+                printParallelUsage(program);
+                return 1;
+            }
+        } else if (args[i].rfind("--in-flight=", 0) == 0) {
+            in_flight = static_cast<size_t>(std::max(1, std::atoi(args[i].c_str() + 12)));
+        } else if (args[i].rfind("--channels=", 0) == 0) {
+            channel_count = static_cast<size_t>(std::max(1, std::atoi(args[i].c_str() + 11)));
+        } else if (!collectInputs(args[i], inputs)) {
+            return 1;
+        }
+    }
+    if (inputs.empty()) {
+        printParallelUsage(program);
+        return 1;
+    }
+
+    const std::string& output_dir = args[1];
+    std::error_code error;
+    std::filesystem::create_directories(output_dir, error);
+
+    // Com mais de um canal, cada um abre a própria conexão em vez de
+    // compartilhar o subchannel global
+    grpc::ChannelArguments arguments = channel_args;
+    if (channel_count > 1) {
+        arguments.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+    }
+    std::vector<std::shared_ptr<grpc::Channel>> channels;
+    for (size_t i = 0; i < channel_count; ++i) {
+        channels.push_back(grpc::CreateCustomChannel(
+            server_address, grpc::InsecureChannelCredentials(), arguments));
+    }
+
+    in_flight = std::min(in_flight, inputs.size());
+    std::cout << "📦 Files: " << inputs.size() << ", " << in_flight << " in flight over "
+              << channel_count << " channel(s)" << std::endl;
+
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> succeeded(0);
+    std::atomic<size_t> bytes_in(0);
+    std::atomic<size_t> bytes_out(0);
+    std::mutex print_mutex;
+    std::vector<double> latencies(inputs.size(), 0.0);
+    const std::vector<std::string> outputs = batchOutputPaths(
+        inputs, output_dir, FileProcessorClient::batchExtension(operation, format));
+    auto start = std::chrono::steady_clock::now();
+
+    // Um stub por worker (o cliente guarda o erro da última operação),
+    // sobre os canais compartilhados
+    auto worker = [&](size_t index) {
+        FileProcessorClient client(channels[index % channels.size()], tuning);
+        client.setQuiet(true);
+        for (size_t i = next.fetch_add(1); i < inputs.size(); i = next.fetch_add(1)) {
+            const std::string& input = inputs[i];
+            const std::string& output = outputs[i];
+
+            auto file_start = std::chrono::steady_clock::now();
+            bool ok = client.Process(operation, input, output, format, width, height);
+            latencies[i] = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - file_start).count();
+
+            std::error_code size_error;
+            size_t input_size = ok ? std::filesystem::file_size(input, size_error) : 0;
+            size_t output_size = ok ? std::filesystem::file_size(output, size_error) : 0;
+            if (ok) {
+                succeeded.fetch_add(1);
+                bytes_in.fetch_add(input_size);
+                bytes_out.fetch_add(output_size);
+            }
+
+            std::lock_guard<std::mutex> lock(print_mutex);
+            if (ok) {
+                std::cout << "✅ " << input << " -> " << output << " ("
+                          << static_cast<long long>(latencies[i]) << "ms)" << std::endl;
+            } else {
+                std::cout << "❌ " << input << ": " << client.lastError() << std::endl;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < in_flight; ++i) {
+        workers.emplace_back(worker, i);
+    }
+    for (std::thread& thread : workers) {
+        thread.join();
+    }
+
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    std::sort(latencies.begin(), latencies.end());
+    double p50 = latencies[latencies.size() / 2];
+    double p95 = latencies[std::min(latencies.size() - 1, latencies.size() * 95 / 100)];
+    size_t failed = inputs.size() - succeeded.load();
+
+    std::cout << "\n⏱️  Total time: " << static_cast<long long>(seconds * 1000) << "ms ("
+              << succeeded.load() << " succeeded, " << failed << " failed)" << std::endl;
+    std::cout << std::fixed << std::setprecision(2)
+              << "🚀 Throughput: " << inputs.size() / std::max(seconds, 1e-9) << " files/s, "
+              << bytes_in.load() / (1024.0 * 1024.0) / std::max(seconds, 1e-9) << " MB/s in, "
+              << bytes_out.load() / (1024.0 * 1024.0) / std::max(seconds, 1e-9) << " MB/s out"
+              << std::endl;
+    std::cout << std::setprecision(0) << "📈 Latency per file: p50 " << p50 << "ms, p95 "
+              << p95 << "ms" << std::endl;
+    return failed == 0 ? 0 : 1;
+}
+
 int main(int argc, char** argv) {
     std::string server_address = "localhost:50051";
-    
-    if (argc > 1) {
-        server_address = argv[1];
+    std::vector<std::string> batch_args;
+    bool batch_mode = false;
+    bool parallel_mode = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (batch_mode || parallel_mode) {
+            batch_args.push_back(arg);
+        } else if (arg == "--batch") {
+            batch_mode = true;
+        } else if (arg == "--parallel") {
+            parallel_mode = true;
+        } else {
+            server_address = arg;
+        }
     }
     
     grpc::ChannelArguments args;
     args.SetMaxReceiveMessageSize(100 * 1024 * 1024);
     args.SetMaxSendMessageSize(100 * 1024 * 1024);
+    TransferTuning tuning = TransferTuning::fromEnvironment();
+    tuning.apply(args);
+
+    if (parallel_mode) {
+        return runParallel(server_address, args, tuning, batch_args, argv[0]);
+    }
     
     auto channel = grpc::CreateCustomChannel(
         server_address, 
         grpc::InsecureChannelCredentials(),
         args);
     
-    FileProcessorClient client(channel);
+    FileProcessorClient client(channel, tuning);
+
+    if (batch_mode) {
+        return runBatch(client, batch_args, argv[0]);
+    }
     
     while (true) {
         printMenu();
@@ -0,0 +1,208 @@
+#ifndef FILE_IO_H
+#define FILE_IO_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+// Entrada do upload mapeada em memória: os chunks são copiados direto das
+// páginas do arquivo para a mensagem reaproveitada (sem ifstream nem buffer
+// intermediário). Sem mmap (Windows, arquivo especial), o conteúdo é lido
+// inteiro para a memória.
+class MappedInput {
+public:
+    MappedInput() : data_(nullptr), size_(0), mapped_(false) {}
+    ~MappedInput() { close(); }
+
+    MappedInput(const MappedInput&) = delete;
+    MappedInput& operator=(const MappedInput&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+            size_ = static_cast<size_t>(info.st_size);
+            // Arquivo vazio não pode ser mapeado (e não tem o que enviar)
+            void* data = size_ > 0 ? mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0)
+                                   : nullptr;
+            if (data != MAP_FAILED) {
+                ::close(fd);
+                data_ = static_cast<const char*>(data);
+                mapped_ = data_ != nullptr;
+                // Leitura sequencial: o kernel antecipa as próximas páginas
+                if (mapped_) {
+                    madvise(const_cast<char*>(data_), size_, MADV_SEQUENTIAL);
+                }
+                return true;
+            }
+        }
+        ::close(fd);
+#endif
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            return false;
+        }
+        fallback_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        data_ = fallback_.data();
+        size_ = fallback_.size();
+        return true;
+    }
+
+    void close() {
+#ifndef _WIN32
+        if (mapped_) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+#endif
+        data_ = nullptr;
+        size_ = 0;
+        mapped_ = false;
+        std::vector<char>().swap(fallback_);
+    }
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool mapped() const { return mapped_; }
+
+private:
+    const char* data_;
+    size_t size_;
+    bool mapped_;
+    std::vector<char> fallback_;
+};
+
+// Saída do download escrita direto no descritor (sem o buffer do ofstream),
+// com espaço reservado à frente via fallocate: menos fragmentação e menos
+// atualizações de metadados do sistema de arquivos. A reserva não altera o
+// tamanho do arquivo e o excedente é liberado em close().
+class PreallocatedOutput {
+public:
+    // Reserva mínima e máxima por extensão (dobra a cada vez que é alcançada)
+    static constexpr size_t kMinReserveBytes = 1024 * 1024;
+    static constexpr size_t kMaxReserveBytes = 256 * 1024 * 1024;
+
+    PreallocatedOutput() : fd_(-1), written_(0), reserved_(0), next_reserve_(0) {}
+    ~PreallocatedOutput() { close(); }
+
+    PreallocatedOutput(const PreallocatedOutput&) = delete;
+    PreallocatedOutput& operator=(const PreallocatedOutput&) = delete;
+
+    // size_hint: tamanho esperado (0 = desconhecido), usado na primeira reserva
+    bool open(const std::string& path, size_t size_hint = 0) {
+        close();
+        written_ = 0;
+        reserved_ = 0;
+        next_reserve_ = std::min(std::max(size_hint, kMinReserveBytes), kMaxReserveBytes);
+#ifndef _WIN32
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        return fd_ >= 0;
+#else
+        file_.open(path, std::ios::binary | std::ios::trunc);
+        return file_.is_open();
+#endif
+    }
+
+    bool isOpen() const {
+#ifndef _WIN32
+        return fd_ >= 0;
+#else
+        return file_.is_open();
+#endif
+    }
+
+    bool write(const char* data, size_t size) {
+#ifndef _WIN32
+        if (fd_ < 0) {
+            return false;
+        }
+        reserve(written_ + size);
+        size_t done = 0;
+        while (done < size) {
+            ssize_t result = ::write(fd_, data + done, size - done);
+            if (result < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            done += static_cast<size_t>(result);
+        }
+        written_ += size;
+        return true;
+#else
+        file_.write(data, static_cast<std::streamsize>(size));
+        written_ += size;
+        return file_.good();
+#endif
+    }
+
+    // Liberar a reserva além do que foi escrito e fechar
+    bool close() {
+#ifndef _WIN32
+        if (fd_ < 0) {
+            return true;
+        }
+        bool ok = reserved_ <= written_ ||
+                  ftruncate(fd_, static_cast<off_t>(written_)) == 0;
+        ok = ::close(fd_) == 0 && ok;
+        fd_ = -1;
+        return ok;
+#else
+        if (!file_.is_open()) {
+            return true;
+        }
+        file_.close();
+        return !file_.fail();
+#endif
+    }
+
+    size_t written() const { return written_; }
+
+private:
+    void reserve(size_t needed) {
+#ifdef __linux__
+        if (needed <= reserved_) {
+            return;
+        }
+        size_t length = std::max(next_reserve_, needed - reserved_);
+        // Sem suporte no sistema de arquivos: segue sem reserva
+        if (fallocate(fd_, FALLOC_FL_KEEP_SIZE, static_cast<off_t>(reserved_),
+                      static_cast<off_t>(length)) == 0) {
+            reserved_ += length;
+            next_reserve_ = std::min(next_reserve_ * 2, kMaxReserveBytes);
+        } else {
+            reserved_ = SIZE_MAX;
+        }
+#else
+        (void)needed;
+#endif
+    }
+
+    int fd_;
+    size_t written_;
+    size_t reserved_;
+    size_t next_reserve_;
+#ifdef _WIN32
+    std::ofstream file_;
+#endif
+};
+
+#endif // FILE_IO_H
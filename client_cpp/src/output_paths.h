@@ -0,0 +1,39 @@
+#ifndef OUTPUT_PATHS_H
+#define OUTPUT_PATHS_H
+
+#include <filesystem>
+#include <set>
+#include <string>
+#include <vector>
+
+// Saída de cada entrada em output_dir (stem + extensão). Entradas de
+// diretórios diferentes com o mesmo nome recebem "-2", "-3"... em vez de
+// sobrescrever umas às outras. Os nomes literais de todas as entradas são
+// reservados antes dos sufixos: com a/x.pdf, b/x.pdf e c/x-2.pdf, c fica
+// com x-2 e b com x-3
+inline std::vector<std::string> batchOutputPaths(const std::vector<std::string>& input_paths,
+                                                 const std::string& output_dir,
+                                                 const std::string& extension) {
+    std::set<std::string> literal;
+    for (const std::string& input_path : input_paths) {
+        literal.insert(std::filesystem::path(input_path).stem().string() + extension);
+    }
+
+    std::vector<std::string> paths;
+    std::set<std::string> taken;
+    for (const std::string& input_path : input_paths) {
+        std::string stem = std::filesystem::path(input_path).stem().string();
+        std::string name = stem + extension;
+        if (taken.count(name) > 0) {
+            // Nem a saída de outra entrada nem o nome literal de outra entrada
+            for (int suffix = 2; taken.count(name) > 0 || literal.count(name) > 0; ++suffix) {
+                name = stem + "-" + std::to_string(suffix) + extension;
+            }
+        }
+        taken.insert(name);
+        paths.push_back((std::filesystem::path(output_dir) / name).string());
+    }
+    return paths;
+}
+
+#endif // OUTPUT_PATHS_H
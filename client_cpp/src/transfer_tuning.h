@@ -0,0 +1,231 @@
+#ifndef TRANSFER_TUNING_H
+#define TRANSFER_TUNING_H
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <grpcpp/grpcpp.h>
+#include <zlib.h>
+
+// Ajustes de transferência do cliente, com as mesmas variáveis de ambiente
+// do servidor: FP_CHUNK_MIN_BYTES/FP_CHUNK_MAX_BYTES (valores iguais fixam o
+// tamanho do chunk), FP_HTTP2_WINDOW_BYTES, FP_HTTP2_BDP_PROBE,
+// FP_HTTP2_WRITE_BUFFER_BYTES e FP_HTTP2_MAX_FRAME_BYTES, além de
+// FP_COMPRESSION/FP_COMPRESSION_MIN_SAVINGS para a compressão dos uploads.
+// FP_DEADLINE_SECONDS e FP_PRIORITY definem o prazo e a prioridade
+// ("fp-priority") de cada chamada, usados pelo agendador do servidor
+struct TransferTuning {
+    size_t chunk_min_bytes = 64 * 1024;
+    size_t chunk_max_bytes = 4 * 1024 * 1024;
+    size_t http2_window_bytes = 0;
+    bool http2_bdp_probe = true;
+    size_t http2_write_buffer_bytes = 1024 * 1024;
+    size_t http2_max_frame_bytes = 0;
+    bool compression = true;
+    size_t compression_min_savings_percent = 10;
+    size_t deadline_seconds = 0;
+    std::string priority;
+
+    // Amostra do início do arquivo usada para decidir a compressão
+    static constexpr size_t kCompressionSampleBytes = 64 * 1024;
+
+    static TransferTuning fromEnvironment() {
+        TransferTuning tuning;
+        tuning.chunk_min_bytes = std::min<size_t>(std::max<size_t>(
+            envSize("FP_CHUNK_MIN_BYTES", tuning.chunk_min_bytes), 1024), 64 * 1024 * 1024);
+        tuning.chunk_max_bytes = std::min<size_t>(std::max(
+            envSize("FP_CHUNK_MAX_BYTES", tuning.chunk_max_bytes), tuning.chunk_min_bytes),
+            64 * 1024 * 1024);
+        tuning.http2_window_bytes = envSize("FP_HTTP2_WINDOW_BYTES",
+                                            tuning.http2_window_bytes);
+        tuning.http2_bdp_probe = envBool("FP_HTTP2_BDP_PROBE", tuning.http2_bdp_probe);
+        tuning.http2_write_buffer_bytes = envSize("FP_HTTP2_WRITE_BUFFER_BYTES",
+                                                  tuning.http2_write_buffer_bytes);
+        tuning.http2_max_frame_bytes = envSize("FP_HTTP2_MAX_FRAME_BYTES",
+                                               tuning.http2_max_frame_bytes);
+        tuning.compression = envBool("FP_COMPRESSION", tuning.compression);
+        tuning.compression_min_savings_percent = std::min<size_t>(envSize(
+            "FP_COMPRESSION_MIN_SAVINGS", tuning.compression_min_savings_percent), 100);
+        tuning.deadline_seconds = envSize("FP_DEADLINE_SECONDS", tuning.deadline_seconds);
+        const char* priority = std::getenv("FP_PRIORITY");
+        tuning.priority = priority != nullptr ? priority : "";
+        return tuning;
+    }
+
+    // Janela, sondagem de BDP e buffer de escrita do HTTP/2 (zeros mantêm
+    // os padrões do gRPC)
+    void apply(grpc::ChannelArguments& args) const {
+        args.SetInt(GRPC_ARG_HTTP2_BDP_PROBE, http2_bdp_probe ? 1 : 0);
+        if (http2_window_bytes > 0) {
+            args.SetInt(GRPC_ARG_HTTP2_STREAM_LOOKAHEAD_BYTES, toInt(http2_window_bytes));
+        }
+        if (http2_write_buffer_bytes > 0) {
+            args.SetInt(GRPC_ARG_HTTP2_WRITE_BUFFER_SIZE, toInt(http2_write_buffer_bytes));
+        }
+        if (http2_max_frame_bytes > 0) {
+            // HTTP/2 aceita quadros de 16KB a 16MB
+            args.SetInt(GRPC_ARG_HTTP2_MAX_FRAME_SIZE, toInt(std::min<size_t>(
+                std::max<size_t>(http2_max_frame_bytes, 16384), 16777215)));
+        }
+    }
+
+    // Prazo (0 = sem prazo) e prioridade (-10 a 10 ou low/normal/high) da chamada
+    void prepareCall(grpc::ClientContext& context) const {
+        if (deadline_seconds > 0) {
+            context.set_deadline(std::chrono::system_clock::now() +
+                                 std::chrono::seconds(deadline_seconds));
+        }
+        if (!priority.empty()) {
+            context.AddMetadata("fp-priority", priority);
+        }
+    }
+
+    // Upload com gzip compensa? Formatos já comprimidos (pela assinatura)
+    // ficam de fora; nos demais, deflate rápido no início do arquivo
+    // precisa economizar compression_min_savings_percent
+    bool compressUpload(const std::string& path) const {
+        if (!compression) {
+            return false;
+        }
+        std::ifstream file(path, std::ios::binary);
+        std::vector<char> sample(kCompressionSampleBytes);
+        file.read(sample.data(), sample.size());
+        size_t length = static_cast<size_t>(file.gcount());
+        if (length == 0 || looksCompressed(sample.data(), length)) {
+            return false;
+        }
+
+        uLongf compressed_size = compressBound(static_cast<uLong>(length));
+        std::vector<Bytef> compressed(compressed_size);
+        if (compress2(compressed.data(), &compressed_size,
+                      reinterpret_cast<const Bytef*>(sample.data()),
+                      static_cast<uLong>(length), Z_BEST_SPEED) != Z_OK) {
+            return false;
+        }
+        return compressed_size * 100 <=
+               length * (100 - compression_min_savings_percent);
+    }
+
+    // Assinaturas de formatos comprimidos (mesma lista do servidor)
+    static bool looksCompressed(const char* data, size_t size) {
+        static const std::string kSignatures[] = {
+            std::string("\xFF\xD8\xFF", 3),         // JPEG
+            std::string("\x89PNG", 4),              // PNG
+            std::string("%PDF", 4),                 // PDF
+            std::string("GIF8", 4),                 // GIF
+            std::string("\x00\x00\x00\x0CjP  ", 8), // JPEG 2000
+            std::string("PK\x03\x04", 4),           // ZIP
+            std::string("\x1F\x8B", 2),             // gzip
+            std::string("BZh", 3),                  // bzip2
+            std::string("\xFD" "7zXZ", 5),          // xz
+            std::string("\x28\xB5\x2F\xFD", 4),     // zstd
+        };
+        for (const std::string& signature : kSignatures) {
+            if (size >= signature.size() &&
+                std::memcmp(data, signature.data(), signature.size()) == 0) {
+                return true;
+            }
+        }
+        return size >= 12 && std::memcmp(data, "RIFF", 4) == 0 &&
+               std::memcmp(data + 8, "WEBP", 4) == 0;
+    }
+
+    static bool envBool(const char* name, bool default_value) {
+        const char* value = std::getenv(name);
+        if (value == nullptr || *value == '\0') {
+            return default_value;
+        }
+        std::string text = value;
+        return text == "1" || text == "true" || text == "on" || text == "yes";
+    }
+
+    static size_t envSize(const char* name, size_t default_value) {
+        const char* value = std::getenv(name);
+        if (value == nullptr || *value == '\0') {
+            return default_value;
+        }
+        char* end = nullptr;
+        long long parsed = std::strtoll(value, &end, 10);
+        return end == value || *end != '\0' || parsed < 0
+            ? default_value : static_cast<size_t>(parsed);
+    }
+
+    static int toInt(size_t value) {
+        return static_cast<int>(std::min<size_t>(value, INT_MAX));
+    }
+};
+
+// Tamanho dos chunks enviados: começa proporcional ao arquivo (cerca de 16
+// chunks) e mira em ~kTargetInterval por Write pela vazão medida, em
+// potências de 2 entre os limites, no máximo dobrando ou reduzindo à metade
+// por passo. Mesmo critério do servidor (chunk_sizer.h)
+class AdaptiveChunkSizer {
+public:
+    static constexpr std::chrono::milliseconds kTargetInterval{20};
+
+    AdaptiveChunkSizer(size_t min_bytes, size_t max_bytes, uint64_t total_bytes = 0)
+        : min_bytes_(min_bytes),
+          max_bytes_(std::max(min_bytes, max_bytes)),
+          chunk_bytes_(clamp(floorPowerOfTwo(total_bytes / 16))),
+          recent_bytes_(0.0),
+          recent_seconds_(0.0),
+          bytes_per_second_(0.0) {}
+
+    AdaptiveChunkSizer(const TransferTuning& tuning, uint64_t total_bytes)
+        : AdaptiveChunkSizer(tuning.chunk_min_bytes, tuning.chunk_max_bytes,
+                             total_bytes) {}
+
+    size_t next() const { return chunk_bytes_; }
+
+    double bytesPerSecond() const { return bytes_per_second_; }
+
+    // Registrar um chunk: bytes e duração do Write
+    void record(size_t bytes, std::chrono::steady_clock::duration elapsed) {
+        if (min_bytes_ == max_bytes_ || bytes == 0) {
+            return;
+        }
+        // Bytes e tempo com decaimento: um Write que retornou na hora
+        // (buffer do transporte) não domina a estimativa
+        recent_bytes_ = 0.7 * recent_bytes_ + static_cast<double>(bytes);
+        recent_seconds_ = 0.7 * recent_seconds_ +
+                          std::chrono::duration<double>(elapsed).count();
+        bytes_per_second_ = recent_bytes_ / std::max(recent_seconds_, 1e-6);
+
+        double target = bytes_per_second_ *
+            std::chrono::duration<double>(kTargetInterval).count();
+        size_t wanted = floorPowerOfTwo(static_cast<uint64_t>(
+            std::min(target, static_cast<double>(max_bytes_))));
+        wanted = std::min(std::max(wanted, chunk_bytes_ / 2), chunk_bytes_ * 2);
+        chunk_bytes_ = clamp(wanted);
+    }
+
+private:
+    static size_t floorPowerOfTwo(uint64_t value) {
+        size_t result = 1;
+        while (result <= value / 2) {
+            result *= 2;
+        }
+        return result;
+    }
+
+    size_t clamp(size_t value) const {
+        return std::min(std::max(value, min_bytes_), max_bytes_);
+    }
+
+    size_t min_bytes_;
+    size_t max_bytes_;
+    size_t chunk_bytes_;
+    double recent_bytes_;
+    double recent_seconds_;
+    double bytes_per_second_;
+};
+
+#endif // TRANSFER_TUNING_H
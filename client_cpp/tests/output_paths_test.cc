@@ -0,0 +1,54 @@
+// Teste dos nomes de saída do --batch e do --parallel: entradas com o mesmo
+// nome recebem sufixos sem tomar o nome literal de outra entrada.
+//
+// Uso: output_paths_test (código de saída != 0 em falha)
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "output_paths.h"
+
+namespace {
+int failures = 0;
+
+void expectPaths(const std::vector<std::string>& inputs,
+                 const std::vector<std::string>& expected) {
+    std::vector<std::string> paths = batchOutputPaths(inputs, "out", ".txt");
+    std::vector<std::string> names;
+    for (const std::string& path : paths) {
+        names.push_back(std::filesystem::path(path).filename().string());
+    }
+    if (names != expected) {
+        std::cerr << "unexpected names for";
+        for (const std::string& input : inputs) {
+            std::cerr << " " << input;
+        }
+        std::cerr << ":";
+        for (const std::string& name : names) {
+            std::cerr << " " << name;
+        }
+        std::cerr << std::endl;
+        ++failures;
+    }
+}
+}
+
+int main() {
+    expectPaths({"a/x.pdf", "b/y.pdf"}, {"x.txt", "y.txt"});
+    expectPaths({"a/x.pdf", "b/x.pdf", "c/x.pdf"}, {"x.txt", "x-2.txt", "x-3.txt"});
+    // O nome literal de c/x-2.pdf é reservado antes dos sufixos
+    expectPaths({"a/x.pdf", "b/x.pdf", "c/x-2.pdf"}, {"x.txt", "x-3.txt", "x-2.txt"});
+    expectPaths({"c/x-2.pdf", "a/x.pdf", "b/x.pdf"}, {"x-2.txt", "x.txt", "x-3.txt"});
+    // Duas entradas com o mesmo nome literal com sufixo
+    expectPaths({"a/x.pdf", "b/x.pdf", "c/x-2.pdf", "d/x-2.pdf"},
+                {"x.txt", "x-3.txt", "x-2.txt", "x-2-2.txt"});
+
+    if (failures > 0) {
+        std::cerr << "output_paths_test: " << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "output_paths_test: OK" << std::endl;
+    return 0;
+}
@@ -3,8 +3,11 @@
 
 import grpc
 import os
+import queue
+import random
 import sys
 import time
+import zlib
 from pathlib import Path
 from typing import Optional
 
@@ -14,10 +17,143 @@ import file_processor_pb2
 import file_processor_pb2_grpc
 
 
+def _env_int(name: str, default: int) -> int:
+    """Variável de ambiente inteira não negativa (padrão se ausente ou inválida)"""
+    try:
+        value = int(os.environ.get(name, ''))
+    except ValueError:
+        return default
+    return value if value >= 0 else default
+
+
+def _env_bool(name: str, default: bool) -> bool:
+    """Variável de ambiente booleana (1/true/on/yes)"""
+    value = os.environ.get(name, '')
+    if not value:
+        return default
+    return value.lower() in ('1', 'true', 'on', 'yes')
+
+
+def _call_options() -> dict:
+    """
+    Prazo (FP_DEADLINE_SECONDS, 0 = sem prazo) e prioridade (FP_PRIORITY:
+    -10 a 10 ou low/normal/high) de cada chamada, usados pelo agendador do
+    servidor
+    """
+    options = {}
+    deadline = _env_int('FP_DEADLINE_SECONDS', 0)
+    if deadline > 0:
+        options['timeout'] = deadline
+    priority = os.environ.get('FP_PRIORITY', '')
+    if priority:
+        options['metadata'] = (('fp-priority', priority),)
+    return options
+
+
+# Assinaturas de formatos já comprimidos (mesma lista do servidor)
+_COMPRESSED_SIGNATURES = (
+    b'\xff\xd8\xff', b'\x89PNG', b'%PDF', b'GIF8', b'\x00\x00\x00\x0cjP  ',
+    b'PK\x03\x04', b'\x1f\x8b', b'BZh', b'\xfd7zXZ', b'\x28\xb5\x2f\xfd',
+)
+
+
+def _compress_upload(file_path: str) -> bool:
+    """
+    Upload com gzip compensa? Formatos já comprimidos ficam de fora; nos
+    demais, deflate rápido no início do arquivo precisa economizar
+    FP_COMPRESSION_MIN_SAVINGS (padrão 10%)
+    """
+    if not _env_bool('FP_COMPRESSION', True):
+        return False
+    try:
+        with open(file_path, 'rb') as f:
+            sample = f.read(64 * 1024)
+    except OSError:
+        return False
+    if not sample or sample.startswith(_COMPRESSED_SIGNATURES):
+        return False
+    if sample[:4] == b'RIFF' and sample[8:12] == b'WEBP':
+        return False
+    min_savings = min(_env_int('FP_COMPRESSION_MIN_SAVINGS', 10), 100)
+    return len(zlib.compress(sample, 1)) * 100 <= len(sample) * (100 - min_savings)
+
+
+def batch_output_names(input_paths: list, extension: str) -> list:
+    """
+    Nome de saída de cada entrada do lote (stem + extensão). Nomes repetidos
+    (mesmo arquivo em diretórios diferentes) recebem "-2", "-3"... em vez de
+    sobrescrever uns aos outros, sem tomar o nome literal de outra entrada:
+    com a/x.pdf, b/x.pdf e c/x-2.pdf, c fica com x-2 e b com x-3
+    """
+    literal = {Path(path).stem + extension for path in input_paths}
+    names = []
+    taken = set()
+    for path in input_paths:
+        stem = Path(path).stem
+        name = stem + extension
+        suffix = 2
+        while name in taken or (suffix > 2 and name in literal):
+            name = f"{stem}-{suffix}{extension}"
+            suffix += 1
+        taken.add(name)
+        names.append(name)
+    return names
+
+
+class AdaptiveChunkSizer:
+    """
+    Tamanho dos chunks enviados (mesmo critério do cliente C++): começa
+    proporcional ao arquivo (cerca de 16 chunks) e mira em ~20ms por
+    mensagem pela vazão medida, em potências de 2 entre FP_CHUNK_MIN_BYTES e
+    FP_CHUNK_MAX_BYTES, no máximo dobrando ou reduzindo à metade por passo
+    """
+    
+    TARGET_INTERVAL = 0.020
+    
+    def __init__(self, total_bytes: int = 0):
+        self.min_bytes = min(max(_env_int('FP_CHUNK_MIN_BYTES', 64 * 1024), 1024),
+                             64 * 1024 * 1024)
+        self.max_bytes = min(max(_env_int('FP_CHUNK_MAX_BYTES', 4 * 1024 * 1024),
+                                 self.min_bytes), 64 * 1024 * 1024)
+        self.chunk_bytes = self._clamp(self._floor_power_of_two(total_bytes // 16))
+        self.recent_bytes = 0.0
+        self.recent_seconds = 0.0
+        self.bytes_per_second = 0.0
+    
+    def next(self) -> int:
+        return self.chunk_bytes
+    
+    def record(self, length: int, seconds: float):
+        """Registrar um chunk: bytes e tempo até o gRPC consumir a mensagem"""
+        if self.min_bytes == self.max_bytes or length == 0:
+            return
+        # Bytes e tempo com decaimento: um envio que retornou na hora não
+        # domina a estimativa
+        self.recent_bytes = 0.7 * self.recent_bytes + length
+        self.recent_seconds = 0.7 * self.recent_seconds + seconds
+        self.bytes_per_second = self.recent_bytes / max(self.recent_seconds, 1e-6)
+        wanted = self._floor_power_of_two(
+            int(min(self.bytes_per_second * self.TARGET_INTERVAL, self.max_bytes)))
+        wanted = min(max(wanted, self.chunk_bytes // 2), self.chunk_bytes * 2)
+        self.chunk_bytes = self._clamp(wanted)
+    
+    def _clamp(self, value: int) -> int:
+        return min(max(value, self.min_bytes), self.max_bytes)
+    
+    @staticmethod
+    def _floor_power_of_two(value: int) -> int:
+        return 1 << (value.bit_length() - 1) if value > 0 else 1
+
+
 class FileProcessorClient:
     """Cliente gRPC para processamento de arquivos"""
     
-    CHUNK_SIZE = 64 * 1024  # 64KB
+    RESUMABLE_THRESHOLD = 8 * 1024 * 1024  # uploads retomáveis a partir de 8MB
+    NEW_UPLOAD_ID = "new"  # primeira chamada: o servidor gera o token
+    MAX_ATTEMPTS = 5
+    RETRYABLE_CODES = (grpc.StatusCode.UNAVAILABLE, grpc.StatusCode.ABORTED,
+                       grpc.StatusCode.DATA_LOSS, grpc.StatusCode.DEADLINE_EXCEEDED,
+                       grpc.StatusCode.CANCELLED, grpc.StatusCode.UNKNOWN)
     
     def __init__(self, server_address: str = 'localhost:50051'):
         """
@@ -32,44 +168,113 @@ class FileProcessorClient:
             options=[
                 ('grpc.max_receive_message_length', 100 * 1024 * 1024),
                 ('grpc.max_send_message_length', 100 * 1024 * 1024),
-            ]
+            ] + self._flow_control_options()
         )
         self.stub = file_processor_pb2_grpc.FileProcessorServiceStub(
             self.channel)
     
-    def _send_file(self, file_path: str):
+    @staticmethod
+    def _flow_control_options():
+        """
+        Controle de fluxo HTTP/2 (mesmas variáveis FP_HTTP2_* do servidor)
+        
+        Returns:
+            list: Opções do canal; zeros mantêm os padrões do gRPC
+        """
+        options = [('grpc.http2.bdp_probe',
+                    0 if os.environ.get('FP_HTTP2_BDP_PROBE', '1').lower()
+                    in ('0', 'false', 'off', 'no') else 1)]
+        window = _env_int('FP_HTTP2_WINDOW_BYTES', 0)
+        if window > 0:
+            options.append(('grpc.http2.lookahead_bytes', min(window, 2**31 - 1)))
+        write_buffer = _env_int('FP_HTTP2_WRITE_BUFFER_BYTES', 1024 * 1024)
+        if write_buffer > 0:
+            options.append(('grpc.http2.write_buffer_size', min(write_buffer, 2**31 - 1)))
+        return options
+
+    def _metadata(self, file_path: str):
+        """
+        Metadados do arquivo enviados no cabeçalho
+        
+        Args:
+            file_path: Caminho do arquivo
+            
+        Returns:
+            FileMetadata: Nome e tamanho do arquivo
+        """
+        return file_processor_pb2.FileMetadata(
+            file_name=os.path.basename(file_path),
+            file_size=os.path.getsize(file_path))
+
+    def _send_file(self, file_path: str, header, offsets: Optional[queue.Queue] = None):
         """
         Gerador para enviar arquivo em chunks
         
         Args:
             file_path: Caminho do arquivo
+            header: RequestHeader com metadados e parâmetros (primeira mensagem);
+                recebe o token devolvido pelo servidor nos uploads retomáveis
+            offsets: Fila com o UploadStatus do servidor (uploads retomáveis)
             
         Yields:
-            FileChunk: Chunks do arquivo
+            FileChunk: Cabeçalho e chunks do arquivo
         """
+        yield file_processor_pb2.FileChunk(header=header)
+        offset = 0
+        if header.upload_id:
+            # Aguardar o UploadStatus lido por _receive_file (None: stream encerrado)
+            status = offsets.get()
+            if status is None:
+                return
+            # Token do upload para as próximas tentativas
+            if status.upload_id:
+                header.upload_id = status.upload_id
+            offset = status.committed_offset
+            if offset > 0:
+                print(f"↪️  Resuming upload at {self._format_file_size(offset)}")
+        sizer = AdaptiveChunkSizer(os.path.getsize(file_path))
         with open(file_path, 'rb') as f:
+            f.seek(offset)
             while True:
-                chunk_data = f.read(self.CHUNK_SIZE)
+                chunk_data = f.read(sizer.next())
                 if not chunk_data:
                     break
-                yield file_processor_pb2.FileChunk(content=chunk_data)
+                # CRC-32 do zlib, o mesmo verificado pelo servidor
+                started = time.monotonic()
+                yield file_processor_pb2.FileChunk(
+                    content=chunk_data,
+                    integrity=file_processor_pb2.ChunkIntegrity(
+                        offset=offset, crc32=zlib.crc32(chunk_data)))
+                sizer.record(len(chunk_data), time.monotonic() - started)
+                offset += len(chunk_data)
     
-    def _receive_file(self, response_iterator, output_path: str) -> int:
+    def _receive_file(self, response_iterator, output_path: str,
+                      offsets: Optional[queue.Queue] = None) -> int:
         """
         Recebe arquivo do servidor
         
         Args:
             response_iterator: Iterador de resposta do servidor
             output_path: Caminho para salvar arquivo
+            offsets: Fila que recebe o UploadStatus
             
         Returns:
             int: Número de bytes recebidos
         """
         total_bytes = 0
-        with open(output_path, 'wb') as f:
-            for chunk in response_iterator:
-                f.write(chunk.content)
-                total_bytes += len(chunk.content)
+        try:
+            with open(output_path, 'wb') as f:
+                for chunk in response_iterator:
+                    if chunk.HasField('upload_status'):
+                        if offsets is not None:
+                            offsets.put(chunk.upload_status)
+                        continue
+                    f.write(chunk.content)
+                    total_bytes += len(chunk.content)
+        finally:
+            # Liberar o gerador de envio se o stream terminar antes do status
+            if offsets is not None:
+                offsets.put(None)
         return total_bytes
     
     def _format_file_size(self, bytes_size: int) -> str:
@@ -93,7 +298,7 @@ class FileProcessorClient:
         return f"{size:.2f} {units[unit_index]}"
     
     def _process_file(self, operation_name: str, input_path: str,
-                     output_path: str, rpc_method) -> bool:
+                     output_path: str, rpc_method, header_factory) -> bool:
         """
         Processa arquivo genérico
         
@@ -102,6 +307,7 @@ class FileProcessorClient:
             input_path: Caminho do arquivo de entrada
             output_path: Caminho do arquivo de saída
             rpc_method: Método RPC a ser chamado
+            header_factory: Monta o RequestHeader a partir dos metadados
             
         Returns:
             bool: True se sucesso, False caso contrário
@@ -119,43 +325,134 @@ class FileProcessorClient:
         print(f"📄 Input file: {input_path}")
         print(f"📊 File size: {self._format_file_size(input_size)}")
         
-        try:
-            # Enviar arquivo
-            print("⬆️  Uploading file...")
-            start_upload = time.time()
-            
-            response_iterator = rpc_method(self._send_file(input_path))
-            
-            end_upload = time.time()
-            upload_duration = (end_upload - start_upload) * 1000
-            print(f"✅ Upload completed in {upload_duration:.0f}ms")
-            
-            # Receber arquivo
-            print("⬇️  Downloading result...")
-            start_download = time.time()
-            
-            total_received = self._receive_file(response_iterator, output_path)
-            
-            end_download = time.time()
-            download_duration = (end_download - start_download) * 1000
-            
-            print(f"✅ Download completed in {download_duration:.0f}ms")
-            print(f"💾 Output file: {output_path}")
-            print(f"📊 Output size: {self._format_file_size(total_received)}")
-            
-            total_duration = upload_duration + download_duration
-            print(f"\n⏱️  Total time: {total_duration:.0f}ms")
-            print("✅ Operation completed successfully!\n")
-            
-            return True
+        header = header_factory(self._metadata(input_path))
+        if input_size >= self.RESUMABLE_THRESHOLD:
+            # Arquivos grandes: o servidor guarda o que já recebeu e uma nova
+            # tentativa continua do offset confirmado
+            header.upload_id = self.NEW_UPLOAD_ID
+        
+        attempt = 1
+        while True:
+            try:
+                return self._transfer(input_path, output_path, rpc_method, header)
+            except grpc.RpcError as e:
+                retry_after = self._retry_after(e)
+                if (e.code() == grpc.StatusCode.RESOURCE_EXHAUSTED and retry_after > 0
+                        and attempt < self.MAX_ATTEMPTS):
+                    # Servidor sobrecarregado: recusa antes do upload, com a
+                    # espera sugerida no trailing metadata
+                    print(f"⏳ Server busy ({e.details()}), retrying in "
+                          f"{retry_after * 1000:.0f}ms "
+                          f"(attempt {attempt + 1}/{self.MAX_ATTEMPTS})...")
+                    time.sleep(retry_after)
+                    attempt += 1
+                    continue
+                if e.code() == grpc.StatusCode.UNIMPLEMENTED and header.upload_id:
+                    # Servidor sem uploads retomáveis: envio comum
+                    header.upload_id = ""
+                    continue
+                if (header.upload_id and attempt < self.MAX_ATTEMPTS and
+                        e.code() in self.RETRYABLE_CODES):
+                    print(f"🔁 Transfer interrupted ({e.details()}), resuming "
+                          f"(attempt {attempt + 1}/{self.MAX_ATTEMPTS})...")
+                    time.sleep(0.5 * attempt)
+                    attempt += 1
+                    continue
+                print(f"❌ RPC error: {e.code()}: {e.details()}")
+                return False
+            except Exception as e:
+                print(f"❌ Error: {str(e)}")
+                return False
+    
+    def _transfer(self, input_path: str, output_path: str, rpc_method, header) -> bool:
+        """
+        Uma tentativa de envio e recebimento
+        
+        Args:
+            input_path: Caminho do arquivo de entrada
+            output_path: Caminho do arquivo de saída
+            rpc_method: Método RPC a ser chamado
+            header: RequestHeader (com upload_id nos uploads retomáveis)
             
-        except grpc.RpcError as e:
-            print(f"❌ RPC error: {e.code()}: {e.details()}")
-            return False
-        except Exception as e:
-            print(f"❌ Error: {str(e)}")
-            return False
+        Returns:
+            bool: True se sucesso (erros RPC são propagados)
+        """
+        # Enviar arquivo
+        print("⬆️  Uploading file...")
+        start_upload = time.time()
+        
+        offsets = queue.Queue() if header.upload_id else None
+        compression = grpc.Compression.NoCompression
+        if _compress_upload(input_path):
+            # Entradas compressíveis (texto, BMP...) sobem com gzip
+            print("🗜️  Compressing upload (gzip)")
+            compression = grpc.Compression.Gzip
+        response_iterator = rpc_method(self._send_file(input_path, header, offsets),
+                                       compression=compression, **_call_options())
+        
+        end_upload = time.time()
+        upload_duration = (end_upload - start_upload) * 1000
+        print(f"✅ Upload completed in {upload_duration:.0f}ms")
+        
+        # Receber arquivo
+        print("⬇️  Downloading result...")
+        start_download = time.time()
+        
+        total_received = self._receive_file(response_iterator, output_path, offsets)
+        
+        end_download = time.time()
+        download_duration = (end_download - start_download) * 1000
+        
+        print(f"✅ Download completed in {download_duration:.0f}ms")
+        self._print_response_compression(response_iterator)
+        print(f"💾 Output file: {output_path}")
+        print(f"📊 Output size: {self._format_file_size(total_received)}")
+        
+        total_duration = upload_duration + download_duration
+        print(f"\n⏱️  Total time: {total_duration:.0f}ms")
+        print("✅ Operation completed successfully!\n")
+        
+        return True
     
+    @staticmethod
+    def _retry_after(call) -> float:
+        """
+        Espera sugerida pelo servidor ao recusar uma requisição
+        ("fp-retry-after-ms"), em segundos, com até 20% a mais para espalhar
+        as tentativas; 0 se ausente
+        """
+        try:
+            metadata = dict(call.trailing_metadata() or ())
+            milliseconds = int(metadata.get('fp-retry-after-ms', 0))
+        except (ValueError, TypeError):
+            return 0.0
+        if milliseconds <= 0:
+            return 0.0
+        return milliseconds * random.uniform(1.0, 1.2) / 1000.0
+
+    def _print_response_compression(self, call):
+        """
+        Resumo da compressão das respostas enviado pelo servidor no trailing
+        metadata "fp-compression" (compressed=N;estimated=M;uncompressed=K)
+        """
+        summary = dict(call.trailing_metadata() or ()).get('fp-compression')
+        if summary is None:
+            return
+        values = {}
+        for field in summary.split(';'):
+            name, _, value = field.partition('=')
+            if value.isdigit():
+                values[name] = int(value)
+
+        compressed = values.get('compressed', 0)
+        if compressed == 0:
+            print("🗜️  Response sent uncompressed")
+            return
+        estimated = values.get('estimated', 0)
+        print(f"🗜️  Response compression: {self._format_file_size(compressed)} -> "
+              f"~{self._format_file_size(estimated)} "
+              f"({100.0 * (1.0 - estimated / compressed):.1f}% saved)")
+
     def compress_pdf(self, input_path: str, output_path: str) -> bool:
         """
         Comprime PDF
@@ -171,7 +468,10 @@ class FileProcessorClient:
             "Compress PDF",
             input_path,
             output_path,
-            self.stub.CompressPDF
+            self.stub.CompressPDF,
+            lambda metadata: file_processor_pb2.RequestHeader(
+                compress_pdf=file_processor_pb2.CompressPDFRequest(
+                    metadata=metadata))
         )
     
     def convert_to_txt(self, input_path: str, output_path: str) -> bool:
@@ -189,7 +489,10 @@ class FileProcessorClient:
             "Convert PDF to TXT",
             input_path,
             output_path,
-            self.stub.ConvertToTXT
+            self.stub.ConvertToTXT,
+            lambda metadata: file_processor_pb2.RequestHeader(
+                convert_to_txt=file_processor_pb2.ConvertToTXTRequest(
+                    metadata=metadata))
         )
     
     def convert_image_format(self, input_path: str, output_path: str,
@@ -209,11 +512,15 @@ class FileProcessorClient:
             f"Convert Image to {output_format.upper()}",
             input_path,
             output_path,
-            self.stub.ConvertImageFormat
+            self.stub.ConvertImageFormat,
+            lambda metadata: file_processor_pb2.RequestHeader(
+                convert_image_format=file_processor_pb2.ConvertImageFormatRequest(
+                    metadata=metadata, output_format=output_format))
         )
     
     def resize_image(self, input_path: str, output_path: str,
-                    width: int, height: int) -> bool:
+                    width: int, height: int,
+                    maintain_aspect_ratio: bool = False) -> bool:
         """
         Redimensiona imagem
         
@@ -222,6 +529,7 @@ class FileProcessorClient:
             output_path: Caminho da imagem de saída
             width: Largura desejada
             height: Altura desejada
+            maintain_aspect_ratio: Caber em width x height mantendo a proporção
             
         Returns:
             bool: True se sucesso
@@ -230,9 +538,157 @@ class FileProcessorClient:
             f"Resize Image to {width}x{height}",
             input_path,
             output_path,
-            self.stub.ResizeImage
+            self.stub.ResizeImage,
+            lambda metadata: file_processor_pb2.RequestHeader(
+                resize_image=file_processor_pb2.ResizeImageRequest(
+                    metadata=metadata, width=width, height=height,
+                    maintain_aspect_ratio=maintain_aspect_ratio))
         )
     
+    BATCH_OPERATIONS = {
+        'compress': ('COMPRESS_PDF', '.pdf'),
+        'txt': ('CONVERT_TO_TXT', '.txt'),
+        'convert': ('CONVERT_IMAGE_FORMAT', None),
+        'resize': ('RESIZE_IMAGE', '.jpg'),
+    }
+
+    def _send_batch(self, input_paths, operation: int, output_format: str,
+                    width: int, height: int):
+        """
+        Gerador das mensagens do lote: cabeçalho na primeira mensagem de
+        cada arquivo, chunks de conteúdo e end_of_file no final
+        
+        Args:
+            input_paths: Arquivos de entrada (file_id = índice + 1)
+            operation: Valor do enum Operation
+            output_format: Formato de saída (ConvertImageFormat)
+            width: Largura (ResizeImage)
+            height: Altura (ResizeImage)
+            
+        Yields:
+            BatchRequest: Mensagens do lote
+        """
+        for index, input_path in enumerate(input_paths):
+            file_id = index + 1
+            header = file_processor_pb2.BatchFileHeader(
+                operation=operation,
+                file_name=os.path.basename(input_path),
+                output_format=output_format,
+                width=width,
+                height=height)
+
+            first = True
+            try:
+                sizer = AdaptiveChunkSizer(os.path.getsize(input_path))
+                with open(input_path, 'rb') as f:
+                    while True:
+                        chunk_data = f.read(sizer.next())
+                        if not chunk_data:
+                            break
+                        started = time.monotonic()
+                        yield file_processor_pb2.BatchRequest(
+                            file_id=file_id,
+                            header=header if first else None,
+                            content=chunk_data)
+                        sizer.record(len(chunk_data), time.monotonic() - started)
+                        first = False
+            except OSError as e:
+                print(f"❌ Error reading {input_path}: {e}")
+
+            # Arquivo vazio ou ilegível: o servidor reporta o erro pelo id
+            yield file_processor_pb2.BatchRequest(
+                file_id=file_id,
+                header=header if first else None,
+                end_of_file=True)
+
+    def process_batch(self, operation_name: str, input_paths, output_dir: str,
+                      output_format: str = '', width: int = 0,
+                      height: int = 0) -> bool:
+        """
+        Processa vários arquivos em um único stream; os resultados chegam
+        na ordem em que ficam prontos
+        
+        Args:
+            operation_name: compress, txt, convert ou resize
+            input_paths: Arquivos de entrada
+            output_dir: Diretório dos resultados
+            output_format: Formato de saída (convert)
+            width: Largura (resize)
+            height: Altura (resize)
+            
+        Returns:
+            bool: True se todos os arquivos foram processados
+        """
+        print(f"\n┌─────────────────────────────────────┐")
+        print(f"│ {'ProcessBatch':35} │")
+        print(f"└─────────────────────────────────────┘\n")
+
+        enum_name, extension = self.BATCH_OPERATIONS[operation_name]
+        if extension is None:
+            extension = '.' + (output_format or 'png')
+        operation = file_processor_pb2.Operation.Value(enum_name)
+
+        os.makedirs(output_dir, exist_ok=True)
+        output_paths = {
+            index + 1: os.path.join(output_dir, name)
+            for index, name in enumerate(batch_output_names(input_paths, extension))
+        }
+
+        print(f"📦 Files: {len(input_paths)}")
+        start = time.time()
+        succeeded = 0
+        failed = 0
+        outputs = {}
+
+        # A API síncrona não desliga a compressão por mensagem: gzip só
+        # quando todos os arquivos do lote compensam
+        compression = grpc.Compression.NoCompression
+        if input_paths and all(_compress_upload(path) for path in input_paths):
+            compression = grpc.Compression.Gzip
+
+        try:
+            responses = self.stub.ProcessBatch(
+                self._send_batch(input_paths, operation, output_format,
+                                 width, height),
+                compression=compression, **_call_options())
+            for response in responses:
+                output_path = output_paths.get(response.file_id)
+                if output_path is None:
+                    continue
+
+                if response.content:
+                    if response.file_id not in outputs:
+                        outputs[response.file_id] = open(output_path, 'wb')
+                    outputs[response.file_id].write(response.content)
+
+                if response.end_of_file:
+                    output = outputs.pop(response.file_id, None)
+                    if output is not None:
+                        output.close()
+                    input_path = input_paths[response.file_id - 1]
+                    if response.status_code == 0:
+                        succeeded += 1
+                        print(f"✅ {input_path} -> {output_path}")
+                    else:
+                        failed += 1
+                        print(f"❌ {input_path}: {response.status_message}")
+
+        except grpc.RpcError as e:
+            print(f"❌ RPC error: {e.code()}: {e.details()}")
+            retry_after = self._retry_after(e)
+            if retry_after > 0:
+                print(f"⏳ Server busy, retry after {retry_after * 1000:.0f}ms")
+            return False
+        finally:
+            for output in outputs.values():
+                output.close()
+
+        duration = (time.time() - start) * 1000
+        print(f"\n⏱️  Total time: {duration:.0f}ms "
+              f"({succeeded} succeeded, {failed} failed)")
+        self._print_response_compression(responses)
+        return failed == 0 and succeeded == len(input_paths)
+
     def close(self):
         """Fecha conexão com servidor"""
         self.channel.close()
@@ -264,9 +720,47 @@ def main():
         help='Server address (default: localhost:50051)'
     )
     
+    parser.add_argument(
+        '--batch',
+        choices=sorted(FileProcessorClient.BATCH_OPERATIONS),
+        help='Batch mode: process FILES in a single stream'
+    )
+    parser.add_argument(
+        '--output-dir',
+        default='output',
+        help='Output directory for batch mode (default: output)'
+    )
+    parser.add_argument(
+        '--format',
+        default='',
+        help='Output format for batch convert (default: png)'
+    )
+    parser.add_argument(
+        '--size',
+        default='',
+        help='WIDTHxHEIGHT for batch resize (default: 800x600)'
+    )
+    parser.add_argument('files', nargs='*', help='Input files for batch mode')
+    
     args = parser.parse_args()
     
     client = FileProcessorClient(args.server)
+
+    if args.batch:
+        width = height = 0
+        if args.size:
+            try:
+                width, height = (int(v) for v in args.size.lower().split('x'))
+            except ValueError:
+                parser.error('--size must be WIDTHxHEIGHT')
+        if not args.files:
+            parser.error('batch mode requires input files')
+        try:
+            ok = client.process_batch(args.batch, args.files, args.output_dir,
+                                      args.format, width, height)
+        finally:
+            client.close()
+        sys.exit(0 if ok else 1)
     
     try:
         while True:
@@ -0,0 +1,195 @@
+#!/usr/bin/env bash
+################################################################################
+# Benchmark de Transferência
+# Compara chunks fixos de 64KB (sem buffer_hint, janelas padrão) com os
+# chunks adaptativos em vários tamanhos de arquivo e latências simuladas
+# no loopback (tc netem, requer root). As requisições são servidas pelo
+# cache de resultados após o aquecimento, então o tempo medido é o de
+# transferência (upload + download de um PNG sem compressão).
+################################################################################
+
+set -e
+
+# Cores
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+BLUE='\033[0;34m'
+CYAN='\033[0;36m'
+NC='\033[0m'
+
+print_color() {
+    local color=$1
+    shift
+    echo -e "${color}$@${NC}"
+}
+
+# Diretórios
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+PROJECT_ROOT="$(dirname "$SCRIPT_DIR")"
+SERVER_BIN="${SERVER_BIN:-$PROJECT_ROOT/server_cpp/build/file_processor_server}"
+BENCH_BIN="${BENCH_BIN:-$PROJECT_ROOT/client_cpp/build/file_processor_bench}"
+OUTPUT_DIR="$PROJECT_ROOT/tests/test_results/transfer_bench"
+
+# Parâmetros padrão
+SIZES_MB="1 16 64"
+DELAYS_MS="0 10 50"
+REQUESTS=5
+PORT=50090
+
+while [[ $# -gt 0 ]]; do
+    case $1 in
+        --sizes)
+            SIZES_MB="$2"
+            shift 2
+            ;;
+        --delays)
+            DELAYS_MS="$2"
+            shift 2
+            ;;
+        --requests)
+            REQUESTS="$2"
+            shift 2
+            ;;
+        --port)
+            PORT="$2"
+            shift 2
+            ;;
+        -h|--help)
+            echo "Uso: $0 [opções]"
+            echo ""
+            echo "Opções:"
+            echo "  --sizes \"MB...\"     Tamanhos dos arquivos (padrão: \"$SIZES_MB\")"
+            echo "  --delays \"MS...\"    Atrasos do netem no loopback (padrão: \"$DELAYS_MS\")"
+            echo "  --requests N        Requisições medidas por ponto (padrão: $REQUESTS)"
+            echo "  --port N            Porta do servidor de teste (padrão: $PORT)"
+            echo "  -h, --help          Mostrar esta ajuda"
+            exit 0
+            ;;
+        *)
+            print_color "$RED" "❌ Opção desconhecida: $1"
+            exit 1
+            ;;
+    esac
+done
+
+for binary in "$SERVER_BIN" "$BENCH_BIN"; do
+    if [[ ! -x "$binary" ]]; then
+        print_color "$RED" "❌ Erro: $binary não encontrado. Execute ./scripts/build.sh"
+        exit 1
+    fi
+done
+
+WORK_DIR="$(mktemp -d)"
+SERVER_PID=""
+NETEM_ACTIVE=false
+
+cleanup() {
+    if [[ -n "$SERVER_PID" ]]; then
+        kill "$SERVER_PID" 2>/dev/null || true
+        wait "$SERVER_PID" 2>/dev/null || true
+    fi
+    if [[ "$NETEM_ACTIVE" == true ]]; then
+        tc qdisc del dev lo root 2>/dev/null || true
+    fi
+    rm -rf "$WORK_DIR"
+}
+trap cleanup EXIT
+
+mkdir -p "$OUTPUT_DIR"
+
+# PNG de ruído sem compressão: o tamanho não muda na reconversão
+print_color "$CYAN" "📁 Gerando arquivos de entrada..."
+for size in $SIZES_MB; do
+    python3 - "$WORK_DIR/noise_${size}mb.png" "$size" <<'EOF'
+import os, struct, sys, zlib
+path, megabytes = sys.argv[1], float(sys.argv[2])
+side = max(16, int((megabytes * 1024 * 1024 / 3) ** 0.5))
+def chunk(kind, data):
+    return (struct.pack('>I', len(data)) + kind + data +
+            struct.pack('>I', zlib.crc32(kind + data) & 0xffffffff))
+rows = b''.join(b'\x00' + os.urandom(side * 3) for _ in range(side))
+with open(path, 'wb') as f:
+    f.write(b'\x89PNG\r\n\x1a\n')
+    f.write(chunk(b'IHDR', struct.pack('>IIBBBBB', side, side, 8, 2, 0, 0, 0)))
+    f.write(chunk(b'IDAT', zlib.compress(rows, 0)))
+    f.write(chunk(b'IEND', b''))
+EOF
+done
+
+start_server() {
+    (cd "$WORK_DIR" && env "$@" "$SERVER_BIN" "127.0.0.1:$PORT" > server.log 2>&1) &
+    SERVER_PID=$!
+    for _ in $(seq 1 50); do
+        if timeout 1 bash -c "cat < /dev/null > /dev/tcp/127.0.0.1/$PORT" 2>/dev/null; then
+            return 0
+        fi
+        sleep 0.1
+    done
+    print_color "$RED" "❌ Servidor de teste não iniciou (veja $WORK_DIR/server.log)"
+    exit 1
+}
+
+stop_server() {
+    kill "$SERVER_PID" 2>/dev/null || true
+    wait "$SERVER_PID" 2>/dev/null || true
+    SERVER_PID=""
+}
+
+# Modos: variáveis comuns ao servidor e ao bench, mais opções do bench
+FIXED_ENV="FP_CHUNK_MIN_BYTES=65536 FP_CHUNK_MAX_BYTES=65536 FP_HTTP2_WRITE_BUFFER_BYTES=0"
+ADAPTIVE_ENV=""
+COMMON_ENV="FP_CACHE_MEMORY_BYTES=$((1024 * 1024 * 1024)) FP_METRICS_PORT=0 FP_RESUMABLE_UPLOADS=0"
+
+printf "\n%-8s %-8s %-10s %12s %12s\n" "delay" "size" "mode" "MB/s" "p50 (ms)"
+for delay in $DELAYS_MS; do
+    if [[ "$delay" != "0" ]]; then
+        if ! tc qdisc add dev lo root netem delay "${delay}ms" 2>/dev/null; then
+            print_color "$YELLOW" "⚠️  tc netem indisponível (root e sch_netem), pulando ${delay}ms"
+            continue
+        fi
+        NETEM_ACTIVE=true
+    fi
+
+    for mode in fixed adaptive; do
+        if [[ "$mode" == fixed ]]; then
+            MODE_ENV="$FIXED_ENV"
+            BENCH_ARGS="--buffer-hint=0"
+        else
+            MODE_ENV="$ADAPTIVE_ENV"
+            BENCH_ARGS=""
+        fi
+        # shellcheck disable=SC2086
+        start_server $COMMON_ENV $MODE_ENV
+
+        for size in $SIZES_MB; do
+            report="$OUTPUT_DIR/${mode}_${delay}ms_${size}mb.json"
+            # shellcheck disable=SC2086
+            env $MODE_ENV "$BENCH_BIN" "127.0.0.1:$PORT" --requests="$REQUESTS" \
+                --warmup=1 --concurrency=1 --mix=convert=1 --timeout=600 \
+                $BENCH_ARGS --output="$report" "$WORK_DIR/noise_${size}mb.png" \
+                2>/dev/null || true
+            python3 - "$report" "$delay" "$size" "$mode" <<'EOF'
+import json, sys
+report, delay, size, mode = sys.argv[1:]
+try:
+    data = json.load(open(report))
+    rate = data['bytes_per_second'] / (1024 * 1024)
+    p50 = data['latency_ms']['p50']
+    errors = f" ({data['errors']} errors)" if data['errors'] else ""
+    print(f"{delay + 'ms':8} {size + 'MB':8} {mode:10} {rate:12.1f} {p50:12.1f}{errors}")
+except (OSError, ValueError, KeyError):
+    print(f"{delay + 'ms':8} {size + 'MB':8} {mode:10} {'failed':>12}")
+EOF
+        done
+        stop_server
+    done
+
+    if [[ "$NETEM_ACTIVE" == true ]]; then
+        tc qdisc del dev lo root 2>/dev/null || true
+        NETEM_ACTIVE=false
+    fi
+done
+
+echo ""
+print_color "$GREEN" "✅ Relatórios JSON em $OUTPUT_DIR"
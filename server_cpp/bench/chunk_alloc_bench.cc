@@ -0,0 +1,250 @@
+// Benchmark de alocações no caminho dos chunks do servidor: mensagem nova a
+// cada chunk, mensagem reaproveitada com set_content e o caminho atual
+// (mensagens na arena da chamada, content reaproveitado com assign e
+// amostra de compressão com o deflate da thread), no envio e no recebimento
+//
+// Uso: chunk_alloc_bench [chunks_por_thread] [chunk_KB] [threads] [chunks_por_chamada]
+// Conta as chamadas ao operator new, as alocações do zlib na amostra de
+// compressão e as que o ChunkBufferPool repassa ao malloc. Cada "chamada"
+// recria as mensagens (e a arena); com várias threads, a disputa no
+// alocador aparece no tempo por chunk.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <google/protobuf/arena.h>
+#include <zlib.h>
+
+#include "call_arena.h"
+#include "chunk_buffer_pool.h"
+#include "compression_policy.h"
+#include "file_processor.pb.h"
+
+namespace {
+std::atomic<uint64_t> g_allocations{0};
+thread_local uint64_t t_allocations = 0;
+}
+
+// Contagem por thread (somada ao fim de cada execução), sem disputa
+void* operator new(size_t size) {
+    ++t_allocations;
+    void* data = std::malloc(size == 0 ? 1 : size);
+    if (data == nullptr) {
+        throw std::bad_alloc();
+    }
+    return data;
+}
+
+void operator delete(void* data) noexcept {
+    std::free(data);
+}
+
+void operator delete(void* data, size_t) noexcept {
+    std::free(data);
+}
+
+namespace {
+
+struct Config {
+    size_t chunks = 20000;
+    size_t chunk_bytes = 64 * 1024;
+    size_t threads = 4;
+    size_t chunks_per_call = 16;
+};
+
+// Caminho anterior da amostra: compress2 inicializa e libera o deflate a
+// cada chamada; aqui com o mesmo deflateInit, contando as alocações
+voidpf countingAlloc(voidpf, uInt items, uInt size) {
+    ++t_allocations;
+    return std::calloc(items, size);
+}
+
+void countingFree(voidpf, voidpf address) {
+    std::free(address);
+}
+
+double legacySampleRatio(const char* data, size_t size) {
+    size_t sample = std::min(size, CompressionPolicy::kSampleBytes);
+    uLongf bound = compressBound(static_cast<uLong>(sample));
+    std::vector<Bytef> buffer(bound);
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    stream.zalloc = countingAlloc;
+    stream.zfree = countingFree;
+    if (deflateInit(&stream, Z_BEST_SPEED) != Z_OK) {
+        return 1.0;
+    }
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = static_cast<uInt>(sample);
+    stream.next_out = buffer.data();
+    stream.avail_out = static_cast<uInt>(bound);
+    deflate(&stream, Z_FINISH);
+    double ratio = static_cast<double>(stream.total_out) / static_cast<double>(sample);
+    deflateEnd(&stream);
+    return std::min(1.0, ratio);
+}
+
+// Saída de exemplo: texto repetitivo com variação (comprime como um TXT)
+std::string makeSource(size_t size) {
+    std::string source;
+    source.reserve(size);
+    uint32_t state = 12345;
+    while (source.size() < size) {
+        state = state * 1103515245u + 12345u;
+        source += "line " + std::to_string(state % 100000) + " of extracted text\n";
+    }
+    source.resize(size);
+    return source;
+}
+
+// Envio: sink simula a serialização feita pelo gRPC
+using Scenario = std::function<void(const Config&, const std::string& source,
+                                    const std::string& wire, std::string& sink)>;
+
+void sendNewMessage(const Config& config, const std::string& source, const std::string&,
+                    std::string& sink) {
+    for (size_t i = 0; i < config.chunks; ++i) {
+        file_processor::FileChunk chunk;
+        chunk.set_content(source.data(), config.chunk_bytes);
+        legacySampleRatio(chunk.content().data(), chunk.content().size());
+        chunk.SerializeToString(&sink);
+    }
+}
+
+void sendReused(const Config& config, const std::string& source, const std::string&,
+                std::string& sink) {
+    for (size_t call = 0; call < config.chunks; call += config.chunks_per_call) {
+        file_processor::FileChunk chunk;
+        for (size_t i = call; i < std::min(config.chunks, call + config.chunks_per_call); ++i) {
+            chunk.set_content(source.data(), config.chunk_bytes);
+            legacySampleRatio(chunk.content().data(), chunk.content().size());
+            chunk.SerializeToString(&sink);
+        }
+    }
+}
+
+void sendArena(const Config& config, const std::string& source, const std::string&,
+               std::string& sink) {
+    for (size_t call = 0; call < config.chunks; call += config.chunks_per_call) {
+        google::protobuf::Arena arena(callArenaOptions());
+        auto* chunk = google::protobuf::Arena::CreateMessage<file_processor::FileChunk>(&arena);
+        for (size_t i = call; i < std::min(config.chunks, call + config.chunks_per_call); ++i) {
+            chunk->mutable_content()->assign(source.data(), config.chunk_bytes);
+            CompressionPolicy::sampleRatio(chunk->content().data(), chunk->content().size());
+            chunk->SerializeToString(&sink);
+        }
+    }
+}
+
+// Recebimento: wire é um chunk serializado com ChunkIntegrity
+void receiveNewMessage(const Config& config, const std::string&, const std::string& wire,
+                       std::string&) {
+    for (size_t i = 0; i < config.chunks; ++i) {
+        file_processor::FileChunk chunk;
+        chunk.ParseFromString(wire);
+    }
+}
+
+void receiveReused(const Config& config, const std::string&, const std::string& wire,
+                   std::string&) {
+    for (size_t call = 0; call < config.chunks; call += config.chunks_per_call) {
+        file_processor::FileChunk chunk;
+        for (size_t i = call; i < std::min(config.chunks, call + config.chunks_per_call); ++i) {
+            chunk.ParseFromString(wire);
+        }
+    }
+}
+
+void receiveArena(const Config& config, const std::string&, const std::string& wire,
+                  std::string&) {
+    for (size_t call = 0; call < config.chunks; call += config.chunks_per_call) {
+        google::protobuf::Arena arena(callArenaOptions());
+        auto* chunk = google::protobuf::Arena::CreateMessage<file_processor::FileChunk>(&arena);
+        for (size_t i = call; i < std::min(config.chunks, call + config.chunks_per_call); ++i) {
+            chunk->ParseFromString(wire);
+        }
+    }
+}
+
+void run(const std::string& label, const Scenario& scenario, const Config& config,
+         const std::string& source, const std::string& wire) {
+    // Aquecimento (caches das threads e do pool), fora da medição
+    Config warmup = config;
+    warmup.chunks = std::min<size_t>(config.chunks, 64);
+    std::string sink;
+    scenario(warmup, source, wire, sink);
+
+    g_allocations.store(0);
+    uint64_t pool_misses = ChunkBufferPool::getInstance().stats().misses;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < config.threads; ++t) {
+        workers.emplace_back([&]() {
+            std::string thread_sink;
+            t_allocations = 0;
+            scenario(config, source, wire, thread_sink);
+            g_allocations.fetch_add(t_allocations);
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    uint64_t allocations = g_allocations.load() +
+                           (ChunkBufferPool::getInstance().stats().misses - pool_misses);
+
+    double total_chunks = static_cast<double>(config.chunks * config.threads);
+    std::cout << std::left << std::setw(22) << label << std::fixed
+              << std::setprecision(3) << " allocs/chunk=" << allocations / total_chunks
+              << std::setprecision(0) << " ns/chunk=" << seconds * 1e9 / total_chunks
+              << " (" << total_chunks * config.chunk_bytes / (1024.0 * 1024.0) / seconds
+              << " MB/s)" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    auto argument = [&](int index, size_t fallback) {
+        return argc > index ? static_cast<size_t>(std::max(1, std::atoi(argv[index])))
+                            : fallback;
+    };
+    Config config;
+    config.chunks = argument(1, config.chunks);
+    config.chunk_bytes = argument(2, config.chunk_bytes / 1024) * 1024;
+    config.threads = argument(3, config.threads);
+    config.chunks_per_call = argument(4, config.chunks_per_call);
+
+    std::string source = makeSource(config.chunk_bytes);
+    file_processor::FileChunk received;
+    received.set_content(source);
+    received.mutable_integrity()->set_offset(0);
+    received.mutable_integrity()->set_crc32(static_cast<uint32_t>(
+        crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(source.data()),
+              static_cast<uInt>(source.size()))));
+    std::string wire;
+    received.SerializeToString(&wire);
+
+    std::cout << config.threads << " threads x " << config.chunks << " chunks of "
+              << config.chunk_bytes / 1024 << " KB, " << config.chunks_per_call
+              << " chunks per call" << std::endl;
+
+    run("send/new-message", sendNewMessage, config, source, wire);
+    run("send/reused", sendReused, config, source, wire);
+    run("send/arena+pool", sendArena, config, source, wire);
+    run("receive/new-message", receiveNewMessage, config, source, wire);
+    run("receive/reused", receiveReused, config, source, wire);
+    run("receive/arena", receiveArena, config, source, wire);
+    return 0;
+}
@@ -0,0 +1,245 @@
+// Benchmark de latência por requisição: ImageMagick (subprocesso) vs engine in-process
+//
+// Uso: image_engine_bench [imagem_entrada] [iteracoes] [LxA] [threads]
+// Sem imagem de entrada, um JPEG sintético de 1920x1080 é gerado.
+// Também mede só a reamostragem (sem decode/encode) por filtro, nos
+// caminhos escalar e SIMD, com as faixas distribuídas em `threads` workers.
+// Para JPEG, compara o decode completo com o reduzido na IDCT (latência e
+// memória de pixels por requisição); use um destino ao menos 2x menor.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "file_processor_utils.h"
+#include "image_engine.h"
+#include "image_resampler.h"
+#include "work_stealing_executor.h"
+
+namespace {
+
+struct LatencyStats {
+    double mean_ms = 0.0;
+    double p50_ms = 0.0;
+    double p95_ms = 0.0;
+};
+
+LatencyStats summarize(std::vector<double> samples) {
+    LatencyStats stats;
+    if (samples.empty()) {
+        return stats;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    double total = 0.0;
+    for (double sample : samples) {
+        total += sample;
+    }
+
+    stats.mean_ms = total / samples.size();
+    stats.p50_ms = samples[samples.size() / 2];
+    stats.p95_ms = samples[std::min(samples.size() - 1, samples.size() * 95 / 100)];
+    return stats;
+}
+
+void printStats(const std::string& label, const LatencyStats& stats) {
+    std::cout << std::left << std::setw(18) << label
+              << std::fixed << std::setprecision(2)
+              << " mean=" << stats.mean_ms << "ms"
+              << " p50=" << stats.p50_ms << "ms"
+              << " p95=" << stats.p95_ms << "ms" << std::endl;
+}
+
+// Gradiente sintético codificado como JPEG
+bool makeSyntheticInput(std::string& output) {
+    Image image;
+    image.width = 1920;
+    image.height = 1080;
+    image.channels = 3;
+    image.pixels.resize(static_cast<size_t>(image.width) * image.height * 3);
+
+    for (int y = 0; y < image.height; ++y) {
+        for (int x = 0; x < image.width; ++x) {
+            uint8_t* pixel = &image.pixels[(static_cast<size_t>(y) * image.width + x) * 3];
+            pixel[0] = static_cast<uint8_t>(x * 255 / image.width);
+            pixel[1] = static_cast<uint8_t>(y * 255 / image.height);
+            pixel[2] = static_cast<uint8_t>((x ^ y) & 0xFF);
+        }
+    }
+
+    std::string error;
+    return ImageEngine::encode(image, ImageFormat::JPEG, output, error);
+}
+
+// Buffers de pixels vivos em uma requisição: imagem decodificada,
+// intermediário da passada horizontal e imagem final
+size_t pixelBytesPerRequest(const std::string& input, int width, int height,
+                            bool scaled_decode) {
+    Image decoded;
+    std::string error;
+    if (!ImageEngine::decode(input, decoded, error, scaled_decode ? width : 0,
+                             scaled_decode ? height : 0)) {
+        return 0;
+    }
+    size_t channels = static_cast<size_t>(decoded.channels);
+    return decoded.pixels.size() +
+           static_cast<size_t>(width) * decoded.height * channels +
+           static_cast<size_t>(width) * height * channels;
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string input_path = argc > 1 ? argv[1] : "";
+    int iterations = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+    int width = 800;
+    int height = 600;
+    if (argc > 3) {
+        std::sscanf(argv[3], "%dx%d", &width, &height);
+    }
+    size_t threads = argc > 4 ? static_cast<size_t>(std::max(1, std::atoi(argv[4]))) : 1;
+
+    if (!ImageEngine::isAvailable()) {
+        std::cerr << "Image engine was built without codecs" << std::endl;
+        return 1;
+    }
+
+    std::string input;
+    if (input_path.empty()) {
+        if (!makeSyntheticInput(input)) {
+            std::cerr << "Failed to build synthetic input" << std::endl;
+            return 1;
+        }
+        input_path = "synthetic 1920x1080 JPEG";
+    } else if (!FileProcessorUtils::readFile(input_path, input)) {
+        std::cerr << "Failed to read " << input_path << std::endl;
+        return 1;
+    }
+
+    std::cout << "Input: " << input_path << " (" << input.size() << " bytes)"
+              << ", target " << width << "x" << height
+              << ", " << iterations << " iterations, " << threads << " threads"
+              << ", SIMD " << ImageResampler::instructionSet() << std::endl;
+
+    // Caminho antigo: arquivo temporário + convert -resize WxH!
+    std::vector<double> subprocess_samples;
+    std::string temp_input = FileProcessorUtils::generateTempFileName("bench_in", ".img");
+    std::string temp_output = FileProcessorUtils::generateTempFileName("bench_out", ".jpg");
+
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        FileProcessorUtils::writeFile(temp_input, input);
+        auto result = FileProcessorUtils::executeCommand(
+            {"convert", temp_input, "-resize",
+             std::to_string(width) + "x" + std::to_string(height) + "!", temp_output});
+        std::string output;
+        FileProcessorUtils::readFile(temp_output, output);
+        double elapsed = elapsedMs(start);
+
+        if (result.exit_code != 0) {
+            std::cout << "subprocess         skipped (convert unavailable: exit "
+                      << result.exit_code << ")" << std::endl;
+            subprocess_samples.clear();
+            break;
+        }
+        subprocess_samples.push_back(elapsed);
+    }
+    FileProcessorUtils::cleanupFile(temp_input);
+    FileProcessorUtils::cleanupFile(temp_output);
+
+    WorkStealingExecutor executor(threads);
+    ResizeOptions options;
+    if (threads > 1) {
+        options.parallel_for = [&executor](size_t count,
+                                           const std::function<void(size_t)>& body) {
+            executor.parallelFor(count, body);
+        };
+    }
+
+    // Caminho novo: decode -> resize -> encode em memória, com o decode
+    // completo e com a redução na IDCT (só tem efeito em JPEG)
+    std::vector<double> engine_samples;
+    std::vector<double> full_decode_samples;
+    for (bool scaled_decode : {false, true}) {
+        options.scaled_decode = scaled_decode;
+        std::vector<double>& samples = scaled_decode ? engine_samples
+                                                     : full_decode_samples;
+        for (int i = 0; i < iterations; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            std::string output;
+            std::string error;
+            if (!ImageEngine::resizeImage(input, width, height, ImageFormat::JPEG,
+                                          output, error, options)) {
+                std::cerr << "Image engine failed: " << error << std::endl;
+                return 1;
+            }
+            samples.push_back(elapsedMs(start));
+        }
+    }
+
+    // Só a reamostragem, por filtro e caminho (escalar x SIMD)
+    Image decoded;
+    std::string error;
+    if (!ImageEngine::decode(input, decoded, error)) {
+        std::cerr << "Image engine failed: " << error << std::endl;
+        return 1;
+    }
+    const std::string simd = ImageResampler::instructionSet();
+    for (ResampleFilter filter : {ResampleFilter::BILINEAR, ResampleFilter::BICUBIC,
+                                  ResampleFilter::LANCZOS}) {
+        options.filter = filter;
+        for (bool use_simd : {false, true}) {
+            if (use_simd && simd == "scalar") {
+                continue;
+            }
+            ImageResampler::setSimdEnabled(use_simd);
+            std::vector<double> samples;
+            for (int i = 0; i < iterations; ++i) {
+                Image resized;
+                auto start = std::chrono::steady_clock::now();
+                ImageEngine::resize(decoded, width, height, resized, error, options);
+                samples.push_back(elapsedMs(start));
+            }
+            printStats(std::string(ImageResampler::filterName(filter)) + "/" +
+                       (use_simd ? simd : "scalar"), summarize(samples));
+        }
+    }
+    ImageResampler::setSimdEnabled(true);
+
+    LatencyStats engine_stats = summarize(engine_samples);
+    if (ImageEngine::detectFormat(input) == ImageFormat::JPEG) {
+        size_t full_bytes = pixelBytesPerRequest(input, width, height, false);
+        size_t scaled_bytes = pixelBytesPerRequest(input, width, height, true);
+        LatencyStats full_stats = summarize(full_decode_samples);
+        printStats("full-decode", full_stats);
+        printStats("scaled-decode", engine_stats);
+        std::cout << "pixel memory/request " << std::fixed << std::setprecision(1)
+                  << full_bytes / (1024.0 * 1024.0) << "MB -> "
+                  << scaled_bytes / (1024.0 * 1024.0) << "MB, speedup (mean) "
+                  << full_stats.mean_ms / engine_stats.mean_ms << "x" << std::endl;
+    }
+
+    if (!subprocess_samples.empty()) {
+        LatencyStats subprocess_stats = summarize(subprocess_samples);
+        printStats("subprocess", subprocess_stats);
+        printStats("in-process", engine_stats);
+        std::cout << "speedup (mean) " << std::fixed << std::setprecision(1)
+                  << subprocess_stats.mean_ms / engine_stats.mean_ms << "x"
+                  << std::endl;
+    } else {
+        printStats("in-process", engine_stats);
+    }
+
+    return 0;
+}
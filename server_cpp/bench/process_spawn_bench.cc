@@ -0,0 +1,168 @@
+// Benchmark de criação de processos: popen (sh + ferramenta, o antigo
+// executeCommand), fork+exec e posix_spawn (ProcessRunner)
+//
+// Uso: process_spawn_bench [iteracoes] [MB_residentes] [threads_ocupadas]
+// Cada método executa `true` com o processo ocioso e depois "carregado":
+// MB_residentes de memória tocada (como buffers e cache de um servidor em
+// uso) e threads_ocupadas girando na CPU. O custo de fork cresce com a
+// tabela de páginas do pai; o de posix_spawn (clone+exec) não.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "process_runner.h"
+
+namespace {
+
+struct LatencyStats {
+    double mean_ms = 0.0;
+    double p50_ms = 0.0;
+    double p95_ms = 0.0;
+};
+
+LatencyStats summarize(std::vector<double> samples) {
+    LatencyStats stats;
+    if (samples.empty()) {
+        return stats;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    double total = 0.0;
+    for (double sample : samples) {
+        total += sample;
+    }
+
+    stats.mean_ms = total / samples.size();
+    stats.p50_ms = samples[samples.size() / 2];
+    stats.p95_ms = samples[std::min(samples.size() - 1, samples.size() * 95 / 100)];
+    return stats;
+}
+
+void printStats(const std::string& label, const LatencyStats& stats) {
+    std::cout << std::left << std::setw(22) << label
+              << std::fixed << std::setprecision(3)
+              << " mean=" << stats.mean_ms << "ms"
+              << " p50=" << stats.p50_ms << "ms"
+              << " p95=" << stats.p95_ms << "ms" << std::endl;
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+// Caminho antigo: shell intermediário e leitura com fgets
+bool runPopen() {
+    FILE* pipe = popen("true 2>&1", "r");
+    if (pipe == nullptr) {
+        return false;
+    }
+    char buffer[128];
+    while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
+    }
+    return pclose(pipe) == 0;
+}
+
+bool runForkExec() {
+    pid_t pid = fork();
+    if (pid < 0) {
+        return false;
+    }
+    if (pid == 0) {
+        execlp("true", "true", static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+bool runSpawn() {
+    ProcessRunner runner;
+    return runner.run({"true"}).exit_code == 0;
+}
+
+std::vector<double> measure(const std::function<bool()>& method, int iterations) {
+    std::vector<double> samples;
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        if (!method()) {
+            std::cerr << "Process failed" << std::endl;
+            return {};
+        }
+        samples.push_back(elapsedMs(start));
+    }
+    return samples;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200;
+    size_t resident_mb = argc > 2 ? static_cast<size_t>(std::max(0, std::atoi(argv[2]))) : 1024;
+    int busy_threads = argc > 3 ? std::max(0, std::atoi(argv[3])) : 2;
+
+    const std::vector<std::pair<std::string, std::function<bool()>>> methods = {
+        {"popen", runPopen},
+        {"fork+exec", runForkExec},
+        {"posix_spawn", runSpawn},
+    };
+
+    std::cout << "Spawning `true` " << iterations << " times per method" << std::endl;
+
+    for (const auto& method : methods) {
+        printStats(method.first + "/idle", summarize(measure(method.second, iterations)));
+    }
+
+    // Carga: memória residente (páginas tocadas) e threads ocupadas
+    std::vector<char> ballast(resident_mb * 1024 * 1024);
+    for (size_t offset = 0; offset < ballast.size(); offset += 4096) {
+        ballast[offset] = static_cast<char>(offset);
+    }
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < busy_threads; ++i) {
+        workers.emplace_back([&stop]() {
+            volatile uint64_t counter = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                counter = counter + 1;
+            }
+        });
+    }
+
+    std::cout << "Loaded: " << resident_mb << "MB resident, " << busy_threads
+              << " busy threads" << std::endl;
+    std::vector<double> loaded_means;
+    for (const auto& method : methods) {
+        LatencyStats stats = summarize(measure(method.second, iterations));
+        printStats(method.first + "/loaded", stats);
+        loaded_means.push_back(stats.mean_ms);
+    }
+
+    stop.store(true);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    if (loaded_means.back() > 0.0) {
+        std::cout << std::fixed << std::setprecision(1)
+                  << "posix_spawn speedup (loaded, mean): "
+                  << loaded_means[0] / loaded_means.back() << "x vs popen, "
+                  << loaded_means[1] / loaded_means.back() << "x vs fork+exec"
+                  << std::endl;
+    }
+    return 0;
+}
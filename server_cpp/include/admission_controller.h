@@ -0,0 +1,138 @@
+#ifndef ADMISSION_CONTROLLER_H
+#define ADMISSION_CONTROLLER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+// Controle de admissão na entrada das RPCs, antes de o upload ser lido.
+// Uma requisição é recusada (RESOURCE_EXHAUSTED, com sugestão de espera)
+// quando:
+// - o servidor já tem max_jobs requisições/arquivos em andamento;
+// - o cliente (peer, sem a porta) já ocupa a parte justa dele: max_jobs
+//   dividido pelos clientes com jobs em andamento ou recusados há pouco,
+//   para que um lote grande não tome todas as vagas de quem espera;
+// - o disco temporário tem menos de min_free_disk_bytes livres;
+// - os bytes recebidos e ainda não processados passariam de
+//   max_queued_bytes (verificado pelo tamanho declarado no cabeçalho e
+//   conforme os chunks chegam), contando também parked_bytes (partes de
+//   uploads retomáveis aguardando o cliente).
+// Limites 0 desabilitam a verificação correspondente.
+class AdmissionController {
+public:
+    struct Limits {
+        size_t max_jobs = 0;
+        bool fair_share = true;
+        uint64_t max_queued_bytes = 0;
+        uint64_t min_free_disk_bytes = 0;
+        std::string disk_path;
+        std::chrono::milliseconds retry_after{1000};
+        // Bytes em disco fora das requisições, somados aos bytes na fila
+        std::function<uint64_t()> parked_bytes;
+    };
+
+    enum class Reason { CAPACITY, PEER_SHARE, QUEUED_BYTES, DISK, COUNT };
+
+    // Vaga de uma requisição admitida, devolvida em release() ou no destrutor
+    class Ticket {
+    public:
+        Ticket() = default;
+        ~Ticket() { release(); }
+
+        Ticket(const Ticket&) = delete;
+        Ticket& operator=(const Ticket&) = delete;
+
+        bool admitted() const { return controller_ != nullptr; }
+        const std::string& peer() const { return peer_; }
+
+        // Espera sugerida ao cliente após uma recusa
+        std::chrono::milliseconds retryAfter() const { return retry_after_; }
+
+        // Reservar ao menos bytes (tamanho declarado ou já recebido); false
+        // + mensagem se a reserva passaria do limite de bytes na fila
+        bool reserveBytes(uint64_t bytes, std::string& error_message);
+
+        // Uso de um stream de lote: arquivos em andamento e bytes na fila
+        // (só contabiliza; o lote se limita por jobAllowance/bytesAvailable)
+        void setUsage(size_t jobs, uint64_t bytes);
+
+        // Jobs que este ticket pode ocupar pela capacidade e pela parte
+        // justa do cliente (ao menos 1)
+        size_t jobAllowance() const;
+
+        // Ainda há espaço no limite de bytes na fila
+        bool bytesAvailable() const;
+
+        void release();
+
+    private:
+        friend class AdmissionController;
+
+        AdmissionController* controller_ = nullptr;
+        std::string peer_;
+        size_t jobs_ = 0;
+        uint64_t bytes_ = 0;
+        std::chrono::milliseconds retry_after_{0};
+    };
+
+    explicit AdmissionController(const Limits& limits);
+
+    AdmissionController(const AdmissionController&) = delete;
+    AdmissionController& operator=(const AdmissionController&) = delete;
+
+    // Admitir uma requisição de peer (endereço do gRPC); false + mensagem
+    // (e ticket.retryAfter()) quando recusada
+    bool admit(const std::string& peer, Ticket& ticket, std::string& error_message);
+
+    // Identificação do cliente: "ipv4:10.0.0.1:5123" -> "ipv4:10.0.0.1"
+    static std::string peerKey(const std::string& peer);
+
+    static const char* reasonName(Reason reason);
+
+    const Limits& limits() const { return limits_; }
+    size_t activeJobs() const;
+    uint64_t queuedBytes() const;
+    size_t activePeers() const;
+    uint64_t rejections(Reason reason) const {
+        return rejections_[static_cast<size_t>(reason)].load(std::memory_order_relaxed);
+    }
+
+private:
+    struct PeerState {
+        size_t jobs = 0;
+        // Última recusa: o cliente ainda disputa vagas por um tempo
+        std::chrono::steady_clock::time_point rejected_at;
+    };
+
+    // Parte justa de jobs de um cliente (com o mutex)
+    size_t fairShareLocked(const std::string& peer,
+                           std::chrono::steady_clock::time_point now);
+
+    // Espaço livre do disco temporário, consultado no máximo a cada segundo
+    uint64_t freeDiskLocked(std::chrono::steady_clock::time_point now);
+
+    void reject(Reason reason, const std::string& peer, Ticket& ticket,
+                std::chrono::steady_clock::time_point now);
+    void releaseTicket(Ticket& ticket);
+
+    uint64_t parkedBytes() const;
+
+    Limits limits_;
+
+    mutable std::mutex mutex_;
+    size_t jobs_;
+    uint64_t bytes_;
+    std::map<std::string, PeerState> peers_;
+    uint64_t free_disk_bytes_;
+    std::chrono::steady_clock::time_point disk_checked_at_;
+    bool disk_checked_;
+
+    std::atomic<uint64_t> rejections_[static_cast<size_t>(Reason::COUNT)];
+};
+
+#endif // ADMISSION_CONTROLLER_H
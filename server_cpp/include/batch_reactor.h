@@ -0,0 +1,169 @@
+#ifndef BATCH_REACTOR_H
+#define BATCH_REACTOR_H
+
+#include <grpcpp/grpcpp.h>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "file_processor.grpc.pb.h"
+#include "admission_controller.h"
+#include "call_arena.h"
+#include "chunk_sizer.h"
+#include "compression_policy.h"
+#include "content_hash.h"
+#include "job_context.h"
+#include "logger.h"
+#include "metrics.h"
+#include "operation_limiter.h"
+#include "transfer_buffer.h"
+
+// Operação resolvida a partir do cabeçalho de um arquivo do lote
+struct BatchOperation {
+    std::string service_name;
+    OperationLimiter* limiter = nullptr;
+    std::string cache_parameters;
+    std::function<grpc::Status(TransferBuffer& input, TransferBuffer& output)> handler;
+};
+
+// Reactor da RPC ProcessBatch: recebe vários arquivos multiplexados no
+// mesmo stream, envia cada arquivo completo ao limiter da sua operação e
+// devolve os resultados na ordem em que ficam prontos, marcados pelo id.
+// Com max_in_flight arquivos abertos, aguardando processamento ou envio, a
+// leitura é pausada (o controle de fluxo do HTTP/2 segura o cliente); um
+// arquivo novo com o limite de arquivos abertos (sem end_of_file) atingido
+// encerra o lote com RESOURCE_EXHAUSTED. A compressão é decidida por
+// arquivo (CompressionPolicy) e o total do lote vai no trailing metadata
+// "fp-compression". O stream passa pelo AdmissionController ao abrir e,
+// depois, conta os arquivos abertos e em andamento e os bytes na fila como
+// uso do cliente: a leitura também pausa além da parte justa dele (que
+// também limita os arquivos abertos) ou com o limite de bytes do servidor
+// atingido; sem arquivos em processamento que a retomem, o lote é
+// recusado. Os arquivos entram na fila dos limiters com o prazo e a
+// prioridade da chamada (JobContext); cancelada ou expirada, os que
+// aguardam são descartados e os que rodam têm a ferramenta externa
+// interrompida.
+class BatchReactor
+    : public grpc::ServerBidiReactor<file_processor::BatchRequest,
+                                     file_processor::BatchResponse> {
+public:
+    // false + mensagem para cabeçalho inválido (operação ou parâmetros)
+    using Resolver = std::function<bool(const file_processor::BatchFileHeader& header,
+                                        BatchOperation& operation,
+                                        std::string& error_message)>;
+
+    BatchReactor(grpc::CallbackServerContext* context, Resolver resolver,
+                 size_t max_in_flight, AdmissionController& admission);
+
+    void OnReadDone(bool ok) override;
+    void OnWriteDone(bool ok) override;
+    void OnDone() override;
+    void OnCancel() override;
+
+private:
+    struct BatchFile {
+        uint64_t id = 0;
+        std::string file_name;
+        BatchOperation operation;
+        TransferBuffer input;
+        TransferBuffer output;
+        ContentHasher hasher;
+        std::string cache_key;
+        grpc::Status status;
+        size_t bytes_sent = 0;
+        CompressionPolicy compression;
+
+        // Métricas da operação e início das fases receive/send
+        OperationMetrics* metrics = nullptr;
+        std::chrono::steady_clock::time_point received_at;
+        std::chrono::steady_clock::time_point send_started_at;
+
+        BatchFile(size_t spill_threshold,
+                  const std::shared_ptr<ScratchSpace::Quota>& scratch_quota,
+                  bool compression_enabled, size_t compression_min_savings_percent)
+            : input(spill_threshold, scratch_quota), output(spill_threshold, scratch_quota),
+              compression(compression_enabled, compression_min_savings_percent) {}
+    };
+
+    // Tratar uma mensagem recebida; false encerra a leitura do lote
+    bool handleRequest(const file_processor::BatchRequest& request);
+
+    // Fim da leitura: arquivos ainda abertos vão com erro para o envio
+    void closeUploads();
+
+    // Resultado descartado sem envio (stream falhou)
+    static void discardFile(BatchFile* file);
+
+    // Arquivo enviado ou descartado sai da contagem do lote (com o mutex)
+    void releaseFile(BatchFile* file);
+
+    // Arquivo completo: cache, depois processamento no limiter
+    void processFile(std::unique_ptr<BatchFile> file);
+    void runFile(BatchFile* file);
+
+    // Status dos arquivos de uma chamada abandonada
+    grpc::Status abandonedStatus(const std::string& when) const;
+    void completeFile(BatchFile* file, const grpc::Status& status);
+
+    // Preencher write_response_ com o próximo pedaço do arquivo atual;
+    // false quando não há nada pronto para enviar
+    bool prepareNextWrite();
+
+    // Decidir, sob o mutex, a próxima leitura/escrita/finalização e
+    // executá-la fora dele
+    void advance();
+
+    grpc::CallbackServerContext* context_;
+    std::shared_ptr<JobContext> job_;
+    Resolver resolver_;
+    size_t max_in_flight_;
+    Logger& logger_;
+    size_t spill_threshold_;
+    // Cota de disco temporário do lote, compartilhada pelos arquivos
+    std::shared_ptr<ScratchSpace::Quota> scratch_quota_;
+
+    // Mensagens do stream, na arena da chamada
+    google::protobuf::Arena arena_;
+    file_processor::BatchRequest* read_request_;
+    file_processor::BatchResponse* write_response_;
+    grpc::WriteOptions write_options_;
+
+    // Tamanho dos chunks ajustado pela vazão de todo o stream
+    AdaptiveChunkSizer chunk_sizer_;
+    size_t write_length_;
+    std::chrono::steady_clock::time_point write_started_at_;
+    bool metadata_sent_;
+    CompressionPolicy compression_totals_;
+
+    // Vaga no controle de admissão e bytes recebidos ainda não enviados
+    AdmissionController::Ticket admission_;
+    uint64_t queued_bytes_;
+
+    std::mutex mutex_;
+    // Arquivos ainda em upload; alterado só pelos callbacks de leitura, com
+    // o mutex (o tamanho conta no uso do lote)
+    std::map<uint64_t, std::unique_ptr<BatchFile>> uploads_;
+    // Arquivos completos ainda não enviados (processando ou na fila de envio);
+    // indexados pelo ponteiro, já que um id pode ser reutilizado pelo cliente
+    std::map<BatchFile*, std::unique_ptr<BatchFile>> in_flight_;
+    std::deque<BatchFile*> ready_;
+    BatchFile* sending_;
+
+    bool reading_;
+    bool reads_done_;
+    bool writing_;
+    bool finished_;
+    bool stream_failed_;
+    grpc::Status final_status_;
+
+    size_t files_completed_;
+    size_t files_failed_;
+};
+
+#endif // BATCH_REACTOR_H
@@ -0,0 +1,23 @@
+#ifndef CALL_ARENA_H
+#define CALL_ARENA_H
+
+#include <google/protobuf/arena.h>
+
+#include "chunk_buffer_pool.h"
+
+// Arena de protobuf de uma chamada: as mensagens do stream e as
+// submensagens de cada chunk (ChunkIntegrity, cabeçalhos) são alocadas por
+// incremento em blocos emprestados do ChunkBufferPool, devolvidos juntos
+// quando o reactor é destruído. Submensagens substituídas a cada leitura
+// só são liberadas no fim (~32 bytes por chunk com integrity); os buffers
+// de content são std::string comuns, reaproveitados pela mensagem.
+inline google::protobuf::ArenaOptions callArenaOptions() {
+    google::protobuf::ArenaOptions options;
+    options.start_block_size = ChunkBufferPool::kMinClassBytes;
+    options.max_block_size = 64 * 1024;
+    options.block_alloc = &ChunkBufferPool::allocateBlock;
+    options.block_dealloc = &ChunkBufferPool::deallocateBlock;
+    return options;
+}
+
+#endif // CALL_ARENA_H
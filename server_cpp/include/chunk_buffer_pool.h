@@ -0,0 +1,119 @@
+#ifndef CHUNK_BUFFER_POOL_H
+#define CHUNK_BUFFER_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Pool de buffers por classe de tamanho (potências de 2, de 4KB a 4MB) para
+// o caminho dos chunks: buffers de leitura e blocos das arenas de protobuf
+// das chamadas. Cada thread guarda, sem lock, alguns buffers livres das
+// classes de até 512KB; o excedente (e as classes maiores) vai para listas
+// compartilhadas, limitadas a max_pooled_bytes, e o que não cabe volta ao
+// alocador. Pedidos acima da maior classe vão direto ao malloc. Um buffer
+// pode ser devolvido por outra thread.
+class ChunkBufferPool {
+public:
+    static constexpr size_t kMinClassBytes = 4 * 1024;
+    static constexpr size_t kMaxClassBytes = 4 * 1024 * 1024;
+    static constexpr size_t kClassCount = 11;
+
+    // Buffer emprestado do pool; devolvido no destrutor
+    class Buffer {
+    public:
+        Buffer() : data_(nullptr), size_(0) {}
+        Buffer(char* data, size_t size) : data_(data), size_(size) {}
+        ~Buffer() { reset(); }
+
+        Buffer(Buffer&& other) noexcept : data_(other.data_), size_(other.size_) {
+            other.data_ = nullptr;
+            other.size_ = 0;
+        }
+        Buffer& operator=(Buffer&& other) noexcept {
+            if (this != &other) {
+                reset();
+                data_ = other.data_;
+                size_ = other.size_;
+                other.data_ = nullptr;
+                other.size_ = 0;
+            }
+            return *this;
+        }
+
+        Buffer(const Buffer&) = delete;
+        Buffer& operator=(const Buffer&) = delete;
+
+        char* data() const { return data_; }
+        // Tamanho pedido (a capacidade real é a da classe)
+        size_t size() const { return size_; }
+
+        void reset();
+
+    private:
+        char* data_;
+        size_t size_;
+    };
+
+    // O cache da thread não mantém contadores (seria um ponto de disputa);
+    // só os caminhos mais lentos são contados
+    struct Stats {
+        // Pedidos atendidos pelas listas compartilhadas e pelo alocador
+        uint64_t shared_hits = 0;
+        uint64_t misses = 0;
+        // Bytes livres nas listas compartilhadas
+        size_t pooled_bytes = 0;
+    };
+
+    // Nunca destruído: threads do gRPC ainda terminando após o fim do main
+    // devolvem os caches delas ao pool
+    static ChunkBufferPool& getInstance() {
+        static ChunkBufferPool* instance = new ChunkBufferPool();
+        return *instance;
+    }
+
+    ChunkBufferPool(const ChunkBufferPool&) = delete;
+    ChunkBufferPool& operator=(const ChunkBufferPool&) = delete;
+
+    // Limite das listas compartilhadas (0 = só os caches das threads)
+    void setMaxPooledBytes(size_t bytes);
+
+    Buffer acquire(size_t size);
+
+    // Interface de malloc/free com o tamanho na devolução
+    void* allocate(size_t size);
+    void deallocate(void* data, size_t size);
+
+    // Funções livres para ArenaOptions::block_alloc/block_dealloc
+    static void* allocateBlock(size_t size) { return getInstance().allocate(size); }
+    static void deallocateBlock(void* data, size_t size) {
+        getInstance().deallocate(data, size);
+    }
+
+    Stats stats() const;
+
+private:
+    ChunkBufferPool() : max_pooled_bytes_(32 * 1024 * 1024), pooled_bytes_(0) {}
+
+    struct ThreadCache;
+    static ThreadCache& threadCache();
+
+    // Índice da classe de size (kClassCount se acima da maior)
+    static size_t classIndex(size_t size);
+    static size_t classBytes(size_t index) { return kMinClassBytes << index; }
+
+    // Listas compartilhadas (chamadas pelos caches das threads)
+    char* takeShared(size_t index);
+    void giveShared(size_t index, char* data);
+
+    std::atomic<size_t> max_pooled_bytes_;
+    mutable std::mutex mutex_;
+    std::vector<char*> shared_[kClassCount];
+    size_t pooled_bytes_;
+
+    std::atomic<uint64_t> shared_hits_{0};
+    std::atomic<uint64_t> misses_{0};
+};
+
+#endif // CHUNK_BUFFER_POOL_H
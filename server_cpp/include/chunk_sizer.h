@@ -0,0 +1,74 @@
+#ifndef CHUNK_SIZER_H
+#define CHUNK_SIZER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Tamanho dos chunks de um stream. Começa proporcional ao arquivo (cerca de
+// 16 chunks, para que arquivos pequenos não esperem um chunk enorme) e,
+// a cada envio, mira em ~kTargetInterval de transmissão pela vazão medida:
+// enlace rápido leva a chunks maiores, que diluem o custo por mensagem;
+// enlace lento volta a chunks menores, que mantêm o controle de fluxo e o
+// cancelamento responsivos. Potências de 2 entre os limites, no máximo
+// dobrando ou reduzindo à metade por passo.
+class AdaptiveChunkSizer {
+public:
+    static constexpr std::chrono::milliseconds kTargetInterval{20};
+
+    AdaptiveChunkSizer(size_t min_bytes, size_t max_bytes, uint64_t total_bytes = 0)
+        : min_bytes_(min_bytes),
+          max_bytes_(std::max(min_bytes, max_bytes)),
+          chunk_bytes_(clamp(floorPowerOfTwo(total_bytes / 16))),
+          recent_bytes_(0.0),
+          recent_seconds_(0.0),
+          bytes_per_second_(0.0) {}
+
+    size_t next() const { return chunk_bytes_; }
+
+    // Vazão estimada (bytes/s); 0 antes do primeiro chunk
+    double bytesPerSecond() const { return bytes_per_second_; }
+
+    // Registrar um chunk: bytes e tempo até a escrita ser concluída
+    void record(size_t bytes, std::chrono::steady_clock::duration elapsed) {
+        if (min_bytes_ == max_bytes_ || bytes == 0) {
+            return;
+        }
+        // Bytes e tempo com decaimento: um Write que retornou na hora
+        // (buffer do transporte) não domina a estimativa
+        recent_bytes_ = 0.7 * recent_bytes_ + static_cast<double>(bytes);
+        recent_seconds_ = 0.7 * recent_seconds_ +
+                          std::chrono::duration<double>(elapsed).count();
+        bytes_per_second_ = recent_bytes_ / std::max(recent_seconds_, 1e-6);
+
+        double target = bytes_per_second_ *
+            std::chrono::duration<double>(kTargetInterval).count();
+        size_t wanted = floorPowerOfTwo(static_cast<uint64_t>(
+            std::min(target, static_cast<double>(max_bytes_))));
+        wanted = std::min(std::max(wanted, chunk_bytes_ / 2), chunk_bytes_ * 2);
+        chunk_bytes_ = clamp(wanted);
+    }
+
+private:
+    static size_t floorPowerOfTwo(uint64_t value) {
+        size_t result = 1;
+        while (result <= value / 2) {
+            result *= 2;
+        }
+        return result;
+    }
+
+    size_t clamp(size_t value) const {
+        return std::min(std::max(value, min_bytes_), max_bytes_);
+    }
+
+    size_t min_bytes_;
+    size_t max_bytes_;
+    size_t chunk_bytes_;
+    double recent_bytes_;
+    double recent_seconds_;
+    double bytes_per_second_;
+};
+
+#endif // CHUNK_SIZER_H
@@ -0,0 +1,169 @@
+#ifndef COMPRESSION_POLICY_H
+#define COMPRESSION_POLICY_H
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Compressão das respostas de um stream (gzip/deflate do gRPC, negociado
+// com o cliente pelo nível de compressão da chamada). Saídas que já chegam
+// comprimidas (JPEG, PNG, PDF..., reconhecidas pelo início do primeiro
+// chunk) vão inteiras sem compressão; nas demais, o início de cada chunk é
+// comprimido com deflate rápido para estimar a razão, e chunks que não
+// economizam o mínimo configurado também vão sem compressão
+// (WriteOptions::set_no_compression).
+class CompressionPolicy {
+public:
+    // Amostra comprimida por chunk
+    static constexpr size_t kSampleBytes = 16 * 1024;
+
+    // Assinatura de um formato já comprimido (imagens, PDF, arquivos)
+    static bool looksCompressed(const char* data, size_t size) {
+        static const std::string kSignatures[] = {
+            std::string("\xFF\xD8\xFF", 3),         // JPEG
+            std::string("\x89PNG", 4),              // PNG
+            std::string("%PDF", 4),                 // PDF
+            std::string("GIF8", 4),                 // GIF
+            std::string("\x00\x00\x00\x0CjP  ", 8), // JPEG 2000
+            std::string("PK\x03\x04", 4),           // ZIP
+            std::string("\x1F\x8B", 2),             // gzip
+            std::string("BZh", 3),                  // bzip2
+            std::string("\xFD" "7zXZ", 5),          // xz
+            std::string("\x28\xB5\x2F\xFD", 4),     // zstd
+        };
+        for (const std::string& signature : kSignatures) {
+            if (size >= signature.size() &&
+                std::memcmp(data, signature.data(), signature.size()) == 0) {
+                return true;
+            }
+        }
+        // WebP: RIFF....WEBP
+        return size >= 12 && std::memcmp(data, "RIFF", 4) == 0 &&
+               std::memcmp(data + 8, "WEBP", 4) == 0;
+    }
+
+    // Razão comprimido/original do início dos dados (1.0 quando não há ganho).
+    // O estado do deflate (~270KB) e o buffer de saída são da thread e
+    // reiniciados a cada amostra, em vez de alocados por chunk (compress2)
+    static double sampleRatio(const char* data, size_t size) {
+        size_t sample = std::min(size, kSampleBytes);
+        if (sample == 0) {
+            return 1.0;
+        }
+        thread_local SampleDeflater deflater;
+        size_t compressed_size = 0;
+        if (!deflater.compress(data, sample, compressed_size)) {
+            return 1.0;
+        }
+        return std::min(1.0, static_cast<double>(compressed_size) /
+                             static_cast<double>(sample));
+    }
+
+    CompressionPolicy(bool enabled, size_t min_savings_percent)
+        : enabled_(enabled),
+          max_ratio_(1.0 - static_cast<double>(std::min<size_t>(min_savings_percent, 100)) /
+                           100.0),
+          format_checked_(false),
+          compressed_bytes_(0),
+          estimated_bytes_(0),
+          uncompressed_bytes_(0) {}
+
+    // Compressão habilitada na chamada (antes da primeira escrita)
+    bool enabled() const { return enabled_; }
+
+    // Comprimir este chunk? Os chunks devem vir em ordem (o primeiro define
+    // o formato); registra o resultado nas estatísticas
+    bool compressChunk(const char* data, size_t size) {
+        if (enabled_ && !format_checked_ && size > 0) {
+            format_checked_ = true;
+            if (looksCompressed(data, size)) {
+                enabled_ = false;
+            }
+        }
+        if (!enabled_ || size == 0) {
+            uncompressed_bytes_ += size;
+            return false;
+        }
+        double ratio = sampleRatio(data, size);
+        if (ratio > max_ratio_) {
+            uncompressed_bytes_ += size;
+            return false;
+        }
+        compressed_bytes_ += size;
+        estimated_bytes_ += static_cast<uint64_t>(static_cast<double>(size) * ratio);
+        return true;
+    }
+
+    // Bytes enviados comprimidos (antes da compressão) e o tamanho estimado
+    // deles no fio, pela razão das amostras
+    uint64_t compressedBytes() const { return compressed_bytes_; }
+    uint64_t estimatedBytes() const { return estimated_bytes_; }
+    uint64_t uncompressedBytes() const { return uncompressed_bytes_; }
+
+    // Somar as estatísticas de outro stream (totais de um lote)
+    void add(const CompressionPolicy& other) {
+        compressed_bytes_ += other.compressed_bytes_;
+        estimated_bytes_ += other.estimated_bytes_;
+        uncompressed_bytes_ += other.uncompressed_bytes_;
+    }
+
+    // "compressed=N;estimated=M;uncompressed=K", para log e trailing metadata
+    std::string summary() const {
+        return "compressed=" + std::to_string(compressed_bytes_) +
+               ";estimated=" + std::to_string(estimated_bytes_) +
+               ";uncompressed=" + std::to_string(uncompressed_bytes_);
+    }
+
+private:
+    // Deflate rápido reaproveitado (mesmos parâmetros de compress2 com
+    // Z_BEST_SPEED)
+    class SampleDeflater {
+    public:
+        SampleDeflater() : ready_(false), output_(compressBound(kSampleBytes)) {
+            std::memset(&stream_, 0, sizeof(stream_));
+            ready_ = deflateInit(&stream_, Z_BEST_SPEED) == Z_OK;
+        }
+        ~SampleDeflater() {
+            if (ready_) {
+                deflateEnd(&stream_);
+            }
+        }
+
+        SampleDeflater(const SampleDeflater&) = delete;
+        SampleDeflater& operator=(const SampleDeflater&) = delete;
+
+        bool compress(const char* data, size_t size, size_t& compressed_size) {
+            if (!ready_ || deflateReset(&stream_) != Z_OK) {
+                return false;
+            }
+            stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+            stream_.avail_in = static_cast<uInt>(size);
+            stream_.next_out = output_.data();
+            stream_.avail_out = static_cast<uInt>(output_.size());
+            if (deflate(&stream_, Z_FINISH) != Z_STREAM_END) {
+                return false;
+            }
+            compressed_size = static_cast<size_t>(stream_.total_out);
+            return true;
+        }
+
+    private:
+        z_stream stream_;
+        bool ready_;
+        std::vector<Bytef> output_;
+    };
+
+    bool enabled_;
+    double max_ratio_;
+    bool format_checked_;
+    uint64_t compressed_bytes_;
+    uint64_t estimated_bytes_;
+    uint64_t uncompressed_bytes_;
+};
+
+#endif // COMPRESSION_POLICY_H
@@ -0,0 +1,164 @@
+#ifndef CONTENT_HASH_H
+#define CONTENT_HASH_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+// Hash incremental de 64 bits (algoritmo XXH64), alimentado chunk a chunk
+// enquanto o arquivo chega; usado como chave do cache de resultados
+class ContentHasher {
+public:
+    explicit ContentHasher(uint64_t seed = 0) {
+        reset(seed);
+    }
+
+    void reset(uint64_t seed = 0) {
+        seed_ = seed;
+        v1_ = seed + kPrime1 + kPrime2;
+        v2_ = seed + kPrime2;
+        v3_ = seed;
+        v4_ = seed - kPrime1;
+        total_length_ = 0;
+        buffer_size_ = 0;
+    }
+
+    void update(const void* data, size_t length) {
+        const uint8_t* input = static_cast<const uint8_t*>(data);
+        const uint8_t* end = input + length;
+        total_length_ += length;
+
+        // Completar o bloco de 32 bytes pendente
+        if (buffer_size_ + length < 32) {
+            std::memcpy(buffer_ + buffer_size_, input, length);
+            buffer_size_ += length;
+            return;
+        }
+        if (buffer_size_ > 0) {
+            size_t fill = 32 - buffer_size_;
+            std::memcpy(buffer_ + buffer_size_, input, fill);
+            consumeBlock(buffer_);
+            input += fill;
+            buffer_size_ = 0;
+        }
+
+        while (input + 32 <= end) {
+            consumeBlock(input);
+            input += 32;
+        }
+
+        buffer_size_ = static_cast<size_t>(end - input);
+        std::memcpy(buffer_, input, buffer_size_);
+    }
+
+    uint64_t digest() const {
+        uint64_t hash;
+        if (total_length_ >= 32) {
+            hash = rotl(v1_, 1) + rotl(v2_, 7) + rotl(v3_, 12) + rotl(v4_, 18);
+            hash = mergeRound(hash, v1_);
+            hash = mergeRound(hash, v2_);
+            hash = mergeRound(hash, v3_);
+            hash = mergeRound(hash, v4_);
+        } else {
+            hash = seed_ + kPrime5;
+        }
+        hash += total_length_;
+
+        const uint8_t* p = buffer_;
+        const uint8_t* end = buffer_ + buffer_size_;
+        while (p + 8 <= end) {
+            hash ^= round(0, read64(p));
+            hash = rotl(hash, 27) * kPrime1 + kPrime4;
+            p += 8;
+        }
+        if (p + 4 <= end) {
+            hash ^= static_cast<uint64_t>(read32(p)) * kPrime1;
+            hash = rotl(hash, 23) * kPrime2 + kPrime3;
+            p += 4;
+        }
+        while (p < end) {
+            hash ^= static_cast<uint64_t>(*p) * kPrime5;
+            hash = rotl(hash, 11) * kPrime1;
+            ++p;
+        }
+
+        hash ^= hash >> 33;
+        hash *= kPrime2;
+        hash ^= hash >> 29;
+        hash *= kPrime3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+    uint64_t totalLength() const { return total_length_; }
+
+    static uint64_t hash(const void* data, size_t length, uint64_t seed = 0) {
+        ContentHasher hasher(seed);
+        hasher.update(data, length);
+        return hasher.digest();
+    }
+
+    static std::string toHex(uint64_t value) {
+        static const char digits[] = "0123456789abcdef";
+        std::string hex(16, '0');
+        for (int i = 15; i >= 0; --i) {
+            hex[i] = digits[value & 0xF];
+            value >>= 4;
+        }
+        return hex;
+    }
+
+private:
+    static constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+    static constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+    static constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+    static constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+    static constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+    static uint64_t rotl(uint64_t value, int bits) {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    static uint64_t round(uint64_t acc, uint64_t input) {
+        acc += input * kPrime2;
+        acc = rotl(acc, 31);
+        return acc * kPrime1;
+    }
+
+    static uint64_t mergeRound(uint64_t acc, uint64_t value) {
+        acc ^= round(0, value);
+        return acc * kPrime1 + kPrime4;
+    }
+
+    // Leitura little-endian (x86/ARM)
+    static uint64_t read64(const uint8_t* p) {
+        uint64_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    static uint32_t read32(const uint8_t* p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    void consumeBlock(const uint8_t* block) {
+        v1_ = round(v1_, read64(block));
+        v2_ = round(v2_, read64(block + 8));
+        v3_ = round(v3_, read64(block + 16));
+        v4_ = round(v4_, read64(block + 24));
+    }
+
+    uint64_t seed_;
+    uint64_t v1_;
+    uint64_t v2_;
+    uint64_t v3_;
+    uint64_t v4_;
+    uint64_t total_length_;
+    uint8_t buffer_[32];
+    size_t buffer_size_;
+};
+
+#endif // CONTENT_HASH_H
@@ -5,51 +5,144 @@
 #include "file_processor.grpc.pb.h"
 #include "logger.h"
 #include "file_processor_utils.h"
+#include "image_engine.h"
+#include "transfer_buffer.h"
+#include "work_stealing_executor.h"
+#include "operation_limiter.h"
+#include "admission_controller.h"
+#include "file_transfer_reactor.h"
+#include "batch_reactor.h"
+#include "ghostscript_pool.h"
+#include "pdf_sharder.h"
+#include "pdf_text_engine.h"
+#include <map>
+#include <memory>
+#include <vector>
 
-class FileProcessorServiceImpl final 
-    : public file_processor::FileProcessorService::Service {
+// Serviço na API callback: as threads do gRPC só movimentam chunks, as
+// conversões rodam no executor com limite de concorrência por operação
+class FileProcessorServiceImpl final
+    : public file_processor::FileProcessorService::CallbackService {
 public:
+    using FileReactor = grpc::ServerBidiReactor<file_processor::FileChunk,
+                                                file_processor::FileChunk>;
+
     FileProcessorServiceImpl();
     ~FileProcessorServiceImpl();
 
     // Compressão de PDF
-    grpc::Status CompressPDF(
-        grpc::ServerContext* context,
-        grpc::ServerReaderWriter<file_processor::FileChunk,
-                                file_processor::FileChunk>* stream) override;
+    FileReactor* CompressPDF(grpc::CallbackServerContext* context) override;
 
     // Conversão PDF para TXT
-    grpc::Status ConvertToTXT(
-        grpc::ServerContext* context,
-        grpc::ServerReaderWriter<file_processor::FileChunk,
-                                file_processor::FileChunk>* stream) override;
+    FileReactor* ConvertToTXT(grpc::CallbackServerContext* context) override;
 
     // Conversão de formato de imagem
-    grpc::Status ConvertImageFormat(
-        grpc::ServerContext* context,
-        grpc::ServerReaderWriter<file_processor::FileChunk,
-                                file_processor::FileChunk>* stream) override;
+    FileReactor* ConvertImageFormat(grpc::CallbackServerContext* context) override;
 
     // Redimensionamento de imagem
-    grpc::Status ResizeImage(
-        grpc::ServerContext* context,
-        grpc::ServerReaderWriter<file_processor::FileChunk,
-                                file_processor::FileChunk>* stream) override;
+    FileReactor* ResizeImage(grpc::CallbackServerContext* context) override;
+
+    // Processamento em lote (vários arquivos e operações no mesmo stream)
+    grpc::ServerBidiReactor<file_processor::BatchRequest, file_processor::BatchResponse>*
+    ProcessBatch(grpc::CallbackServerContext* context) override;
 
 private:
-    // Receber arquivo via streaming
-    bool receiveFile(grpc::ServerReaderWriter<file_processor::FileChunk,
-                                             file_processor::FileChunk>* stream,
-                    const std::string& output_path,
-                    std::string& error_message);
-
-    // Enviar arquivo via streaming
-    bool sendFile(grpc::ServerReaderWriter<file_processor::FileChunk,
-                                          file_processor::FileChunk>* stream,
-                 const std::string& input_path,
-                 std::string& error_message);
+    // Handlers executados no executor após o upload completo
+    grpc::Status compressPDF(TransferBuffer& input, TransferBuffer& output);
+    grpc::Status convertToTXT(TransferBuffer& input, TransferBuffer& output);
+    grpc::Status convertImageFormat(TransferBuffer& input, TransferBuffer& output,
+                                    ImageFormat output_format);
+    grpc::Status resizeImage(TransferBuffer& input, TransferBuffer& output,
+                             int width, int height, bool maintain_aspect_ratio);
+
+    // Handlers em pipeline (stdin/stdout da ferramenta ligados ao stream)
+    grpc::Status compressPDFPipelined(ChunkStream& stream);
+    grpc::Status convertToTXTPipelined(ChunkStream& stream);
+
+    // ConvertToTXT em pipeline com a engine in-process: o PDF é recebido
+    // inteiro e o texto de cada página vai para o cliente assim que fica pronto
+    grpc::Status convertToTXTStreamed(ChunkStream& stream);
+
+    // ConvertToTXT com pdftotext (inteiro ou em faixas de páginas)
+    grpc::Status convertToTXTExternal(TransferBuffer& input, TransferBuffer& output);
+
+    // Processar imagem com a engine in-process; false indica que o
+    // chamador deve recorrer ao ImageMagick (formato não suportado ou falha),
+    // a menos que rejected traga um erro (imagem acima de FP_IMAGE_MAX_PIXELS)
+    bool tryImageEngine(const std::string& service_name,
+                        TransferBuffer& input,
+                        TransferBuffer& output,
+                        ImageFormat output_format,
+                        int width, int height,
+                        bool maintain_aspect_ratio,
+                        grpc::Status& rejected);
+
+    // Extrair o texto com a engine in-process para output; false indica que
+    // o chamador deve recorrer ao pdftotext (engine indisponível ou falha)
+    bool tryPdfTextEngine(const std::string& service_name,
+                          TransferBuffer& input,
+                          TransferBuffer& output);
+
+    // Engine de texto compilada e habilitada (FP_PDF_TEXT_ENGINE)
+    bool usePdfTextEngine() const;
+
+    // Executar ferramenta em pipeline: os chunks recebidos alimentam o stdin
+    // enquanto o stdout é devolvido ao cliente à medida que é produzido
+    grpc::Status runPipelined(const std::string& service_name,
+                              ChunkStream& stream,
+                              const std::vector<std::string>& command,
+                              const std::string& tool_name,
+                              bool allow_empty_output,
+                              size_t& bytes_received,
+                              size_t& bytes_sent);
+
+    // Operação, limiter, parâmetros de cache e handler de um arquivo do lote
+    bool resolveBatchOperation(const file_processor::BatchFileHeader& header,
+                               BatchOperation& operation,
+                               std::string& error_message);
+
+    // Parâmetros das RPCs de arquivo: o cabeçalho é convertido para o
+    // formato do lote e validado por resolveBatchOperation
+    FileTransferReactor::HeaderResolver headerResolver(file_processor::Operation operation);
+
+    // Faixas de páginas para um PDF grande; vazio ou uma faixa = sem divisão
+    std::vector<PdfSharder::PageRange> planPdfShards(const std::string& service_name,
+                                                     const TransferBuffer& input,
+                                                     const std::string& input_file);
+
+    // Pipeline para PDFs (requer POSIX)
+    bool usePdfPipeline() const;
+
+    // Reactor de uma RPC de PDF em pipeline: streaming direto sem cache de
+    // resultados; com cache, híbrido (só uploads a partir de
+    // FP_PDF_PIPELINE_MIN_BYTES passam ao pipeline)
+    FileReactor* createPipelined(grpc::CallbackServerContext* context,
+                                 const std::string& service_name,
+                                 file_processor::Operation operation,
+                                 FileTransferReactor::StreamingHandler handler);
+
+    OperationLimiter& limiterFor(const std::string& service_name);
+
+    // Gauges de concorrência, filas, admissão, cache e disco temporário no /metrics
+    void registerMetrics();
 
     Logger& logger_;
+    WorkStealingExecutor executor_;
+    std::map<std::string, std::unique_ptr<OperationLimiter>> limiters_;
+
+    // Chamadas em pipeline: esperam a rede e a ferramenta, então rodam fora
+    // do executor de CPU (nulo sem o modo pipeline)
+    std::unique_ptr<WorkStealingExecutor> pipeline_executor_;
+
+    // Admissão na entrada das RPCs (antes do upload), sobre os limiters
+    std::unique_ptr<AdmissionController> admission_;
+
+    PdfSharder pdf_sharder_;
+    PdfTextEngine pdf_text_engine_;
+    ResampleFilter resize_filter_;
+
+    // Workers Ghostscript pré-inicializados (nulo: sempre executa o gs)
+    std::unique_ptr<GhostscriptPool> gs_pool_;
 };
 
 #endif // FILE_PROCESSOR_SERVICE_IMPL_H
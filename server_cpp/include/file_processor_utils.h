@@ -10,6 +10,7 @@
 #include <algorithm>
 #include <chrono>
 #include <cstdlib>
+#include <fstream>
 
 #ifdef _WIN32
 #include <io.h>
@@ -24,22 +25,36 @@
 #include <unistd.h>
 #endif
 
+#include "process_runner.h"
+#include "scratch_space.h"
+
 class FileProcessorUtils {
 public:
     struct CommandResult {
         int exit_code;
         std::string output;
+        // stderr da ferramenta ou motivo da falha
         std::string error;
+        // Interrompido porque a chamada do job foi cancelada ou expirou
+        bool interrupted = false;
+        bool timed_out = false;
+
+        // Texto para mensagens de erro: o stderr, ou o stdout se ele estiver vazio
+        const std::string& diagnostics() const { return error.empty() ? output : error; }
     };
 
-    // Executar comando do sistema e capturar saída
-    static CommandResult executeCommand(const std::string& command) {
+    // Executar ferramenta externa sem shell (argv[0] procurado no PATH) e
+    // capturar stdout e stderr, com os limites padrão de ProcessRunner
+    // (timeout, CPU e memória). Dentro de um job, o comando acompanha a
+    // chamada: cancelada ou expirada, o processo é encerrado e exit_code fica -1
+    static CommandResult executeCommand(const std::vector<std::string>& argv) {
         CommandResult result;
-        std::array<char, 128> buffer;
+#ifdef _WIN32
+        std::array<char, 4096> buffer;
         std::string output;
         
         // Adicionar 2>&1 para capturar stderr também
-        std::string full_command = command + " 2>&1";
+        std::string full_command = formatCommand(argv) + " 2>&1";
         
         std::unique_ptr<FILE, decltype(&pclose)> pipe(
             popen(full_command.c_str(), "r"), pclose);
@@ -50,35 +65,43 @@ public:
             return result;
         }
         
-        while (fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr) {
-            output += buffer.data();
+        size_t length = 0;
+        while ((length = fread(buffer.data(), 1, buffer.size(), pipe.get())) > 0) {
+            output.append(buffer.data(), length);
         }
         
-#ifdef _WIN32
         result.exit_code = _pclose(pipe.release());
+        result.output = output;
 #else
-        result.exit_code = pclose(pipe.release()) / 256;
+        ProcessRunner runner;
+        ProcessRunner::Result run = runner.run(argv);
+        result.exit_code = run.exit_code;
+        result.output = std::move(run.output);
+        result.error = run.error.empty() ? std::move(run.error_output) : run.error;
+        result.interrupted = run.interrupted;
+        result.timed_out = run.timed_out;
 #endif
-        result.output = output;
-        
         return result;
     }
 
-    // Gerar nome único para arquivo temporário
+    // Linha de comando para logs (argumentos com espaços entre aspas)
+    static std::string formatCommand(const std::vector<std::string>& argv) {
+        std::string command;
+        for (const std::string& arg : argv) {
+            if (!command.empty()) {
+                command += ' ';
+            }
+            bool quote = arg.empty() || arg.find_first_of(" \t\"'") != std::string::npos;
+            command += quote ? "\"" + arg + "\"" : arg;
+        }
+        return command;
+    }
+
+    // Gerar nome único para arquivo temporário, no diretório do processo
+    // dentro do ScratchSpace (FP_SCRATCH_DIR)
     static std::string generateTempFileName(const std::string& prefix,
                                            const std::string& extension) {
-        auto now = std::chrono::system_clock::now();
-        auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now.time_since_epoch()).count();
-        
-#ifdef _WIN32
-        std::string temp_dir = getenv("TEMP") ? getenv("TEMP") : "C:\\Temp";
-        return temp_dir + "\\" + prefix + "_" + std::to_string(timestamp) 
-               + "_" + std::to_string(rand()) + extension;
-#else
-        return "/tmp/" + prefix + "_" + std::to_string(timestamp) 
-               + "_" + std::to_string(rand()) + extension;
-#endif
+        return ScratchSpace::getInstance().uniquePath(prefix, extension);
     }
 
     // Verificar se arquivo existe
@@ -115,6 +138,37 @@ public:
         }
     }
 
+    // Ler arquivo inteiro para memória
+    static bool readFile(const std::string& path, std::string& content) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) {
+            return false;
+        }
+
+        std::streamsize size = file.tellg();
+        if (size < 0) {
+            return false;
+        }
+        file.seekg(0, std::ios::beg);
+
+        content.resize(static_cast<size_t>(size));
+        if (size > 0 && !file.read(&content[0], size)) {
+            return false;
+        }
+        return true;
+    }
+
+    // Gravar conteúdo em memória no arquivo
+    static bool writeFile(const std::string& path, const std::string& content) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+
+        file.write(content.data(), static_cast<std::streamsize>(content.size()));
+        return file.good();
+    }
+
     // Extrair extensão do arquivo
     static std::string getFileExtension(const std::string& filename) {
         size_t dot_pos = filename.find_last_of('.');
@@ -0,0 +1,305 @@
+#ifndef FILE_TRANSFER_REACTOR_H
+#define FILE_TRANSFER_REACTOR_H
+
+#include <grpcpp/grpcpp.h>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "file_processor.grpc.pb.h"
+#include "admission_controller.h"
+#include "call_arena.h"
+#include "chunk_sizer.h"
+#include "compression_policy.h"
+#include "content_hash.h"
+#include "job_context.h"
+#include "logger.h"
+#include "metrics.h"
+#include "operation_limiter.h"
+#include "transfer_buffer.h"
+
+// Stream bloqueante de chunks, usado pelos handlers em modo pipeline. Os
+// buffers de content trocam de mensagem em vez de serem copiados: Read
+// devolve em chunk o buffer lido e Write envia o de chunk, que volta com um
+// buffer já alocado (conteúdo indefinido) para ser reaproveitado
+class ChunkStream {
+public:
+    enum class ReadState { PENDING, CHUNK, END };
+
+    virtual ~ChunkStream() = default;
+    virtual bool Read(file_processor::FileChunk* chunk) = 0;
+    virtual bool Write(file_processor::FileChunk* chunk) = 0;
+
+    // Leitura sem bloquear, para multiplexar o stream com outros
+    // descritores: TryRead pede o próximo chunk se nenhum está a caminho e
+    // devolve PENDING até ele chegar (readEventFd() fica legível), CHUNK com
+    // o chunk ou END no fim do stream (ou erro)
+    virtual ReadState TryRead(file_processor::FileChunk* chunk) = 0;
+    virtual int readEventFd() const = 0;
+
+    // Tamanho sugerido para o próximo chunk de saída, ajustado pela vazão
+    // medida nos Write anteriores (AdaptiveChunkSizer)
+    virtual size_t chunkSize() = 0;
+};
+
+// Reactor da API callback para as RPCs de arquivo.
+//
+// Modo buffered: o cabeçalho opcional (primeira mensagem) define os
+// parâmetros e o tamanho esperado; o upload é acumulado pelos callbacks
+// (sem ocupar thread),
+// o processamento roda no executor via OperationLimiter e a saída é
+// enviada de volta também pelos callbacks. O hash da entrada é calculado
+// durante o upload; acerto no ResultCache dispensa o processamento.
+//
+// Modo streaming: o handler roda num pool próprio de E/S (não ocupa o
+// executor de CPU enquanto espera a rede) e usa o reactor como ChunkStream;
+// a leitura só começa quando o job ganha um slot do limiter, então o
+// controle de fluxo do HTTP/2 segura o cliente enquanto espera.
+// O cabeçalho, se enviado, é descartado (as operações em pipeline não têm
+// parâmetros); um upload_id recebe offset 0, já que não há parte guardada.
+//
+// Modo híbrido: começa buffered e, se o cabeçalho anuncia um upload
+// grande, passa ao streaming; o cabeçalho é entregue ao handler como a
+// primeira leitura. Uploads pequenos continuam passando pelo cache.
+//
+// Upload retomável (cabeçalho com upload_id, só no modo buffered): os
+// chunks vão para o UploadStore em vez do buffer, o servidor responde ao
+// cabeçalho com o offset já confirmado e, se o stream cair antes do fim, a
+// parte fica guardada para a próxima chamada com o mesmo id. Offsets e
+// CRC-32 dos chunks, quando enviados, são verificados em qualquer modo.
+//
+// Compressão (FP_COMPRESSION): a chamada aceita gzip/deflate conforme o
+// cliente anuncia e cada chunk de resposta passa pelo CompressionPolicy;
+// o resumo vai no log e no trailing metadata "fp-compression".
+//
+// Admissão: a RPC passa pelo AdmissionController antes da primeira leitura
+// e reserva os bytes do tamanho anunciado (ou recebidos, sem cabeçalho);
+// recusas viram RESOURCE_EXHAUSTED com "fp-retry-after-ms" no trailing
+// metadata. A vaga é devolvida ao encerrar a RPC.
+//
+// Agendamento: cada chamada tem um JobContext (prazo do gRPC e prioridade
+// "fp-priority") que ordena o job na fila do limiter; jobs de chamadas
+// canceladas ou expiradas são descartados antes de começar e, se já estão
+// rodando, a ferramenta externa é interrompida. O tempo processado para
+// chamadas abandonadas conta como desperdício nas métricas.
+//
+// Métricas: no modo buffered as fases receive/process/send são medidas
+// separadamente; no streaming elas se sobrepõem e tudo conta como process.
+//
+// Memória: as mensagens do stream ficam na arena da chamada e são
+// reaproveitadas a cada chunk; o content é lido direto para a mensagem
+// (saída em disco) ou copiado uma vez, sem alocar, para o buffer dela.
+class FileTransferReactor
+    : public grpc::ServerBidiReactor<file_processor::FileChunk,
+                                     file_processor::FileChunk>,
+      public ChunkStream {
+public:
+    using BufferedHandler =
+        std::function<grpc::Status(TransferBuffer& input, TransferBuffer& output)>;
+    using StreamingHandler = std::function<grpc::Status(ChunkStream& stream)>;
+
+    // Parâmetros da operação a partir do cabeçalho (vazio se o cliente não
+    // enviou um): cache_parameters compõem a chave do cache e handler
+    // processa o upload. false + mensagem viram INVALID_ARGUMENT
+    using HeaderResolver =
+        std::function<bool(const file_processor::RequestHeader& header,
+                           std::string& cache_parameters,
+                           BufferedHandler& handler,
+                           std::string& error_message)>;
+
+    static FileTransferReactor* createBuffered(grpc::CallbackServerContext* context,
+                                               const std::string& service_name,
+                                               OperationLimiter& limiter,
+                                               AdmissionController& admission,
+                                               HeaderResolver resolver);
+
+    // O handler roda em io_executor, com o slot de limiter
+    static FileTransferReactor* createStreaming(grpc::CallbackServerContext* context,
+                                                const std::string& service_name,
+                                                OperationLimiter& limiter,
+                                                WorkStealingExecutor& io_executor,
+                                                AdmissionController& admission,
+                                                StreamingHandler handler);
+
+    // Buffered até o cabeçalho; se ele anuncia pelo menos streaming_min_bytes
+    // (e o resolver o aceita), a chamada passa ao modo streaming com handler,
+    // em io_executor. Sem cabeçalho ou com upload menor, segue buffered
+    // (com o ResultCache)
+    static FileTransferReactor* createHybrid(grpc::CallbackServerContext* context,
+                                             const std::string& service_name,
+                                             OperationLimiter& limiter,
+                                             WorkStealingExecutor& io_executor,
+                                             AdmissionController& admission,
+                                             HeaderResolver resolver,
+                                             StreamingHandler handler,
+                                             uint64_t streaming_min_bytes);
+
+    // Contexto de agendamento de uma chamada: prazo e prioridade pedida
+    // (se FP_CLIENT_PRIORITY); também usado pelo ProcessBatch
+    static std::shared_ptr<JobContext> jobContextFor(grpc::CallbackServerContext* context);
+
+    // ChunkStream (somente no modo streaming, fora das threads do gRPC)
+    bool Read(file_processor::FileChunk* chunk) override;
+    bool Write(file_processor::FileChunk* chunk) override;
+    ReadState TryRead(file_processor::FileChunk* chunk) override;
+    int readEventFd() const override { return read_event_fds_[0]; }
+    size_t chunkSize() override;
+
+    void OnReadDone(bool ok) override;
+    void OnWriteDone(bool ok) override;
+    void OnDone() override;
+    void OnCancel() override;
+
+private:
+    FileTransferReactor(grpc::CallbackServerContext* context,
+                        const std::string& service_name,
+                        OperationLimiter& limiter,
+                        AdmissionController& admission);
+    ~FileTransferReactor() override;
+
+    // Admitir a RPC; recusada, ela já foi encerrada
+    bool admit();
+
+    // Pipe de eventos de leitura do modo streaming; false encerra a RPC
+    bool openReadEvents();
+
+    // Enfileirar o streaming_handler_ (modo streaming)
+    void submitStreamingJob();
+
+    // Passar ao modo streaming com o cabeçalho já lido em read_chunk_, que
+    // o handler recebe como primeira leitura
+    void switchToStreaming();
+
+    // Bytes recebidos ou anunciados contra o limite da fila; false encerra a RPC
+    bool reserveBytes(uint64_t bytes);
+
+    // Encerrar com RESOURCE_EXHAUSTED e a espera sugerida ao cliente
+    void rejectBusy(const std::string& error, std::chrono::milliseconds retry_after);
+
+    // Enfileirar o job no limiter; recusa vira RESOURCE_EXHAUSTED e o
+    // descarte (chamada cancelada ou expirada na fila) encerra a RPC
+    void submitJob(std::function<void()> job);
+
+    // Status de uma chamada abandonada: DEADLINE_EXCEEDED ou CANCELLED
+    grpc::Status abandonedStatus(const std::string& when) const;
+
+    // Processamento iniciado em started terminou: se a chamada já foi
+    // abandonada, conta como desperdício; true nesse caso
+    bool recordIfAbandoned(std::chrono::steady_clock::time_point started);
+
+    // Executar o handler convertendo exceções em INTERNAL
+    grpc::Status runHandler(const std::function<grpc::Status()>& handler);
+
+    // Resolver os parâmetros (uma vez, na primeira mensagem ou no fim de um
+    // upload vazio); false se a RPC já foi encerrada (erro) ou passou ao
+    // modo streaming (híbrido): em ambos, o modo buffered não lê mais
+    bool resolveParameters(const file_processor::RequestHeader& header);
+
+    // Abrir/retomar o upload no UploadStore e enviar o UploadStatus
+    bool openResumableUpload(const std::string& upload_id,
+                             const file_processor::FileMetadata* metadata);
+
+    // Verificar offset e CRC-32 (ChunkIntegrity) de um chunk; position =
+    // bytes já recebidos
+    grpc::Status verifyChunk(const file_processor::FileChunk& chunk,
+                             uint64_t position) const;
+
+    // Gravar um chunk recebido (buffer ou upload retomável)
+    bool storeChunk(const file_processor::FileChunk& chunk);
+
+    // Fim do upload retomável: a parte completa vira a entrada
+    bool completeResumableUpload();
+
+    // Enquanto o UploadStatus está em envio, outra escrita (ou o Finish)
+    // fica para o OnWriteDone dele; true se action foi adiada
+    bool deferWhileStatusPending(std::function<void()> action);
+
+    // Chamado ao fim do upload no modo buffered
+    void processUpload();
+    bool lookupCache(bool include_disk);
+    void serveCached(std::string content);
+    void storeInCache();
+
+    void sendNextChunk();
+
+    // Opções de escrita do chunk: sem compressão quando não compensa
+    grpc::WriteOptions writeOptions(const file_processor::FileChunk& chunk);
+
+    void finish(const grpc::Status& status);
+
+    grpc::CallbackServerContext* context_;
+    std::string service_name_;
+    OperationLimiter& limiter_;
+    // Onde o job roda (nulo = executor do limiter)
+    WorkStealingExecutor* job_executor_;
+    AdmissionController& admission_controller_;
+    AdmissionController::Ticket admission_;
+    std::shared_ptr<JobContext> job_;
+    Logger& logger_;
+    OperationMetrics& metrics_;
+    std::chrono::steady_clock::time_point start_time_;
+    std::chrono::steady_clock::time_point send_start_time_;
+    bool send_started_;
+
+    bool streaming_;
+    // Modo híbrido: io_executor e tamanho anunciado que passa ao streaming
+    WorkStealingExecutor* streaming_executor_;
+    uint64_t streaming_min_bytes_;
+    HeaderResolver resolver_;
+    bool parameters_resolved_;
+    BufferedHandler buffered_handler_;
+    StreamingHandler streaming_handler_;
+
+    ContentHasher hasher_;
+    std::string cache_parameters_;
+    std::string cache_key_;
+
+    // Mensagens do stream, na arena da chamada
+    google::protobuf::Arena arena_;
+    file_processor::FileChunk* read_chunk_;
+    file_processor::FileChunk* write_chunk_;
+    file_processor::FileChunk* status_chunk_;
+
+    // Upload retomável: token emitido pelo UploadStore
+    std::string upload_id_;
+    bool upload_open_;
+    uint64_t upload_size_;
+    uint64_t upload_offset_;
+    uint64_t resumed_from_;
+    bool status_write_pending_;
+    std::function<void()> after_status_;
+
+    // Cota de disco temporário da requisição (entrada e saída)
+    std::shared_ptr<ScratchSpace::Quota> scratch_quota_;
+    TransferBuffer input_;
+    TransferBuffer output_;
+    AdaptiveChunkSizer chunk_sizer_;
+    size_t bytes_sent_;
+    size_t chunk_length_;
+    std::chrono::steady_clock::time_point chunk_start_time_;
+    CompressionPolicy compression_;
+
+    // Sincronização das operações bloqueantes do modo streaming (e do
+    // UploadStatus no modo buffered)
+    std::mutex mutex_;
+    std::mutex write_mutex_;
+    std::condition_variable cv_;
+    bool read_started_;
+    bool read_pending_;
+    bool read_ok_;
+    bool read_closed_;
+    // Pipe não bloqueante com um byte por leitura concluída (modo streaming)
+    int read_event_fds_[2];
+    bool write_pending_;
+    bool write_ok_;
+
+    // Chunk rejeitado no modo streaming e bytes já lidos
+    grpc::Status stream_error_;
+    uint64_t stream_position_;
+};
+
+#endif // FILE_TRANSFER_REACTOR_H
@@ -0,0 +1,120 @@
+#ifndef GHOSTSCRIPT_POOL_H
+#define GHOSTSCRIPT_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "piped_process.h"
+
+// Pool de processos Ghostscript persistentes (pdfwrite já inicializado),
+// dirigidos por PostScript no stdin: cada job troca o OutputFile, executa
+// o PDF de entrada com runpdf (ou só conta as páginas) entre save/restore e imprime um marcador de
+// fim (com nonce por job) no stdout. Só entradas com cabeçalho %PDF- são
+// aceitas, e cada worker só tem acesso ao próprio diretório, onde o job
+// corrente expõe a entrada e a saída. Um worker é reciclado após
+// max_jobs_per_worker jobs, em qualquer erro ou quando o job é
+// interrompido (chamada cancelada ou expirada).
+class GhostscriptPool {
+public:
+    struct Stats {
+        uint64_t jobs;
+        uint64_t failures;
+        uint64_t recycled;
+        size_t live_workers;
+        size_t idle_workers;
+    };
+
+    GhostscriptPool(size_t size, size_t max_jobs_per_worker,
+                    const std::vector<std::string>& pdfwrite_options);
+    ~GhostscriptPool();
+
+    GhostscriptPool(const GhostscriptPool&) = delete;
+    GhostscriptPool& operator=(const GhostscriptPool&) = delete;
+
+    // Iniciar todos os workers; false se o Ghostscript não responde
+    bool warmUp(std::string& error_message);
+
+    // Resultado de um job de compressão. UNAVAILABLE é falha do pool (sem
+    // worker, worker caiu, entrada que não é PDF): o chamador pode executar
+    // o gs. REJECTED é o gs recusando o documento e INTERRUPTED, a chamada
+    // cancelada ou expirada: repetir em outro gs não adianta
+    enum class Outcome { OK, REJECTED, INTERRUPTED, UNAVAILABLE };
+
+    // Comprimir input_path em output_path usando um worker ocioso
+    // (aguarda se todos estão ocupados)
+    Outcome compress(const std::string& input_path, const std::string& output_path,
+                     std::string& error_message);
+
+    // Número de páginas lido por um worker ocioso (sem iniciar processo);
+    // 0 se não há worker livre ou não for possível determinar
+    int countPages(const std::string& input_path);
+
+    // Falhas consecutivas indicam incompatibilidade (ex.: gs antigo que não
+    // permite trocar o OutputFile em modo SAFER); o chamador deixa de usar o pool
+    bool degraded() const { return consecutive_failures_.load() >= kMaxConsecutiveFailures; }
+
+    size_t size() const { return size_; }
+    Stats stats() const;
+
+private:
+    struct Worker {
+        std::unique_ptr<PipedProcess> process;
+        size_t jobs = 0;
+        std::string pending_output;
+        // Único diretório liberado para este gs (--permit-file-all)
+        std::string directory;
+    };
+
+    // wait = false: nullptr se nenhum worker está livre
+    std::unique_ptr<Worker> acquire(bool wait, std::string& error_message);
+    void release(std::unique_ptr<Worker> worker, bool healthy);
+
+    std::unique_ptr<Worker> startWorker(std::string& error_message);
+    void stopWorker(Worker& worker, bool force);
+
+    // Executar body (PostScript que deixa um inteiro no topo da pilha, com
+    // FPInput/FPOutput definidos) em um worker; false se o job nem chegou
+    // ao gs (ou, sem wait, não havia worker livre). result = -1 em erro;
+    // completed = false se o worker caiu antes do marcador de fim
+    bool runJob(const std::string& input_path, const std::string& output_path,
+                const std::string& body, bool wait, int& result, bool& completed,
+                bool& interrupted, std::string& error_message);
+
+    // Links in.pdf/out.pdf no diretório do worker para os arquivos do job
+    static std::string jobPath(const Worker& worker, const char* name);
+    bool exposeJobFiles(Worker& worker, const std::string& input_path,
+                        const std::string& output_path, std::string& error_message);
+    void hideJobFiles(Worker& worker);
+
+    // Enviar PostScript e ler o stdout até o marcador com o nonce;
+    // exit_code = 0 se ok
+    bool execute(Worker& worker, const std::string& script, const std::string& nonce,
+                 int& exit_code, std::string& output);
+
+    static std::string escapePostScript(const std::string& value);
+
+    size_t size_;
+    size_t max_jobs_per_worker_;
+    std::vector<std::string> command_;
+
+    static constexpr uint64_t kMaxConsecutiveFailures = 3;
+
+    mutable std::mutex mutex_;
+    std::condition_variable available_cv_;
+    std::vector<std::unique_ptr<Worker>> idle_;
+    size_t live_;
+    bool stopping_;
+
+    std::atomic<uint64_t> jobs_;
+    std::atomic<uint64_t> failures_;
+    std::atomic<uint64_t> recycled_;
+    std::atomic<uint64_t> consecutive_failures_;
+};
+
+#endif // GHOSTSCRIPT_POOL_H
@@ -0,0 +1,111 @@
+#ifndef IMAGE_ENGINE_H
+#define IMAGE_ENGINE_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "image_resampler.h"
+
+// Formatos reconhecidos pela engine (os demais seguem pelo ImageMagick)
+// Formatos aceitos como saída; a engine trata JPEG e PNG, os demais só o
+// ImageMagick
+enum class ImageFormat {
+    UNKNOWN,
+    JPEG,
+    PNG,
+    GIF,
+    BMP,
+    TIFF,
+    WEBP
+};
+
+// Imagem decodificada: pixels intercalados de 8 bits (RGB ou RGBA)
+struct Image {
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    std::vector<uint8_t> pixels;
+};
+
+// Parâmetros do redimensionamento (filtro, proporção e execução em faixas
+// paralelas)
+struct ResizeOptions {
+    ResampleFilter filter = ResampleFilter::LANCZOS;
+    // Caber em width x height mantendo a proporção (-resize WxH); o tamanho
+    // exato só é aplicado por resizeImage, resize() sempre usa WxH
+    bool maintain_aspect_ratio = false;
+    // JPEG reduzido já na IDCT (1/2, 1/4 ou 1/8) quando o destino é ao menos
+    // 2x menor; a reamostragem final parte de uma imagem bem menor
+    bool scaled_decode = true;
+    // Maior largura x altura aceita no decode (0 = sem limite)
+    size_t max_pixels = 0;
+    ImageResampler::ParallelFor parallel_for;
+};
+
+// Engine de imagem in-process: decode -> transformação -> encode em memória.
+// Evita o fork/exec do ImageMagick para os formatos suportados; quem chama
+// deve recorrer ao subprocesso quando isSupported() retornar false.
+class ImageEngine {
+public:
+    // Engine compilada com ao menos um codec
+    static bool isAvailable();
+
+    // Detectar formato pelos bytes iniciais do arquivo
+    static ImageFormat detectFormat(const std::string& data);
+
+    // Converter nome de formato ("png", "jpg", ...) para ImageFormat; nomes
+    // fora da lista de formatos aceitos resultam em UNKNOWN
+    static ImageFormat formatFromName(const std::string& name);
+
+    // Extensão padrão do formato (".png", ".jpg")
+    static std::string extensionFor(ImageFormat format);
+
+    // Nome canônico do formato ("png", "jpeg"), usado como coder do ImageMagick
+    static std::string nameFor(ImageFormat format);
+
+    static bool canDecode(ImageFormat format);
+    static bool canEncode(ImageFormat format);
+
+    // Entrada e saída podem ser tratadas sem subprocesso
+    static bool isSupported(const std::string& input, ImageFormat output_format);
+
+    // Dimensões lidas só do cabeçalho (JPEG e PNG), sem decodificar
+    static bool readDimensions(const std::string& data, int& width, int& height);
+
+    // Com min_width/min_height, um JPEG pode ser decodificado reduzido
+    // (1/2, 1/4 ou 1/8) desde que continue cobrindo esse tamanho; os demais
+    // formatos ignoram o limite. Imagens cujo cabeçalho declara mais de
+    // max_pixels pixels são recusadas antes de alocar (0 = sem limite)
+    static bool decode(const std::string& data, Image& image,
+                       std::string& error_message,
+                       int min_width = 0, int min_height = 0,
+                       size_t max_pixels = 0);
+
+    static bool encode(const Image& image, ImageFormat format,
+                       std::string& output, std::string& error_message,
+                       int jpeg_quality = 92);
+
+    // Redimensionar para exatamente width x height (equivale a -resize WxH!)
+    static bool resize(const Image& source, int width, int height,
+                       Image& destination, std::string& error_message,
+                       const ResizeOptions& options = ResizeOptions());
+
+    // Maior tamanho com a proporção de source que cabe em width x height
+    static void fitWithin(int source_width, int source_height,
+                          int& width, int& height);
+
+    // Pipeline completo: conversão de formato
+    static bool convertImage(const std::string& input, ImageFormat output_format,
+                             std::string& output, std::string& error_message,
+                             size_t max_pixels = 0);
+
+    // Pipeline completo: redimensionamento
+    static bool resizeImage(const std::string& input, int width, int height,
+                            ImageFormat output_format, std::string& output,
+                            std::string& error_message,
+                            const ResizeOptions& options = ResizeOptions());
+};
+
+#endif // IMAGE_ENGINE_H
@@ -0,0 +1,50 @@
+#ifndef IMAGE_RESAMPLER_H
+#define IMAGE_RESAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Filtros de reamostragem (suporte de 1, 2 e 3 pixels na escala de destino)
+enum class ResampleFilter {
+    BILINEAR,
+    BICUBIC,
+    LANCZOS
+};
+
+// Redimensionamento separável: passada horizontal para um buffer
+// intermediário de 8 bits, depois passada vertical. Os pesos de cada pixel
+// de destino são calculados uma vez por eixo; ao reduzir, o suporte do
+// filtro é alargado pela escala (antialiasing, como o -resize do ImageMagick).
+//
+// Pixels intercalados de 1 a 4 canais; imagens planares são reamostradas
+// plano a plano com channels = 1. Os laços internos usam AVX2/FMA ou
+// SSE4.1 quando a CPU suporta (detecção em tempo de execução), com
+// fallback escalar nas demais plataformas.
+class ImageResampler {
+public:
+    // Executa body(0..count-1), possivelmente em paralelo, e aguarda
+    using ParallelFor = std::function<void(size_t count,
+                                           const std::function<void(size_t)>& body)>;
+
+    // "bilinear", "bicubic" ou "lanczos"
+    static bool filterFromName(const std::string& name, ResampleFilter& filter);
+    static const char* filterName(ResampleFilter filter);
+
+    // Caminho usado nas passadas ("avx2", "sse4.1" ou "scalar")
+    static const char* instructionSet();
+
+    // Desabilitar SIMD (comparação nos benchmarks)
+    static void setSimdEnabled(bool enabled);
+
+    // Reamostrar source (source_width x source_height) para destination
+    // (width x height), ambos com linhas contíguas. Imagens grandes são
+    // divididas em faixas de linhas executadas via parallel_for, se fornecido
+    static void resample(const uint8_t* source, int source_width, int source_height,
+                         int channels, uint8_t* destination, int width, int height,
+                         ResampleFilter filter,
+                         const ParallelFor& parallel_for = ParallelFor());
+};
+
+#endif // IMAGE_RESAMPLER_H
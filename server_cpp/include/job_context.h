@@ -0,0 +1,142 @@
+#ifndef JOB_CONTEXT_H
+#define JOB_CONTEXT_H
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Estado de uma chamada visto pelos jobs dela: prazo (deadline do gRPC),
+// prioridade pedida pelo cliente (metadata "fp-priority") e cancelamento.
+// O OperationLimiter ordena a fila por prioridade e prazo e descarta os
+// jobs de chamadas expiradas ou canceladas antes de começarem; durante a
+// execução, o contexto da thread (Scope) permite que PipedProcess
+// interrompa a ferramenta externa (SIGTERM e, após kill_grace, SIGKILL).
+// Quem guarda jobs da chamada (a fila do limiter) registra um listener de
+// cancelamento para descartá-los assim que ela é cancelada.
+class JobContext {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr int kMinPriority = -10;
+    static constexpr int kMaxPriority = 10;
+
+    JobContext(Clock::time_point deadline, int priority,
+               std::chrono::milliseconds kill_grace)
+        : deadline_(deadline),
+          priority_(std::min(std::max(priority, kMinPriority), kMaxPriority)),
+          kill_grace_(kill_grace),
+          cancelled_(false) {}
+
+    JobContext(const JobContext&) = delete;
+    JobContext& operator=(const JobContext&) = delete;
+
+    // Prazo de uma chamada gRPC no relógio monotônico (máximo = sem prazo)
+    static Clock::time_point deadlineFrom(std::chrono::system_clock::time_point deadline) {
+        auto now = std::chrono::system_clock::now();
+        // Prazos além de um ano equivalem a "sem prazo" (e evitam overflow)
+        if (deadline > now + std::chrono::hours(24 * 365)) {
+            return Clock::time_point::max();
+        }
+        return Clock::now() + std::chrono::duration_cast<Clock::duration>(deadline - now);
+    }
+
+    // "fp-priority": inteiro (-10 a 10) ou low/normal/high; inválida = 0
+    static int parsePriority(std::string value) {
+        std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+        if (value == "low") {
+            return -5;
+        }
+        if (value == "high") {
+            return 5;
+        }
+        char* end = nullptr;
+        long parsed = std::strtol(value.c_str(), &end, 10);
+        if (value.empty() || *end != '\0') {
+            return 0;
+        }
+        return static_cast<int>(std::min<long>(std::max<long>(parsed, kMinPriority),
+                                               kMaxPriority));
+    }
+
+    bool hasDeadline() const { return deadline_ != Clock::time_point::max(); }
+    Clock::time_point deadline() const { return deadline_; }
+    int priority() const { return priority_; }
+    std::chrono::milliseconds killGrace() const { return kill_grace_; }
+
+    // Marca o cancelamento e chama (uma vez) os listeners registrados
+    void cancel() {
+        std::vector<std::pair<const void*, std::function<void()>>> listeners;
+        {
+            std::lock_guard<std::mutex> lock(listeners_mutex_);
+            cancelled_.store(true, std::memory_order_release);
+            listeners.swap(listeners_);
+        }
+        for (auto& listener : listeners) {
+            listener.second();
+        }
+    }
+
+    // Chamar listener no cancelamento; um por key (o limiter registra uma vez
+    // por chamada, mesmo com vários jobs na fila). Já cancelada, chama agora
+    void addCancelListener(const void* key, std::function<void()> listener) {
+        {
+            std::lock_guard<std::mutex> lock(listeners_mutex_);
+            if (!cancelled()) {
+                for (const auto& existing : listeners_) {
+                    if (existing.first == key) {
+                        return;
+                    }
+                }
+                listeners_.emplace_back(key, std::move(listener));
+                return;
+            }
+        }
+        listener();
+    }
+
+    bool cancelled() const { return cancelled_.load(std::memory_order_acquire); }
+    bool expired() const { return hasDeadline() && Clock::now() >= deadline_; }
+
+    // O resultado não será entregue: o trabalho restante é desperdício
+    bool abandoned() const { return cancelled() || expired(); }
+
+    // Contexto do job em execução nesta thread (nulo fora de um job)
+    static JobContext* current() { return currentSlot(); }
+
+    // Define o contexto da thread enquanto o job executa
+    class Scope {
+    public:
+        explicit Scope(JobContext* context) : previous_(currentSlot()) {
+            currentSlot() = context;
+        }
+        ~Scope() { currentSlot() = previous_; }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        JobContext* previous_;
+    };
+
+private:
+    static JobContext*& currentSlot() {
+        static thread_local JobContext* current = nullptr;
+        return current;
+    }
+
+    const Clock::time_point deadline_;
+    const int priority_;
+    const std::chrono::milliseconds kill_grace_;
+    std::atomic<bool> cancelled_;
+    std::mutex listeners_mutex_;
+    std::vector<std::pair<const void*, std::function<void()>>> listeners_;
+};
+
+#endif // JOB_CONTEXT_H
@@ -7,13 +7,15 @@
 #endif
 #endif
 
-#include <string>
-#include <fstream>
-#include <mutex>
+#include <atomic>
 #include <chrono>
-#include <iomanip>
-#include <sstream>
-#include <iostream>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 
 enum class LogLevel {
     INFO_LEVEL,
@@ -22,6 +24,11 @@ enum class LogLevel {
     ERROR_LEVEL
 };
 
+// Logger assíncrono: log() só filtra o nível e enfileira o registro em um
+// ring buffer limitado (MPSC, sem lock); uma thread de fundo formata e
+// grava em lotes, mantendo o arquivo aberto. Sob sobrecarga, registros são
+// descartados e contabilizados (INFO/SUCCESS primeiro), sem bloquear a
+// thread da requisição.
 class Logger {
 public:
     static Logger& getInstance() {
@@ -29,84 +36,86 @@ public:
         return instance;
     }
 
-    void setLogFile(const std::string& filename) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        log_file_path_ = filename;
+    void setLogFile(const std::string& filename);
+
+    // Níveis abaixo do mínimo são descartados antes de enfileirar
+    void setMinLevel(LogLevel level) {
+        min_level_.store(static_cast<int>(level), std::memory_order_relaxed);
     }
 
-    void log(LogLevel level, const std::string& service_name,
-             const std::string& file_name, const std::string& message) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        std::string timestamp = getCurrentTimestamp();
-        std::string level_str = getLevelString(level);
-        
-        std::ostringstream log_entry;
-        log_entry << "[" << timestamp << "] "
-                  << "[" << level_str << "] "
-                  << "Service: " << service_name << " | "
-                  << "File: " << file_name << " | "
-                  << "Message: " << message;
-        
-        // Log para arquivo
-        std::ofstream log_file(log_file_path_, std::ios::app);
-        if (log_file.is_open()) {
-            log_file << log_entry.str() << std::endl;
-            log_file.close();
-        }
-        
-        // Log para console com cores
-        std::cout << getColorCode(level) << log_entry.str() 
-                  << "\033[0m" << std::endl;
+    bool isEnabled(LogLevel level) const {
+        return static_cast<int>(level) >= min_level_.load(std::memory_order_relaxed);
     }
 
+    void log(LogLevel level, const std::string& service_name,
+             const std::string& file_name, const std::string& message);
+
+    // Aguardar a gravação de tudo que foi enfileirado até agora
+    void flush();
+
+    uint64_t droppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // "info", "success", "warning" ou "error" (inválido mantém o padrão)
+    static LogLevel parseLevel(const std::string& name, LogLevel default_level);
+
 private:
-    Logger() : log_file_path_("server.log") {}
-    ~Logger() = default;
+    struct Record {
+        LogLevel level = LogLevel::INFO_LEVEL;
+        std::chrono::system_clock::time_point time;
+        std::string service_name;
+        std::string file_name;
+        std::string message;
+    };
+
+    // Slot do ring (fila limitada de Vyukov): a sequência indica se o slot
+    // está livre para o produtor da posição ou pronto para o consumidor
+    struct Slot {
+        std::atomic<size_t> sequence;
+        Record record;
+    };
+
+    Logger();
+    ~Logger();
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
 
-    std::string getCurrentTimestamp() {
-        auto now = std::chrono::system_clock::now();
-        auto time_t_now = std::chrono::system_clock::to_time_t(now);
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now.time_since_epoch()) % 1000;
-        
-        std::tm tm_now;
-#ifdef _WIN32
-        localtime_s(&tm_now, &time_t_now);
-#else
-        localtime_r(&time_t_now, &tm_now);
-#endif
-        
-        std::ostringstream oss;
-        oss << std::put_time(&tm_now, "%Y-%m-%d %H:%M:%S")
-            << '.' << std::setfill('0') << std::setw(3) << ms.count();
-        return oss.str();
-    }
+    bool tryEnqueue(Record& record);
+    bool tryDequeue(Record& record);
 
-    std::string getLevelString(LogLevel level) {
-        switch (level) {
-            case LogLevel::INFO_LEVEL: return "INFO";
-            case LogLevel::SUCCESS_LEVEL: return "SUCCESS";
-            case LogLevel::WARNING_LEVEL: return "WARNING";
-            case LogLevel::ERROR_LEVEL: return "ERROR";
-            default: return "UNKNOWN";
-        }
-    }
+    void writerLoop();
+    void writeBatch(std::string& file_batch, std::string& console_batch);
+    void openLogFile();
 
-    std::string getColorCode(LogLevel level) {
-        switch (level) {
-            case LogLevel::INFO_LEVEL: return "\033[36m";      // Cyan
-            case LogLevel::SUCCESS_LEVEL: return "\033[32m";   // Green
-            case LogLevel::WARNING_LEVEL: return "\033[33m";   // Yellow
-            case LogLevel::ERROR_LEVEL: return "\033[31m";     // Red
-            default: return "\033[0m";                   // Reset
-        }
-    }
+    static void formatRecord(const Record& record, std::string& line);
+    static const char* getLevelString(LogLevel level);
+    static const char* getColorCode(LogLevel level);
 
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_;
+    // Ocupação a partir da qual INFO/SUCCESS são descartados
+    size_t low_priority_limit_;
+
+    // Produtores e consumidor em linhas de cache separadas
+    alignas(64) std::atomic<size_t> enqueue_pos_;
+    alignas(64) size_t dequeue_pos_;
+
+    std::atomic<int> min_level_;
+    std::atomic<uint64_t> dropped_;
+    std::atomic<uint64_t> written_;
+
+    // Acordar a thread de fundo só quando ela está dormindo
+    std::atomic<bool> writer_sleeping_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable flushed_cv_;
+    bool stopping_;
+
+    std::mutex file_mutex_;
     std::string log_file_path_;
-    std::mutex mutex_;
+    bool reopen_file_;
+    std::FILE* log_file_;
+
+    std::thread writer_;
 };
 
 #endif // LOGGER_H
@@ -0,0 +1,119 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Fases de uma requisição medidas nos histogramas de latência
+enum class RequestPhase {
+    RECEIVE,
+    PROCESS,
+    SEND
+};
+
+// Histograma de latência com buckets fixos (segundos). observe() só faz
+// incrementos atômicos relaxados, sem lock no caminho da requisição.
+class LatencyHistogram {
+public:
+    static constexpr size_t kBucketCount = 14;
+    static const double kBucketBounds[kBucketCount];
+
+    LatencyHistogram();
+
+    void observe(double seconds);
+
+    // Linhas _bucket/_sum/_count no formato de exposição do Prometheus
+    void render(const std::string& name, const std::string& labels,
+                std::string& output) const;
+
+private:
+    // Último bucket = +Inf
+    std::atomic<uint64_t> counts_[kBucketCount + 1];
+    std::atomic<uint64_t> sum_microseconds_;
+};
+
+// Contadores e histogramas de uma operação
+struct OperationMetrics {
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> errors{0};
+    std::atomic<uint64_t> cache_hits{0};
+    std::atomic<uint64_t> bytes_in{0};
+    std::atomic<uint64_t> bytes_out{0};
+    // Bytes de resposta enviados com compressão e o tamanho estimado no fio
+    std::atomic<uint64_t> compressed_bytes{0};
+    std::atomic<uint64_t> compressed_wire_bytes{0};
+    // Jobs que processaram (total ou parcialmente) para uma chamada já
+    // cancelada ou expirada, e o tempo de processamento desperdiçado
+    std::atomic<uint64_t> abandoned_jobs{0};
+    std::atomic<uint64_t> wasted_process_microseconds{0};
+    LatencyHistogram phases[3];
+
+    void observe(RequestPhase phase, std::chrono::steady_clock::time_point start) {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        phases[static_cast<size_t>(phase)].observe(elapsed.count());
+    }
+
+    // Processamento iniciado em start cujo resultado não será entregue
+    void recordWasted(std::chrono::steady_clock::time_point start) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+        abandoned_jobs.fetch_add(1, std::memory_order_relaxed);
+        wasted_process_microseconds.fetch_add(static_cast<uint64_t>(elapsed.count()),
+                                              std::memory_order_relaxed);
+    }
+};
+
+// Registro de métricas do servidor. As operações são fixas (criadas no
+// construtor, mapa imutável depois), então registrar é só um incremento
+// atômico; gauges são callbacks avaliados apenas na coleta.
+class Metrics {
+public:
+    using GaugeFunction = std::function<double()>;
+
+    static Metrics& getInstance() {
+        static Metrics instance;
+        return instance;
+    }
+
+    // Métricas da operação (nome desconhecido cai em "other")
+    OperationMetrics& operation(const std::string& name);
+
+    // Gauge (ou contador mantido por outro componente) lido na coleta;
+    // owner identifica quem registrou, para remoção antes de ser destruído
+    void addGauge(const void* owner, const std::string& name, const std::string& help,
+                  const std::string& labels, GaugeFunction function,
+                  bool is_counter = false);
+    void removeGauges(const void* owner);
+
+    // Texto no formato de exposição do Prometheus (text/plain; version=0.0.4)
+    std::string render() const;
+
+private:
+    struct Gauge {
+        const void* owner;
+        std::string name;
+        std::string help;
+        std::string labels;
+        GaugeFunction function;
+        bool is_counter;
+    };
+
+    Metrics();
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    std::map<std::string, std::unique_ptr<OperationMetrics>> operations_;
+
+    mutable std::mutex gauges_mutex_;
+    std::vector<Gauge> gauges_;
+};
+
+#endif // METRICS_H
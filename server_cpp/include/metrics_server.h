@@ -0,0 +1,35 @@
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+// Endpoint HTTP mínimo que expõe Metrics::render() em GET /metrics para
+// scrape do Prometheus. Uma única thread atende as conexões em sequência
+// (scrapes são raros e pequenos); qualquer outro caminho recebe 404.
+class MetricsServer {
+public:
+    MetricsServer();
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    // Abrir a porta e iniciar a thread; false + mensagem se não conseguir
+    bool start(const std::string& address, int port, std::string& error_message);
+    void stop();
+
+    int port() const { return port_; }
+
+private:
+    void serveLoop();
+    void handleConnection(int client_fd);
+
+    int listen_fd_;
+    int port_;
+    std::atomic<bool> stopping_;
+    std::thread thread_;
+};
+
+#endif // METRICS_SERVER_H
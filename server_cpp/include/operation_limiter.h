@@ -0,0 +1,106 @@
+#ifndef OPERATION_LIMITER_H
+#define OPERATION_LIMITER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "job_context.h"
+#include "work_stealing_executor.h"
+
+// Limite de concorrência por operação sobre o executor compartilhado: até
+// max_concurrent jobs executando, até queue_depth aguardando; além disso a
+// requisição é recusada.
+//
+// A fila é ordenada pela prioridade da chamada (maior primeiro), depois
+// pelo prazo (mais próximo primeiro, sem prazo por último) e pela ordem de
+// chegada. Jobs cuja chamada expirou ou foi cancelada são descartados antes
+// de começar: o DropHandler é chamado no lugar do job e o slot segue para o
+// próximo da fila. O cancelamento da chamada (JobContext::cancel) tira os
+// jobs dela da fila na hora; os de prazo vencido saem na próxima submissão
+// ou conclusão (o gRPC também cancela a chamada quando o prazo vence). Com a
+// fila cheia, os descartáveis saem antes da recusa.
+class OperationLimiter {
+public:
+    using Job = std::function<void()>;
+
+    enum class DropReason { DEADLINE, CANCELLED, COUNT };
+    using DropHandler = std::function<void(DropReason reason)>;
+
+    OperationLimiter(const std::string& name, WorkStealingExecutor& executor,
+                     size_t max_concurrent, size_t queue_depth);
+
+    OperationLimiter(const OperationLimiter&) = delete;
+    OperationLimiter& operator=(const OperationLimiter&) = delete;
+
+    // Executar ou enfileirar o job; false se o limite e a fila estão cheios.
+    // Sem context, o job entra com prioridade 0, sem prazo. executor: onde o
+    // job roda quando ganha o slot (nulo = executor do limiter; jobs que
+    // passam a maior parte do tempo esperando a rede usam um pool próprio)
+    bool submit(Job job, std::shared_ptr<JobContext> context = nullptr,
+                DropHandler dropped = nullptr, WorkStealingExecutor* executor = nullptr);
+
+    static const char* dropReasonName(DropReason reason);
+
+    const std::string& name() const { return name_; }
+    size_t maxConcurrent() const { return max_concurrent_; }
+    size_t queueDepth() const { return queue_depth_; }
+    size_t active() const;
+    size_t queued() const;
+    uint64_t dropped(DropReason reason) const {
+        return dropped_[static_cast<size_t>(reason)].load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Waiting {
+        Job job;
+        std::shared_ptr<JobContext> context;
+        DropHandler dropped;
+        WorkStealingExecutor* executor = nullptr;
+    };
+
+    // Ordem da fila: -prioridade, prazo, chegada
+    using Key = std::tuple<int, JobContext::Clock::time_point, uint64_t>;
+    using Queue = std::map<Key, Waiting>;
+    using DroppedJobs = std::vector<std::pair<Waiting, DropReason>>;
+
+    // Motivo para descartar o job (false se ele deve executar)
+    static bool shouldDrop(const std::shared_ptr<JobContext>& context, DropReason& reason);
+
+    // Remover da fila os jobs descartáveis (com o mutex)
+    void purgeLocked(DroppedJobs& dropped);
+
+    // Descartar os jobs de chamadas canceladas (listener do JobContext)
+    void purgeAbandoned();
+
+    // Contar os descartes e chamar os DropHandlers (sem o mutex)
+    void notifyDropped(DroppedJobs& dropped);
+
+    // Executar no executor com o contexto da chamada na thread
+    void dispatch(Job job, std::shared_ptr<JobContext> context,
+                  WorkStealingExecutor* executor);
+    void onJobDone();
+
+    std::string name_;
+    WorkStealingExecutor& executor_;
+    size_t max_concurrent_;
+    size_t queue_depth_;
+
+    mutable std::mutex mutex_;
+    size_t active_;
+    uint64_t sequence_;
+    Queue waiting_;
+
+    std::atomic<uint64_t> dropped_[static_cast<size_t>(DropReason::COUNT)];
+};
+
+#endif // OPERATION_LIMITER_H
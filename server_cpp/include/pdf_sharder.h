@@ -0,0 +1,69 @@
+#ifndef PDF_SHARDER_H
+#define PDF_SHARDER_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "work_stealing_executor.h"
+
+// Processamento de PDFs grandes em faixas de páginas paralelas: cada faixa
+// roda em um gs/pdftotext próprio no executor e os resultados são unidos
+// na ordem das páginas. O job que divide o documento também executa faixas
+// ainda não iniciadas, então não bloqueia um worker esperando os demais.
+class PdfSharder {
+public:
+    struct PageRange {
+        int first;
+        int last;
+    };
+
+    // min_pages: páginas a partir das quais o documento é dividido (0 desabilita)
+    // max_shards: limite de faixas simultâneas (0 = threads do executor)
+    PdfSharder(WorkStealingExecutor& executor, size_t min_pages, size_t max_shards);
+
+    bool enabled() const { return min_pages_ > 0 && max_shards_ > 1; }
+
+    // Só vale contar as páginas (custa um processo) se o tamanho do arquivo
+    // comporta min_pages páginas
+    bool worthCounting(size_t file_size) const;
+
+    // Número de páginas via qpdf (ou pdfinfo); 0 se não for possível determinar
+    static int countPages(const std::string& pdf_path);
+
+    // Faixas para o documento (uma única faixa = processar inteiro)
+    std::vector<PageRange> planShards(int page_count) const;
+
+    // CompressPDF por faixas: gs -dFirstPage/-dLastPage e junção com
+    // qpdf sobre a primeira faixa (ou gs, se o qpdf não estiver instalado)
+    bool compress(const std::string& input_path, const std::string& output_path,
+                  const std::vector<PageRange>& ranges, std::string& error_message);
+
+    // ConvertToTXT por faixas: pdftotext -f/-l e concatenação dos textos
+    bool extractText(const std::string& input_path, const std::string& output_path,
+                     const std::vector<PageRange>& ranges, std::string& error_message);
+
+    // Divisão uniforme de page_count páginas em shards faixas
+    static std::vector<PageRange> splitPages(int page_count, size_t shards);
+
+private:
+    using ShardTask = std::function<bool(size_t index, std::string& error_message)>;
+
+    // Executar task para cada faixa em paralelo; a primeira falha vira o erro
+    bool runShards(size_t count, const ShardTask& task, std::string& error_message);
+
+    bool mergePdfs(const std::vector<std::string>& parts, const std::string& output_path,
+                   std::string& error_message);
+
+    static bool qpdfAvailable();
+
+    // Estimativa baixa do tamanho de uma página (PDF só de texto, comprimido)
+    static constexpr size_t kMinBytesPerPage = 2 * 1024;
+
+    WorkStealingExecutor& executor_;
+    size_t min_pages_;
+    size_t max_shards_;
+};
+
+#endif // PDF_SHARDER_H
@@ -0,0 +1,77 @@
+#ifndef PDF_TEXT_ENGINE_H
+#define PDF_TEXT_ENGINE_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "work_stealing_executor.h"
+
+// Extração de texto de PDF in-process (poppler-cpp), sem subir o pdftotext.
+// O documento é lido da memória (ou de um caminho, para entradas em disco)
+// e as páginas são extraídas em paralelo no executor: cada participante
+// abre o próprio documento (o poppler não compartilha um entre threads) e
+// pega a próxima página livre. O texto é entregue na ordem das páginas
+// assim que cada uma fica pronta, com até algumas páginas de antecedência
+// guardadas em memória. O job que chama também extrai páginas, então não
+// bloqueia um worker esperando os demais. O formato segue o do pdftotext
+// (UTF-8, cada página terminada em form feed); sem a biblioteca,
+// isAvailable() é false e quem chama recorre ao pdftotext.
+class PdfTextEngine {
+public:
+    // Texto de uma página, na ordem; more_ready indica que a página
+    // seguinte já está pronta (quem agrupa a saída pode esperar por ela).
+    // Retornar false interrompe a extração com error_message
+    using PageSink = std::function<bool(const std::string& text, bool more_ready,
+                                        std::string& error_message)>;
+
+    // Documento aberto por um participante. O padrão usa o poppler-cpp;
+    // outro leitor exercita o agendamento das páginas sem a biblioteca
+    class PageReader {
+    public:
+        virtual ~PageReader() = default;
+        // data == nullptr: abrir path
+        virtual bool open(const char* data, size_t size, const std::string& path,
+                          std::string& error_message) = 0;
+        virtual int pageCount() const = 0;
+        // Texto da página index (0 = primeira), terminado em form feed
+        virtual bool pageText(int index, std::string& text, std::string& error_message) = 0;
+    };
+    using ReaderFactory = std::function<std::unique_ptr<PageReader>()>;
+
+    // max_workers: páginas extraídas ao mesmo tempo (0 = threads do executor);
+    // sem reader_factory, poppler-cpp
+    PdfTextEngine(WorkStealingExecutor& executor, size_t max_workers,
+                  ReaderFactory reader_factory = ReaderFactory());
+
+    // Engine compilada com poppler-cpp
+    static bool isAvailable();
+
+    // PDF em memória (data deve viver até o retorno)
+    bool extract(const char* data, size_t size, const PageSink& sink,
+                 int& page_count, std::string& error_message);
+
+    // PDF em um arquivo (memfd, spill em disco)
+    bool extractFile(const std::string& path, const PageSink& sink,
+                     int& page_count, std::string& error_message);
+
+    // Participantes usados para page_count páginas
+    size_t workersFor(int page_count) const;
+
+private:
+    struct Input {
+        const char* data = nullptr;
+        size_t size = 0;
+        std::string path;
+    };
+
+    bool run(const Input& input, const PageSink& sink, int& page_count,
+             std::string& error_message);
+
+    WorkStealingExecutor& executor_;
+    size_t max_workers_;
+    ReaderFactory reader_factory_;
+};
+
+#endif // PDF_TEXT_ENGINE_H
@@ -0,0 +1,94 @@
+#ifndef PIPED_PROCESS_H
+#define PIPED_PROCESS_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#endif
+
+// Processo externo com stdin/stdout ligados por pipes, usado no modo
+// pipeline: a entrada é alimentada enquanto os chunks chegam e a saída é
+// lida assim que a ferramenta a produz. O stderr é capturado à parte para
+// as mensagens de erro. Disponível apenas em plataformas POSIX.
+//
+// O processo roda no próprio grupo (sinais alcançam também os filhos, como
+// os de um "sh -c"). Dentro de um job (JobContext::current()), a leitura
+// do stdout acompanha a chamada: se ela for cancelada ou expirar, o grupo
+// recebe SIGTERM e, se não terminar em kill_grace, SIGKILL.
+class PipedProcess {
+public:
+    PipedProcess();
+    ~PipedProcess();
+
+    PipedProcess(const PipedProcess&) = delete;
+    PipedProcess& operator=(const PipedProcess&) = delete;
+
+    static bool isSupported();
+
+    // Iniciar processo (argv[0] procurado no PATH, sem shell) via
+    // ProcessRunner::spawn, com o limite de memória padrão
+    bool start(const std::vector<std::string>& argv, std::string& error_message);
+
+    // Escrever no stdin do processo (bloqueante); false se o processo fechou a entrada
+    bool writeInput(const char* data, size_t size);
+
+    // Escrever o que o pipe do stdin aceita agora, sem bloquear: bytes
+    // escritos (0 com o pipe cheio) ou -1 se o processo fechou a entrada.
+    // Depois da primeira chamada, writeInput não deve ser usado
+    long writeInputAvailable(const char* data, size_t size);
+
+    // Descritores para multiplexar stdin (POLLOUT) e stdout (POLLIN) num
+    // único poll; -1 depois de fechados
+    int inputFd() const { return stdin_fd_; }
+    int outputFd() const { return stdout_fd_; }
+
+    // Interromper o processo se a chamada do job foi abandonada (como na
+    // leitura do stdout); true nesse caso
+    bool stopIfAbandoned();
+
+    // Sinalizar fim da entrada (EOF no stdin)
+    void closeInput();
+
+    // Ler do stdout (bloqueante); retorna 0 no fim da saída e -1 em erro
+    // ou interrupção
+    long readOutput(char* buffer, size_t size);
+
+    // Processo encerrado porque a chamada do job foi cancelada ou expirou
+    bool interrupted() const { return interrupted_; }
+
+    // Aguardar término e retornar o código de saída
+    int wait();
+
+    // Encerrar o processo imediatamente
+    void kill();
+
+    // Primeiros bytes do stderr capturado
+    std::string errorOutput(size_t max_size = 4096) const;
+
+private:
+    // Aguardar dados no stdout acompanhando a chamada do job; false se ela
+    // foi abandonada (o processo é interrompido antes de retornar)
+    bool waitForOutput();
+
+    // SIGTERM no grupo, descartando a saída até o fim; SIGKILL após grace
+    void interrupt();
+
+    // Sinal para o grupo do processo
+    void signalGroup(int signal);
+
+#ifndef _WIN32
+    pid_t pid_;
+#endif
+    int stdin_fd_;
+    int stdout_fd_;
+    int stderr_fd_;
+    bool waited_;
+    int exit_code_;
+    bool interrupted_;
+    bool input_nonblocking_;
+};
+
+#endif // PIPED_PROCESS_H
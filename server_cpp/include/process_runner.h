@@ -0,0 +1,124 @@
+#ifndef PROCESS_RUNNER_H
+#define PROCESS_RUNNER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#endif
+
+// Execução de ferramentas externas sem shell: posix_spawn com argv (no
+// glibc, clone+exec sem copiar a tabela de páginas do servidor, ao
+// contrário de fork ou popen, que ainda cria um /bin/sh intermediário).
+// stdout e stderr chegam por pipes separados, lidos com poll em blocos de
+// 64KB. O processo roda no próprio grupo, com limites de tempo, CPU e
+// memória; kill() o encerra a partir de outra thread.
+//
+// Dentro de um job (JobContext::current()), a execução acompanha a
+// chamada: cancelada ou expirada, o grupo recebe SIGTERM e, se não
+// terminar em kill_grace, SIGKILL. O estouro do timeout segue o mesmo
+// caminho. Disponível apenas em plataformas POSIX.
+class ProcessRunner {
+public:
+    struct Limits {
+        // Tempo máximo de execução (0 = sem limite)
+        std::chrono::milliseconds timeout{0};
+        // RLIMIT_CPU em segundos e RLIMIT_AS em bytes (0 = sem limite)
+        size_t cpu_seconds = 0;
+        size_t memory_bytes = 0;
+        // Bytes guardados de cada saída; o excedente é lido e descartado
+        size_t max_output_bytes = 16 * 1024 * 1024;
+        // SIGTERM -> SIGKILL no timeout (nos jobs, vale o kill_grace da chamada)
+        std::chrono::milliseconds kill_grace{2000};
+    };
+
+    struct Result {
+        int exit_code = -1;
+        std::string output;
+        std::string error_output;
+        // Falha ao iniciar ou motivo do encerramento forçado
+        std::string error;
+        bool timed_out = false;
+        bool interrupted = false;
+        bool killed = false;
+        bool truncated = false;
+    };
+
+    ProcessRunner();
+
+    ProcessRunner(const ProcessRunner&) = delete;
+    ProcessRunner& operator=(const ProcessRunner&) = delete;
+
+    static bool isSupported();
+
+    // Executar (argv[0] procurado no PATH) e aguardar o término, com os
+    // limites padrão ou os informados
+    Result run(const std::vector<std::string>& argv);
+    Result run(const std::vector<std::string>& argv, const Limits& limits);
+
+    // Encerrar (SIGKILL no grupo) o processo em execução em run(); pode
+    // ser chamado de outra thread, antes ou durante a execução
+    void kill();
+
+    // Limites usados por run(argv) e executeCommand (configurados pelo servidor)
+    static void setDefaultLimits(const Limits& limits);
+    static Limits defaultLimits();
+
+#ifndef _WIN32
+    // Iniciar argv em um grupo de processos próprio com os fds dados como
+    // stdin/stdout/stderr (-1 = /dev/null) e os limites de CPU e memória
+    static bool spawn(const std::vector<std::string>& argv,
+                      int stdin_fd, int stdout_fd, int stderr_fd,
+                      const Limits& limits, pid_t& pid, std::string& error_message);
+
+    // Pipe com as duas pontas em close-on-exec
+    static bool makePipe(int fds[2]);
+
+    // Código de saída do status do waitpid (128 + sinal se morto por sinal)
+    static int exitCodeFromStatus(int status);
+
+    // Sinal para o grupo de pid (ou só para pid, fora de um grupo próprio)
+    static void signalGroup(pid_t pid, int signal);
+#endif
+
+    // Fechar o descritor, se aberto, e marcá-lo como -1
+    static void closeFd(int& fd);
+
+    // Intervalo em que a execução confere se a chamada do job foi abandonada
+    static constexpr int kPollIntervalMs = 100;
+
+    // Contadores desde o início do servidor
+    static uint64_t spawnCount() { return counters().spawned.load(); }
+    static uint64_t interruptedCount() { return counters().interrupted.load(); }
+    static uint64_t timedOutCount() { return counters().timed_out.load(); }
+
+    // Processo encerrado porque a chamada do job foi abandonada (PipedProcess)
+    static void countInterrupted() { counters().interrupted.fetch_add(1); }
+
+private:
+    struct Counters {
+        std::atomic<uint64_t> spawned{0};
+        std::atomic<uint64_t> interrupted{0};
+        std::atomic<uint64_t> timed_out{0};
+    };
+
+    static Counters& counters() {
+        static Counters instance;
+        return instance;
+    }
+
+    // Protege pid_ contra o reaproveitamento do pid entre o término e kill()
+    std::mutex mutex_;
+#ifndef _WIN32
+    pid_t pid_;
+#endif
+    bool kill_requested_;
+};
+
+#endif // PROCESS_RUNNER_H
@@ -0,0 +1,93 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+class TransferBuffer;
+
+// Cache de resultados endereçado por conteúdo: chave = operação +
+// parâmetros + hash e tamanho da entrada. Camada em memória (LRU) e
+// camada opcional em disco (LRU por arquivo, persistente entre execuções).
+class ResultCache {
+public:
+    struct Stats {
+        uint64_t memory_hits;
+        uint64_t disk_hits;
+        uint64_t misses;
+        uint64_t stores;
+        uint64_t evictions;
+        size_t memory_bytes;
+        size_t memory_entries;
+        size_t disk_bytes;
+        size_t disk_entries;
+    };
+
+    // Instância configurada por FP_CACHE_MEMORY_BYTES, FP_CACHE_DIR e FP_CACHE_DISK_BYTES
+    static ResultCache& getInstance();
+
+    ResultCache(size_t memory_capacity, const std::string& disk_dir,
+                size_t disk_capacity);
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    static std::string makeKey(const std::string& operation,
+                               const std::string& parameters,
+                               uint64_t content_hash, size_t content_size);
+
+    bool enabled() const { return memory_capacity_ > 0 || hasDiskTier(); }
+    bool hasDiskTier() const { return !disk_dir_.empty() && disk_capacity_ > 0; }
+
+    // Maior resultado aceito (entradas maiores não são armazenadas)
+    size_t maxEntryBytes() const;
+
+    // Buscar resultado; com include_disk == false consulta só a memória
+    // (a falta só é contabilizada quando não há outra camada a consultar)
+    bool lookup(const std::string& key, std::string& content, bool include_disk);
+
+    void store(const std::string& key, const std::string& content);
+
+    // Armazenar a saída de uma operação (em memória ou já em disco)
+    void storeOutput(const std::string& key, TransferBuffer& output);
+
+    Stats stats() const;
+
+private:
+    using Entry = std::pair<std::string, std::shared_ptr<const std::string>>;
+    using DiskEntry = std::pair<std::string, size_t>; // arquivo, tamanho
+
+    bool lookupDisk(const std::string& key, std::string& content);
+    void storeMemory(const std::string& key, std::shared_ptr<const std::string> content);
+    void storeDisk(const std::string& key, const std::string& content);
+    void loadDiskIndex();
+    std::string diskFileName(const std::string& key) const;
+
+    size_t memory_capacity_;
+    std::string disk_dir_;
+    size_t disk_capacity_;
+
+    mutable std::mutex memory_mutex_;
+    std::list<Entry> memory_lru_;
+    std::unordered_map<std::string, std::list<Entry>::iterator> memory_index_;
+    size_t memory_bytes_;
+
+    mutable std::mutex disk_mutex_;
+    std::list<DiskEntry> disk_lru_;
+    std::unordered_map<std::string, std::list<DiskEntry>::iterator> disk_index_;
+    size_t disk_bytes_;
+
+    std::atomic<uint64_t> memory_hits_;
+    std::atomic<uint64_t> disk_hits_;
+    std::atomic<uint64_t> misses_;
+    std::atomic<uint64_t> stores_;
+    std::atomic<uint64_t> evictions_;
+};
+
+#endif // RESULT_CACHE_H
@@ -0,0 +1,116 @@
+#ifndef SCRATCH_SPACE_H
+#define SCRATCH_SPACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Espaço temporário do servidor (spills de transferência, saídas das
+// ferramentas, faixas de PDF). Cada processo usa um diretório privado
+// (0700) dentro da raiz configurada, ao lado de um arquivo de lock mantido
+// com flock enquanto o processo vive; na inicialização, diretórios cujo lock
+// está livre (processo encerrado, inclusive por crash) são removidos. Os
+// nomes não colidem (mkstemp ou contador do processo) e, quando o sistema
+// de arquivos permite, os spills usam O_TMPFILE, sem nome e liberados pelo
+// kernel junto com o descritor. A raiz pode ficar em tmpfs (arquivos
+// pequenos, rápidos) ou em NVMe (arquivos grandes). Os bytes em disco são
+// contados por requisição (Quota) e no total.
+class ScratchSpace {
+public:
+    // Bytes em disco de uma requisição, compartilhados pelos seus buffers
+    class Quota {
+    public:
+        explicit Quota(size_t limit) : limit_(limit), used_(0) {}
+
+        Quota(const Quota&) = delete;
+        Quota& operator=(const Quota&) = delete;
+
+        size_t limit() const { return limit_; }
+        size_t used() const { return used_.load(std::memory_order_relaxed); }
+
+    private:
+        friend class ScratchSpace;
+
+        const size_t limit_;
+        std::atomic<size_t> used_;
+    };
+
+    struct Stats {
+        size_t used_bytes = 0;
+        uint64_t quota_rejections = 0;
+        // Diretórios de processos encerrados removidos na inicialização
+        uint64_t orphans_removed = 0;
+        uint64_t orphan_bytes_removed = 0;
+    };
+
+    // Instância configurada por FP_SCRATCH_DIR, FP_SCRATCH_MAX_BYTES e
+    // FP_SCRATCH_REQUEST_QUOTA_BYTES
+    static ScratchSpace& getInstance();
+
+    // root vazio = <tmp>/fp_scratch; limites 0 = sem limite
+    ScratchSpace(const std::string& root, size_t max_bytes, size_t request_quota_bytes);
+    ~ScratchSpace();
+
+    ScratchSpace(const ScratchSpace&) = delete;
+    ScratchSpace& operator=(const ScratchSpace&) = delete;
+
+    // Raiz compartilhada entre processos e diretório privado deste processo
+    // (sem lock, o diretório temporário do sistema)
+    const std::string& root() const { return root_; }
+    const std::string& directory() const { return directory_; }
+    bool isPrivate() const { return lock_fd_ >= 0; }
+    // Motivo de não haver diretório privado (vazio se há)
+    const std::string& setupError() const { return setup_error_; }
+
+    // Cota de uma nova requisição (nullptr se não há limite por requisição)
+    std::shared_ptr<Quota> newQuota() const;
+
+    // Caminho único ainda inexistente, para ferramentas que criam o arquivo
+    std::string uniquePath(const std::string& prefix, const std::string& extension);
+
+    // Criar arquivo vazio com nome único (mkstemps)
+    bool createFile(const std::string& prefix, const std::string& extension,
+                    std::string& path, std::string& error_message);
+
+    // Arquivo sem nome (O_TMPFILE) no diretório do processo; -1 se o
+    // sistema de arquivos ou a plataforma não suportam
+    int createAnonymous(std::string& error_message);
+
+    // Reservar bytes em disco; false se a cota da requisição ou o limite
+    // total seriam ultrapassados (nada é reservado)
+    bool reserve(Quota* quota, size_t bytes, std::string& error_message);
+
+    // Contabilizar sem verificar limites (arquivo que já está em disco)
+    void charge(Quota* quota, size_t bytes);
+
+    void release(Quota* quota, size_t bytes);
+
+    // Capacidade e espaço livre do sistema de arquivos do diretório
+    bool space(size_t& capacity, size_t& available) const;
+
+    Stats stats() const;
+
+private:
+    // Criar o diretório privado e o lock; false mantém o diretório do sistema
+    bool createPrivateDirectory(std::string& error_message);
+    // Remover diretórios de processos encerrados
+    void removeOrphans();
+
+    std::string root_;
+    std::string directory_;
+    std::string lock_path_;
+    std::string setup_error_;
+    int lock_fd_;
+    size_t max_bytes_;
+    size_t request_quota_bytes_;
+
+    std::atomic<uint64_t> sequence_{0};
+    std::atomic<size_t> used_bytes_{0};
+    std::atomic<uint64_t> quota_rejections_{0};
+    uint64_t orphans_removed_ = 0;
+    uint64_t orphan_bytes_removed_ = 0;
+};
+
+#endif // SCRATCH_SPACE_H
@@ -0,0 +1,323 @@
+#ifndef SERVER_CONFIG_H
+#define SERVER_CONFIG_H
+
+#include <string>
+#include <cstddef>
+#include <cstdlib>
+#include <algorithm>
+#include <map>
+#include <utility>
+
+// Limites de uma operação no executor
+struct OperationLimits {
+    // Jobs simultâneos (0 = número de workers)
+    size_t max_concurrent = 0;
+    // Requisições aguardando slot; além disso retorna RESOURCE_EXHAUSTED
+    size_t queue_depth = 32;
+};
+
+// Configuração do servidor, lida das variáveis de ambiente FP_*
+struct ServerConfig {
+    // Usar a engine de imagem in-process antes de recorrer ao ImageMagick
+    bool image_engine_enabled = true;
+
+    // Filtro do redimensionamento in-process ("bilinear", "bicubic", "lanczos")
+    std::string resize_filter = "lanczos";
+
+    // Redução de JPEG na IDCT (1/2, 1/4, 1/8) quando o destino é bem menor
+    bool jpeg_scaled_decode = true;
+
+    // Imagens com mais pixels que isso (pelo cabeçalho) são recusadas antes
+    // do decode; protege contra imagens pequenas que expandem para GBs
+    size_t image_max_pixels = 64 * 1024 * 1024;
+
+    // Arquivos até este tamanho ficam em memória (memfd para ferramentas
+    // externas); acima dele, são gravados em disco
+    size_t spill_threshold_bytes = 32 * 1024 * 1024;
+
+    // ConvertToTXT/CompressPDF em pipeline: stdin da ferramenta alimentado
+    // enquanto os chunks chegam e stdout devolvido assim que produzido. As
+    // chamadas rodam num pool de E/S próprio, uma thread por chamada
+    // (0 = soma dos limites de concorrência das duas operações). Com o
+    // cache de resultados ativo, só entram em pipeline uploads que anunciam
+    // pelo menos pdf_pipeline_min_bytes; os menores (ou sem tamanho) passam
+    // pelo cache no modo buffered
+    bool pdf_pipeline_enabled = true;
+    size_t pipeline_threads = 0;
+    size_t pdf_pipeline_min_bytes = 1024 * 1024;
+
+    // Pool de processos Ghostscript persistentes para CompressPDF
+    // (tamanho 0 = limite de concorrência da operação)
+    bool gs_pool_enabled = true;
+    size_t gs_pool_size = 0;
+    size_t gs_worker_max_jobs = 50;
+
+    // PDFs com pelo menos pdf_shard_min_pages páginas são processados em
+    // faixas paralelas (0 desabilita); pdf_max_shards 0 = threads do executor
+    size_t pdf_shard_min_pages = 100;
+    size_t pdf_max_shards = 0;
+
+    // ConvertToTXT in-process com poppler-cpp, quando compilado (senão,
+    // pdftotext); páginas extraídas em paralelo por até pdf_text_workers
+    // participantes (0 = threads do executor)
+    bool pdf_text_engine_enabled = true;
+    size_t pdf_text_workers = 0;
+
+    // Cache de resultados: camada em memória (0 desabilita) e camada em
+    // disco opcional (habilitada quando cache_dir é definido)
+    size_t cache_memory_bytes = 64 * 1024 * 1024;
+    std::string cache_dir;
+    size_t cache_disk_bytes = 1024ULL * 1024 * 1024;
+
+    // Uploads retomáveis: partes guardadas por upload_id em upload_dir
+    // (vazio = <tmp>/fp_uploads) e removidas após upload_ttl_seconds sem atividade
+    bool resumable_uploads_enabled = true;
+    std::string upload_dir;
+    size_t upload_ttl_seconds = 3600;
+
+    // Arquivos temporários (spills, saídas grandes, faixas de PDF) num
+    // diretório privado do processo dentro de scratch_dir (vazio =
+    // <tmp>/fp_scratch; tmpfs para velocidade, NVMe para volume). Bytes em
+    // disco por requisição e no total (0 = sem limite)
+    std::string scratch_dir;
+    size_t scratch_request_quota_bytes = 0;
+    size_t scratch_max_bytes = 0;
+
+    // Chunks enviados ao cliente: começam pelo tamanho da resposta e se
+    // ajustam à vazão medida, entre chunk_min_bytes e chunk_max_bytes
+    // (valores iguais fixam o tamanho)
+    size_t chunk_min_bytes = 64 * 1024;
+    size_t chunk_max_bytes = 4 * 1024 * 1024;
+
+    // Buffers livres guardados nas listas compartilhadas do ChunkBufferPool
+    // (leitura dos chunks e blocos das arenas das chamadas), além do
+    // pequeno cache de cada thread
+    size_t buffer_pool_bytes = 32 * 1024 * 1024;
+
+    // Controle de fluxo HTTP/2: janela inicial por stream (0 = padrão do
+    // gRPC), sondagem de BDP que alarga a janela conforme o enlace e bytes
+    // que uma escrita com buffer_hint pode deixar pendentes no transporte
+    size_t http2_window_bytes = 0;
+    bool http2_bdp_probe = true;
+    size_t http2_write_buffer_bytes = 1024 * 1024;
+    size_t http2_max_frame_bytes = 0;
+
+    // Compressão gzip das respostas (negociada com o cliente) para saídas
+    // que não chegam comprimidas; chunks cuja amostra economiza menos que
+    // compression_min_savings_percent vão sem compressão
+    bool compression_enabled = true;
+    size_t compression_min_savings_percent = 10;
+
+    // Threads do executor de conversões (0 = núcleos disponíveis)
+    size_t worker_threads = 0;
+
+    // Arquivos de um lote aguardando processamento ou envio antes de pausar
+    // a leitura do stream (0 = 2x threads do executor)
+    size_t batch_max_in_flight = 0;
+
+    // Logger assíncrono: nível mínimo ("info", "success", "warning",
+    // "error") e capacidade da fila; com a fila cheia, registros são descartados
+    std::string log_level = "info";
+    size_t log_queue_size = 8192;
+
+    // Endpoint HTTP GET /metrics no formato do Prometheus (porta 0 desabilita);
+    // só no loopback, salvo FP_METRICS_ADDRESS explícito
+    std::string metrics_address = "127.0.0.1";
+    size_t metrics_port = 9100;
+
+    // Controle de admissão, antes do upload: jobs em andamento (0 = soma de
+    // max_concurrent + queue_depth das operações), parte justa por cliente,
+    // bytes recebidos ainda não processados e espaço livre mínimo no disco
+    // temporário (0 desabilita); recusas sugerem admission_retry_after_ms
+    size_t admission_max_jobs = 0;
+    bool admission_fair_share = true;
+    size_t admission_max_queued_bytes = 4ULL * 1024 * 1024 * 1024;
+    size_t admission_min_free_disk_bytes = 256 * 1024 * 1024;
+    size_t admission_retry_after_ms = 1000;
+
+    // Agendamento dos jobs: a fila de cada operação segue a prioridade
+    // pedida pelo cliente (metadata "fp-priority"; desabilitada, todas valem
+    // 0) e o prazo da chamada. Ferramentas de uma chamada cancelada ou
+    // expirada recebem SIGTERM e, após kill_grace_ms, SIGKILL
+    bool client_priority_enabled = true;
+    size_t kill_grace_ms = 2000;
+
+    // Limites das ferramentas externas (ProcessRunner): tempo de execução,
+    // CPU (RLIMIT_CPU) e memória (RLIMIT_AS); 0 desabilita cada um
+    size_t command_timeout_seconds = 600;
+    size_t command_cpu_seconds = 0;
+    size_t command_memory_bytes = 0;
+
+    // Limites padrão e por operação (FP_<OPERACAO>_MAX_CONCURRENT/_QUEUE_DEPTH)
+    OperationLimits default_limits;
+    std::map<std::string, OperationLimits> operation_limits;
+
+    const OperationLimits& limitsFor(const std::string& operation) const {
+        auto it = operation_limits.find(operation);
+        return it != operation_limits.end() ? it->second : default_limits;
+    }
+
+    static const ServerConfig& getInstance() {
+        static const ServerConfig instance = fromEnvironment();
+        return instance;
+    }
+
+    static ServerConfig fromEnvironment() {
+        ServerConfig config;
+        config.image_engine_enabled = getEnvBool("FP_IMAGE_ENGINE",
+                                                 config.image_engine_enabled);
+        config.resize_filter = getEnvString("FP_RESIZE_FILTER", config.resize_filter);
+        config.jpeg_scaled_decode = getEnvBool("FP_JPEG_SCALED_DECODE",
+                                               config.jpeg_scaled_decode);
+        config.image_max_pixels = getEnvSize("FP_IMAGE_MAX_PIXELS", config.image_max_pixels);
+        config.spill_threshold_bytes = getEnvSize("FP_SPILL_THRESHOLD_BYTES",
+                                                  config.spill_threshold_bytes);
+        config.pdf_pipeline_enabled = getEnvBool("FP_PDF_PIPELINE",
+                                                 config.pdf_pipeline_enabled);
+        config.pipeline_threads = getEnvSize("FP_PIPELINE_THREADS", config.pipeline_threads);
+        config.pdf_pipeline_min_bytes = getEnvSize("FP_PDF_PIPELINE_MIN_BYTES",
+                                                   config.pdf_pipeline_min_bytes);
+        config.gs_pool_enabled = getEnvBool("FP_GS_POOL", config.gs_pool_enabled);
+        config.gs_pool_size = getEnvSize("FP_GS_POOL_SIZE", config.gs_pool_size);
+        config.gs_worker_max_jobs = getEnvSize("FP_GS_WORKER_MAX_JOBS",
+                                               config.gs_worker_max_jobs);
+        config.pdf_shard_min_pages = getEnvSize("FP_PDF_SHARD_MIN_PAGES",
+                                                config.pdf_shard_min_pages);
+        config.pdf_max_shards = getEnvSize("FP_PDF_MAX_SHARDS", config.pdf_max_shards);
+        config.pdf_text_engine_enabled = getEnvBool("FP_PDF_TEXT_ENGINE",
+                                                    config.pdf_text_engine_enabled);
+        config.pdf_text_workers = getEnvSize("FP_PDF_TEXT_WORKERS", config.pdf_text_workers);
+        config.cache_memory_bytes = getEnvSize("FP_CACHE_MEMORY_BYTES",
+                                               config.cache_memory_bytes);
+        config.cache_dir = getEnvString("FP_CACHE_DIR", config.cache_dir);
+        config.cache_disk_bytes = getEnvSize("FP_CACHE_DISK_BYTES",
+                                             config.cache_disk_bytes);
+        config.resumable_uploads_enabled = getEnvBool("FP_RESUMABLE_UPLOADS",
+                                                      config.resumable_uploads_enabled);
+        config.upload_dir = getEnvString("FP_UPLOAD_DIR", config.upload_dir);
+        config.upload_ttl_seconds = getEnvSize("FP_UPLOAD_TTL_SECONDS",
+                                               config.upload_ttl_seconds);
+        config.scratch_dir = getEnvString("FP_SCRATCH_DIR", config.scratch_dir);
+        config.scratch_request_quota_bytes = getEnvSize("FP_SCRATCH_REQUEST_QUOTA_BYTES",
+                                                        config.scratch_request_quota_bytes);
+        config.scratch_max_bytes = getEnvSize("FP_SCRATCH_MAX_BYTES",
+                                              config.scratch_max_bytes);
+        config.chunk_min_bytes = getEnvSize("FP_CHUNK_MIN_BYTES", config.chunk_min_bytes);
+        config.chunk_max_bytes = getEnvSize("FP_CHUNK_MAX_BYTES", config.chunk_max_bytes);
+        // Abaixo do limite de mensagem do servidor (100MB)
+        config.chunk_min_bytes = std::min<size_t>(std::max<size_t>(
+            config.chunk_min_bytes, 1024), 64 * 1024 * 1024);
+        config.chunk_max_bytes = std::min<size_t>(std::max(
+            config.chunk_max_bytes, config.chunk_min_bytes), 64 * 1024 * 1024);
+        config.buffer_pool_bytes = getEnvSize("FP_BUFFER_POOL_BYTES",
+                                              config.buffer_pool_bytes);
+        config.http2_window_bytes = getEnvSize("FP_HTTP2_WINDOW_BYTES",
+                                               config.http2_window_bytes);
+        config.http2_bdp_probe = getEnvBool("FP_HTTP2_BDP_PROBE", config.http2_bdp_probe);
+        config.http2_write_buffer_bytes = getEnvSize("FP_HTTP2_WRITE_BUFFER_BYTES",
+                                                     config.http2_write_buffer_bytes);
+        config.http2_max_frame_bytes = getEnvSize("FP_HTTP2_MAX_FRAME_BYTES",
+                                                  config.http2_max_frame_bytes);
+        config.compression_enabled = getEnvBool("FP_COMPRESSION", config.compression_enabled);
+        config.compression_min_savings_percent = std::min<size_t>(getEnvSize(
+            "FP_COMPRESSION_MIN_SAVINGS", config.compression_min_savings_percent), 100);
+        config.worker_threads = getEnvSize("FP_WORKER_THREADS", config.worker_threads);
+        config.batch_max_in_flight = getEnvSize("FP_BATCH_MAX_IN_FLIGHT",
+                                                config.batch_max_in_flight);
+        config.log_level = getEnvString("FP_LOG_LEVEL", config.log_level);
+        config.log_queue_size = getEnvSize("FP_LOG_QUEUE_SIZE", config.log_queue_size);
+        config.metrics_address = getEnvString("FP_METRICS_ADDRESS", config.metrics_address);
+        config.metrics_port = getEnvSize("FP_METRICS_PORT", config.metrics_port);
+
+        config.admission_max_jobs = getEnvSize("FP_ADMISSION_MAX_JOBS",
+                                               config.admission_max_jobs);
+        config.admission_fair_share = getEnvBool("FP_ADMISSION_FAIR_SHARE",
+                                                 config.admission_fair_share);
+        config.admission_max_queued_bytes = getEnvSize("FP_ADMISSION_MAX_QUEUED_BYTES",
+                                                       config.admission_max_queued_bytes);
+        config.admission_min_free_disk_bytes = getEnvSize(
+            "FP_ADMISSION_MIN_FREE_DISK_BYTES", config.admission_min_free_disk_bytes);
+        config.admission_retry_after_ms = std::max<size_t>(getEnvSize(
+            "FP_ADMISSION_RETRY_AFTER_MS", config.admission_retry_after_ms), 1);
+
+        config.client_priority_enabled = getEnvBool("FP_CLIENT_PRIORITY",
+                                                    config.client_priority_enabled);
+        config.kill_grace_ms = getEnvSize("FP_KILL_GRACE_MS", config.kill_grace_ms);
+        config.command_timeout_seconds = getEnvSize("FP_COMMAND_TIMEOUT_SECONDS",
+                                                    config.command_timeout_seconds);
+        config.command_cpu_seconds = getEnvSize("FP_COMMAND_CPU_SECONDS",
+                                                config.command_cpu_seconds);
+        config.command_memory_bytes = getEnvSize("FP_COMMAND_MEMORY_BYTES",
+                                                 config.command_memory_bytes);
+
+        config.default_limits.max_concurrent = getEnvSize(
+            "FP_MAX_CONCURRENT", config.default_limits.max_concurrent);
+        config.default_limits.queue_depth = getEnvSize(
+            "FP_QUEUE_DEPTH", config.default_limits.queue_depth);
+
+        const std::pair<const char*, const char*> operations[] = {
+            {"CompressPDF", "FP_COMPRESS_PDF"},
+            {"ConvertToTXT", "FP_CONVERT_TO_TXT"},
+            {"ConvertImageFormat", "FP_CONVERT_IMAGE_FORMAT"},
+            {"ResizeImage", "FP_RESIZE_IMAGE"},
+        };
+        for (const auto& operation : operations) {
+            OperationLimits limits = config.default_limits;
+            std::string prefix = operation.second;
+            limits.max_concurrent = getEnvSize((prefix + "_MAX_CONCURRENT").c_str(),
+                                               limits.max_concurrent);
+            limits.queue_depth = getEnvSize((prefix + "_QUEUE_DEPTH").c_str(),
+                                            limits.queue_depth);
+            config.operation_limits[operation.first] = limits;
+        }
+        return config;
+    }
+
+    // Ler variável booleana ("1", "true", "on", "yes" habilitam)
+    static bool getEnvBool(const char* name, bool default_value) {
+        const char* value = std::getenv(name);
+        if (value == nullptr || *value == '\0') {
+            return default_value;
+        }
+
+        std::string lower_value = value;
+        std::transform(lower_value.begin(), lower_value.end(),
+                      lower_value.begin(), ::tolower);
+
+        return lower_value == "1" || lower_value == "true" ||
+               lower_value == "on" || lower_value == "yes";
+    }
+
+    // Ler variável inteira, mantendo o padrão se inválida
+    static long long getEnvInt(const char* name, long long default_value) {
+        const char* value = std::getenv(name);
+        if (value == nullptr || *value == '\0') {
+            return default_value;
+        }
+
+        char* end = nullptr;
+        long long parsed = std::strtoll(value, &end, 10);
+        if (end == value || *end != '\0') {
+            return default_value;
+        }
+        return parsed;
+    }
+
+    // Ler variável inteira não negativa
+    static size_t getEnvSize(const char* name, size_t default_value) {
+        return static_cast<size_t>(std::max<long long>(0,
+            getEnvInt(name, static_cast<long long>(default_value))));
+    }
+
+    // Ler variável texto
+    static std::string getEnvString(const char* name,
+                                    const std::string& default_value) {
+        const char* value = std::getenv(name);
+        if (value == nullptr || *value == '\0') {
+            return default_value;
+        }
+        return value;
+    }
+};
+
+#endif // SERVER_CONFIG_H
@@ -0,0 +1,103 @@
+#ifndef TRANSFER_BUFFER_H
+#define TRANSFER_BUFFER_H
+
+#include <string>
+#include <fstream>
+#include <cstddef>
+#include <memory>
+
+#include "scratch_space.h"
+
+// Buffer de transferência de arquivos do servidor.
+//
+// O conteúdo fica em memória enquanto não ultrapassa o limite de spill;
+// acima disso é gravado no ScratchSpace (O_TMPFILE quando possível, senão
+// um arquivo com nome), contando na cota da requisição. Quando uma
+// ferramenta externa precisa de um caminho, o conteúdo em memória é exposto
+// via memfd (Linux), de modo que arquivos pequenos nunca tocam o sistema de
+// arquivos. Arquivos temporários e descritores são liberados no destrutor.
+class TransferBuffer {
+public:
+    // quota: cota de disco da requisição (nullptr = só o limite total)
+    explicit TransferBuffer(size_t spill_threshold,
+                            std::shared_ptr<ScratchSpace::Quota> quota = nullptr);
+    ~TransferBuffer();
+
+    TransferBuffer(const TransferBuffer&) = delete;
+    TransferBuffer& operator=(const TransferBuffer&) = delete;
+
+    // Acrescentar dados (recebimento por chunks)
+    bool append(const char* data, size_t size, std::string& error_message);
+
+    // Substituir todo o conteúdo (saída produzida em memória)
+    bool assign(std::string content, std::string& error_message);
+
+    // Assumir um arquivo já completo em disco (removido no destrutor)
+    bool adoptFile(const std::string& path, std::string& error_message);
+
+    // Reservar capacidade quando o tamanho final é conhecido
+    void reserve(size_t size);
+
+    size_t size() const { return size_; }
+    bool inMemory() const { return storage_ == Storage::MEMORY; }
+    bool onDisk() const { return storage_ == Storage::DISK || storage_ == Storage::TMPFILE; }
+
+    // A última falha foi por falta de espaço temporário (cota ou limite total)
+    bool quotaExceeded() const { return quota_exceeded_; }
+
+    // Conteúdo em memória (válido apenas se inMemory())
+    const std::string& memory() const { return memory_; }
+
+    // Ler o conteúdo completo, independente do armazenamento
+    bool readAll(std::string& content);
+
+    // Ler até length bytes a partir de offset; retorna bytes lidos
+    size_t readAt(size_t offset, char* buffer, size_t length);
+
+    // Caminho legível por um processo externo
+    bool inputPath(std::string& path, std::string& error_message);
+
+    // Preparar destino para um processo externo gravar a saída.
+    // prefer_disk força arquivo temporário (entradas grandes geram saídas grandes)
+    bool prepareOutput(bool prefer_disk, const std::string& extension,
+                       std::string& path, std::string& error_message);
+
+    // Atualizar o tamanho após o processo externo terminar de gravar
+    bool commitOutput(std::string& error_message);
+
+    // Descrição curta para logs ("memory", "memfd", "tmpfile", caminho em disco)
+    std::string description() const;
+
+private:
+    enum class Storage {
+        MEMORY,
+        MEMFD,
+        // Arquivo sem nome no ScratchSpace, acessado como o memfd
+        TMPFILE,
+        DISK
+    };
+
+    bool spillToDisk(const std::string& extension, std::string& error_message);
+    bool createMemfd(std::string& error_message);
+    bool writeFd(const char* data, size_t size, std::string& error_message);
+    // Caminho /proc/<pid>/fd/<n> do descritor
+    std::string fdPath() const;
+    void release();
+    // Ajustar os bytes contados no ScratchSpace ao tamanho atual em disco;
+    // com enforce, falha se a cota ou o limite total seriam ultrapassados
+    bool accountDisk(size_t bytes, bool enforce, std::string& error_message);
+
+    size_t spill_threshold_;
+    std::shared_ptr<ScratchSpace::Quota> quota_;
+    Storage storage_;
+    size_t size_;
+    std::string memory_;
+    std::string disk_path_;
+    std::fstream disk_stream_;
+    // memfd ou O_TMPFILE
+    int fd_;
+    size_t disk_accounted_;
+    bool quota_exceeded_;
+};
+
+#endif // TRANSFER_BUFFER_H
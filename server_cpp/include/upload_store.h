@@ -0,0 +1,92 @@
+#ifndef UPLOAD_STORE_H
+#define UPLOAD_STORE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Uploads parciais retomáveis. Cada upload vira um arquivo
+// <token>_<tamanho>.part no diretório configurado; o token é gerado pelo
+// servidor (128 bits aleatórios) e devolvido ao cliente, que o apresenta
+// para retomar de qualquer endereço. O tamanho atual do arquivo é o offset
+// confirmado (os chunks só são gravados depois de verificados, em ordem).
+// Um upload aberto não pode ser usado por outro
+// stream; partes sem atividade por mais que o TTL são removidas. Os bytes
+// das partes contam no limite total do ScratchSpace, e os das partes
+// paradas (sem stream) em parkedBytes(), somados aos bytes na fila do
+// controle de admissão.
+class UploadStore {
+public:
+    // Instância configurada por FP_RESUMABLE_UPLOADS, FP_UPLOAD_DIR e
+    // FP_UPLOAD_TTL_SECONDS
+    static UploadStore& getInstance();
+
+    UploadStore(const std::string& directory, std::chrono::seconds ttl);
+
+    UploadStore(const UploadStore&) = delete;
+    UploadStore& operator=(const UploadStore&) = delete;
+
+    bool enabled() const { return !directory_.empty(); }
+
+    // Token novo e imprevisível (32 dígitos hexadecimais)
+    static std::string newToken();
+
+    // Abrir ou retomar um upload. requested_id é o token de uma chamada
+    // anterior; sem parte guardada sob ele para file_size (primeira chamada,
+    // parte expirada ou id escolhido pelo cliente), o upload começa do zero
+    // com um token novo. upload_id recebe o token em uso e committed_offset
+    // os bytes já guardados. Falha se o upload está aberto em outro stream
+    bool open(const std::string& requested_id, uint64_t file_size, std::string& upload_id,
+              uint64_t& committed_offset, std::string& error_message);
+
+    // Acrescentar dados verificados ao upload aberto; space_exhausted indica
+    // falha pelo limite do espaço temporário
+    bool append(const std::string& upload_id, const char* data, size_t size,
+                std::string& error_message, bool* space_exhausted = nullptr);
+
+    // Fechar o stream mantendo a parte para uma retomada
+    void release(const std::string& upload_id);
+
+    // Upload completo: a parte sai do diretório e passa a pertencer a quem
+    // chamou, em path (arquivo temporário comum)
+    bool complete(const std::string& upload_id, std::string& path,
+                  std::string& error_message);
+
+    // Remover partes expiradas; retorna quantas foram removidas
+    size_t removeExpired();
+
+    size_t activeUploads() const;
+
+    // Bytes em partes sem stream aberto (aguardando retomada)
+    uint64_t parkedBytes() const { return parked_bytes_.load(std::memory_order_relaxed); }
+
+    // Letras, dígitos, '-' e '_' (até 128 caracteres): o id compõe o nome do arquivo
+    static bool isValidId(const std::string& upload_id);
+
+private:
+    struct ActiveUpload {
+        std::string path;
+        std::ofstream stream;
+        uint64_t bytes = 0;
+    };
+
+    std::string partPath(const std::string& upload_id, uint64_t file_size) const;
+
+    void park(uint64_t bytes);
+    void unpark(uint64_t bytes);
+
+    std::string directory_;
+    std::chrono::seconds ttl_;
+
+    mutable std::mutex mutex_;
+    std::map<std::string, std::unique_ptr<ActiveUpload>> active_;
+    std::chrono::steady_clock::time_point last_sweep_;
+    std::atomic<uint64_t> parked_bytes_{0};
+};
+
+#endif // UPLOAD_STORE_H
@@ -0,0 +1,63 @@
+#ifndef WORK_STEALING_EXECUTOR_H
+#define WORK_STEALING_EXECUTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pool fixo de threads para as conversões pesadas em CPU. Cada worker tem
+// sua própria fila: tarefas submetidas por um worker vão para a fila dele
+// (LIFO, aproveitando cache), as externas são distribuídas em round-robin,
+// e um worker ocioso rouba do início da fila dos demais.
+class WorkStealingExecutor {
+public:
+    using Task = std::function<void()>;
+
+    // num_threads == 0 usa defaultThreadCount()
+    explicit WorkStealingExecutor(size_t num_threads = 0);
+    ~WorkStealingExecutor();
+
+    WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+    WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+
+    void submit(Task task);
+
+    // Executar body(0..count-1) em paralelo e aguardar. A thread chamadora
+    // também consome índices, então pode ser usado de dentro de um worker
+    void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+    // Executar as tarefas pendentes e encerrar os workers
+    void shutdown();
+
+    size_t threadCount() const { return workers_.size(); }
+    size_t pendingTasks() const { return pending_.load(); }
+
+    // Núcleos disponíveis, respeitando a cota de CPU do cgroup (containers)
+    static size_t defaultThreadCount();
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(size_t index);
+    bool popTask(size_t index, Task& task);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    std::atomic<size_t> pending_;
+    std::atomic<size_t> next_worker_;
+    bool stopping_;
+};
+
+#endif // WORK_STEALING_EXECUTOR_H
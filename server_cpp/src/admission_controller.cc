@@ -0,0 +1,251 @@
+#include "admission_controller.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <limits>
+
+namespace fs = std::filesystem;
+
+namespace {
+// Espaço livre do disco consultado no máximo uma vez por intervalo
+const std::chrono::seconds kDiskCheckInterval(1);
+
+// Disco cheio não se resolve com a próxima requisição concluída
+const int kDiskRetryFactor = 5;
+}
+
+AdmissionController::AdmissionController(const Limits& limits)
+    : limits_(limits),
+      jobs_(0),
+      bytes_(0),
+      free_disk_bytes_(0),
+      disk_checked_(false) {
+    for (auto& counter : rejections_) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+std::string AdmissionController::peerKey(const std::string& peer) {
+    // Conexões do mesmo cliente diferem só na porta (unix: caminho inteiro)
+    if (peer.compare(0, 5, "ipv4:") != 0 && peer.compare(0, 5, "ipv6:") != 0) {
+        return peer;
+    }
+    size_t separator = peer.rfind(':');
+    return separator > 5 ? peer.substr(0, separator) : peer;
+}
+
+const char* AdmissionController::reasonName(Reason reason) {
+    switch (reason) {
+        case Reason::CAPACITY: return "capacity";
+        case Reason::PEER_SHARE: return "peer_share";
+        case Reason::QUEUED_BYTES: return "queued_bytes";
+        case Reason::DISK: return "disk";
+        default: return "other";
+    }
+}
+
+bool AdmissionController::admit(const std::string& peer, Ticket& ticket,
+                                std::string& error_message) {
+    ticket.release();
+    const std::string key = peerKey(peer);
+    auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (limits_.min_free_disk_bytes > 0) {
+        uint64_t free_bytes = freeDiskLocked(now);
+        if (free_bytes < limits_.min_free_disk_bytes) {
+            reject(Reason::DISK, key, ticket, now);
+            error_message = "Server overloaded: " + std::to_string(free_bytes) +
+                            " bytes of temporary disk free (minimum " +
+                            std::to_string(limits_.min_free_disk_bytes) + ")";
+            return false;
+        }
+    }
+
+    if (limits_.max_jobs > 0 && jobs_ >= limits_.max_jobs) {
+        reject(Reason::CAPACITY, key, ticket, now);
+        error_message = "Server overloaded: " + std::to_string(jobs_) +
+                        " jobs in progress (limit " + std::to_string(limits_.max_jobs) + ")";
+        return false;
+    }
+
+    PeerState& state = peers_[key];
+    if (limits_.max_jobs > 0 && limits_.fair_share) {
+        size_t share = fairShareLocked(key, now);
+        if (state.jobs >= share) {
+            reject(Reason::PEER_SHARE, key, ticket, now);
+            error_message = "Client share exceeded: " + std::to_string(state.jobs) +
+                            " jobs in progress (fair share " + std::to_string(share) +
+                            " of " + std::to_string(limits_.max_jobs) + ")";
+            return false;
+        }
+    }
+
+    ++state.jobs;
+    ++jobs_;
+    ticket.controller_ = this;
+    ticket.peer_ = key;
+    ticket.jobs_ = 1;
+    ticket.bytes_ = 0;
+    ticket.retry_after_ = std::chrono::milliseconds(0);
+    return true;
+}
+
+size_t AdmissionController::fairShareLocked(const std::string& peer,
+                                            std::chrono::steady_clock::time_point now) {
+    // Disputam vagas os clientes com jobs em andamento e os recusados há
+    // pouco (ainda devem tentar de novo), além de quem pede agora
+    const auto waiting_window = limits_.retry_after * 3;
+    size_t competing = 0;
+    for (auto it = peers_.begin(); it != peers_.end();) {
+        const PeerState& state = it->second;
+        bool waiting = state.rejected_at.time_since_epoch().count() != 0 &&
+                       now - state.rejected_at < waiting_window;
+        if (state.jobs > 0 || waiting || it->first == peer) {
+            ++competing;
+            ++it;
+        } else {
+            it = peers_.erase(it);
+        }
+    }
+    return std::max<size_t>(1, (limits_.max_jobs + competing - 1) /
+                               std::max<size_t>(competing, 1));
+}
+
+uint64_t AdmissionController::freeDiskLocked(std::chrono::steady_clock::time_point now) {
+    if (!disk_checked_ || now - disk_checked_at_ >= kDiskCheckInterval) {
+        std::error_code error;
+        fs::space_info space = fs::space(limits_.disk_path, error);
+        // Falha na consulta não bloqueia o servidor
+        free_disk_bytes_ = error ? std::numeric_limits<uint64_t>::max()
+                                 : static_cast<uint64_t>(space.available);
+        disk_checked_at_ = now;
+        disk_checked_ = true;
+    }
+    return free_disk_bytes_;
+}
+
+void AdmissionController::reject(Reason reason, const std::string& peer, Ticket& ticket,
+                                 std::chrono::steady_clock::time_point now) {
+    rejections_[static_cast<size_t>(reason)].fetch_add(1, std::memory_order_relaxed);
+    peers_[peer].rejected_at = now;
+    ticket.retry_after_ = reason == Reason::DISK
+        ? limits_.retry_after * kDiskRetryFactor : limits_.retry_after;
+}
+
+void AdmissionController::releaseTicket(Ticket& ticket) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_ -= std::min(jobs_, ticket.jobs_);
+    bytes_ -= std::min(bytes_, ticket.bytes_);
+    auto it = peers_.find(ticket.peer_);
+    if (it != peers_.end()) {
+        it->second.jobs -= std::min(it->second.jobs, ticket.jobs_);
+        // Recusados ficam até a janela de espera expirar (fairShareLocked)
+        if (it->second.jobs == 0 && it->second.rejected_at.time_since_epoch().count() == 0) {
+            peers_.erase(it);
+        }
+    }
+}
+
+size_t AdmissionController::activeJobs() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return jobs_;
+}
+
+uint64_t AdmissionController::parkedBytes() const {
+    return limits_.parked_bytes ? limits_.parked_bytes() : 0;
+}
+
+uint64_t AdmissionController::queuedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+}
+
+size_t AdmissionController::activePeers() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<size_t>(std::count_if(peers_.begin(), peers_.end(),
+        [](const std::pair<const std::string, PeerState>& entry) {
+            return entry.second.jobs > 0;
+        }));
+}
+
+bool AdmissionController::Ticket::reserveBytes(uint64_t bytes, std::string& error_message) {
+    if (controller_ == nullptr || bytes <= bytes_) {
+        return true;
+    }
+
+    AdmissionController& controller = *controller_;
+    std::lock_guard<std::mutex> lock(controller.mutex_);
+    uint64_t limit = controller.limits_.max_queued_bytes;
+    uint64_t others = controller.bytes_ - bytes_ + controller.parkedBytes();
+    // Um arquivo maior que o limite passa sozinho: o limite evita acúmulo
+    if (limit > 0 && others > 0 && others + bytes > limit) {
+        controller.reject(Reason::QUEUED_BYTES, peer_, *this,
+                          std::chrono::steady_clock::now());
+        error_message = "Server overloaded: " + std::to_string(others) +
+                        " bytes queued, request needs " + std::to_string(bytes) +
+                        " (limit " + std::to_string(limit) + ")";
+        return false;
+    }
+    controller.bytes_ = controller.bytes_ - bytes_ + bytes;
+    bytes_ = bytes;
+    return true;
+}
+
+void AdmissionController::Ticket::setUsage(size_t jobs, uint64_t bytes) {
+    if (controller_ == nullptr) {
+        return;
+    }
+
+    AdmissionController& controller = *controller_;
+    std::lock_guard<std::mutex> lock(controller.mutex_);
+    controller.jobs_ = controller.jobs_ - jobs_ + jobs;
+    controller.bytes_ = controller.bytes_ - bytes_ + bytes;
+    PeerState& state = controller.peers_[peer_];
+    state.jobs = state.jobs - std::min(state.jobs, jobs_) + jobs;
+    jobs_ = jobs;
+    bytes_ = bytes;
+}
+
+size_t AdmissionController::Ticket::jobAllowance() const {
+    if (controller_ == nullptr) {
+        return 1;
+    }
+
+    AdmissionController& controller = *controller_;
+    size_t max_jobs = controller.limits_.max_jobs;
+    if (max_jobs == 0) {
+        return std::numeric_limits<size_t>::max();
+    }
+
+    std::lock_guard<std::mutex> lock(controller.mutex_);
+    size_t others = controller.jobs_ - std::min(controller.jobs_, jobs_);
+    size_t allowance = max_jobs > others ? max_jobs - others : 0;
+    if (controller.limits_.fair_share) {
+        size_t share = controller.fairShareLocked(peer_, std::chrono::steady_clock::now());
+        auto it = controller.peers_.find(peer_);
+        size_t peer_others = it == controller.peers_.end()
+            ? 0 : it->second.jobs - std::min(it->second.jobs, jobs_);
+        allowance = std::min(allowance, share > peer_others ? share - peer_others : 0);
+    }
+    return std::max<size_t>(allowance, 1);
+}
+
+bool AdmissionController::Ticket::bytesAvailable() const {
+    if (controller_ == nullptr || controller_->limits_.max_queued_bytes == 0) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(controller_->mutex_);
+    return controller_->bytes_ + controller_->parkedBytes() <
+           controller_->limits_.max_queued_bytes;
+}
+
+void AdmissionController::Ticket::release() {
+    if (controller_ == nullptr) {
+        return;
+    }
+    controller_->releaseTicket(*this);
+    controller_ = nullptr;
+    jobs_ = 0;
+    bytes_ = 0;
+}
@@ -0,0 +1,493 @@
+#include "batch_reactor.h"
+#include "file_transfer_reactor.h"
+#include "result_cache.h"
+#include "server_config.h"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+BatchReactor::BatchReactor(grpc::CallbackServerContext* context, Resolver resolver,
+                           size_t max_in_flight, AdmissionController& admission)
+    : context_(context),
+      job_(FileTransferReactor::jobContextFor(context)),
+      resolver_(std::move(resolver)),
+      max_in_flight_(std::max<size_t>(max_in_flight, 1)),
+      logger_(Logger::getInstance()),
+      spill_threshold_(ServerConfig::getInstance().spill_threshold_bytes),
+      scratch_quota_(ScratchSpace::getInstance().newQuota()),
+      arena_(callArenaOptions()),
+      read_request_(
+          google::protobuf::Arena::CreateMessage<file_processor::BatchRequest>(&arena_)),
+      write_response_(
+          google::protobuf::Arena::CreateMessage<file_processor::BatchResponse>(&arena_)),
+      chunk_sizer_(ServerConfig::getInstance().chunk_min_bytes,
+                   ServerConfig::getInstance().chunk_max_bytes),
+      write_length_(0),
+      metadata_sent_(false),
+      compression_totals_(ServerConfig::getInstance().compression_enabled,
+                          ServerConfig::getInstance().compression_min_savings_percent),
+      queued_bytes_(0),
+      sending_(nullptr),
+      reading_(true),
+      reads_done_(false),
+      writing_(false),
+      finished_(false),
+      stream_failed_(false),
+      files_completed_(0),
+      files_failed_(0) {
+    if (compression_totals_.enabled()) {
+        context_->set_compression_level(GRPC_COMPRESS_LEVEL_LOW);
+    }
+
+    std::string error;
+    if (!admission.admit(context_->peer(), admission_, error)) {
+        logger_.log(LogLevel::WARNING_LEVEL, "ProcessBatch", context_->peer(),
+                   error + " (retry after " +
+                   std::to_string(admission_.retryAfter().count()) + "ms)");
+        context_->AddTrailingMetadata("fp-retry-after-ms",
+                                      std::to_string(admission_.retryAfter().count()));
+        finished_ = true;
+        reads_done_ = true;
+        reading_ = false;
+        Finish(grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, error));
+        return;
+    }
+    StartRead(read_request_);
+}
+
+void BatchReactor::OnReadDone(bool ok) {
+    if (ok && handleRequest(*read_request_)) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            reading_ = false;
+        }
+        advance();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        reading_ = false;
+        reads_done_ = true;
+    }
+    closeUploads();
+    advance();
+}
+
+void BatchReactor::closeUploads() {
+    // Fim da leitura: arquivos sem end_of_file não serão processados
+    std::vector<std::unique_ptr<BatchFile>> incomplete;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& entry : uploads_) {
+            incomplete.push_back(std::move(entry.second));
+        }
+        uploads_.clear();
+    }
+
+    for (auto& file : incomplete) {
+        if (file->status.ok()) {
+            file->status = grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                        "Batch ended before end_of_file for file " +
+                                        std::to_string(file->id));
+        }
+        processFile(std::move(file));
+    }
+}
+
+bool BatchReactor::handleRequest(const file_processor::BatchRequest& request) {
+    // uploads_ só é alterado pelos callbacks de leitura (um por vez)
+    const uint64_t id = request.file_id();
+    auto it = uploads_.find(id);
+
+    if (it == uploads_.end()) {
+        // Cada arquivo aberto segura um buffer: além do limite do lote e
+        // da parte justa do cliente, o lote é encerrado
+        size_t max_open = std::min(max_in_flight_, admission_.jobAllowance());
+        if (uploads_.size() >= max_open) {
+            std::string error = "Too many open files in batch (limit " +
+                                std::to_string(max_open) + ")";
+            logger_.log(LogLevel::WARNING_LEVEL, "ProcessBatch", context_->peer(), error);
+            std::lock_guard<std::mutex> lock(mutex_);
+            final_status_ = grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, error);
+            return false;
+        }
+
+        const ServerConfig& config = ServerConfig::getInstance();
+        std::unique_ptr<BatchFile> file(new BatchFile(
+            spill_threshold_, scratch_quota_, config.compression_enabled,
+            config.compression_min_savings_percent));
+        file->id = id;
+        file->received_at = std::chrono::steady_clock::now();
+        if (!request.has_header()) {
+            file->status = grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                        "First message of file " + std::to_string(id) +
+                                        " has no header");
+        } else {
+            file->file_name = request.header().file_name();
+            std::string error_msg;
+            if (!resolver_(request.header(), file->operation, error_msg)) {
+                file->status = grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, error_msg);
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        it = uploads_.emplace(id, std::move(file)).first;
+    } else if (request.has_header() && it->second->status.ok()) {
+        it->second->status = grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                          "Duplicate header for file " + std::to_string(id));
+    }
+
+    BatchFile& file = *it->second;
+    if (file.status.ok() && !request.content().empty()) {
+        file.hasher.update(request.content().data(), request.content().size());
+        std::string error_msg;
+        if (!file.input.append(request.content().data(), request.content().size(),
+                               error_msg)) {
+            logger_.log(LogLevel::ERROR_LEVEL, "ProcessBatch", file.input.description(),
+                       error_msg);
+            file.status = grpc::Status(file.input.quotaExceeded()
+                                           ? grpc::StatusCode::RESOURCE_EXHAUSTED
+                                           : grpc::StatusCode::INTERNAL,
+                                       error_msg);
+        } else {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queued_bytes_ += request.content().size();
+        }
+    }
+
+    if (request.end_of_file()) {
+        std::unique_ptr<BatchFile> complete = std::move(it->second);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            uploads_.erase(it);
+        }
+        processFile(std::move(complete));
+    }
+    return true;
+}
+
+void BatchReactor::processFile(std::unique_ptr<BatchFile> file) {
+    BatchFile* raw = file.get();
+    // Cabeçalho inválido não tem operação: contabilizado como "other"
+    raw->metrics = &Metrics::getInstance().operation(raw->operation.service_name);
+    raw->metrics->requests.fetch_add(1, std::memory_order_relaxed);
+    raw->metrics->bytes_in.fetch_add(raw->input.size(), std::memory_order_relaxed);
+    raw->metrics->observe(RequestPhase::RECEIVE, raw->received_at);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_flight_[raw] = std::move(file);
+    }
+
+    if (!raw->status.ok()) {
+        completeFile(raw, raw->status);
+        return;
+    }
+
+    const std::string& service_name = raw->operation.service_name;
+    logger_.log(LogLevel::INFO_LEVEL, "ProcessBatch", raw->file_name,
+               "File " + std::to_string(raw->id) + " received (" +
+               std::to_string(raw->input.size()) + " bytes), " + service_name);
+
+    // Acerto na memória é servido sem passar pela fila
+    ResultCache& cache = ResultCache::getInstance();
+    if (cache.enabled()) {
+        raw->cache_key = ResultCache::makeKey(service_name,
+                                              raw->operation.cache_parameters,
+                                              raw->hasher.digest(), raw->input.size());
+        std::string cached;
+        std::string error_msg;
+        if (cache.lookup(raw->cache_key, cached, false)) {
+            raw->metrics->cache_hits.fetch_add(1, std::memory_order_relaxed);
+            completeFile(raw, raw->output.assign(std::move(cached), error_msg)
+                ? grpc::Status::OK
+                : grpc::Status(grpc::StatusCode::INTERNAL, error_msg));
+            return;
+        }
+    }
+
+    OperationLimiter& limiter = *raw->operation.limiter;
+    auto dropped = [this, raw](OperationLimiter::DropReason) {
+        completeFile(raw, abandonedStatus("before processing"));
+    };
+    if (!limiter.submit([this, raw]() { runFile(raw); }, job_, dropped)) {
+        std::string error = "Server busy: " + service_name + " queue is full (" +
+                            std::to_string(limiter.maxConcurrent()) + " running, " +
+                            std::to_string(limiter.queueDepth()) + " queued)";
+        logger_.log(LogLevel::WARNING_LEVEL, "ProcessBatch", raw->file_name, error);
+        completeFile(raw, grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, error));
+    }
+}
+
+grpc::Status BatchReactor::abandonedStatus(const std::string& when) const {
+    if (job_->expired()) {
+        return grpc::Status(grpc::StatusCode::DEADLINE_EXCEEDED,
+                            "Deadline exceeded " + when);
+    }
+    return grpc::Status(grpc::StatusCode::CANCELLED, "Request cancelled " + when);
+}
+
+void BatchReactor::runFile(BatchFile* file) {
+    if (context_->IsCancelled() || job_->abandoned()) {
+        completeFile(file, abandonedStatus("before processing"));
+        return;
+    }
+
+    ResultCache& cache = ResultCache::getInstance();
+    if (!file->cache_key.empty() && cache.hasDiskTier()) {
+        std::string cached;
+        std::string error_msg;
+        if (cache.lookup(file->cache_key, cached, true) &&
+            file->output.assign(std::move(cached), error_msg)) {
+            file->metrics->cache_hits.fetch_add(1, std::memory_order_relaxed);
+            completeFile(file, grpc::Status::OK);
+            return;
+        }
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    grpc::Status status;
+    try {
+        status = file->operation.handler(file->input, file->output);
+    } catch (const std::exception& e) {
+        status = grpc::Status(grpc::StatusCode::INTERNAL,
+                              "Unhandled exception in " + file->operation.service_name +
+                              ": " + e.what());
+    } catch (...) {
+        status = grpc::Status(grpc::StatusCode::INTERNAL,
+                              "Unhandled unknown exception in " +
+                              file->operation.service_name);
+    }
+    file->metrics->observe(RequestPhase::PROCESS, started);
+
+    if (status.ok()) {
+        cache.storeOutput(file->cache_key, file->output);
+    }
+    if (job_->abandoned()) {
+        file->metrics->recordWasted(started);
+        logger_.log(LogLevel::WARNING_LEVEL, "ProcessBatch", file->file_name,
+                   "Batch abandoned while file " + std::to_string(file->id) +
+                   " was processing");
+        status = abandonedStatus("during processing");
+    }
+    completeFile(file, status);
+}
+
+void BatchReactor::completeFile(BatchFile* file, const grpc::Status& status) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        file->status = status;
+        ++files_completed_;
+        if (!status.ok()) {
+            ++files_failed_;
+        }
+        ready_.push_back(file);
+    }
+    advance();
+}
+
+bool BatchReactor::prepareNextWrite() {
+    if (sending_ == nullptr) {
+        if (ready_.empty()) {
+            return false;
+        }
+        sending_ = ready_.front();
+        ready_.pop_front();
+        sending_->send_started_at = std::chrono::steady_clock::now();
+    }
+
+    BatchFile& file = *sending_;
+    write_response_->Clear();
+    write_response_->set_file_id(file.id);
+
+    bool last = true;
+    write_length_ = 0;
+    if (file.status.ok()) {
+        size_t length = std::min(chunk_sizer_.next(), file.output.size() - file.bytes_sent);
+        if (file.output.inMemory()) {
+            write_response_->mutable_content()->assign(
+                file.output.memory().data() + file.bytes_sent, length);
+        } else if (length > 0) {
+            std::string* content = write_response_->mutable_content();
+            content->resize(length);
+            length = file.output.readAt(file.bytes_sent, &(*content)[0], length);
+            content->resize(length);
+            if (length == 0) {
+                file.status = grpc::Status(grpc::StatusCode::INTERNAL,
+                                           "Failed to read output for sending");
+            }
+        }
+        file.bytes_sent += length;
+        write_length_ = length;
+        last = !file.status.ok() || file.bytes_sent >= file.output.size();
+    }
+
+    // Próximo chunk do mesmo arquivo vem em seguida: escrita agrupável.
+    // A primeira resposta do stream leva os metadados iniciais e vai sem
+    // hint (com ele o transporte só os enviaria com o buffer cheio)
+    write_options_ = grpc::WriteOptions();
+    if (!file.compression.compressChunk(write_response_->content().data(),
+                                        write_response_->content().size())) {
+        write_options_.set_no_compression();
+    }
+    if (!last && metadata_sent_) {
+        write_options_.set_buffer_hint();
+    }
+    metadata_sent_ = true;
+    write_started_at_ = std::chrono::steady_clock::now();
+
+    if (last) {
+        write_response_->set_end_of_file(true);
+        write_response_->set_status_code(static_cast<int>(file.status.error_code()));
+        write_response_->set_status_message(file.status.error_message());
+        file.metrics->bytes_out.fetch_add(file.bytes_sent, std::memory_order_relaxed);
+        file.metrics->compressed_bytes.fetch_add(file.compression.compressedBytes(),
+                                                 std::memory_order_relaxed);
+        file.metrics->compressed_wire_bytes.fetch_add(file.compression.estimatedBytes(),
+                                                      std::memory_order_relaxed);
+        compression_totals_.add(file.compression);
+        if (file.status.ok()) {
+            file.metrics->observe(RequestPhase::SEND, file.send_started_at);
+        } else {
+            file.metrics->errors.fetch_add(1, std::memory_order_relaxed);
+        }
+        // O conteúdo já foi copiado para a resposta; libera o slot do lote
+        releaseFile(sending_);
+        sending_ = nullptr;
+    }
+    return true;
+}
+
+void BatchReactor::advance() {
+    bool start_read = false;
+    bool start_write = false;
+    bool close_uploads = false;
+    std::string close_reason;
+    bool finish = false;
+    size_t completed = 0;
+    size_t failed = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (finished_) {
+            return;
+        }
+
+        if (stream_failed_) {
+            // Cliente não recebe mais nada: descartar os resultados prontos
+            for (BatchFile* file : ready_) {
+                discardFile(file);
+                releaseFile(file);
+            }
+            ready_.clear();
+            if (sending_ != nullptr) {
+                discardFile(sending_);
+                releaseFile(sending_);
+                sending_ = nullptr;
+            }
+        } else if (!writing_ && prepareNextWrite()) {
+            writing_ = true;
+            start_write = true;
+        }
+
+        // Arquivos abertos e pendentes contam como jobs do cliente. A leitura
+        // pausa além do limite do lote, da parte justa do cliente ou do
+        // limite de bytes do servidor, enquanto houver arquivos pendentes
+        // que a retomem; sem eles, segue só para concluir os arquivos
+        // abertos (novos ids além do limite encerram o lote)
+        size_t jobs = in_flight_.size() + uploads_.size();
+        admission_.setUsage(std::max<size_t>(jobs, 1), queued_bytes_);
+        if (!reading_ && !reads_done_ && !stream_failed_) {
+            bool bytes_available = admission_.bytesAvailable();
+            if (bytes_available &&
+                (in_flight_.empty() ||
+                 jobs < std::min(max_in_flight_, admission_.jobAllowance()))) {
+                reading_ = true;
+                start_read = true;
+            } else if (in_flight_.empty()) {
+                // Nada retomaria a leitura: os arquivos abertos são recusados
+                reads_done_ = true;
+                close_uploads = true;
+                close_reason = "Server busy: queued bytes limit reached during batch";
+                final_status_ = grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED,
+                                             close_reason);
+            }
+        }
+
+        // Finalizar só sem jobs pendentes, que ainda referenciam o reactor
+        if ((reads_done_ || stream_failed_) && !reading_ && !writing_ &&
+            in_flight_.empty() && uploads_.empty()) {
+            finished_ = true;
+            finish = true;
+            if (stream_failed_) {
+                final_status_ = grpc::Status(grpc::StatusCode::CANCELLED,
+                                             "Batch stream failed");
+            }
+            completed = files_completed_;
+            failed = files_failed_;
+            admission_.release();
+        }
+    }
+
+    if (start_write) {
+        StartWrite(write_response_, write_options_);
+    }
+    if (start_read) {
+        StartRead(read_request_);
+    }
+    if (close_uploads) {
+        logger_.log(LogLevel::WARNING_LEVEL, "ProcessBatch", context_->peer(),
+                   close_reason);
+        closeUploads();
+        advance();
+    }
+    if (finish) {
+        logger_.log(final_status_.ok() ? LogLevel::SUCCESS_LEVEL : LogLevel::WARNING_LEVEL,
+                   "ProcessBatch", "N/A",
+                   "Batch completed: " + std::to_string(completed) + " files, " +
+                   std::to_string(failed) + " failed");
+        if (compression_totals_.enabled()) {
+            if (compression_totals_.compressedBytes() > 0) {
+                logger_.log(LogLevel::INFO_LEVEL, "ProcessBatch", "N/A",
+                           "Response compression: " + compression_totals_.summary());
+            }
+            context_->AddTrailingMetadata("fp-compression", compression_totals_.summary());
+        }
+        Finish(final_status_);
+    }
+}
+
+void BatchReactor::discardFile(BatchFile* file) {
+    file->metrics->bytes_out.fetch_add(file->bytes_sent, std::memory_order_relaxed);
+    file->metrics->errors.fetch_add(1, std::memory_order_relaxed);
+}
+
+void BatchReactor::releaseFile(BatchFile* file) {
+    queued_bytes_ -= std::min<uint64_t>(queued_bytes_, file->input.size());
+    in_flight_.erase(file);
+}
+
+void BatchReactor::OnWriteDone(bool ok) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        writing_ = false;
+        if (!ok) {
+            stream_failed_ = true;
+        } else {
+            chunk_sizer_.record(write_length_,
+                                std::chrono::steady_clock::now() - write_started_at_);
+        }
+    }
+    if (!ok) {
+        logger_.log(LogLevel::ERROR_LEVEL, "ProcessBatch", "N/A", "Failed to send chunk");
+    }
+    advance();
+}
+
+void BatchReactor::OnCancel() {
+    job_->cancel();
+}
+
+void BatchReactor::OnDone() {
+    delete this;
+}
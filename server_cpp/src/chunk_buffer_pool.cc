@@ -0,0 +1,170 @@
+#include "chunk_buffer_pool.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace {
+// Classes guardadas no cache de cada thread e limites por classe
+const size_t kThreadCachedClasses = 8;                 // até 512KB
+const size_t kThreadCacheClassBytes = 512 * 1024;
+const size_t kThreadCacheMaxBuffers = 8;
+}
+
+// Buffers livres da thread; devolvidos às listas compartilhadas quando a
+// thread termina
+struct ChunkBufferPool::ThreadCache {
+    std::vector<char*> free[kThreadCachedClasses];
+
+    ThreadCache() {
+        for (size_t index = 0; index < kThreadCachedClasses; ++index) {
+            free[index].reserve(capacity(index));
+        }
+    }
+
+    static size_t capacity(size_t index) {
+        return std::max<size_t>(1, std::min(kThreadCacheMaxBuffers,
+                                            kThreadCacheClassBytes / classBytes(index)));
+    }
+
+    ~ThreadCache() {
+        ChunkBufferPool& pool = ChunkBufferPool::getInstance();
+        for (size_t index = 0; index < kThreadCachedClasses; ++index) {
+            for (char* data : free[index]) {
+                pool.giveShared(index, data);
+            }
+        }
+    }
+};
+
+ChunkBufferPool::ThreadCache& ChunkBufferPool::threadCache() {
+    thread_local ThreadCache cache;
+    return cache;
+}
+
+void ChunkBufferPool::Buffer::reset() {
+    if (data_ != nullptr) {
+        ChunkBufferPool::getInstance().deallocate(data_, size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+void ChunkBufferPool::setMaxPooledBytes(size_t bytes) {
+    max_pooled_bytes_.store(bytes, std::memory_order_relaxed);
+
+    // Reduzido: liberar o excedente já guardado
+    std::vector<char*> released;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t index = kClassCount; index-- > 0 && pooled_bytes_ > bytes;) {
+            while (!shared_[index].empty() && pooled_bytes_ > bytes) {
+                released.push_back(shared_[index].back());
+                shared_[index].pop_back();
+                pooled_bytes_ -= classBytes(index);
+            }
+        }
+    }
+    for (char* data : released) {
+        std::free(data);
+    }
+}
+
+size_t ChunkBufferPool::classIndex(size_t size) {
+    size_t index = 0;
+    while (index < kClassCount && classBytes(index) < size) {
+        ++index;
+    }
+    return index;
+}
+
+ChunkBufferPool::Buffer ChunkBufferPool::acquire(size_t size) {
+    return Buffer(static_cast<char*>(allocate(size)), size);
+}
+
+void* ChunkBufferPool::allocate(size_t size) {
+    size_t index = classIndex(size);
+    if (index >= kClassCount) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        void* data = std::malloc(size);
+        if (data == nullptr) {
+            throw std::bad_alloc();
+        }
+        return data;
+    }
+
+    if (index < kThreadCachedClasses) {
+        std::vector<char*>& list = threadCache().free[index];
+        if (!list.empty()) {
+            char* data = list.back();
+            list.pop_back();
+            return data;
+        }
+    }
+
+    char* data = takeShared(index);
+    if (data != nullptr) {
+        shared_hits_.fetch_add(1, std::memory_order_relaxed);
+        return data;
+    }
+
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    data = static_cast<char*>(std::malloc(classBytes(index)));
+    if (data == nullptr) {
+        throw std::bad_alloc();
+    }
+    return data;
+}
+
+void ChunkBufferPool::deallocate(void* data, size_t size) {
+    if (data == nullptr) {
+        return;
+    }
+    size_t index = classIndex(size);
+    if (index >= kClassCount) {
+        std::free(data);
+        return;
+    }
+
+    if (index < kThreadCachedClasses) {
+        std::vector<char*>& list = threadCache().free[index];
+        if (list.size() < ThreadCache::capacity(index)) {
+            list.push_back(static_cast<char*>(data));
+            return;
+        }
+    }
+    giveShared(index, static_cast<char*>(data));
+}
+
+char* ChunkBufferPool::takeShared(size_t index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (shared_[index].empty()) {
+        return nullptr;
+    }
+    char* data = shared_[index].back();
+    shared_[index].pop_back();
+    pooled_bytes_ -= classBytes(index);
+    return data;
+}
+
+void ChunkBufferPool::giveShared(size_t index, char* data) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pooled_bytes_ + classBytes(index) <=
+            max_pooled_bytes_.load(std::memory_order_relaxed)) {
+            shared_[index].push_back(data);
+            pooled_bytes_ += classBytes(index);
+            return;
+        }
+    }
+    std::free(data);
+}
+
+ChunkBufferPool::Stats ChunkBufferPool::stats() const {
+    Stats stats;
+    stats.shared_hits = shared_hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.pooled_bytes = pooled_bytes_;
+    return stats;
+}
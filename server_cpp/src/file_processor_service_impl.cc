@@ -1,473 +1,1291 @@
 ﻿#include "file_processor_service_impl.h"
+#include "chunk_buffer_pool.h"
+#include "image_engine.h"
+#include "server_config.h"
+#include "piped_process.h"
+#include "process_runner.h"
+#include "result_cache.h"
+#include "scratch_space.h"
+#include "metrics.h"
+#include "upload_store.h"
+#include <algorithm>
+#include <cctype>
+#include <climits>
 #include <fstream>
 #include <sstream>
 #include <vector>
 #include <exception>
 
+#ifndef _WIN32
+#include <poll.h>
+#include <cerrno>
+#endif
+
+namespace {
+// Saída da ferramenta não aproveitada; sem espaço temporário (cota da
+// requisição ou limite total) o cliente recebe RESOURCE_EXHAUSTED
+grpc::Status outputFailure(const TransferBuffer& output, const std::string& error_msg,
+                           const std::string& default_error) {
+    if (output.quotaExceeded()) {
+        return grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, error_msg);
+    }
+    return grpc::Status(grpc::StatusCode::INTERNAL, default_error);
+}
+}
+
 FileProcessorServiceImpl::FileProcessorServiceImpl()
-    : logger_(Logger::getInstance()) {
+    : logger_(Logger::getInstance()),
+      executor_(ServerConfig::getInstance().worker_threads),
+      pdf_sharder_(executor_, ServerConfig::getInstance().pdf_shard_min_pages,
+                   ServerConfig::getInstance().pdf_max_shards),
+      pdf_text_engine_(executor_, ServerConfig::getInstance().pdf_text_workers),
+      resize_filter_(ResampleFilter::LANCZOS) {
+    const ServerConfig& config = ServerConfig::getInstance();
+
+    if (!ImageResampler::filterFromName(config.resize_filter, resize_filter_)) {
+        logger_.log(LogLevel::WARNING_LEVEL, "System", "N/A",
+                   "Unknown resize filter '" + config.resize_filter + "', using lanczos");
+    }
+
+    ProcessRunner::Limits process_limits;
+    process_limits.timeout = std::chrono::seconds(config.command_timeout_seconds);
+    process_limits.cpu_seconds = config.command_cpu_seconds;
+    process_limits.memory_bytes = config.command_memory_bytes;
+    process_limits.kill_grace = std::chrono::milliseconds(config.kill_grace_ms);
+    ProcessRunner::setDefaultLimits(process_limits);
+    ChunkBufferPool::getInstance().setMaxPooledBytes(config.buffer_pool_bytes);
+
+    // Criado aqui (e não no primeiro spill) para varrer o que processos
+    // encerrados deixaram antes de aceitar requisições
+    ScratchSpace& scratch = ScratchSpace::getInstance();
+    if (scratch.isPrivate()) {
+        ScratchSpace::Stats scratch_stats = scratch.stats();
+        logger_.log(LogLevel::INFO_LEVEL, "System", "N/A",
+                   "Scratch directory: " + scratch.directory() + " (" +
+                   std::to_string(scratch_stats.orphans_removed) +
+                   " orphaned directories removed, " +
+                   std::to_string(scratch_stats.orphan_bytes_removed) + " bytes)");
+    } else {
+        logger_.log(LogLevel::WARNING_LEVEL, "System", "N/A",
+                   scratch.setupError() + "; using " + scratch.directory());
+    }
+
+    for (const char* service_name : {"CompressPDF", "ConvertToTXT",
+                                     "ConvertImageFormat", "ResizeImage"}) {
+        const OperationLimits& limits = config.limitsFor(service_name);
+        size_t max_concurrent = limits.max_concurrent > 0
+            ? limits.max_concurrent : executor_.threadCount();
+        limiters_[service_name] = std::make_unique<OperationLimiter>(
+            service_name, executor_, max_concurrent, limits.queue_depth);
+    }
+
+    // Padrão: o que os limiters aceitam (executando + na fila), para que uma
+    // requisição admitida não seja recusada só depois do upload
+    AdmissionController::Limits admission_limits;
+    admission_limits.max_jobs = config.admission_max_jobs;
+    if (admission_limits.max_jobs == 0) {
+        for (const auto& entry : limiters_) {
+            admission_limits.max_jobs += entry.second->maxConcurrent() +
+                                         entry.second->queueDepth();
+        }
+    }
+    admission_limits.fair_share = config.admission_fair_share;
+    admission_limits.max_queued_bytes = config.admission_max_queued_bytes;
+    admission_limits.min_free_disk_bytes = config.admission_min_free_disk_bytes;
+    admission_limits.disk_path = scratch.directory();
+    admission_limits.retry_after =
+        std::chrono::milliseconds(config.admission_retry_after_ms);
+    admission_limits.parked_bytes = [] { return UploadStore::getInstance().parkedBytes(); };
+    admission_ = std::make_unique<AdmissionController>(admission_limits);
+    logger_.log(LogLevel::INFO_LEVEL, "System", "N/A",
+               "Admission control: " + std::to_string(admission_limits.max_jobs) +
+               " jobs" + (admission_limits.fair_share ? " (fair share per client)" : "") +
+               ", " + std::to_string(admission_limits.max_queued_bytes) +
+               " queued bytes, " + std::to_string(admission_limits.min_free_disk_bytes) +
+               " bytes of free disk required");
+
+    if (config.gs_pool_enabled && PipedProcess::isSupported()) {
+        size_t pool_size = config.gs_pool_size > 0
+            ? config.gs_pool_size : limiterFor("CompressPDF").maxConcurrent();
+        gs_pool_ = std::make_unique<GhostscriptPool>(
+            pool_size, config.gs_worker_max_jobs,
+            std::vector<std::string>{"-dCompatibilityLevel=1.4", "-dPDFSETTINGS=/ebook"});
+
+        std::string error_msg;
+        if (gs_pool_->warmUp(error_msg)) {
+            logger_.log(LogLevel::INFO_LEVEL, "System", "N/A",
+                       "Ghostscript pool ready (" + std::to_string(pool_size) +
+                       " workers)");
+        } else {
+            logger_.log(LogLevel::WARNING_LEVEL, "System", "N/A",
+                       "Ghostscript pool disabled, using exec: " + error_msg);
+            gs_pool_.reset();
+        }
+    }
+
+    // Uma thread por chamada em pipeline: o limiter de cada operação já
+    // limita quantas rodam ao mesmo tempo
+    if (usePdfPipeline()) {
+        size_t pipeline_threads = config.pipeline_threads;
+        if (pipeline_threads == 0) {
+            pipeline_threads = limiterFor("ConvertToTXT").maxConcurrent() +
+                               (gs_pool_ ? 0 : limiterFor("CompressPDF").maxConcurrent());
+        }
+        pipeline_executor_ = std::make_unique<WorkStealingExecutor>(pipeline_threads);
+        logger_.log(LogLevel::INFO_LEVEL, "System", "N/A",
+                   "PDF pipeline mode (" + std::to_string(pipeline_threads) +
+                   " I/O threads)");
+    }
+
+    if (usePdfTextEngine()) {
+        logger_.log(LogLevel::INFO_LEVEL, "System", "N/A",
+                   "PDF text engine ready (poppler-cpp, up to " +
+                   std::to_string(pdf_text_engine_.workersFor(INT_MAX)) +
+                   " pages in parallel)");
+    }
+
+    registerMetrics();
+
     logger_.log(LogLevel::INFO_LEVEL, "System", "N/A",
-               "FileProcessorService initialized");
+               "FileProcessorService initialized (" +
+               std::to_string(executor_.threadCount()) + " worker threads)");
 }
 
 FileProcessorServiceImpl::~FileProcessorServiceImpl() {
+    // Os gauges leem membros deste serviço
+    Metrics::getInstance().removeGauges(this);
+
+    // Concluir jobs pendentes antes de destruir os limiters que eles usam
+    // (os do pipeline ainda podem submeter trabalho ao executor)
+    if (pipeline_executor_) {
+        pipeline_executor_->shutdown();
+    }
+    executor_.shutdown();
+
+    if (gs_pool_) {
+        GhostscriptPool::Stats stats = gs_pool_->stats();
+        logger_.log(LogLevel::INFO_LEVEL, "System", "N/A",
+                   "Ghostscript pool: " + std::to_string(stats.jobs) + " jobs, " +
+                   std::to_string(stats.failures) + " failures, " +
+                   std::to_string(stats.recycled) + " workers recycled");
+    }
+
+    if (ResultCache::getInstance().enabled()) {
+        ResultCache::Stats stats = ResultCache::getInstance().stats();
+        logger_.log(LogLevel::INFO_LEVEL, "System", "N/A",
+                   "Result cache: " + std::to_string(stats.memory_hits) +
+                   " memory hits, " + std::to_string(stats.disk_hits) +
+                   " disk hits, " + std::to_string(stats.misses) + " misses, " +
+                   std::to_string(stats.evictions) + " evictions");
+    }
+
     logger_.log(LogLevel::INFO_LEVEL, "System", "N/A",
                "FileProcessorService shutting down");
 }
 
-bool FileProcessorServiceImpl::receiveFile(
-    grpc::ServerReaderWriter<file_processor::FileChunk,
-                            file_processor::FileChunk>* stream,
-    const std::string& output_path,
-    std::string& error_message) {
-    try {
-        if (stream == nullptr) {
-            error_message = "Internal server error: null stream";
-            return false;
+void FileProcessorServiceImpl::registerMetrics() {
+    Metrics& metrics = Metrics::getInstance();
+
+    for (const auto& entry : limiters_) {
+        const OperationLimiter* limiter = entry.second.get();
+        const std::string labels = "operation=\"" + entry.first + "\"";
+        metrics.addGauge(this, "fp_operation_active_jobs",
+                         "Jobs currently running per operation", labels,
+                         [limiter]() { return static_cast<double>(limiter->active()); });
+        metrics.addGauge(this, "fp_operation_queued_jobs",
+                         "Jobs waiting for a slot per operation", labels,
+                         [limiter]() { return static_cast<double>(limiter->queued()); });
+        for (OperationLimiter::DropReason reason : {OperationLimiter::DropReason::DEADLINE,
+                                                    OperationLimiter::DropReason::CANCELLED}) {
+            metrics.addGauge(this, "fp_dropped_jobs_total",
+                             "Queued jobs dropped before running (call expired or cancelled)",
+                             labels + ",reason=\"" +
+                                 OperationLimiter::dropReasonName(reason) + "\"",
+                             [limiter, reason]() {
+                                 return static_cast<double>(limiter->dropped(reason));
+                             }, true);
         }
+    }
 
-        std::ofstream output_file(output_path, std::ios::binary);
-        if (!output_file) {
-            error_message = "Failed to create temporary file: " + output_path;
-            return false;
-        }
+    const AdmissionController* admission = admission_.get();
+    metrics.addGauge(this, "fp_admission_jobs", "Requests and batch files admitted", "",
+                     [admission]() { return static_cast<double>(admission->activeJobs()); });
+    metrics.addGauge(this, "fp_admission_queued_bytes",
+                     "Uploaded bytes reserved by admitted requests", "",
+                     [admission]() { return static_cast<double>(admission->queuedBytes()); });
+    metrics.addGauge(this, "fp_admission_active_peers", "Clients with admitted requests", "",
+                     [admission]() { return static_cast<double>(admission->activePeers()); });
+    for (AdmissionController::Reason reason :
+         {AdmissionController::Reason::CAPACITY, AdmissionController::Reason::PEER_SHARE,
+          AdmissionController::Reason::QUEUED_BYTES, AdmissionController::Reason::DISK}) {
+        metrics.addGauge(this, "fp_admission_rejections_total",
+                         "Requests rejected by admission control",
+                         std::string("reason=\"") +
+                             AdmissionController::reasonName(reason) + "\"",
+                         [admission, reason]() {
+                             return static_cast<double>(admission->rejections(reason));
+                         }, true);
+    }
 
-        file_processor::FileChunk chunk;
-        size_t total_bytes = 0;
+    metrics.addGauge(this, "fp_interrupted_processes_total",
+                     "External tools stopped because their call was cancelled or expired", "",
+                     []() { return static_cast<double>(ProcessRunner::interruptedCount()); },
+                     true);
+    metrics.addGauge(this, "fp_process_timeouts_total",
+                     "External tools stopped by the command timeout", "",
+                     []() { return static_cast<double>(ProcessRunner::timedOutCount()); },
+                     true);
+    metrics.addGauge(this, "fp_process_spawns_total", "External tools started", "",
+                     []() { return static_cast<double>(ProcessRunner::spawnCount()); },
+                     true);
+    metrics.addGauge(this, "fp_buffer_pool_bytes",
+                     "Free chunk buffers held in the shared pool lists", "",
+                     []() {
+                         return static_cast<double>(
+                             ChunkBufferPool::getInstance().stats().pooled_bytes);
+                     });
+    metrics.addGauge(this, "fp_buffer_pool_requests_total",
+                     "Chunk buffers served from the shared lists or the allocator "
+                     "(thread cache hits are not counted)", "source=\"shared\"",
+                     []() {
+                         return static_cast<double>(
+                             ChunkBufferPool::getInstance().stats().shared_hits);
+                     }, true);
+    metrics.addGauge(this, "fp_buffer_pool_requests_total",
+                     "Chunk buffers served from the shared lists or the allocator "
+                     "(thread cache hits are not counted)", "source=\"malloc\"",
+                     []() {
+                         return static_cast<double>(
+                             ChunkBufferPool::getInstance().stats().misses);
+                     }, true);
+    metrics.addGauge(this, "fp_executor_pending_tasks",
+                     "Tasks queued or running in the executor", "",
+                     [this]() { return static_cast<double>(executor_.pendingTasks()); });
+    metrics.addGauge(this, "fp_temp_disk_bytes",
+                     "Bytes held in temporary transfer files", "",
+                     []() {
+                         return static_cast<double>(
+                             ScratchSpace::getInstance().stats().used_bytes);
+                     });
+    metrics.addGauge(this, "fp_scratch_capacity_bytes",
+                     "Size of the filesystem holding the scratch directory", "",
+                     []() {
+                         size_t capacity = 0;
+                         size_t available = 0;
+                         ScratchSpace::getInstance().space(capacity, available);
+                         return static_cast<double>(capacity);
+                     });
+    metrics.addGauge(this, "fp_scratch_free_bytes",
+                     "Free bytes in the filesystem holding the scratch directory", "",
+                     []() {
+                         size_t capacity = 0;
+                         size_t available = 0;
+                         ScratchSpace::getInstance().space(capacity, available);
+                         return static_cast<double>(available);
+                     });
+    metrics.addGauge(this, "fp_scratch_quota_rejections_total",
+                     "Writes refused by the per-request scratch quota or the total limit", "",
+                     []() {
+                         return static_cast<double>(
+                             ScratchSpace::getInstance().stats().quota_rejections);
+                     }, true);
+    metrics.addGauge(this, "fp_scratch_orphans_removed_total",
+                     "Scratch directories of dead processes removed at startup", "",
+                     []() {
+                         return static_cast<double>(
+                             ScratchSpace::getInstance().stats().orphans_removed);
+                     }, true);
+    metrics.addGauge(this, "fp_log_dropped_records_total",
+                     "Log records dropped because the queue was full", "",
+                     [this]() { return static_cast<double>(logger_.droppedCount()); },
+                     true);
+
+    if (ResultCache::getInstance().enabled()) {
+        metrics.addGauge(this, "fp_cache_bytes", "Bytes stored in the result cache",
+                         "tier=\"memory\"", []() {
+            return static_cast<double>(ResultCache::getInstance().stats().memory_bytes);
+        });
+        metrics.addGauge(this, "fp_cache_bytes", "Bytes stored in the result cache",
+                         "tier=\"disk\"", []() {
+            return static_cast<double>(ResultCache::getInstance().stats().disk_bytes);
+        });
+        metrics.addGauge(this, "fp_cache_misses_total", "Result cache misses", "", []() {
+            return static_cast<double>(ResultCache::getInstance().stats().misses);
+        }, true);
+    }
 
-        while (stream->Read(&chunk)) {
-            output_file.write(chunk.content().data(), chunk.content().size());
-            total_bytes += chunk.content().size();
+    if (gs_pool_) {
+        metrics.addGauge(this, "fp_gs_pool_workers", "Ghostscript pool workers",
+                         "state=\"live\"", [this]() {
+            return static_cast<double>(gs_pool_->stats().live_workers);
+        });
+        metrics.addGauge(this, "fp_gs_pool_workers", "Ghostscript pool workers",
+                         "state=\"idle\"", [this]() {
+            return static_cast<double>(gs_pool_->stats().idle_workers);
+        });
+    }
+}
 
-            if (!output_file.good()) {
-                error_message = "Error writing to file";
-                output_file.close();
-                return false;
-            }
-        }
+bool FileProcessorServiceImpl::usePdfTextEngine() const {
+    return ServerConfig::getInstance().pdf_text_engine_enabled &&
+           PdfTextEngine::isAvailable();
+}
 
-        output_file.close();
+bool FileProcessorServiceImpl::usePdfPipeline() const {
+    return ServerConfig::getInstance().pdf_pipeline_enabled &&
+           PipedProcess::isSupported();
+}
 
-        logger_.log(LogLevel::INFO_LEVEL, "FileTransfer", output_path,
-                   "Received " + std::to_string(total_bytes) + " bytes");
+FileProcessorServiceImpl::FileReactor* FileProcessorServiceImpl::createPipelined(
+    grpc::CallbackServerContext* context,
+    const std::string& service_name,
+    file_processor::Operation operation,
+    FileTransferReactor::StreamingHandler handler) {
+    // O hash só é conhecido ao fim do upload, quando a ferramenta em pipeline
+    // já está rodando: com o cache ativo, só uploads grandes (em que o tempo
+    // até o primeiro byte pesa mais) dispensam a consulta ao cache
+    if (!ResultCache::getInstance().enabled()) {
+        return FileTransferReactor::createStreaming(
+            context, service_name, limiterFor(service_name), *pipeline_executor_,
+            *admission_, std::move(handler));
+    }
+    return FileTransferReactor::createHybrid(
+        context, service_name, limiterFor(service_name), *pipeline_executor_,
+        *admission_, headerResolver(operation), std::move(handler),
+        ServerConfig::getInstance().pdf_pipeline_min_bytes);
+}
 
-        return true;
-    } catch (const std::exception& e) {
-        error_message = std::string("Exception in receiveFile: ") + e.what();
-        logger_.log(LogLevel::ERROR_LEVEL, "FileTransfer", output_path, error_message);
+std::vector<PdfSharder::PageRange> FileProcessorServiceImpl::planPdfShards(
+    const std::string& service_name,
+    const TransferBuffer& input,
+    const std::string& input_file) {
+    // Contar páginas custa um processo; arquivos pequenos demais para ter
+    // pdf_shard_min_pages páginas nem são avaliados
+    if (!pdf_sharder_.worthCounting(input.size())) {
+        return {};
+    }
+
+    // Um worker do pool já está com o gs carregado; senão qpdf/pdfinfo
+    int page_count = 0;
+    if (gs_pool_ && !gs_pool_->degraded()) {
+        page_count = gs_pool_->countPages(input_file);
+    }
+    if (page_count <= 0) {
+        page_count = PdfSharder::countPages(input_file);
+    }
+    std::vector<PdfSharder::PageRange> ranges = pdf_sharder_.planShards(page_count);
+    if (ranges.size() > 1) {
+        logger_.log(LogLevel::INFO_LEVEL, service_name, input_file,
+                   "Splitting " + std::to_string(page_count) + " pages into " +
+                   std::to_string(ranges.size()) + " parallel ranges");
+    }
+    return ranges;
+}
+
+OperationLimiter& FileProcessorServiceImpl::limiterFor(const std::string& service_name) {
+    return *limiters_.at(service_name);
+}
+
+bool FileProcessorServiceImpl::tryImageEngine(
+    const std::string& service_name,
+    TransferBuffer& input,
+    TransferBuffer& output,
+    ImageFormat output_format,
+    int width, int height,
+    bool maintain_aspect_ratio,
+    grpc::Status& rejected) {
+    const ServerConfig& config = ServerConfig::getInstance();
+    if (!config.image_engine_enabled ||
+        !ImageEngine::isAvailable()) {
         return false;
-    } catch (...) {
-        error_message = "Unknown error in receiveFile";
-        logger_.log(LogLevel::ERROR_LEVEL, "FileTransfer", output_path, error_message);
+    }
+
+    // Arquivos pequenos já estão em memória; os grandes são lidos do spill
+    std::string spilled_input;
+    if (!input.inMemory() && !input.readAll(spilled_input)) {
         return false;
     }
+    const std::string& input_data = input.inMemory() ? input.memory() : spilled_input;
+
+    if (!ImageEngine::isSupported(input_data, output_format)) {
+        logger_.log(LogLevel::INFO_LEVEL, service_name, input.description(),
+                   "Format not handled by image engine, using ImageMagick");
+        return false;
+    }
+
+    // Cabeçalho declara mais pixels que o limite: recusar em vez de passar
+    // a bomba de descompressão adiante para o ImageMagick
+    int source_width = 0;
+    int source_height = 0;
+    if (config.image_max_pixels > 0 &&
+        ImageEngine::readDimensions(input_data, source_width, source_height) &&
+        static_cast<uint64_t>(source_width) * static_cast<uint64_t>(source_height) >
+            config.image_max_pixels) {
+        std::string error = "Image of " + std::to_string(source_width) + "x" +
+                            std::to_string(source_height) + " exceeds the limit of " +
+                            std::to_string(config.image_max_pixels) + " pixels";
+        logger_.log(LogLevel::ERROR_LEVEL, service_name, input.description(), error);
+        rejected = grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, error);
+        return false;
+    }
+
+    // Imagens grandes são reamostradas em faixas de linhas no executor
+    ResizeOptions resize_options;
+    resize_options.filter = resize_filter_;
+    resize_options.maintain_aspect_ratio = maintain_aspect_ratio;
+    resize_options.scaled_decode = config.jpeg_scaled_decode;
+    resize_options.max_pixels = config.image_max_pixels;
+    resize_options.parallel_for = [this](size_t count,
+                                         const std::function<void(size_t)>& body) {
+        executor_.parallelFor(count, body);
+    };
+
+    std::string encoded;
+    std::string error_msg;
+    bool processed = (width > 0 && height > 0)
+        ? ImageEngine::resizeImage(input_data, width, height, output_format,
+                                   encoded, error_msg, resize_options)
+        : ImageEngine::convertImage(input_data, output_format, encoded, error_msg,
+                                    config.image_max_pixels);
+
+    if (processed && !output.assign(std::move(encoded), error_msg)) {
+        processed = false;
+    }
+
+    if (!processed) {
+        logger_.log(LogLevel::WARNING_LEVEL, service_name, input.description(),
+                   "Image engine failed, falling back to ImageMagick: " + error_msg);
+        return false;
+    }
+
+    std::string detail;
+    if (width > 0 && height > 0) {
+        detail = std::string(" (") + ImageResampler::filterName(resize_filter_) + ", " +
+                 ImageResampler::instructionSet() + ")";
+    }
+    logger_.log(LogLevel::INFO_LEVEL, service_name, input.description(),
+               "Processed in-process by image engine" + detail);
+    return true;
 }
 
-bool FileProcessorServiceImpl::sendFile(
-    grpc::ServerReaderWriter<file_processor::FileChunk,
-                            file_processor::FileChunk>* stream,
-    const std::string& input_path,
-    std::string& error_message) {
-    try {
-        if (stream == nullptr) {
-            error_message = "Internal server error: null stream";
-            return false;
-        }
+bool FileProcessorServiceImpl::tryPdfTextEngine(const std::string& service_name,
+                                                TransferBuffer& input,
+                                                TransferBuffer& output) {
+    if (!usePdfTextEngine()) {
+        return false;
+    }
 
-        std::ifstream input_file(input_path, std::ios::binary);
-        if (!input_file) {
-            error_message = "Failed to open file for sending: " + input_path;
-            return false;
-        }
+    // O texto vai para o buffer de saída (spill e cota como qualquer saída)
+    PdfTextEngine::PageSink sink = [&output](const std::string& text, bool,
+                                             std::string& error) {
+        return output.append(text.data(), text.size(), error);
+    };
+
+    int page_count = 0;
+    std::string error_msg;
+    std::string input_file;
+    bool extracted = input.inMemory()
+        ? pdf_text_engine_.extract(input.memory().data(), input.memory().size(), sink,
+                                   page_count, error_msg)
+        : input.inputPath(input_file, error_msg) &&
+          pdf_text_engine_.extractFile(input_file, sink, page_count, error_msg);
+
+    if (!extracted) {
+        logger_.log(LogLevel::WARNING_LEVEL, service_name, input.description(),
+                   "PDF text engine failed, falling back to pdftotext: " + error_msg);
+        return false;
+    }
 
-        const size_t chunk_size = 64 * 1024; // 64KB chunks
-        std::vector<char> buffer(chunk_size);
-        size_t total_bytes = 0;
+    logger_.log(LogLevel::SUCCESS_LEVEL, service_name, input.description(),
+               "Converted to TXT in-process (" + std::to_string(page_count) + " pages, " +
+               std::to_string(pdf_text_engine_.workersFor(page_count)) + " workers, " +
+               std::to_string(output.size()) + " bytes)");
+    return true;
+}
 
-        while (input_file.read(buffer.data(), chunk_size) || input_file.gcount() > 0) {
-            file_processor::FileChunk chunk;
-            chunk.set_content(buffer.data(), static_cast<size_t>(input_file.gcount()));
+grpc::Status FileProcessorServiceImpl::runPipelined(
+    const std::string& service_name,
+    ChunkStream& stream,
+    const std::vector<std::string>& command,
+    const std::string& tool_name,
+    bool allow_empty_output,
+    size_t& bytes_received,
+    size_t& bytes_sent) {
+    bytes_received = 0;
+    bytes_sent = 0;
+
+    std::string command_line;
+    for (const std::string& arg : command) {
+        command_line += (command_line.empty() ? "" : " ") + arg;
+    }
+    logger_.log(LogLevel::INFO_LEVEL, service_name, "pipe",
+               "Executing (pipelined): " + command_line);
 
-            if (!stream->Write(chunk)) {
-                error_message = "Failed to send chunk";
-                input_file.close();
-                return false;
+#ifdef _WIN32
+    (void)stream;
+    (void)command;
+    (void)tool_name;
+    (void)allow_empty_output;
+    return grpc::Status(grpc::StatusCode::UNIMPLEMENTED,
+                        "Pipelined tools are not supported on this platform");
+#else
+    PipedProcess process;
+    std::string error_msg;
+    if (!process.start(command, error_msg)) {
+        logger_.log(LogLevel::ERROR_LEVEL, service_name, "pipe", error_msg);
+        return grpc::Status(grpc::StatusCode::INTERNAL, error_msg);
+    }
+
+    // Uma thread só: o poll acorda com o próximo chunk do cliente (pipe de
+    // eventos do reactor), com espaço no stdin ou com saída no stdout. A
+    // saída é lida direto para o buffer do chunk (Write devolve outro buffer
+    // para a próxima leitura), no tamanho que o stream sugere pela vazão
+    const int poll_interval_ms = 100;
+    file_processor::FileChunk input_chunk;
+    size_t input_offset = 0;
+    bool input_pending = false;
+    bool input_done = false;
+    file_processor::FileChunk chunk;
+    bool send_failed = false;
+    long length = 0;
+    while (true) {
+        // Chamada abandonada: a ferramenta é interrompida
+        if (process.stopIfAbandoned()) {
+            length = -1;
+            break;
+        }
+
+        if (!input_done && !input_pending) {
+            switch (stream.TryRead(&input_chunk)) {
+                case ChunkStream::ReadState::CHUNK:
+                    bytes_received += input_chunk.content().size();
+                    input_offset = 0;
+                    input_pending = !input_chunk.content().empty();
+                    continue;
+                case ChunkStream::ReadState::END:
+                    input_done = true;
+                    process.closeInput();
+                    break;
+                case ChunkStream::ReadState::PENDING:
+                    break;
             }
+        }
 
-            total_bytes += static_cast<size_t>(input_file.gcount());
+        struct pollfd fds[3];
+        nfds_t count = 0;
+        const nfds_t output_index = count;
+        fds[count++] = {process.outputFd(), POLLIN, 0};
+        nfds_t input_index = 0;
+        if (input_pending) {
+            input_index = count;
+            fds[count++] = {process.inputFd(), POLLOUT, 0};
+        } else if (!input_done) {
+            fds[count++] = {stream.readEventFd(), POLLIN, 0};
+        }
+        if (poll(fds, count, poll_interval_ms) < 0 && errno != EINTR) {
+            length = -1;
+            break;
         }
 
-        input_file.close();
+        if (input_pending && fds[input_index].revents != 0) {
+            long written = process.writeInputAvailable(
+                input_chunk.content().data() + input_offset,
+                input_chunk.content().size() - input_offset);
+            if (written < 0) {
+                // Ferramenta encerrou a entrada (erro ou término antecipado)
+                input_pending = false;
+                input_done = true;
+                process.closeInput();
+            } else {
+                input_offset += static_cast<size_t>(written);
+                input_pending = input_offset < input_chunk.content().size();
+            }
+        }
 
-        logger_.log(LogLevel::INFO_LEVEL, "FileTransfer", input_path,
-                   "Sent " + std::to_string(total_bytes) + " bytes");
+        if (fds[output_index].revents != 0) {
+            const size_t chunk_size = stream.chunkSize();
+            std::string* content = chunk.mutable_content();
+            content->resize(chunk_size);
+            length = process.readOutput(&(*content)[0], chunk_size);
+            if (length <= 0) {
+                break;
+            }
+            content->resize(static_cast<size_t>(length));
+            if (!stream.Write(&chunk)) {
+                send_failed = true;
+                break;
+            }
+            bytes_sent += static_cast<size_t>(length);
+        }
+    }
 
-        return true;
-    } catch (const std::exception& e) {
-        error_message = std::string("Exception in sendFile: ") + e.what();
-        logger_.log(LogLevel::ERROR_LEVEL, "FileTransfer", input_path, error_message);
-        return false;
-    } catch (...) {
-        error_message = "Unknown error in sendFile";
-        logger_.log(LogLevel::ERROR_LEVEL, "FileTransfer", input_path, error_message);
-        return false;
+    if (send_failed || length < 0) {
+        process.kill();
+    }
+    process.closeInput();
+    int exit_code = process.wait();
+
+    logger_.log(LogLevel::INFO_LEVEL, "FileTransfer", "pipe",
+               "Received " + std::to_string(bytes_received) + " bytes, sent " +
+               std::to_string(bytes_sent) + " bytes");
+
+    if (process.interrupted()) {
+        error_msg = tool_name + " interrupted: request cancelled or deadline exceeded";
+    } else if (send_failed) {
+        error_msg = "Failed to send chunk";
+    } else if (length < 0) {
+        error_msg = "Failed to read " + tool_name + " output";
+    } else if (exit_code != 0) {
+        error_msg = tool_name + " failed with code " + std::to_string(exit_code) +
+                    ": " + process.errorOutput();
+    } else if (bytes_sent == 0 && !allow_empty_output) {
+        error_msg = "Output file was not created";
+    } else {
+        return grpc::Status::OK;
     }
+
+    logger_.log(LogLevel::ERROR_LEVEL, service_name, "pipe", error_msg);
+    return grpc::Status(grpc::StatusCode::INTERNAL, error_msg);
+#endif
 }
 
-grpc::Status FileProcessorServiceImpl::CompressPDF(
-    grpc::ServerContext* context,
-    grpc::ServerReaderWriter<file_processor::FileChunk,
-                            file_processor::FileChunk>* stream) {
+FileProcessorServiceImpl::FileReactor* FileProcessorServiceImpl::CompressPDF(
+    grpc::CallbackServerContext* context) {
     std::string service_name = "CompressPDF";
     logger_.log(LogLevel::INFO_LEVEL, service_name, "N/A", "Request received");
 
-    try {
-        // Gerar nomes de arquivos temporários
-        std::string input_file = FileProcessorUtils::generateTempFileName(
-            "input_pdf", ".pdf");
-        std::string output_file = FileProcessorUtils::generateTempFileName(
-            "output_pdf", ".pdf");
+    // Modo pipeline: gs lê do stdin e escreve o PDF no stdout; com o pool
+    // ativo, os workers já inicializados evitam o custo de subir o gs
+    if (!gs_pool_ && usePdfPipeline()) {
+        return createPipelined(
+            context, service_name, file_processor::COMPRESS_PDF,
+            [this](ChunkStream& stream) { return compressPDFPipelined(stream); });
+    }
 
-        // Receber arquivo do cliente
-        std::string error_msg;
-        if (!receiveFile(stream, input_file, error_msg)) {
+    return FileTransferReactor::createBuffered(
+        context, service_name, limiterFor(service_name), *admission_,
+        headerResolver(file_processor::COMPRESS_PDF));
+}
+
+grpc::Status FileProcessorServiceImpl::compressPDFPipelined(ChunkStream& stream) {
+    std::string service_name = "CompressPDF";
+    size_t input_size = 0;
+    size_t output_size = 0;
+    grpc::Status status = runPipelined(
+        service_name, stream,
+        {"gs", "-sDEVICE=pdfwrite", "-dCompatibilityLevel=1.4",
+         "-dPDFSETTINGS=/ebook", "-dNOPAUSE", "-dQUIET", "-dBATCH",
+         "-sstdout=%stderr", "-sOutputFile=-", "-"},
+        "Ghostscript", false, input_size, output_size);
+    if (!status.ok()) {
+        return status;
+    }
+
+    double compression_ratio = 0.0;
+    if (input_size > 0) {
+        compression_ratio = (1.0 - (double)output_size / (double)input_size) * 100.0;
+    }
+    logger_.log(LogLevel::SUCCESS_LEVEL, service_name, "pipe",
+               "Compressed from " + std::to_string(input_size) +
+               " to " + std::to_string(output_size) +
+               " bytes (" + std::to_string(compression_ratio) + "% reduction)");
+    return grpc::Status::OK;
+}
+
+grpc::Status FileProcessorServiceImpl::compressPDF(TransferBuffer& input,
+                                                   TransferBuffer& output) {
+    std::string service_name = "CompressPDF";
+
+    std::string error_msg;
+    std::string input_file;
+    std::string output_file;
+    if (!input.inputPath(input_file, error_msg) ||
+        !output.prepareOutput(input.onDisk(), ".pdf", output_file, error_msg)) {
+        logger_.log(LogLevel::ERROR_LEVEL, service_name, input.description(),
+                   error_msg);
+        return grpc::Status(grpc::StatusCode::INTERNAL, error_msg);
+    }
+
+    // PDF grande: faixas de páginas em paralelo
+    bool compressed = false;
+    std::vector<PdfSharder::PageRange> ranges = planPdfShards(service_name, input,
+                                                              input_file);
+    if (ranges.size() > 1) {
+        compressed = pdf_sharder_.compress(input_file, output_file, ranges, error_msg);
+        if (!compressed) {
+            logger_.log(LogLevel::WARNING_LEVEL, service_name, input_file,
+                       error_msg + "; compressing whole document");
+        }
+    }
+
+    // Worker Ghostscript do pool; o gs é executado só se o pool falhou
+    // (sem worker, worker caiu ou pool degradado), não se o documento foi
+    // recusado ou a chamada abandonada
+    if (!compressed && gs_pool_ && !gs_pool_->degraded()) {
+        logger_.log(LogLevel::INFO_LEVEL, service_name, input_file,
+                   "Dispatching to Ghostscript worker pool");
+        GhostscriptPool::Outcome outcome = gs_pool_->compress(input_file, output_file,
+                                                              error_msg);
+        compressed = outcome == GhostscriptPool::Outcome::OK;
+        if (outcome == GhostscriptPool::Outcome::INTERRUPTED ||
+            (outcome == GhostscriptPool::Outcome::REJECTED && !gs_pool_->degraded())) {
             logger_.log(LogLevel::ERROR_LEVEL, service_name, input_file, error_msg);
-            FileProcessorUtils::cleanupFile(input_file);
             return grpc::Status(grpc::StatusCode::INTERNAL, error_msg);
         }
+        if (!compressed) {
+            logger_.log(LogLevel::WARNING_LEVEL, service_name, input_file,
+                       error_msg + "; falling back to exec");
+        }
+    }
 
+    if (!compressed) {
         // Executar compressão com Ghostscript
-        std::ostringstream command;
-        command << "gs -sDEVICE=pdfwrite "
-                << "-dCompatibilityLevel=1.4 "
-                << "-dPDFSETTINGS=/ebook "
-                << "-dNOPAUSE -dQUIET -dBATCH "
-                << "-sOutputFile=\"" << output_file << "\" "
-                << "\"" << input_file << "\"";
+        std::vector<std::string> command = {
+            "gs", "-sDEVICE=pdfwrite", "-dCompatibilityLevel=1.4",
+            "-dPDFSETTINGS=/ebook", "-dNOPAUSE", "-dQUIET", "-dBATCH",
+            "-sOutputFile=" + output_file, input_file};
 
         logger_.log(LogLevel::INFO_LEVEL, service_name, input_file,
-                   "Executing: " + command.str());
+                   "Executing: " + FileProcessorUtils::formatCommand(command));
 
-        auto result = FileProcessorUtils::executeCommand(command.str());
+        auto result = FileProcessorUtils::executeCommand(command);
 
         if (result.exit_code != 0) {
             std::string error = "Ghostscript failed with code " +
                                std::to_string(result.exit_code) +
-                               ": " + result.output;
+                               ": " + result.diagnostics();
             logger_.log(LogLevel::ERROR_LEVEL, service_name, input_file, error);
-
-            FileProcessorUtils::cleanupFile(input_file);
-            FileProcessorUtils::cleanupFile(output_file);
-
             return grpc::Status(grpc::StatusCode::INTERNAL, error);
         }
+    }
 
-        // Verificar se arquivo de saída foi criado
-        if (!FileProcessorUtils::fileExists(output_file)) {
-            std::string error = "Output file was not created";
-            logger_.log(LogLevel::ERROR_LEVEL, service_name, output_file, error);
+    // Verificar se arquivo de saída foi criado
+    if (!output.commitOutput(error_msg) || output.size() == 0) {
+        grpc::Status status = outputFailure(output, error_msg, "Output file was not created");
+        logger_.log(LogLevel::ERROR_LEVEL, service_name, output_file, status.error_message());
+        return status;
+    }
 
-            FileProcessorUtils::cleanupFile(input_file);
-            return grpc::Status(grpc::StatusCode::INTERNAL, error);
-        }
+    // Calcular taxa de compressão (guardando divisão por zero)
+    size_t input_size = input.size();
+    size_t output_size = output.size();
+    double compression_ratio = 0.0;
+    if (input_size > 0) {
+        compression_ratio = (1.0 - (double)output_size / (double)input_size) * 100.0;
+    }
 
-        // Calcular taxa de compressão (guardando divisão por zero)
-        size_t input_size = FileProcessorUtils::getFileSize(input_file);
-        size_t output_size = FileProcessorUtils::getFileSize(output_file);
-        double compression_ratio = 0.0;
-        if (input_size > 0) {
-            compression_ratio = (1.0 - (double)output_size / (double)input_size) * 100.0;
-        }
+    logger_.log(LogLevel::SUCCESS_LEVEL, service_name, input_file,
+               "Compressed from " + std::to_string(input_size) +
+               " to " + std::to_string(output_size) +
+               " bytes (" + std::to_string(compression_ratio) + "% reduction)");
+    return grpc::Status::OK;
+}
+
+FileProcessorServiceImpl::FileReactor* FileProcessorServiceImpl::ConvertToTXT(
+    grpc::CallbackServerContext* context) {
+    std::string service_name = "ConvertToTXT";
+    logger_.log(LogLevel::INFO_LEVEL, service_name, "N/A", "Request received");
+
+    // Modo pipeline: pdftotext lê do stdin e escreve o texto no stdout
+    if (usePdfPipeline()) {
+        return createPipelined(
+            context, service_name, file_processor::CONVERT_TO_TXT,
+            [this](ChunkStream& stream) { return convertToTXTPipelined(stream); });
+    }
+
+    return FileTransferReactor::createBuffered(
+        context, service_name, limiterFor(service_name), *admission_,
+        headerResolver(file_processor::CONVERT_TO_TXT));
+}
 
-        logger_.log(LogLevel::SUCCESS_LEVEL, service_name, input_file,
-                   "Compressed from " + std::to_string(input_size) +
-                   " to " + std::to_string(output_size) +
-                   " bytes (" + std::to_string(compression_ratio) + "% reduction)");
+grpc::Status FileProcessorServiceImpl::convertToTXTPipelined(ChunkStream& stream) {
+    // Com a engine in-process não há ferramenta para ligar ao stream
+    if (usePdfTextEngine()) {
+        return convertToTXTStreamed(stream);
+    }
 
-        // Enviar arquivo comprimido de volta
-        if (!sendFile(stream, output_file, error_msg)) {
-            logger_.log(LogLevel::ERROR_LEVEL, service_name, output_file, error_msg);
+    std::string service_name = "ConvertToTXT";
+    size_t input_size = 0;
+    size_t output_size = 0;
+    grpc::Status status = runPipelined(service_name, stream,
+                                       {"pdftotext", "-", "-"},
+                                       "pdftotext", true,
+                                       input_size, output_size);
+    if (!status.ok()) {
+        return status;
+    }
 
-            FileProcessorUtils::cleanupFile(input_file);
-            FileProcessorUtils::cleanupFile(output_file);
+    logger_.log(LogLevel::SUCCESS_LEVEL, service_name, "pipe",
+               "Converted to TXT (" + std::to_string(output_size) + " bytes)");
+    return grpc::Status::OK;
+}
 
-            return grpc::Status(grpc::StatusCode::INTERNAL, error_msg);
+grpc::Status FileProcessorServiceImpl::convertToTXTStreamed(ChunkStream& stream) {
+    std::string service_name = "ConvertToTXT";
+
+    // O poppler precisa do documento inteiro (a tabela xref fica no fim)
+    const size_t spill_threshold = ServerConfig::getInstance().spill_threshold_bytes;
+    std::shared_ptr<ScratchSpace::Quota> quota = ScratchSpace::getInstance().newQuota();
+    TransferBuffer input(spill_threshold, quota);
+    std::string error_msg;
+    file_processor::FileChunk chunk;
+    while (stream.Read(&chunk)) {
+        if (!input.append(chunk.content().data(), chunk.content().size(), error_msg)) {
+            logger_.log(LogLevel::ERROR_LEVEL, service_name, input.description(), error_msg);
+            return grpc::Status(input.quotaExceeded() ? grpc::StatusCode::RESOURCE_EXHAUSTED
+                                                      : grpc::StatusCode::INTERNAL,
+                                error_msg);
         }
+    }
 
-        // Limpar arquivos temporários
-        FileProcessorUtils::cleanupFile(input_file);
-        FileProcessorUtils::cleanupFile(output_file);
+    // Cada página sai assim que fica pronta; páginas curtas seguidas, já
+    // prontas, são agrupadas até o tamanho de chunk sugerido pelo stream
+    size_t bytes_sent = 0;
+    bool send_failed = false;
+    chunk.mutable_content()->clear();
+    PdfTextEngine::PageSink sink = [&](const std::string& text, bool more_ready,
+                                       std::string& error) {
+        std::string* content = chunk.mutable_content();
+        content->append(text);
+        if (more_ready && content->size() < stream.chunkSize()) {
+            return true;
+        }
+        size_t length = content->size();
+        if (!stream.Write(&chunk)) {
+            send_failed = true;
+            error = "Failed to send chunk";
+            return false;
+        }
+        bytes_sent += length;
+        chunk.mutable_content()->clear();
+        return true;
+    };
+
+    int page_count = 0;
+    std::string input_file;
+    bool extracted = input.inMemory()
+        ? pdf_text_engine_.extract(input.memory().data(), input.memory().size(), sink,
+                                   page_count, error_msg)
+        : input.inputPath(input_file, error_msg) &&
+          pdf_text_engine_.extractFile(input_file, sink, page_count, error_msg);
+
+    // Nada enviado ainda: o pdftotext pode tentar o mesmo documento
+    JobContext* job = JobContext::current();
+    if (!extracted && bytes_sent == 0 && !send_failed &&
+        !(job != nullptr && job->abandoned())) {
+        logger_.log(LogLevel::WARNING_LEVEL, service_name, input.description(),
+                   "PDF text engine failed, falling back to pdftotext: " + error_msg);
+        TransferBuffer output(spill_threshold, quota);
+        grpc::Status status = convertToTXTExternal(input, output);
+        if (!status.ok()) {
+            return status;
+        }
+        for (size_t offset = 0; offset < output.size();) {
+            std::string* content = chunk.mutable_content();
+            content->resize(std::min(stream.chunkSize(), output.size() - offset));
+            size_t length = output.readAt(offset, &(*content)[0], content->size());
+            if (length == 0) {
+                error_msg = "Failed to read pdftotext output";
+                logger_.log(LogLevel::ERROR_LEVEL, service_name, output.description(),
+                           error_msg);
+                return grpc::Status(grpc::StatusCode::INTERNAL, error_msg);
+            }
+            content->resize(length);
+            if (!stream.Write(&chunk)) {
+                return grpc::Status(grpc::StatusCode::INTERNAL, "Failed to send chunk");
+            }
+            offset += length;
+        }
+        return grpc::Status::OK;
+    }
+
+    if (!extracted) {
+        logger_.log(LogLevel::ERROR_LEVEL, service_name, input.description(), error_msg);
+        return grpc::Status(grpc::StatusCode::INTERNAL, error_msg);
+    }
 
-        logger_.log(LogLevel::SUCCESS_LEVEL, service_name, "N/A",
-                   "Request completed successfully");
+    logger_.log(LogLevel::SUCCESS_LEVEL, service_name, input.description(),
+               "Converted to TXT in-process (" + std::to_string(page_count) +
+               " pages streamed, " + std::to_string(bytes_sent) + " bytes)");
+    return grpc::Status::OK;
+}
 
+grpc::Status FileProcessorServiceImpl::convertToTXT(TransferBuffer& input,
+                                                    TransferBuffer& output) {
+    // Engine in-process primeiro; pdftotext como fallback
+    if (tryPdfTextEngine("ConvertToTXT", input, output)) {
         return grpc::Status::OK;
-    } catch (const std::exception& e) {
-        std::string err = std::string("Unhandled exception in CompressPDF: ") + e.what();
-        logger_.log(LogLevel::ERROR_LEVEL, service_name, "N/A", err);
-        return grpc::Status(grpc::StatusCode::INTERNAL, err);
-    } catch (...) {
-        std::string err = "Unhandled unknown exception in CompressPDF";
-        logger_.log(LogLevel::ERROR_LEVEL, service_name, "N/A", err);
-        return grpc::Status(grpc::StatusCode::INTERNAL, err);
     }
+    return convertToTXTExternal(input, output);
 }
 
-grpc::Status FileProcessorServiceImpl::ConvertToTXT(
-    grpc::ServerContext* context,
-    grpc::ServerReaderWriter<file_processor::FileChunk,
-                            file_processor::FileChunk>* stream) {
+grpc::Status FileProcessorServiceImpl::convertToTXTExternal(TransferBuffer& input,
+                                                            TransferBuffer& output) {
     std::string service_name = "ConvertToTXT";
-    logger_.log(LogLevel::INFO_LEVEL, service_name, "N/A", "Request received");
 
-    try {
-        std::string input_file = FileProcessorUtils::generateTempFileName(
-            "input_pdf", ".pdf");
-        std::string output_file = FileProcessorUtils::generateTempFileName(
-            "output_txt", ".txt");
+    std::string error_msg;
+    std::string input_file;
+    std::string output_file;
+    if (!input.inputPath(input_file, error_msg) ||
+        !output.prepareOutput(input.onDisk(), ".txt", output_file, error_msg)) {
+        logger_.log(LogLevel::ERROR_LEVEL, service_name, input.description(),
+                   error_msg);
+        return grpc::Status(grpc::StatusCode::INTERNAL, error_msg);
+    }
 
-        std::string error_msg;
-        if (!receiveFile(stream, input_file, error_msg)) {
-            logger_.log(LogLevel::ERROR_LEVEL, service_name, input_file, error_msg);
-            return grpc::Status(grpc::StatusCode::INTERNAL, error_msg);
+    // PDF grande: faixas de páginas em paralelo
+    bool converted = false;
+    std::vector<PdfSharder::PageRange> ranges = planPdfShards(service_name, input,
+                                                              input_file);
+    if (ranges.size() > 1) {
+        converted = pdf_sharder_.extractText(input_file, output_file, ranges, error_msg);
+        if (!converted) {
+            logger_.log(LogLevel::WARNING_LEVEL, service_name, input_file,
+                       error_msg + "; converting whole document");
         }
+    }
 
+    if (!converted) {
         // Executar conversão com pdftotext
-        std::string command = "pdftotext \"" + input_file + "\" \"" + output_file + "\"";
+        std::vector<std::string> command = {"pdftotext", input_file, output_file};
 
         logger_.log(LogLevel::INFO_LEVEL, service_name, input_file,
-                   "Executing: " + command);
+                   "Executing: " + FileProcessorUtils::formatCommand(command));
 
         auto result = FileProcessorUtils::executeCommand(command);
 
         if (result.exit_code != 0) {
             std::string error = "pdftotext failed with code " +
                                std::to_string(result.exit_code) +
-                               ": " + result.output;
+                               ": " + result.diagnostics();
             logger_.log(LogLevel::ERROR_LEVEL, service_name, input_file, error);
-
-            FileProcessorUtils::cleanupFile(input_file);
-            FileProcessorUtils::cleanupFile(output_file);
-
             return grpc::Status(grpc::StatusCode::INTERNAL, error);
         }
+    }
 
-        if (!FileProcessorUtils::fileExists(output_file)) {
-            std::string error = "Output file was not created";
-            logger_.log(LogLevel::ERROR_LEVEL, service_name, output_file, error);
-
-            FileProcessorUtils::cleanupFile(input_file);
-            return grpc::Status(grpc::StatusCode::INTERNAL, error);
-        }
-
-        size_t output_size = FileProcessorUtils::getFileSize(output_file);
-        logger_.log(LogLevel::SUCCESS_LEVEL, service_name, input_file,
-                   "Converted to TXT (" + std::to_string(output_size) + " bytes)");
-
-        if (!sendFile(stream, output_file, error_msg)) {
-            logger_.log(LogLevel::ERROR_LEVEL, service_name, output_file, error_msg);
-
-            FileProcessorUtils::cleanupFile(input_file);
-            FileProcessorUtils::cleanupFile(output_file);
-
-            return grpc::Status(grpc::StatusCode::INTERNAL, error_msg);
-        }
-
-        FileProcessorUtils::cleanupFile(input_file);
-        FileProcessorUtils::cleanupFile(output_file);
-
-        logger_.log(LogLevel::SUCCESS_LEVEL, service_name, "N/A",
-                   "Request completed successfully");
-
-        return grpc::Status::OK;
-    } catch (const std::exception& e) {
-        std::string err = std::string("Unhandled exception in ConvertToTXT: ") + e.what();
-        logger_.log(LogLevel::ERROR_LEVEL, service_name, "N/A", err);
-        return grpc::Status(grpc::StatusCode::INTERNAL, err);
-    } catch (...) {
-        std::string err = "Unhandled unknown exception in ConvertToTXT";
-        logger_.log(LogLevel::ERROR_LEVEL, service_name, "N/A", err);
-        return grpc::Status(grpc::StatusCode::INTERNAL, err);
+    // PDF sem texto gera saída vazia, o que não é erro
+    if (!output.commitOutput(error_msg)) {
+        logger_.log(LogLevel::ERROR_LEVEL, service_name, output_file, error_msg);
+        return outputFailure(output, error_msg, error_msg);
     }
+
+    size_t output_size = output.size();
+    logger_.log(LogLevel::SUCCESS_LEVEL, service_name, input_file,
+               "Converted to TXT (" + std::to_string(output_size) + " bytes)");
+    return grpc::Status::OK;
 }
 
-grpc::Status FileProcessorServiceImpl::ConvertImageFormat(
-    grpc::ServerContext* context,
-    grpc::ServerReaderWriter<file_processor::FileChunk,
-                            file_processor::FileChunk>* stream) {
+FileProcessorServiceImpl::FileReactor* FileProcessorServiceImpl::ConvertImageFormat(
+    grpc::CallbackServerContext* context) {
     std::string service_name = "ConvertImageFormat";
     logger_.log(LogLevel::INFO_LEVEL, service_name, "N/A", "Request received");
 
-    try {
-        // Para este exemplo, vamos converter para PNG por padrão
-        std::string input_file = FileProcessorUtils::generateTempFileName(
-            "input_img", ".tmp");
-        std::string output_file = FileProcessorUtils::generateTempFileName(
-            "output_img", ".png");
+    return FileTransferReactor::createBuffered(
+        context, service_name, limiterFor(service_name), *admission_,
+        headerResolver(file_processor::CONVERT_IMAGE_FORMAT));
+}
 
-        std::string error_msg;
-        if (!receiveFile(stream, input_file, error_msg)) {
-            logger_.log(LogLevel::ERROR_LEVEL, service_name, input_file, error_msg);
+grpc::Status FileProcessorServiceImpl::convertImageFormat(TransferBuffer& input,
+                                                          TransferBuffer& output,
+                                                          ImageFormat output_format) {
+    std::string service_name = "ConvertImageFormat";
+    std::string error_msg;
+
+    // Engine in-process primeiro; ImageMagick como fallback
+    grpc::Status rejected;
+    if (!tryImageEngine(service_name, input, output, output_format, 0, 0, false,
+                        rejected)) {
+        if (!rejected.ok()) {
+            return rejected;
+        }
+        std::string input_file;
+        std::string output_file;
+        if (!input.inputPath(input_file, error_msg) ||
+            !output.prepareOutput(input.onDisk(), ImageEngine::extensionFor(output_format),
+                                  output_file, error_msg)) {
+            logger_.log(LogLevel::ERROR_LEVEL, service_name, input.description(),
+                       error_msg);
             return grpc::Status(grpc::StatusCode::INTERNAL, error_msg);
         }
 
-        // Executar conversão com ImageMagick
+        // Executar conversão com ImageMagick; o prefixo "<formato>:" define o
+        // formato de saída, já que o destino pode não ter extensão (memfd)
         // No Windows, usar "magick convert" ao invés de apenas "convert"
 #ifdef _WIN32
-        std::string command = "magick convert \"" + input_file + "\" \"" + output_file + "\"";
+        std::vector<std::string> command = {"magick", "convert", input_file,
+                                            ImageEngine::nameFor(output_format) + ":" +
+                                            output_file};
 #else
-        std::string command = "convert \"" + input_file + "\" \"" + output_file + "\"";
+        std::vector<std::string> command = {"convert", input_file,
+                                            ImageEngine::nameFor(output_format) + ":" +
+                                            output_file};
 #endif
 
         logger_.log(LogLevel::INFO_LEVEL, service_name, input_file,
-                   "Executing: " + command);
+                   "Executing: " + FileProcessorUtils::formatCommand(command));
 
         auto result = FileProcessorUtils::executeCommand(command);
 
         if (result.exit_code != 0) {
             std::string error = "ImageMagick convert failed with code " +
                                std::to_string(result.exit_code) +
-                               ": " + result.output;
+                               ": " + result.diagnostics();
             logger_.log(LogLevel::ERROR_LEVEL, service_name, input_file, error);
-
-            FileProcessorUtils::cleanupFile(input_file);
-            FileProcessorUtils::cleanupFile(output_file);
-
-            return grpc::Status(grpc::StatusCode::INTERNAL, error);
-        }
-
-        if (!FileProcessorUtils::fileExists(output_file)) {
-            std::string error = "Output file was not created";
-            logger_.log(LogLevel::ERROR_LEVEL, service_name, output_file, error);
-
-            FileProcessorUtils::cleanupFile(input_file);
             return grpc::Status(grpc::StatusCode::INTERNAL, error);
         }
 
-        size_t output_size = FileProcessorUtils::getFileSize(output_file);
-        logger_.log(LogLevel::SUCCESS_LEVEL, service_name, input_file,
-                   "Converted to PNG (" + std::to_string(output_size) + " bytes)");
-
-        if (!sendFile(stream, output_file, error_msg)) {
-            logger_.log(LogLevel::ERROR_LEVEL, service_name, output_file, error_msg);
-
-            FileProcessorUtils::cleanupFile(input_file);
-            FileProcessorUtils::cleanupFile(output_file);
-
-            return grpc::Status(grpc::StatusCode::INTERNAL, error_msg);
+        if (!output.commitOutput(error_msg) || output.size() == 0) {
+            grpc::Status status = outputFailure(output, error_msg,
+                                                "Output file was not created");
+            logger_.log(LogLevel::ERROR_LEVEL, service_name, output_file,
+                       status.error_message());
+            return status;
         }
-
-        FileProcessorUtils::cleanupFile(input_file);
-        FileProcessorUtils::cleanupFile(output_file);
-
-        logger_.log(LogLevel::SUCCESS_LEVEL, service_name, "N/A",
-                   "Request completed successfully");
-
-        return grpc::Status::OK;
-    } catch (const std::exception& e) {
-        std::string err = std::string("Unhandled exception in ConvertImageFormat: ") + e.what();
-        logger_.log(LogLevel::ERROR_LEVEL, service_name, "N/A", err);
-        return grpc::Status(grpc::StatusCode::INTERNAL, err);
-    } catch (...) {
-        std::string err = "Unhandled unknown exception in ConvertImageFormat";
-        logger_.log(LogLevel::ERROR_LEVEL, service_name, "N/A", err);
-        return grpc::Status(grpc::StatusCode::INTERNAL, err);
     }
+
+    std::string format_name = ImageEngine::nameFor(output_format);
+    std::transform(format_name.begin(), format_name.end(), format_name.begin(), ::toupper);
+    size_t output_size = output.size();
+    logger_.log(LogLevel::SUCCESS_LEVEL, service_name, input.description(),
+               "Converted to " + format_name + " (" + std::to_string(output_size) +
+               " bytes)");
+    return grpc::Status::OK;
 }
 
-grpc::Status FileProcessorServiceImpl::ResizeImage(
-    grpc::ServerContext* context,
-    grpc::ServerReaderWriter<file_processor::FileChunk,
-                            file_processor::FileChunk>* stream) {
+FileProcessorServiceImpl::FileReactor* FileProcessorServiceImpl::ResizeImage(
+    grpc::CallbackServerContext* context) {
     std::string service_name = "ResizeImage";
     logger_.log(LogLevel::INFO_LEVEL, service_name, "N/A", "Request received");
 
-    try {
-        // Para este exemplo, vamos redimensionar para 800x600
-        int width = 800;
-        int height = 600;
-
-        std::string input_file = FileProcessorUtils::generateTempFileName(
-            "input_img", ".tmp");
-        std::string output_file = FileProcessorUtils::generateTempFileName(
-            "output_img", ".jpg");
+    return FileTransferReactor::createBuffered(
+        context, service_name, limiterFor(service_name), *admission_,
+        headerResolver(file_processor::RESIZE_IMAGE));
+}
 
-        std::string error_msg;
-        if (!receiveFile(stream, input_file, error_msg)) {
-            logger_.log(LogLevel::ERROR_LEVEL, service_name, input_file, error_msg);
+grpc::Status FileProcessorServiceImpl::resizeImage(TransferBuffer& input,
+                                                   TransferBuffer& output,
+                                                   int width, int height,
+                                                   bool maintain_aspect_ratio) {
+    std::string service_name = "ResizeImage";
+    std::string error_msg;
+
+    // Engine in-process primeiro; ImageMagick como fallback
+    grpc::Status rejected;
+    if (!tryImageEngine(service_name, input, output, ImageFormat::JPEG,
+                        width, height, maintain_aspect_ratio, rejected)) {
+        if (!rejected.ok()) {
+            return rejected;
+        }
+        std::string input_file;
+        std::string output_file;
+        if (!input.inputPath(input_file, error_msg) ||
+            !output.prepareOutput(input.onDisk(), ".jpg", output_file, error_msg)) {
+            logger_.log(LogLevel::ERROR_LEVEL, service_name, input.description(),
+                       error_msg);
             return grpc::Status(grpc::StatusCode::INTERNAL, error_msg);
         }
 
-        // Executar redimensionamento com ImageMagick
+        // Executar redimensionamento com ImageMagick ("!" força o tamanho
+        // exato; sem ele a imagem cabe em WxH mantendo a proporção)
         // No Windows, usar "magick convert" ao invés de apenas "convert"
-        std::ostringstream command;
+        const char* geometry_flag = maintain_aspect_ratio ? "" : "!";
+        std::string geometry = std::to_string(width) + "x" + std::to_string(height) +
+                               geometry_flag;
 #ifdef _WIN32
-        command << "magick convert \"" << input_file << "\" "
-                << "-resize " << width << "x" << height << "! "
-                << "\"" << output_file << "\"";
+        std::vector<std::string> command = {"magick", "convert", input_file,
+                                            "-resize", geometry, "jpg:" + output_file};
 #else
-        command << "convert \"" << input_file << "\" "
-                << "-resize " << width << "x" << height << "! "
-                << "\"" << output_file << "\"";
+        std::vector<std::string> command = {"convert", input_file,
+                                            "-resize", geometry, "jpg:" + output_file};
 #endif
 
         logger_.log(LogLevel::INFO_LEVEL, service_name, input_file,
-                   "Executing: " + command.str());
+                   "Executing: " + FileProcessorUtils::formatCommand(command));
 
-        auto result = FileProcessorUtils::executeCommand(command.str());
+        auto result = FileProcessorUtils::executeCommand(command);
 
         if (result.exit_code != 0) {
             std::string error = "ImageMagick resize failed with code " +
                                std::to_string(result.exit_code) +
-                               ": " + result.output;
+                               ": " + result.diagnostics();
             logger_.log(LogLevel::ERROR_LEVEL, service_name, input_file, error);
-
-            FileProcessorUtils::cleanupFile(input_file);
-            FileProcessorUtils::cleanupFile(output_file);
-
             return grpc::Status(grpc::StatusCode::INTERNAL, error);
         }
 
-        if (!FileProcessorUtils::fileExists(output_file)) {
-            std::string error = "Output file was not created";
-            logger_.log(LogLevel::ERROR_LEVEL, service_name, output_file, error);
-
-            FileProcessorUtils::cleanupFile(input_file);
-            return grpc::Status(grpc::StatusCode::INTERNAL, error);
+        if (!output.commitOutput(error_msg) || output.size() == 0) {
+            grpc::Status status = outputFailure(output, error_msg,
+                                                "Output file was not created");
+            logger_.log(LogLevel::ERROR_LEVEL, service_name, output_file,
+                       status.error_message());
+            return status;
         }
+    }
 
-        size_t input_size = FileProcessorUtils::getFileSize(input_file);
-        size_t output_size = FileProcessorUtils::getFileSize(output_file);
+    size_t input_size = input.size();
+    size_t output_size = output.size();
 
-        logger_.log(LogLevel::SUCCESS_LEVEL, service_name, input_file,
-                   "Resized from " + std::to_string(input_size) +
-                   " to " + std::to_string(output_size) +
-                   " bytes (" + std::to_string(width) + "x" +
-                   std::to_string(height) + ")");
+    logger_.log(LogLevel::SUCCESS_LEVEL, service_name, input.description(),
+               "Resized from " + std::to_string(input_size) +
+               " to " + std::to_string(output_size) +
+               " bytes (" + std::to_string(width) + "x" +
+               std::to_string(height) +
+               (maintain_aspect_ratio ? ", aspect ratio preserved" : "") + ")");
+    return grpc::Status::OK;
+}
 
-        if (!sendFile(stream, output_file, error_msg)) {
-            logger_.log(LogLevel::ERROR_LEVEL, service_name, output_file, error_msg);
+grpc::ServerBidiReactor<file_processor::BatchRequest, file_processor::BatchResponse>*
+FileProcessorServiceImpl::ProcessBatch(grpc::CallbackServerContext* context) {
+    logger_.log(LogLevel::INFO_LEVEL, "ProcessBatch", "N/A", "Request received");
 
-            FileProcessorUtils::cleanupFile(input_file);
-            FileProcessorUtils::cleanupFile(output_file);
+    size_t max_in_flight = ServerConfig::getInstance().batch_max_in_flight;
+    if (max_in_flight == 0) {
+        max_in_flight = 2 * executor_.threadCount();
+    }
 
-            return grpc::Status(grpc::StatusCode::INTERNAL, error_msg);
+    return new BatchReactor(
+        context,
+        [this](const file_processor::BatchFileHeader& header,
+               BatchOperation& operation, std::string& error_message) {
+            return resolveBatchOperation(header, operation, error_message);
+        },
+        max_in_flight, *admission_);
+}
+
+bool FileProcessorServiceImpl::resolveBatchOperation(
+    const file_processor::BatchFileHeader& header,
+    BatchOperation& operation,
+    std::string& error_message) {
+    const int max_dimension = 16384;
+
+    switch (header.operation()) {
+        case file_processor::COMPRESS_PDF:
+            operation.service_name = "CompressPDF";
+            operation.cache_parameters = "ebook";
+            operation.handler = [this](TransferBuffer& input, TransferBuffer& output) {
+                return compressPDF(input, output);
+            };
+            break;
+
+        case file_processor::CONVERT_TO_TXT:
+            operation.service_name = "ConvertToTXT";
+            operation.cache_parameters = "txt";
+            operation.handler = [this](TransferBuffer& input, TransferBuffer& output) {
+                return convertToTXT(input, output);
+            };
+            break;
+
+        case file_processor::CONVERT_IMAGE_FORMAT: {
+            // O formato vira coder e extensão do ImageMagick: só a lista aceita
+            ImageFormat format = ImageEngine::formatFromName(
+                header.output_format().empty() ? "png" : header.output_format());
+            if (format == ImageFormat::UNKNOWN) {
+                error_message = "Unsupported output format: " + header.output_format() +
+                                " (expected png, jpg, jpeg, gif, bmp, tiff or webp)";
+                return false;
+            }
+
+            operation.service_name = "ConvertImageFormat";
+            operation.cache_parameters = ImageEngine::nameFor(format);
+            operation.handler = [this, format](TransferBuffer& input,
+                                               TransferBuffer& output) {
+                return convertImageFormat(input, output, format);
+            };
+            break;
         }
 
-        FileProcessorUtils::cleanupFile(input_file);
-        FileProcessorUtils::cleanupFile(output_file);
+        case file_processor::RESIZE_IMAGE: {
+            int width = header.width();
+            int height = header.height();
+            if (width == 0 && height == 0) {
+                width = 800;
+                height = 600;
+            }
+            if (width <= 0 || height <= 0 ||
+                width > max_dimension || height > max_dimension) {
+                error_message = "Invalid dimensions: " + std::to_string(width) + "x" +
+                                std::to_string(height);
+                return false;
+            }
+            // O destino é alocado inteiro: mesmo limite de pixels da decodificação
+            size_t max_pixels = ServerConfig::getInstance().image_max_pixels;
+            if (max_pixels > 0 &&
+                static_cast<uint64_t>(width) * static_cast<uint64_t>(height) > max_pixels) {
+                error_message = "Target size " + std::to_string(width) + "x" +
+                                std::to_string(height) + " exceeds the limit of " +
+                                std::to_string(max_pixels) + " pixels";
+                return false;
+            }
 
-        logger_.log(LogLevel::SUCCESS_LEVEL, service_name, "N/A",
-                   "Request completed successfully");
+            bool maintain_aspect_ratio = header.maintain_aspect_ratio();
+            operation.service_name = "ResizeImage";
+            operation.cache_parameters = "jpeg:" + std::to_string(width) + "x" +
+                                         std::to_string(height) + ":" +
+                                         ImageResampler::filterName(resize_filter_) +
+                                         (maintain_aspect_ratio ? ":fit" : "");
+            operation.handler = [this, width, height, maintain_aspect_ratio](
+                                    TransferBuffer& input, TransferBuffer& output) {
+                return resizeImage(input, output, width, height, maintain_aspect_ratio);
+            };
+            break;
+        }
 
-        return grpc::Status::OK;
-    } catch (const std::exception& e) {
-        std::string err = std::string("Unhandled exception in ResizeImage: ") + e.what();
-        logger_.log(LogLevel::ERROR_LEVEL, service_name, "N/A", err);
-        return grpc::Status(grpc::StatusCode::INTERNAL, err);
-    } catch (...) {
-        std::string err = "Unhandled unknown exception in ResizeImage";
-        logger_.log(LogLevel::ERROR_LEVEL, service_name, "N/A", err);
-        return grpc::Status(grpc::StatusCode::INTERNAL, err);
+        default:
+            error_message = "Unsupported operation: " +
+                            std::to_string(static_cast<int>(header.operation()));
+            return false;
     }
+
+    operation.limiter = &limiterFor(operation.service_name);
+    return true;
+}
+
+FileTransferReactor::HeaderResolver FileProcessorServiceImpl::headerResolver(
+    file_processor::Operation operation) {
+    return [this, operation](const file_processor::RequestHeader& header,
+                             std::string& cache_parameters,
+                             FileTransferReactor::BufferedHandler& handler,
+                             std::string& error_message) {
+        file_processor::BatchFileHeader batch_header;
+        file_processor::Operation header_operation = operation;
+
+        switch (header.parameters_case()) {
+            case file_processor::RequestHeader::kCompressPdf:
+                header_operation = file_processor::COMPRESS_PDF;
+                break;
+            case file_processor::RequestHeader::kConvertToTxt:
+                header_operation = file_processor::CONVERT_TO_TXT;
+                break;
+            case file_processor::RequestHeader::kConvertImageFormat: {
+                const auto& request = header.convert_image_format();
+                header_operation = file_processor::CONVERT_IMAGE_FORMAT;
+                batch_header.set_output_format(request.output_format());
+                break;
+            }
+            case file_processor::RequestHeader::kResizeImage: {
+                const auto& request = header.resize_image();
+                header_operation = file_processor::RESIZE_IMAGE;
+                batch_header.set_width(request.width());
+                batch_header.set_height(request.height());
+                batch_header.set_maintain_aspect_ratio(request.maintain_aspect_ratio());
+                break;
+            }
+            default:
+                // Sem cabeçalho: parâmetros padrão
+                break;
+        }
+
+        if (header_operation != operation) {
+            error_message = "Request header does not match the called RPC";
+            return false;
+        }
+
+        batch_header.set_operation(operation);
+        BatchOperation resolved;
+        if (!resolveBatchOperation(batch_header, resolved, error_message)) {
+            return false;
+        }
+        cache_parameters = resolved.cache_parameters;
+        handler = std::move(resolved.handler);
+        return true;
+    };
 }
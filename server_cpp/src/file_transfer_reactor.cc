@@ -0,0 +1,962 @@
+#include "file_transfer_reactor.h"
+#include "result_cache.h"
+#include "server_config.h"
+#include "upload_store.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <exception>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const size_t kReadBufferSize = 64 * 1024; // leitura do upload retomado para o hash
+
+// Passar a mensagem de from para to sem copiar o content: os buffers das
+// duas trocam de lugar (as mensagens podem estar em arenas diferentes, em
+// que Swap copiaria tudo)
+void moveChunk(file_processor::FileChunk& from, file_processor::FileChunk* to) {
+    to->mutable_content()->swap(*from.mutable_content());
+    if (from.has_integrity()) {
+        *to->mutable_integrity() = from.integrity();
+    } else {
+        to->clear_integrity();
+    }
+    switch (from.payload_case()) {
+        case file_processor::FileChunk::kHeader:
+            *to->mutable_header() = from.header();
+            break;
+        case file_processor::FileChunk::kUploadStatus:
+            *to->mutable_upload_status() = from.upload_status();
+            break;
+        default:
+            to->clear_payload();
+            break;
+    }
+}
+
+// Metadados do cabeçalho, qualquer que seja a operação
+const file_processor::FileMetadata* headerMetadata(
+    const file_processor::RequestHeader& header) {
+    switch (header.parameters_case()) {
+        case file_processor::RequestHeader::kCompressPdf:
+            return &header.compress_pdf().metadata();
+        case file_processor::RequestHeader::kConvertToTxt:
+            return &header.convert_to_txt().metadata();
+        case file_processor::RequestHeader::kConvertImageFormat:
+            return &header.convert_image_format().metadata();
+        case file_processor::RequestHeader::kResizeImage:
+            return &header.resize_image().metadata();
+        default:
+            return nullptr;
+    }
+}
+}
+
+FileTransferReactor::FileTransferReactor(grpc::CallbackServerContext* context,
+                                         const std::string& service_name,
+                                         OperationLimiter& limiter,
+                                         AdmissionController& admission)
+    : context_(context),
+      service_name_(service_name),
+      limiter_(limiter),
+      job_executor_(nullptr),
+      admission_controller_(admission),
+      job_(jobContextFor(context)),
+      logger_(Logger::getInstance()),
+      metrics_(Metrics::getInstance().operation(service_name)),
+      start_time_(std::chrono::steady_clock::now()),
+      send_started_(false),
+      streaming_(false),
+      streaming_executor_(nullptr),
+      streaming_min_bytes_(0),
+      parameters_resolved_(false),
+      arena_(callArenaOptions()),
+      read_chunk_(google::protobuf::Arena::CreateMessage<file_processor::FileChunk>(&arena_)),
+      write_chunk_(google::protobuf::Arena::CreateMessage<file_processor::FileChunk>(&arena_)),
+      status_chunk_(google::protobuf::Arena::CreateMessage<file_processor::FileChunk>(&arena_)),
+      upload_open_(false),
+      upload_size_(0),
+      upload_offset_(0),
+      resumed_from_(0),
+      status_write_pending_(false),
+      scratch_quota_(ScratchSpace::getInstance().newQuota()),
+      input_(ServerConfig::getInstance().spill_threshold_bytes, scratch_quota_),
+      output_(ServerConfig::getInstance().spill_threshold_bytes, scratch_quota_),
+      chunk_sizer_(ServerConfig::getInstance().chunk_min_bytes,
+                   ServerConfig::getInstance().chunk_max_bytes),
+      bytes_sent_(0),
+      chunk_length_(0),
+      compression_(ServerConfig::getInstance().compression_enabled,
+                   ServerConfig::getInstance().compression_min_savings_percent),
+      read_started_(false),
+      read_pending_(false),
+      read_ok_(false),
+      read_closed_(false),
+      read_event_fds_{-1, -1},
+      write_pending_(false),
+      write_ok_(false),
+      stream_position_(0) {
+    metrics_.requests.fetch_add(1, std::memory_order_relaxed);
+    // Vale a partir dos metadados iniciais; o algoritmo é o melhor que o
+    // cliente aceita para o nível (nenhum, se ele não aceitar)
+    if (compression_.enabled()) {
+        context_->set_compression_level(GRPC_COMPRESS_LEVEL_LOW);
+    }
+}
+
+FileTransferReactor::~FileTransferReactor() {
+#ifndef _WIN32
+    for (int fd : read_event_fds_) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+#endif
+}
+
+std::shared_ptr<JobContext> FileTransferReactor::jobContextFor(
+    grpc::CallbackServerContext* context) {
+    const ServerConfig& config = ServerConfig::getInstance();
+    int priority = 0;
+    if (config.client_priority_enabled) {
+        const auto& metadata = context->client_metadata();
+        auto it = metadata.find("fp-priority");
+        if (it != metadata.end()) {
+            priority = JobContext::parsePriority(
+                std::string(it->second.data(), it->second.size()));
+        }
+    }
+    return std::make_shared<JobContext>(JobContext::deadlineFrom(context->deadline()),
+                                        priority,
+                                        std::chrono::milliseconds(config.kill_grace_ms));
+}
+
+FileTransferReactor* FileTransferReactor::createBuffered(
+    grpc::CallbackServerContext* context,
+    const std::string& service_name,
+    OperationLimiter& limiter,
+    AdmissionController& admission,
+    HeaderResolver resolver) {
+    FileTransferReactor* reactor =
+        new FileTransferReactor(context, service_name, limiter, admission);
+    reactor->resolver_ = std::move(resolver);
+    if (reactor->admit()) {
+        reactor->StartRead(reactor->read_chunk_);
+    }
+    return reactor;
+}
+
+FileTransferReactor* FileTransferReactor::createStreaming(
+    grpc::CallbackServerContext* context,
+    const std::string& service_name,
+    OperationLimiter& limiter,
+    WorkStealingExecutor& io_executor,
+    AdmissionController& admission,
+    StreamingHandler handler) {
+    FileTransferReactor* reactor =
+        new FileTransferReactor(context, service_name, limiter, admission);
+    reactor->streaming_ = true;
+    reactor->streaming_handler_ = std::move(handler);
+    reactor->job_executor_ = &io_executor;
+    if (!reactor->openReadEvents() || !reactor->admit()) {
+        return reactor;
+    }
+    reactor->submitStreamingJob();
+    return reactor;
+}
+
+FileTransferReactor* FileTransferReactor::createHybrid(
+    grpc::CallbackServerContext* context,
+    const std::string& service_name,
+    OperationLimiter& limiter,
+    WorkStealingExecutor& io_executor,
+    AdmissionController& admission,
+    HeaderResolver resolver,
+    StreamingHandler handler,
+    uint64_t streaming_min_bytes) {
+    FileTransferReactor* reactor =
+        new FileTransferReactor(context, service_name, limiter, admission);
+    reactor->resolver_ = std::move(resolver);
+    reactor->streaming_handler_ = std::move(handler);
+    reactor->streaming_executor_ = &io_executor;
+    reactor->streaming_min_bytes_ = streaming_min_bytes;
+    if (reactor->admit()) {
+        reactor->StartRead(reactor->read_chunk_);
+    }
+    return reactor;
+}
+
+bool FileTransferReactor::openReadEvents() {
+#ifndef _WIN32
+    bool piped = pipe(read_event_fds_) == 0;
+    for (int fd : read_event_fds_) {
+        if (piped) {
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        }
+    }
+    if (!piped) {
+        read_event_fds_[0] = read_event_fds_[1] = -1;
+        finish(grpc::Status(grpc::StatusCode::INTERNAL,
+                            "Failed to create stream event pipe"));
+        return false;
+    }
+#endif
+    return true;
+}
+
+void FileTransferReactor::submitStreamingJob() {
+    submitJob([this]() {
+        auto started = std::chrono::steady_clock::now();
+        grpc::Status status = runHandler([this]() {
+            return streaming_handler_(*this);
+        });
+        metrics_.observe(RequestPhase::PROCESS, started);
+        if (recordIfAbandoned(started)) {
+            finish(abandonedStatus("during processing"));
+            return;
+        }
+        // Chunk rejeitado em Read(): o erro do handler é consequência dele
+        finish(stream_error_.ok() ? status : stream_error_);
+    });
+}
+
+void FileTransferReactor::switchToStreaming() {
+    if (!openReadEvents()) {
+        return;
+    }
+    // Nenhuma leitura ou escrita pendente: o callback que chama é o único
+    // dono do estado até o job ser enfileirado
+    streaming_ = true;
+    job_executor_ = streaming_executor_;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        read_started_ = true;
+        read_pending_ = false;
+        read_ok_ = true;
+    }
+#ifndef _WIN32
+    const char event = 1;
+    while (write(read_event_fds_[1], &event, 1) < 0 && errno == EINTR) {
+    }
+#endif
+    submitStreamingJob();
+}
+
+bool FileTransferReactor::admit() {
+    std::string error;
+    if (admission_controller_.admit(context_->peer(), admission_, error)) {
+        return true;
+    }
+    rejectBusy(error, admission_.retryAfter());
+    return false;
+}
+
+bool FileTransferReactor::reserveBytes(uint64_t bytes) {
+    std::string error;
+    if (admission_.reserveBytes(bytes, error)) {
+        return true;
+    }
+    rejectBusy(error, admission_.retryAfter());
+    return false;
+}
+
+void FileTransferReactor::rejectBusy(const std::string& error,
+                                     std::chrono::milliseconds retry_after) {
+    logger_.log(LogLevel::WARNING_LEVEL, service_name_, context_->peer(),
+               error + " (retry after " + std::to_string(retry_after.count()) + "ms)");
+    context_->AddTrailingMetadata("fp-retry-after-ms", std::to_string(retry_after.count()));
+    finish(grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, error));
+}
+
+void FileTransferReactor::submitJob(std::function<void()> job) {
+    auto dropped = [this](OperationLimiter::DropReason) {
+        grpc::Status status = abandonedStatus("before processing");
+        logger_.log(LogLevel::WARNING_LEVEL, service_name_, context_->peer(),
+                   "Job dropped from the queue: " + status.error_message());
+        finish(status);
+    };
+    if (!limiter_.submit(std::move(job), job_, dropped, job_executor_)) {
+        std::string error = "Server busy: " + service_name_ + " queue is full (" +
+                            std::to_string(limiter_.maxConcurrent()) + " running, " +
+                            std::to_string(limiter_.queueDepth()) + " queued)";
+        rejectBusy(error, admission_controller_.limits().retry_after);
+    }
+}
+
+grpc::Status FileTransferReactor::abandonedStatus(const std::string& when) const {
+    if (job_->expired()) {
+        return grpc::Status(grpc::StatusCode::DEADLINE_EXCEEDED,
+                            "Deadline exceeded " + when);
+    }
+    return grpc::Status(grpc::StatusCode::CANCELLED, "Request cancelled " + when);
+}
+
+bool FileTransferReactor::recordIfAbandoned(std::chrono::steady_clock::time_point started) {
+    if (!job_->abandoned() && !context_->IsCancelled()) {
+        return false;
+    }
+    metrics_.recordWasted(started);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started);
+    logger_.log(LogLevel::WARNING_LEVEL, service_name_, context_->peer(),
+               "Call abandoned during processing (" + std::to_string(elapsed.count()) +
+               "ms of work wasted)");
+    return true;
+}
+
+grpc::Status FileTransferReactor::runHandler(
+    const std::function<grpc::Status()>& handler) {
+    // Cliente desistiu (ou o prazo venceu) entre a fila e o início do job
+    if (context_->IsCancelled() || job_->abandoned()) {
+        grpc::Status status = abandonedStatus("before processing");
+        logger_.log(LogLevel::WARNING_LEVEL, service_name_, "N/A", status.error_message());
+        return status;
+    }
+
+    try {
+        return handler();
+    } catch (const std::exception& e) {
+        std::string err = "Unhandled exception in " + service_name_ + ": " + e.what();
+        logger_.log(LogLevel::ERROR_LEVEL, service_name_, "N/A", err);
+        return grpc::Status(grpc::StatusCode::INTERNAL, err);
+    } catch (...) {
+        std::string err = "Unhandled unknown exception in " + service_name_;
+        logger_.log(LogLevel::ERROR_LEVEL, service_name_, "N/A", err);
+        return grpc::Status(grpc::StatusCode::INTERNAL, err);
+    }
+}
+
+bool FileTransferReactor::Read(file_processor::FileChunk* chunk) {
+    while (true) {
+        switch (TryRead(chunk)) {
+            case ReadState::CHUNK:
+                return true;
+            case ReadState::END:
+                return false;
+            case ReadState::PENDING: {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return !read_pending_; });
+                break;
+            }
+        }
+    }
+}
+
+ChunkStream::ReadState FileTransferReactor::TryRead(file_processor::FileChunk* chunk) {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (read_closed_) {
+                return ReadState::END;
+            }
+            if (!read_started_) {
+                read_started_ = true;
+                read_pending_ = true;
+                lock.unlock();
+                StartRead(read_chunk_);
+                return ReadState::PENDING;
+            }
+            if (read_pending_) {
+                return ReadState::PENDING;
+            }
+
+            // Leitura concluída: consumir o byte do OnReadDone
+            read_started_ = false;
+#ifndef _WIN32
+            char event;
+            while (read_event_fds_[0] >= 0 && read(read_event_fds_[0], &event, 1) < 0 &&
+                   errno == EINTR) {
+            }
+#endif
+            if (!read_ok_) {
+                read_closed_ = true;
+                return ReadState::END;
+            }
+            moveChunk(*read_chunk_, chunk);
+        }
+        if (!chunk->has_header()) {
+            break;
+        }
+
+        // Sem parte guardada no pipeline: o cliente envia tudo desde o início
+        if (!chunk->header().upload_id().empty()) {
+            file_processor::FileChunk status;
+            status.mutable_upload_status()->set_upload_id(chunk->header().upload_id());
+            status.mutable_upload_status()->set_committed_offset(0);
+            if (!Write(&status)) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                read_closed_ = true;
+                return ReadState::END;
+            }
+        }
+    }
+
+    grpc::Status verified = verifyChunk(*chunk, stream_position_);
+    if (!verified.ok()) {
+        logger_.log(LogLevel::WARNING_LEVEL, service_name_, "pipe",
+                   verified.error_message());
+        std::lock_guard<std::mutex> lock(mutex_);
+        stream_error_ = verified;
+        read_closed_ = true;
+        return ReadState::END;
+    }
+    stream_position_ += chunk->content().size();
+    metrics_.bytes_in.fetch_add(chunk->content().size(), std::memory_order_relaxed);
+    return ReadState::CHUNK;
+}
+
+bool FileTransferReactor::Write(file_processor::FileChunk* chunk) {
+    // Read() também escreve (UploadStatus): uma escrita por vez
+    std::lock_guard<std::mutex> write_lock(write_mutex_);
+    size_t length = chunk->content().size();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        write_pending_ = true;
+        moveChunk(*chunk, write_chunk_);
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    StartWrite(write_chunk_, writeOptions(*write_chunk_));
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return !write_pending_; });
+    if (write_ok_) {
+        metrics_.bytes_out.fetch_add(length, std::memory_order_relaxed);
+        chunk_sizer_.record(length, std::chrono::steady_clock::now() - start);
+    }
+    return write_ok_;
+}
+
+size_t FileTransferReactor::chunkSize() {
+    // No modo streaming o chunk_sizer_ só é usado pelo Write
+    std::lock_guard<std::mutex> write_lock(write_mutex_);
+    return chunk_sizer_.next();
+}
+
+void FileTransferReactor::OnReadDone(bool ok) {
+    if (streaming_) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        read_ok_ = ok;
+        read_pending_ = false;
+#ifndef _WIN32
+        // Acordar quem espera no poll (o pipe não enche: um byte por leitura)
+        const char event = 1;
+        while (write(read_event_fds_[1], &event, 1) < 0 && errno == EINTR) {
+        }
+#endif
+        cv_.notify_all();
+        return;
+    }
+
+    if (ok) {
+        if (read_chunk_->has_header()) {
+            if (parameters_resolved_) {
+                std::string error = "Request header must be the first message";
+                logger_.log(LogLevel::WARNING_LEVEL, service_name_, "N/A", error);
+                finish(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, error));
+                return;
+            }
+            if (resolveParameters(read_chunk_->header())) {
+                StartRead(read_chunk_);
+            }
+            return;
+        }
+
+        // Cliente sem cabeçalho: parâmetros padrão da operação
+        if (!parameters_resolved_ &&
+            !resolveParameters(file_processor::RequestHeader())) {
+            return;
+        }
+
+        if (storeChunk(*read_chunk_)) {
+            StartRead(read_chunk_);
+        }
+        return;
+    }
+
+    // Fim do upload (ou cancelamento, tratado em runHandler)
+    if (!parameters_resolved_ &&
+        !resolveParameters(file_processor::RequestHeader())) {
+        return;
+    }
+    if (!upload_id_.empty() && !completeResumableUpload()) {
+        return;
+    }
+
+    metrics_.observe(RequestPhase::RECEIVE, start_time_);
+    if (upload_id_.empty()) {
+        metrics_.bytes_in.fetch_add(input_.size(), std::memory_order_relaxed);
+        logger_.log(LogLevel::INFO_LEVEL, "FileTransfer", input_.description(),
+                   "Received " + std::to_string(input_.size()) + " bytes");
+    } else {
+        logger_.log(LogLevel::INFO_LEVEL, "FileTransfer", input_.description(),
+                   "Received " + std::to_string(upload_offset_ - resumed_from_) +
+                   " bytes (upload " + upload_id_ + " resumed at " +
+                   std::to_string(resumed_from_) + ", " +
+                   std::to_string(input_.size()) + " bytes total)");
+    }
+    processUpload();
+}
+
+grpc::Status FileTransferReactor::verifyChunk(const file_processor::FileChunk& chunk,
+                                              uint64_t position) const {
+    if (!chunk.has_integrity()) {
+        return grpc::Status::OK;
+    }
+
+    const file_processor::ChunkIntegrity& integrity = chunk.integrity();
+    if (static_cast<uint64_t>(integrity.offset()) != position) {
+        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                            "Chunk offset " + std::to_string(integrity.offset()) +
+                            " does not match expected offset " + std::to_string(position));
+    }
+
+    const std::string& content = chunk.content();
+    uLong crc = crc32(0L, Z_NULL, 0);
+    crc = crc32(crc, reinterpret_cast<const Bytef*>(content.data()),
+                static_cast<uInt>(content.size()));
+    if (static_cast<uint32_t>(crc) != integrity.crc32()) {
+        return grpc::Status(grpc::StatusCode::DATA_LOSS,
+                            "Checksum mismatch for chunk at offset " +
+                            std::to_string(position));
+    }
+    return grpc::Status::OK;
+}
+
+bool FileTransferReactor::storeChunk(const file_processor::FileChunk& chunk) {
+    const std::string& content = chunk.content();
+    grpc::Status verified = verifyChunk(chunk, upload_id_.empty()
+                                                   ? input_.size() : upload_offset_);
+    if (!verified.ok()) {
+        // Upload retomável: a parte guarda o que veio antes do chunk rejeitado
+        logger_.log(LogLevel::WARNING_LEVEL, service_name_,
+                   upload_id_.empty() ? input_.description() : upload_id_,
+                   verified.error_message());
+        finish(verified);
+        return false;
+    }
+
+    // Sem tamanho anunciado, a reserva acompanha os bytes recebidos
+    if (!reserveBytes((upload_id_.empty() ? input_.size() : upload_offset_) +
+                      content.size())) {
+        return false;
+    }
+
+    std::string error_msg;
+    if (upload_id_.empty()) {
+        hasher_.update(content.data(), content.size());
+        if (!input_.append(content.data(), content.size(), error_msg)) {
+            logger_.log(LogLevel::ERROR_LEVEL, service_name_, input_.description(),
+                       error_msg);
+            finish(grpc::Status(input_.quotaExceeded() ? grpc::StatusCode::RESOURCE_EXHAUSTED
+                                                       : grpc::StatusCode::INTERNAL,
+                                error_msg));
+            return false;
+        }
+        return true;
+    }
+
+    if (upload_offset_ + content.size() > upload_size_) {
+        std::string error = "Upload exceeds the announced size of " +
+                            std::to_string(upload_size_) + " bytes";
+        logger_.log(LogLevel::WARNING_LEVEL, service_name_, upload_id_, error);
+        finish(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, error));
+        return false;
+    }
+    bool space_exhausted = false;
+    if (!UploadStore::getInstance().append(upload_id_, content.data(), content.size(),
+                                           error_msg, &space_exhausted)) {
+        logger_.log(LogLevel::ERROR_LEVEL, service_name_, upload_id_, error_msg);
+        finish(grpc::Status(space_exhausted ? grpc::StatusCode::RESOURCE_EXHAUSTED
+                                            : grpc::StatusCode::INTERNAL,
+                            error_msg));
+        return false;
+    }
+    upload_offset_ += content.size();
+    metrics_.bytes_in.fetch_add(content.size(), std::memory_order_relaxed);
+    return true;
+}
+
+bool FileTransferReactor::openResumableUpload(
+    const std::string& upload_id, const file_processor::FileMetadata* metadata) {
+    UploadStore& store = UploadStore::getInstance();
+    grpc::StatusCode code = grpc::StatusCode::OK;
+    std::string error_msg;
+
+    if (metadata == nullptr || metadata->file_size() <= 0) {
+        code = grpc::StatusCode::INVALID_ARGUMENT;
+        error_msg = "Resumable uploads require metadata.file_size";
+    } else if (!store.enabled()) {
+        code = grpc::StatusCode::UNIMPLEMENTED;
+        error_msg = "Resumable uploads are disabled";
+    } else if (!UploadStore::isValidId(upload_id)) {
+        code = grpc::StatusCode::INVALID_ARGUMENT;
+        error_msg = "Invalid upload id: " + upload_id;
+    } else if (scratch_quota_ && scratch_quota_->limit() > 0 &&
+               static_cast<uint64_t>(metadata->file_size()) > scratch_quota_->limit()) {
+        // A parte vira a entrada da requisição: mesma cota de disco
+        code = grpc::StatusCode::RESOURCE_EXHAUSTED;
+        error_msg = "Upload of " + std::to_string(metadata->file_size()) +
+                    " bytes exceeds the scratch quota of " +
+                    std::to_string(scratch_quota_->limit()) + " bytes";
+    } else if (!store.open(upload_id, static_cast<uint64_t>(metadata->file_size()),
+                           upload_id_, upload_offset_, error_msg)) {
+        code = grpc::StatusCode::ABORTED;
+    }
+
+    if (code != grpc::StatusCode::OK) {
+        logger_.log(LogLevel::WARNING_LEVEL, service_name_, upload_id, error_msg);
+        finish(grpc::Status(code, error_msg));
+        return false;
+    }
+
+    upload_open_ = true;
+    upload_size_ = static_cast<uint64_t>(metadata->file_size());
+
+    // Reserva depois de abrir: a parte sai das paradas e não conta duas vezes
+    if (!reserveBytes(upload_size_)) {
+        store.release(upload_id_);
+        upload_open_ = false;
+        return false;
+    }
+    resumed_from_ = upload_offset_;
+    logger_.log(LogLevel::INFO_LEVEL, service_name_, upload_id_,
+               resumed_from_ > 0
+                   ? "Resuming upload at " + std::to_string(resumed_from_) + " of " +
+                     std::to_string(upload_size_) + " bytes"
+                   : "Starting resumable upload of " + std::to_string(upload_size_) +
+                     " bytes");
+
+    // O cliente só envia dados depois de saber de onde continuar
+    status_chunk_->mutable_upload_status()->set_upload_id(upload_id_);
+    status_chunk_->mutable_upload_status()->set_committed_offset(
+        static_cast<int64_t>(upload_offset_));
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        status_write_pending_ = true;
+    }
+    StartWrite(status_chunk_, grpc::WriteOptions().set_no_compression());
+    return true;
+}
+
+bool FileTransferReactor::completeResumableUpload() {
+    UploadStore& store = UploadStore::getInstance();
+    if (upload_offset_ < upload_size_) {
+        store.release(upload_id_);
+        upload_open_ = false;
+        std::string error = "Upload incomplete (" + std::to_string(upload_offset_) +
+                            " of " + std::to_string(upload_size_) +
+                            " bytes); resume with upload id " + upload_id_;
+        logger_.log(LogLevel::WARNING_LEVEL, service_name_, upload_id_, error);
+        finish(grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, error));
+        return false;
+    }
+
+    std::string path;
+    std::string error_msg;
+    bool completed = store.complete(upload_id_, path, error_msg);
+    upload_open_ = false;
+    if (!completed || !input_.adoptFile(path, error_msg)) {
+        logger_.log(LogLevel::ERROR_LEVEL, service_name_, upload_id_, error_msg);
+        finish(grpc::Status(grpc::StatusCode::INTERNAL, error_msg));
+        return false;
+    }
+    return true;
+}
+
+bool FileTransferReactor::deferWhileStatusPending(std::function<void()> action) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!status_write_pending_) {
+        return false;
+    }
+    after_status_ = std::move(action);
+    return true;
+}
+
+bool FileTransferReactor::resolveParameters(const file_processor::RequestHeader& header) {
+    parameters_resolved_ = true;
+
+    std::string error_msg;
+    if (!resolver_(header, cache_parameters_, buffered_handler_, error_msg)) {
+        logger_.log(LogLevel::WARNING_LEVEL, service_name_, "N/A",
+                   "Invalid request header: " + error_msg);
+        finish(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, error_msg));
+        return false;
+    }
+
+    const file_processor::FileMetadata* metadata = headerMetadata(header);
+    bool stream = streaming_executor_ != nullptr && metadata != nullptr &&
+                  metadata->file_size() > 0 &&
+                  static_cast<uint64_t>(metadata->file_size()) >= streaming_min_bytes_;
+    if (!stream && !header.upload_id().empty()) {
+        return openResumableUpload(header.upload_id(), metadata);
+    }
+    if (metadata != nullptr && metadata->file_size() > 0 &&
+        !reserveBytes(static_cast<uint64_t>(metadata->file_size()))) {
+        return false;
+    }
+
+    // Upload grande: o handler em pipeline assume o stream (e o cabeçalho,
+    // que ainda está em read_chunk_); o buffered não lê mais nada
+    if (stream) {
+        logger_.log(LogLevel::INFO_LEVEL, service_name_,
+                   metadata->file_name().empty() ? "N/A" : metadata->file_name(),
+                   "Request header received (" + std::to_string(metadata->file_size()) +
+                   " bytes expected), processing in pipeline");
+        switchToStreaming();
+        return false;
+    }
+
+    // Tamanho anunciado evita realocações durante o upload (o buffer só
+    // reserva até o limite de spill)
+    if (metadata != nullptr) {
+        if (metadata->file_size() > 0) {
+            input_.reserve(static_cast<size_t>(metadata->file_size()));
+        }
+        logger_.log(LogLevel::INFO_LEVEL, service_name_,
+                   metadata->file_name().empty() ? "N/A" : metadata->file_name(),
+                   "Request header received (" +
+                   std::to_string(metadata->file_size()) + " bytes expected, "
+                   "parameters: " + cache_parameters_ + ")");
+    }
+    return true;
+}
+
+void FileTransferReactor::processUpload() {
+    ResultCache& cache = ResultCache::getInstance();
+
+    // Acerto na memória é servido direto do callback, sem passar pela fila
+    if (upload_id_.empty() && cache.enabled() && !context_->IsCancelled()) {
+        cache_key_ = ResultCache::makeKey(service_name_, cache_parameters_,
+                                          hasher_.digest(), input_.size());
+        if (lookupCache(false)) {
+            return;
+        }
+    }
+
+    submitJob([this]() {
+        // Upload retomado: parte do conteúdo veio em outro stream, então o
+        // hash é calculado aqui sobre o arquivo completo
+        ResultCache& cache = ResultCache::getInstance();
+        if (!upload_id_.empty() && cache.enabled()) {
+            ChunkBufferPool::Buffer buffer =
+                ChunkBufferPool::getInstance().acquire(kReadBufferSize);
+            size_t offset = 0;
+            size_t length = 0;
+            while ((length = input_.readAt(offset, buffer.data(), buffer.size())) > 0) {
+                hasher_.update(buffer.data(), length);
+                offset += length;
+            }
+            cache_key_ = ResultCache::makeKey(service_name_, cache_parameters_,
+                                              hasher_.digest(), input_.size());
+            if (lookupCache(true)) {
+                return;
+            }
+        } else if (!cache_key_.empty() && cache.hasDiskTier() && lookupCache(true)) {
+            // Camada em disco consultada já no executor (I/O bloqueante)
+            return;
+        }
+
+        auto started = std::chrono::steady_clock::now();
+        grpc::Status status = runHandler([this]() {
+            return buffered_handler_(input_, output_);
+        });
+        metrics_.observe(RequestPhase::PROCESS, started);
+        bool abandoned = recordIfAbandoned(started);
+        if (!status.ok()) {
+            finish(abandoned ? abandonedStatus("during processing") : status);
+            return;
+        }
+        // O resultado ainda serve a uma nova tentativa pelo cache
+        storeInCache();
+        if (abandoned) {
+            finish(abandonedStatus("during processing"));
+            return;
+        }
+        sendNextChunk();
+    });
+}
+
+bool FileTransferReactor::lookupCache(bool include_disk) {
+    std::string cached;
+    if (!ResultCache::getInstance().lookup(cache_key_, cached, include_disk)) {
+        return false;
+    }
+    serveCached(std::move(cached));
+    return true;
+}
+
+void FileTransferReactor::serveCached(std::string content) {
+    std::string error_msg;
+    if (!output_.assign(std::move(content), error_msg)) {
+        logger_.log(LogLevel::ERROR_LEVEL, service_name_, output_.description(), error_msg);
+        finish(grpc::Status(grpc::StatusCode::INTERNAL, error_msg));
+        return;
+    }
+
+    metrics_.cache_hits.fetch_add(1, std::memory_order_relaxed);
+    ResultCache::Stats stats = ResultCache::getInstance().stats();
+    logger_.log(LogLevel::INFO_LEVEL, service_name_, cache_key_,
+               "Cache hit, skipping processing (hits: " +
+               std::to_string(stats.memory_hits + stats.disk_hits) +
+               ", misses: " + std::to_string(stats.misses) + ")");
+    sendNextChunk();
+}
+
+void FileTransferReactor::storeInCache() {
+    ResultCache::getInstance().storeOutput(cache_key_, output_);
+}
+
+void FileTransferReactor::OnWriteDone(bool ok) {
+    if (streaming_) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        write_ok_ = ok;
+        write_pending_ = false;
+        cv_.notify_all();
+        return;
+    }
+
+    // UploadStatus enviado: liberar a escrita (ou o Finish) que aguardava.
+    // Se falhou, o cliente caiu e a leitura também termina com erro
+    bool status_sent = false;
+    std::function<void()> after_status;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (status_write_pending_) {
+            status_write_pending_ = false;
+            status_sent = true;
+            after_status = std::move(after_status_);
+        }
+    }
+    if (status_sent) {
+        if (after_status) {
+            after_status();
+        }
+        return;
+    }
+
+    if (!ok) {
+        std::string error = "Failed to send chunk";
+        logger_.log(LogLevel::ERROR_LEVEL, service_name_, output_.description(), error);
+        finish(grpc::Status(grpc::StatusCode::INTERNAL, error));
+        return;
+    }
+    chunk_sizer_.record(chunk_length_, std::chrono::steady_clock::now() - chunk_start_time_);
+    sendNextChunk();
+}
+
+void FileTransferReactor::sendNextChunk() {
+    if (deferWhileStatusPending([this]() { sendNextChunk(); })) {
+        return;
+    }
+    if (!send_started_) {
+        send_started_ = true;
+        send_start_time_ = std::chrono::steady_clock::now();
+        const ServerConfig& config = ServerConfig::getInstance();
+        chunk_sizer_ = AdaptiveChunkSizer(config.chunk_min_bytes, config.chunk_max_bytes,
+                                          output_.size());
+    }
+
+    if (bytes_sent_ >= output_.size()) {
+        logger_.log(LogLevel::INFO_LEVEL, "FileTransfer", output_.description(),
+                   "Sent " + std::to_string(bytes_sent_) + " bytes");
+        finish(grpc::Status::OK);
+        return;
+    }
+
+    size_t chunk_size = chunk_sizer_.next();
+    size_t length = std::min(chunk_size, output_.size() - bytes_sent_);
+
+    // Conteúdo em memória é copiado para o buffer da mensagem (assign não
+    // aloca com capacidade suficiente; set_content(ptr, n) criaria uma string
+    // temporária por chunk); em disco, é lido direto para ele
+    std::string* content = write_chunk_->mutable_content();
+    if (output_.inMemory()) {
+        content->assign(output_.memory().data() + bytes_sent_, length);
+    } else {
+        content->resize(length);
+        length = output_.readAt(bytes_sent_, &(*content)[0], length);
+        content->resize(length);
+        if (length == 0) {
+            std::string error = "Failed to read output for sending";
+            logger_.log(LogLevel::ERROR_LEVEL, service_name_, output_.description(), error);
+            finish(grpc::Status(grpc::StatusCode::INTERNAL, error));
+            return;
+        }
+    }
+
+    bytes_sent_ += length;
+    chunk_length_ = length;
+    chunk_start_time_ = std::chrono::steady_clock::now();
+
+    // Ainda há chunks: o transporte pode agrupar esta mensagem com a
+    // próxima (e concluir a escrita com até FP_HTTP2_WRITE_BUFFER_BYTES
+    // pendentes), mantendo mais de um chunk em trânsito. O primeiro chunk
+    // vai sem hint: ele leva os metadados iniciais, que o transporte só
+    // enviaria com o buffer cheio, e a escrita não seria concluída
+    grpc::WriteOptions options = writeOptions(*write_chunk_);
+    if (bytes_sent_ > length && bytes_sent_ < output_.size()) {
+        options.set_buffer_hint();
+    }
+    StartWrite(write_chunk_, options);
+}
+
+grpc::WriteOptions FileTransferReactor::writeOptions(const file_processor::FileChunk& chunk) {
+    grpc::WriteOptions options;
+    if (!compression_.compressChunk(chunk.content().data(), chunk.content().size())) {
+        options.set_no_compression();
+    }
+    return options;
+}
+
+void FileTransferReactor::finish(const grpc::Status& status) {
+    admission_.release();
+    // No modo streaming os bytes já foram contados em Write()
+    metrics_.bytes_out.fetch_add(bytes_sent_, std::memory_order_relaxed);
+    if (!status.ok()) {
+        metrics_.errors.fetch_add(1, std::memory_order_relaxed);
+    } else if (send_started_) {
+        metrics_.observe(RequestPhase::SEND, send_start_time_);
+    }
+
+    if (compression_.compressedBytes() > 0) {
+        metrics_.compressed_bytes.fetch_add(compression_.compressedBytes(),
+                                            std::memory_order_relaxed);
+        metrics_.compressed_wire_bytes.fetch_add(compression_.estimatedBytes(),
+                                                 std::memory_order_relaxed);
+        logger_.log(LogLevel::INFO_LEVEL, service_name_, "N/A",
+                   "Response compression: " + compression_.summary());
+    }
+    if (ServerConfig::getInstance().compression_enabled) {
+        context_->AddTrailingMetadata("fp-compression", compression_.summary());
+    }
+
+    if (status.ok()) {
+        logger_.log(LogLevel::SUCCESS_LEVEL, service_name_, "N/A",
+                   "Request completed successfully");
+    }
+    if (deferWhileStatusPending([this, status]() { Finish(status); })) {
+        return;
+    }
+    Finish(status);
+}
+
+void FileTransferReactor::OnCancel() {
+    // Jobs na fila são descartados; em execução, a ferramenta é interrompida
+    job_->cancel();
+}
+
+void FileTransferReactor::OnDone() {
+    // Stream encerrado no meio do upload: a parte fica para a retomada
+    if (upload_open_) {
+        UploadStore::getInstance().release(upload_id_);
+    }
+    delete this;
+}
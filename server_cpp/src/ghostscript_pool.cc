@@ -0,0 +1,389 @@
+#include "ghostscript_pool.h"
+#include "scratch_space.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <utility>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const char kDoneMarker[] = "%%FP_DONE ";
+
+// O cabeçalho pode vir depois de lixo inicial, como o gs aceita
+const size_t kPdfHeaderWindow = 1024;
+
+bool hasPdfHeader(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    char buffer[kPdfHeaderWindow];
+    file.read(buffer, sizeof(buffer));
+    std::string head(buffer, static_cast<size_t>(file.gcount()));
+    return head.find("%PDF-") != std::string::npos;
+}
+
+// Marcador imprevisível: mensagens do gs sobre o PDF não podem forjá-lo
+std::string newNonce() {
+    std::random_device random;
+    char nonce[17];
+    std::snprintf(nonce, sizeof(nonce), "%08x%08x",
+                  static_cast<unsigned>(random()), static_cast<unsigned>(random()));
+    return nonce;
+}
+}
+
+GhostscriptPool::GhostscriptPool(size_t size, size_t max_jobs_per_worker,
+                                 const std::vector<std::string>& pdfwrite_options)
+    : size_(size == 0 ? 1 : size),
+      max_jobs_per_worker_(max_jobs_per_worker == 0 ? 1 : max_jobs_per_worker),
+      live_(0),
+      stopping_(false),
+      jobs_(0),
+      failures_(0),
+      recycled_(0),
+      consecutive_failures_(0) {
+    // Interpretador lendo comandos do stdin; o pdfwrite começa apontando
+    // para /dev/null e cada job define o próprio OutputFile. As permissões
+    // de arquivo (SAFER) são adicionadas por worker em startWorker.
+    command_ = {"gs", "-q", "-dNOPAUSE", "-dNOPROMPT", "-sDEVICE=pdfwrite"};
+    command_.insert(command_.end(), pdfwrite_options.begin(), pdfwrite_options.end());
+    command_.insert(command_.end(), {"--permit-file-write=/dev/null", "-sOutputFile=/dev/null"});
+}
+
+GhostscriptPool::~GhostscriptPool() {
+    std::vector<std::unique_ptr<Worker>> idle;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        idle.swap(idle_);
+    }
+    for (auto& worker : idle) {
+        stopWorker(*worker, false);
+    }
+}
+
+bool GhostscriptPool::warmUp(std::string& error_message) {
+    std::vector<std::unique_ptr<Worker>> started;
+    for (size_t i = 0; i < size_; ++i) {
+        std::unique_ptr<Worker> worker = startWorker(error_message);
+        if (!worker) {
+            for (auto& w : started) {
+                stopWorker(*w, true);
+            }
+            return false;
+        }
+        started.push_back(std::move(worker));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    live_ += started.size();
+    for (auto& worker : started) {
+        idle_.push_back(std::move(worker));
+    }
+    return true;
+}
+
+std::unique_ptr<GhostscriptPool::Worker> GhostscriptPool::startWorker(
+    std::string& error_message) {
+#ifdef _WIN32
+    error_message = "Ghostscript pool is not supported on this platform";
+    return nullptr;
+#else
+    // Diretório privado do worker: o único caminho liberado no gs. Cada job
+    // expõe nele só a sua entrada e a sua saída (links simbólicos), então um
+    // job não alcança arquivos de outras requisições.
+    std::unique_ptr<Worker> worker(new Worker());
+    worker->directory = ScratchSpace::getInstance().uniquePath("gs_worker", "");
+    if (mkdir(worker->directory.c_str(), 0700) != 0) {
+        error_message = "Failed to create Ghostscript worker directory: " +
+                        std::string(std::strerror(errno));
+        return nullptr;
+    }
+
+    std::vector<std::string> command = command_;
+    command.push_back("--permit-file-all=" + worker->directory + "/");
+    command.push_back("-");
+    worker->process.reset(new PipedProcess());
+    if (!worker->process->start(command, error_message)) {
+        rmdir(worker->directory.c_str());
+        return nullptr;
+    }
+
+    // Handshake: confirma que o interpretador está pronto para receber jobs
+    int exit_code = -1;
+    std::string output;
+    std::string nonce = newNonce();
+    if (!execute(*worker, "(" + std::string(kDoneMarker) + nonce + " 0\\n) print flush\n",
+                 nonce, exit_code, output) || exit_code != 0) {
+        stopWorker(*worker, true);
+        error_message = "Ghostscript worker did not start: " +
+                        (output.empty() ? worker->process->errorOutput() : output);
+        return nullptr;
+    }
+    return worker;
+#endif
+}
+
+void GhostscriptPool::stopWorker(Worker& worker, bool force) {
+    if (force) {
+        worker.process->kill();
+    } else {
+        // EOF no stdin encerra o interpretador normalmente
+        worker.process->writeInput("quit\n", 5);
+        worker.process->closeInput();
+    }
+    worker.process->wait();
+    hideJobFiles(worker);
+#ifndef _WIN32
+    rmdir(worker.directory.c_str());
+#endif
+}
+
+std::string GhostscriptPool::jobPath(const Worker& worker, const char* name) {
+    return worker.directory + "/" + name;
+}
+
+bool GhostscriptPool::exposeJobFiles(Worker& worker, const std::string& input_path,
+                                     const std::string& output_path,
+                                     std::string& error_message) {
+#ifdef _WIN32
+    error_message = "Ghostscript pool is not supported on this platform";
+    return false;
+#else
+    // Sobras de um job interrompido
+    hideJobFiles(worker);
+    if (symlink(input_path.c_str(), jobPath(worker, "in.pdf").c_str()) != 0 ||
+        (!output_path.empty() &&
+         symlink(output_path.c_str(), jobPath(worker, "out.pdf").c_str()) != 0)) {
+        error_message = "Failed to expose job files to Ghostscript worker: " +
+                        std::string(std::strerror(errno));
+        hideJobFiles(worker);
+        return false;
+    }
+    return true;
+#endif
+}
+
+void GhostscriptPool::hideJobFiles(Worker& worker) {
+#ifndef _WIN32
+    unlink(jobPath(worker, "in.pdf").c_str());
+    unlink(jobPath(worker, "out.pdf").c_str());
+#endif
+}
+
+std::unique_ptr<GhostscriptPool::Worker> GhostscriptPool::acquire(
+    bool wait, std::string& error_message) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto available = [this] { return stopping_ || !idle_.empty() || live_ < size_; };
+        if (!wait && !available()) {
+            error_message = "No idle Ghostscript worker";
+            return nullptr;
+        }
+        available_cv_.wait(lock, available);
+        if (stopping_) {
+            error_message = "Ghostscript pool is shutting down";
+            return nullptr;
+        }
+        if (!idle_.empty()) {
+            std::unique_ptr<Worker> worker = std::move(idle_.back());
+            idle_.pop_back();
+            return worker;
+        }
+        ++live_;
+    }
+
+    // Substituto de um worker reciclado
+    std::unique_ptr<Worker> worker = startWorker(error_message);
+    if (!worker) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --live_;
+        available_cv_.notify_one();
+    }
+    return worker;
+}
+
+void GhostscriptPool::release(std::unique_ptr<Worker> worker, bool healthy) {
+    if (!healthy || worker->jobs >= max_jobs_per_worker_) {
+        stopWorker(*worker, !healthy);
+        recycled_.fetch_add(1);
+        std::lock_guard<std::mutex> lock(mutex_);
+        --live_;
+        available_cv_.notify_one();
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stopping_) {
+        lock.unlock();
+        stopWorker(*worker, false);
+        return;
+    }
+    idle_.push_back(std::move(worker));
+    available_cv_.notify_one();
+}
+
+GhostscriptPool::Outcome GhostscriptPool::compress(const std::string& input_path,
+                                                   const std::string& output_path,
+                                                   std::string& error_message) {
+    // Trocar o OutputFile para /dev/null (feito por runJob) fecha o
+    // pdfwrite e finaliza a saída
+    int result = -1;
+    bool completed = false;
+    bool interrupted = false;
+    if (!runJob(input_path, output_path,
+                "<< /OutputFile FPOutput >> setpagedevice FPInput (r) file runpdf 0",
+                true, result, completed, interrupted, error_message)) {
+        return Outcome::UNAVAILABLE;
+    }
+    jobs_.fetch_add(1);
+
+    if (interrupted) {
+        // Chamada cancelada ou expirada: o worker é reciclado, mas o gs não falhou
+        error_message = "Ghostscript job interrupted: request cancelled or deadline exceeded";
+        return Outcome::INTERRUPTED;
+    }
+    if (result != 0) {
+        failures_.fetch_add(1);
+        consecutive_failures_.fetch_add(1);
+        return completed ? Outcome::REJECTED : Outcome::UNAVAILABLE;
+    }
+    consecutive_failures_.store(0);
+    return Outcome::OK;
+}
+
+int GhostscriptPool::countPages(const std::string& input_path) {
+    // Sem worker ocioso, não espera: o chamador tem outras formas de contar
+    int result = -1;
+    bool completed = false;
+    bool interrupted = false;
+    std::string error_message;
+    if (!runJob(input_path, "",
+                "FPInput (r) file runpdfbegin pdfpagecount runpdfend",
+                false, result, completed, interrupted, error_message)) {
+        return 0;
+    }
+    return result > 0 ? result : 0;
+}
+
+bool GhostscriptPool::runJob(const std::string& input_path, const std::string& output_path,
+                             const std::string& body, bool wait, int& result,
+                             bool& completed, bool& interrupted,
+                             std::string& error_message) {
+    // Só PDF entra no interpretador compartilhado: PostScript enviado pelo
+    // cliente poderia redefinir operadores para os jobs seguintes
+    if (!hasPdfHeader(input_path)) {
+        error_message = "Input is not a PDF (missing %PDF- header)";
+        return false;
+    }
+
+    std::unique_ptr<Worker> worker = acquire(wait, error_message);
+    if (!worker) {
+        if (wait) {
+            failures_.fetch_add(1);
+        }
+        return false;
+    }
+
+    if (!exposeJobFiles(*worker, input_path, output_path, error_message)) {
+        failures_.fetch_add(1);
+        release(std::move(worker), false);
+        return false;
+    }
+
+    // O job roda entre save/restore, então o que ele definir na VM local
+    // não chega ao próximo job. Erros são capturados por "stopped" e viram
+    // -1. Antes do restore, o que o job deixou nas pilhas é descartado e só
+    // o resultado (inteiro no topo da pilha) sobra, impresso após o marcador.
+    std::string nonce = newNonce();
+    std::string script =
+        "clear save "
+        "/FPInput (" + escapePostScript(jobPath(*worker, "in.pdf")) + ") def "
+        "/FPOutput (" + escapePostScript(jobPath(*worker, "out.pdf")) + ") def "
+        "{ " + body + " } stopped { -1 } if "
+        "<< /OutputFile (/dev/null) >> setpagedevice "
+        "count 1 roll count 2 sub { pop } repeat cleardictstack restore "
+        "(" + std::string(kDoneMarker) + nonce + " ) print = flush\n";
+
+    std::string output;
+    result = -1;
+    completed = execute(*worker, script, nonce, result, output);
+    hideJobFiles(*worker);
+    worker->jobs++;
+    interrupted = worker->process->interrupted();
+    if (!completed) {
+        result = -1;
+        error_message = "Ghostscript worker exited unexpectedly: " +
+                        worker->process->errorOutput();
+    } else if (result < 0) {
+        error_message = "Ghostscript worker reported an error: " + output;
+    }
+
+    release(std::move(worker), completed && result >= 0);
+    return true;
+}
+
+bool GhostscriptPool::execute(Worker& worker, const std::string& script,
+                              const std::string& nonce,
+                              int& exit_code, std::string& output) {
+    if (!worker.process->writeInput(script.data(), script.size())) {
+        return false;
+    }
+
+    // Ler até a linha do marcador deste job; o que vier antes são mensagens do gs
+    const std::string marker_text = kDoneMarker + nonce + " ";
+    char buffer[4096];
+    while (true) {
+        size_t marker = worker.pending_output.find(marker_text);
+        if (marker != std::string::npos) {
+            size_t line_end = worker.pending_output.find('\n', marker);
+            if (line_end != std::string::npos) {
+                output = worker.pending_output.substr(0, marker);
+                while (!output.empty() && (output.back() == '\n' || output.back() == '\r')) {
+                    output.pop_back();
+                }
+                exit_code = std::atoi(worker.pending_output.c_str() + marker +
+                                      marker_text.size());
+                worker.pending_output.erase(0, line_end + 1);
+                return true;
+            }
+        }
+        long length = worker.process->readOutput(buffer, sizeof(buffer));
+        if (length <= 0) {
+            output = worker.pending_output;
+            return false;
+        }
+        worker.pending_output.append(buffer, static_cast<size_t>(length));
+    }
+}
+
+std::string GhostscriptPool::escapePostScript(const std::string& value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '(' || c == ')' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+GhostscriptPool::Stats GhostscriptPool::stats() const {
+    Stats stats;
+    stats.jobs = jobs_.load();
+    stats.failures = failures_.load();
+    stats.recycled = recycled_.load();
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.live_workers = live_;
+    stats.idle_workers = idle_.size();
+    return stats;
+}
@@ -0,0 +1,525 @@
+#include "image_engine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <csetjmp>
+#include <exception>
+
+#ifdef FP_HAVE_LIBJPEG
+#include <jpeglib.h>
+#endif
+
+#ifdef FP_HAVE_LIBPNG
+#include <png.h>
+#endif
+
+namespace {
+
+#if defined(FP_HAVE_LIBJPEG) || defined(FP_HAVE_LIBPNG)
+// Limite checado logo após ler o cabeçalho, antes de alocar os pixels
+bool exceedsPixelLimit(uint64_t width, uint64_t height, size_t max_pixels,
+                       std::string& error_message) {
+    if (max_pixels == 0 || width * height <= max_pixels) {
+        return false;
+    }
+    error_message = "Image of " + std::to_string(width) + "x" + std::to_string(height) +
+                    " exceeds the limit of " + std::to_string(max_pixels) + " pixels";
+    return true;
+}
+#endif
+
+#ifdef FP_HAVE_LIBJPEG
+// Tratamento de erro da libjpeg: salta de volta em vez de chamar exit()
+struct JpegErrorManager {
+    jpeg_error_mgr base;
+    jmp_buf jump_buffer;
+    char message[JMSG_LENGTH_MAX];
+};
+
+void jpegErrorExit(j_common_ptr cinfo) {
+    JpegErrorManager* manager = reinterpret_cast<JpegErrorManager*>(cinfo->err);
+    (*cinfo->err->format_message)(cinfo, manager->message);
+    longjmp(manager->jump_buffer, 1);
+}
+
+void jpegSilentOutput(j_common_ptr) {}
+
+// Libera o decompressor em qualquer saída (erro da libjpeg, exceção ou retorno)
+struct JpegDecompressGuard {
+    jpeg_decompress_struct* cinfo;
+    ~JpegDecompressGuard() { jpeg_destroy_decompress(cinfo); }
+};
+
+// Maior redução da IDCT que mantém a imagem >= min_width x min_height
+unsigned int jpegScaleDenominator(unsigned int width, unsigned int height,
+                                  int min_width, int min_height) {
+    if (min_width <= 0 || min_height <= 0) {
+        return 1;
+    }
+    for (unsigned int denominator : {8u, 4u, 2u}) {
+        unsigned int scaled_width = (width + denominator - 1) / denominator;
+        unsigned int scaled_height = (height + denominator - 1) / denominator;
+        if (scaled_width >= static_cast<unsigned int>(min_width) &&
+            scaled_height >= static_cast<unsigned int>(min_height)) {
+            return denominator;
+        }
+    }
+    return 1;
+}
+
+bool readJpegDimensions(const std::string& data, int& width, int& height) {
+    jpeg_decompress_struct cinfo;
+    JpegErrorManager error_manager;
+
+    cinfo.err = jpeg_std_error(&error_manager.base);
+    error_manager.base.error_exit = jpegErrorExit;
+    error_manager.base.output_message = jpegSilentOutput;
+
+    if (setjmp(error_manager.jump_buffer)) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo,
+                 reinterpret_cast<const unsigned char*>(data.data()),
+                 static_cast<unsigned long>(data.size()));
+    jpeg_read_header(&cinfo, TRUE);
+    width = static_cast<int>(cinfo.image_width);
+    height = static_cast<int>(cinfo.image_height);
+    jpeg_destroy_decompress(&cinfo);
+    return true;
+}
+
+bool decodeJpeg(const std::string& data, Image& image,
+                std::string& error_message, int min_width, int min_height,
+                size_t max_pixels) {
+    jpeg_decompress_struct cinfo;
+    JpegErrorManager error_manager;
+    std::vector<uint8_t>& pixels = image.pixels;
+
+    // Zerado para que o destroy seja seguro mesmo antes do create
+    std::memset(&cinfo, 0, sizeof(cinfo));
+    cinfo.err = jpeg_std_error(&error_manager.base);
+    error_manager.base.error_exit = jpegErrorExit;
+    error_manager.base.output_message = jpegSilentOutput;
+    JpegDecompressGuard guard{&cinfo};
+
+    if (setjmp(error_manager.jump_buffer)) {
+        error_message = std::string("JPEG decode failed: ") + error_manager.message;
+        return false;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo,
+                 reinterpret_cast<const unsigned char*>(data.data()),
+                 static_cast<unsigned long>(data.size()));
+    jpeg_read_header(&cinfo, TRUE);
+
+    if (exceedsPixelLimit(cinfo.image_width, cinfo.image_height, max_pixels, error_message)) {
+        return false;
+    }
+
+    // CMYK/YCCK exigem gerenciamento de cor: deixar para o ImageMagick
+    if (cinfo.jpeg_color_space == JCS_CMYK || cinfo.jpeg_color_space == JCS_YCCK) {
+        error_message = "JPEG color space not supported by image engine";
+        return false;
+    }
+
+    cinfo.out_color_space = JCS_RGB;
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = jpegScaleDenominator(cinfo.image_width, cinfo.image_height,
+                                             min_width, min_height);
+    jpeg_start_decompress(&cinfo);
+
+    image.width = static_cast<int>(cinfo.output_width);
+    image.height = static_cast<int>(cinfo.output_height);
+    image.channels = 3;
+    pixels.resize(static_cast<size_t>(image.width) * image.height * 3);
+
+    const size_t stride = static_cast<size_t>(image.width) * 3;
+    while (cinfo.output_scanline < cinfo.output_height) {
+        JSAMPROW row = pixels.data() + cinfo.output_scanline * stride;
+        jpeg_read_scanlines(&cinfo, &row, 1);
+    }
+
+    jpeg_finish_decompress(&cinfo);
+    return true;
+}
+
+bool encodeJpeg(const Image& image, std::string& output,
+                std::string& error_message, int quality) {
+    jpeg_compress_struct cinfo;
+    JpegErrorManager error_manager;
+    unsigned char* buffer = nullptr;
+    unsigned long buffer_size = 0;
+    std::vector<uint8_t> row_buffer;
+
+    cinfo.err = jpeg_std_error(&error_manager.base);
+    error_manager.base.error_exit = jpegErrorExit;
+    error_manager.base.output_message = jpegSilentOutput;
+
+    if (setjmp(error_manager.jump_buffer)) {
+        jpeg_destroy_compress(&cinfo);
+        free(buffer);
+        error_message = std::string("JPEG encode failed: ") + error_manager.message;
+        return false;
+    }
+
+    jpeg_create_compress(&cinfo);
+    jpeg_mem_dest(&cinfo, &buffer, &buffer_size);
+
+    cinfo.image_width = static_cast<JDIMENSION>(image.width);
+    cinfo.image_height = static_cast<JDIMENSION>(image.height);
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, quality, TRUE);
+    jpeg_start_compress(&cinfo, TRUE);
+
+    // JPEG não tem canal alfa: descartar quando a origem for RGBA
+    row_buffer.resize(static_cast<size_t>(image.width) * 3);
+    const size_t stride = static_cast<size_t>(image.width) * image.channels;
+
+    while (cinfo.next_scanline < cinfo.image_height) {
+        const uint8_t* source = image.pixels.data() + cinfo.next_scanline * stride;
+        JSAMPROW row;
+
+        if (image.channels == 3) {
+            row = const_cast<JSAMPROW>(source);
+        } else {
+            for (int x = 0; x < image.width; ++x) {
+                row_buffer[x * 3 + 0] = source[x * image.channels + 0];
+                row_buffer[x * 3 + 1] = source[x * image.channels + 1];
+                row_buffer[x * 3 + 2] = source[x * image.channels + 2];
+            }
+            row = row_buffer.data();
+        }
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+
+    output.assign(reinterpret_cast<const char*>(buffer), buffer_size);
+    free(buffer);
+    return true;
+}
+#endif // FP_HAVE_LIBJPEG
+
+#ifdef FP_HAVE_LIBPNG
+bool decodePng(const std::string& data, Image& image,
+               std::string& error_message, size_t max_pixels) {
+    png_image png;
+    std::memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+
+    if (!png_image_begin_read_from_memory(&png, data.data(), data.size())) {
+        error_message = std::string("PNG decode failed: ") + png.message;
+        return false;
+    }
+
+    if (exceedsPixelLimit(png.width, png.height, max_pixels, error_message)) {
+        png_image_free(&png);
+        return false;
+    }
+
+    const bool has_alpha = (png.format & PNG_FORMAT_FLAG_ALPHA) != 0;
+    png.format = has_alpha ? PNG_FORMAT_RGBA : PNG_FORMAT_RGB;
+
+    image.width = static_cast<int>(png.width);
+    image.height = static_cast<int>(png.height);
+    image.channels = has_alpha ? 4 : 3;
+    try {
+        image.pixels.resize(PNG_IMAGE_SIZE(png));
+    } catch (...) {
+        png_image_free(&png);
+        throw;
+    }
+
+    if (!png_image_finish_read(&png, nullptr, image.pixels.data(), 0, nullptr)) {
+        error_message = std::string("PNG decode failed: ") + png.message;
+        png_image_free(&png);
+        return false;
+    }
+    return true;
+}
+
+bool encodePng(const Image& image, std::string& output,
+               std::string& error_message) {
+    png_image png;
+    std::memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+    png.width = static_cast<png_uint_32>(image.width);
+    png.height = static_cast<png_uint_32>(image.height);
+    png.format = image.channels == 4 ? PNG_FORMAT_RGBA : PNG_FORMAT_RGB;
+
+    // Primeira chamada calcula o tamanho necessário
+    png_alloc_size_t size = 0;
+    if (!png_image_write_get_memory_size(png, size, 0, image.pixels.data(), 0,
+                                         nullptr)) {
+        error_message = std::string("PNG encode failed: ") + png.message;
+        return false;
+    }
+
+    output.resize(size);
+    if (!png_image_write_to_memory(&png, &output[0], &size, 0,
+                                   image.pixels.data(), 0, nullptr)) {
+        error_message = std::string("PNG encode failed: ") + png.message;
+        return false;
+    }
+    output.resize(size);
+    return true;
+}
+#endif // FP_HAVE_LIBPNG
+
+} // namespace
+
+bool ImageEngine::isAvailable() {
+#if defined(FP_HAVE_LIBJPEG) || defined(FP_HAVE_LIBPNG)
+    return true;
+#else
+    return false;
+#endif
+}
+
+ImageFormat ImageEngine::detectFormat(const std::string& data) {
+    if (data.size() >= 3 &&
+        static_cast<unsigned char>(data[0]) == 0xFF &&
+        static_cast<unsigned char>(data[1]) == 0xD8 &&
+        static_cast<unsigned char>(data[2]) == 0xFF) {
+        return ImageFormat::JPEG;
+    }
+
+    static const char png_signature[] = "\x89PNG\r\n\x1a\n";
+    if (data.size() >= 8 && data.compare(0, 8, png_signature, 8) == 0) {
+        return ImageFormat::PNG;
+    }
+
+    return ImageFormat::UNKNOWN;
+}
+
+ImageFormat ImageEngine::formatFromName(const std::string& name) {
+    std::string lower_name = name;
+    if (!lower_name.empty() && lower_name[0] == '.') {
+        lower_name.erase(0, 1);
+    }
+    std::transform(lower_name.begin(), lower_name.end(),
+                  lower_name.begin(), ::tolower);
+
+    if (lower_name == "jpg" || lower_name == "jpeg") {
+        return ImageFormat::JPEG;
+    }
+    if (lower_name == "png") {
+        return ImageFormat::PNG;
+    }
+    if (lower_name == "gif") {
+        return ImageFormat::GIF;
+    }
+    if (lower_name == "bmp") {
+        return ImageFormat::BMP;
+    }
+    if (lower_name == "tif" || lower_name == "tiff") {
+        return ImageFormat::TIFF;
+    }
+    if (lower_name == "webp") {
+        return ImageFormat::WEBP;
+    }
+    return ImageFormat::UNKNOWN;
+}
+
+std::string ImageEngine::extensionFor(ImageFormat format) {
+    switch (format) {
+        case ImageFormat::JPEG: return ".jpg";
+        case ImageFormat::PNG: return ".png";
+        case ImageFormat::GIF: return ".gif";
+        case ImageFormat::BMP: return ".bmp";
+        case ImageFormat::TIFF: return ".tiff";
+        case ImageFormat::WEBP: return ".webp";
+        default: return "";
+    }
+}
+
+std::string ImageEngine::nameFor(ImageFormat format) {
+    switch (format) {
+        case ImageFormat::JPEG: return "jpeg";
+        case ImageFormat::PNG: return "png";
+        case ImageFormat::GIF: return "gif";
+        case ImageFormat::BMP: return "bmp";
+        case ImageFormat::TIFF: return "tiff";
+        case ImageFormat::WEBP: return "webp";
+        default: return "";
+    }
+}
+
+bool ImageEngine::canDecode(ImageFormat format) {
+    switch (format) {
+#ifdef FP_HAVE_LIBJPEG
+        case ImageFormat::JPEG: return true;
+#endif
+#ifdef FP_HAVE_LIBPNG
+        case ImageFormat::PNG: return true;
+#endif
+        default: return false;
+    }
+}
+
+bool ImageEngine::canEncode(ImageFormat format) {
+    return canDecode(format);
+}
+
+bool ImageEngine::isSupported(const std::string& input,
+                              ImageFormat output_format) {
+    return canDecode(detectFormat(input)) && canEncode(output_format);
+}
+
+bool ImageEngine::readDimensions(const std::string& data, int& width, int& height) {
+    switch (detectFormat(data)) {
+#ifdef FP_HAVE_LIBJPEG
+        case ImageFormat::JPEG:
+            return readJpegDimensions(data, width, height);
+#endif
+        case ImageFormat::PNG: {
+            // Assinatura (8) + tamanho e tipo do IHDR (8) + largura e altura
+            if (data.size() < 24) {
+                return false;
+            }
+            auto readUint32 = [&data](size_t offset) {
+                return (static_cast<uint32_t>(static_cast<uint8_t>(data[offset])) << 24) |
+                       (static_cast<uint32_t>(static_cast<uint8_t>(data[offset + 1])) << 16) |
+                       (static_cast<uint32_t>(static_cast<uint8_t>(data[offset + 2])) << 8) |
+                       static_cast<uint32_t>(static_cast<uint8_t>(data[offset + 3]));
+            };
+            uint32_t png_width = readUint32(16);
+            uint32_t png_height = readUint32(20);
+            if (png_width == 0 || png_height == 0 ||
+                png_width > 0x7FFFFFFF || png_height > 0x7FFFFFFF) {
+                return false;
+            }
+            width = static_cast<int>(png_width);
+            height = static_cast<int>(png_height);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+bool ImageEngine::decode(const std::string& data, Image& image,
+                         std::string& error_message,
+                         int min_width, int min_height, size_t max_pixels) {
+    try {
+        switch (detectFormat(data)) {
+#ifdef FP_HAVE_LIBJPEG
+            case ImageFormat::JPEG:
+                return decodeJpeg(data, image, error_message, min_width, min_height,
+                                  max_pixels);
+#endif
+#ifdef FP_HAVE_LIBPNG
+            case ImageFormat::PNG:
+                return decodePng(data, image, error_message, max_pixels);
+#endif
+            default:
+                error_message = "Input format not supported by image engine";
+                return false;
+        }
+    } catch (const std::exception& e) {
+        error_message = std::string("Exception in decode: ") + e.what();
+        return false;
+    }
+}
+
+bool ImageEngine::encode(const Image& image, ImageFormat format,
+                         std::string& output, std::string& error_message,
+                         int jpeg_quality) {
+    try {
+        switch (format) {
+#ifdef FP_HAVE_LIBJPEG
+            case ImageFormat::JPEG:
+                return encodeJpeg(image, output, error_message, jpeg_quality);
+#endif
+#ifdef FP_HAVE_LIBPNG
+            case ImageFormat::PNG:
+                return encodePng(image, output, error_message);
+#endif
+            default:
+                (void)jpeg_quality;
+                error_message = "Output format not supported by image engine";
+                return false;
+        }
+    } catch (const std::exception& e) {
+        error_message = std::string("Exception in encode: ") + e.what();
+        return false;
+    }
+}
+
+bool ImageEngine::resize(const Image& source, int width, int height,
+                         Image& destination, std::string& error_message,
+                         const ResizeOptions& options) {
+    if (width <= 0 || height <= 0 || source.width <= 0 || source.height <= 0 ||
+        source.channels < 1 || source.channels > 4) {
+        error_message = "Invalid dimensions for resize";
+        return false;
+    }
+
+    destination.width = width;
+    destination.height = height;
+    destination.channels = source.channels;
+    destination.pixels.resize(static_cast<size_t>(width) * height * source.channels);
+
+    ImageResampler::resample(source.pixels.data(), source.width, source.height,
+                             source.channels, destination.pixels.data(), width, height,
+                             options.filter, options.parallel_for);
+    return true;
+}
+
+void ImageEngine::fitWithin(int source_width, int source_height,
+                            int& width, int& height) {
+    if (source_width <= 0 || source_height <= 0) {
+        return;
+    }
+    double scale = std::min(static_cast<double>(width) / source_width,
+                            static_cast<double>(height) / source_height);
+    width = std::max(1, static_cast<int>(std::lround(source_width * scale)));
+    height = std::max(1, static_cast<int>(std::lround(source_height * scale)));
+}
+
+bool ImageEngine::convertImage(const std::string& input,
+                               ImageFormat output_format, std::string& output,
+                               std::string& error_message, size_t max_pixels) {
+    Image image;
+    if (!decode(input, image, error_message, 0, 0, max_pixels)) {
+        return false;
+    }
+    return encode(image, output_format, output, error_message);
+}
+
+bool ImageEngine::resizeImage(const std::string& input, int width, int height,
+                              ImageFormat output_format, std::string& output,
+                              std::string& error_message,
+                              const ResizeOptions& options) {
+    // O tamanho final vem das dimensões originais, lidas do cabeçalho, para
+    // não depender da redução aplicada no decode
+    int source_width = 0;
+    int source_height = 0;
+    if (options.maintain_aspect_ratio &&
+        readDimensions(input, source_width, source_height)) {
+        fitWithin(source_width, source_height, width, height);
+    }
+
+    Image image;
+    if (!decode(input, image, error_message,
+                options.scaled_decode ? width : 0,
+                options.scaled_decode ? height : 0, options.max_pixels)) {
+        return false;
+    }
+
+    Image resized;
+    if (!resize(image, width, height, resized, error_message, options)) {
+        return false;
+    }
+    return encode(resized, output_format, output, error_message);
+}
@@ -0,0 +1,444 @@
+#include "image_resampler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define FP_RESAMPLE_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+// Imagens menores que isso (pixels de origem) não compensam dividir em faixas
+const size_t kParallelMinPixels = 1024 * 1024;
+// Linhas mínimas e quantidade máxima de faixas
+const int kMinBandRows = 32;
+const int kMaxBands = 64;
+
+std::atomic<bool> g_simd_enabled(true);
+
+enum class InstructionSet {
+    SCALAR,
+    SSE41,
+    AVX2
+};
+
+InstructionSet detectInstructionSet() {
+#ifdef FP_RESAMPLE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return InstructionSet::AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return InstructionSet::SSE41;
+    }
+#endif
+    return InstructionSet::SCALAR;
+}
+
+InstructionSet activeInstructionSet() {
+    static const InstructionSet detected = detectInstructionSet();
+    return g_simd_enabled.load(std::memory_order_relaxed) ? detected
+                                                          : InstructionSet::SCALAR;
+}
+
+double filterSupport(ResampleFilter filter) {
+    switch (filter) {
+        case ResampleFilter::BILINEAR: return 1.0;
+        case ResampleFilter::BICUBIC: return 2.0;
+        case ResampleFilter::LANCZOS: return 3.0;
+    }
+    return 1.0;
+}
+
+double sinc(double x) {
+    if (x == 0.0) {
+        return 1.0;
+    }
+    x *= kPi;
+    return std::sin(x) / x;
+}
+
+double filterWeight(ResampleFilter filter, double x) {
+    x = std::fabs(x);
+    switch (filter) {
+        case ResampleFilter::BILINEAR:
+            return x < 1.0 ? 1.0 - x : 0.0;
+        case ResampleFilter::BICUBIC: {
+            // Catmull-Rom (a = -0.5)
+            const double a = -0.5;
+            if (x < 1.0) {
+                return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+            }
+            if (x < 2.0) {
+                return ((a * x - 5.0 * a) * x + 8.0 * a) * x - 4.0 * a;
+            }
+            return 0.0;
+        }
+        case ResampleFilter::LANCZOS:
+            return x < 3.0 ? sinc(x) * sinc(x / 3.0) : 0.0;
+    }
+    return 0.0;
+}
+
+// Pesos de um eixo: para cada pixel de destino, o primeiro pixel de origem
+// e count pesos normalizados (linha de taps floats, com zeros no final)
+struct Contributions {
+    int taps = 0;
+    std::vector<int> first;
+    std::vector<int> count;
+    std::vector<float> weights;
+
+    const float* weightsFor(int index) const {
+        return weights.data() + static_cast<size_t>(index) * taps;
+    }
+};
+
+Contributions computeContributions(int in_size, int out_size, ResampleFilter filter) {
+    const double scale = static_cast<double>(in_size) / out_size;
+    const double filter_scale = std::max(scale, 1.0);
+    const double support = filterSupport(filter) * filter_scale;
+
+    Contributions result;
+    result.taps = static_cast<int>(std::ceil(support)) * 2 + 1;
+    result.first.resize(out_size);
+    result.count.resize(out_size);
+    result.weights.assign(static_cast<size_t>(out_size) * result.taps, 0.0f);
+
+    std::vector<double> weights(result.taps);
+    for (int i = 0; i < out_size; ++i) {
+        const double center = (i + 0.5) * scale;
+        int first = std::max(0, static_cast<int>(std::floor(center - support + 0.5)));
+        int last = std::min(in_size, static_cast<int>(std::floor(center + support + 0.5)));
+        int count = std::min(last - first, result.taps);
+
+        double total = 0.0;
+        for (int k = 0; k < count; ++k) {
+            weights[k] = filterWeight(filter, (first + k + 0.5 - center) / filter_scale);
+            total += weights[k];
+        }
+        // Sem pesos úteis (escalas extremas): vizinho mais próximo
+        if (count <= 0 || total == 0.0) {
+            first = std::min(std::max(static_cast<int>(center), 0), in_size - 1);
+            count = 1;
+            weights[0] = 1.0;
+            total = 1.0;
+        }
+
+        float* row = result.weights.data() + static_cast<size_t>(i) * result.taps;
+        for (int k = 0; k < count; ++k) {
+            row[k] = static_cast<float>(weights[k] / total);
+        }
+        result.first[i] = first;
+        result.count[i] = count;
+    }
+    return result;
+}
+
+inline uint8_t toByte(float value) {
+    long rounded = std::lrintf(value);
+    return static_cast<uint8_t>(std::min(255L, std::max(0L, rounded)));
+}
+
+// Passada horizontal de uma linha; end delimita o buffer de origem (as
+// variantes SIMD leem alguns bytes além do pixel quando há espaço)
+using HorizontalRow = void (*)(const uint8_t* row, const uint8_t* end, uint8_t* output,
+                               int width, int channels, const Contributions& contributions);
+
+// Passada vertical de uma linha de destino a partir das linhas intermediárias
+using VerticalRow = void (*)(const uint8_t* rows, size_t row_bytes, uint8_t* output,
+                             int first, int count, const float* weights);
+
+void horizontalScalar(const uint8_t* row, const uint8_t* end, uint8_t* output,
+                      int width, int channels, const Contributions& contributions) {
+    (void)end;
+    float sums[4];
+    for (int x = 0; x < width; ++x) {
+        const float* weights = contributions.weightsFor(x);
+        const uint8_t* pixel = row + static_cast<size_t>(contributions.first[x]) * channels;
+        std::fill(sums, sums + channels, 0.0f);
+        for (int k = 0; k < contributions.count[x]; ++k, pixel += channels) {
+            for (int c = 0; c < channels; ++c) {
+                sums[c] += pixel[c] * weights[k];
+            }
+        }
+        for (int c = 0; c < channels; ++c) {
+            output[static_cast<size_t>(x) * channels + c] = toByte(sums[c]);
+        }
+    }
+}
+
+void verticalScalar(const uint8_t* rows, size_t row_bytes, uint8_t* output,
+                    int first, int count, const float* weights) {
+    const uint8_t* base = rows + static_cast<size_t>(first) * row_bytes;
+    for (size_t x = 0; x < row_bytes; ++x) {
+        float sum = 0.0f;
+        const uint8_t* sample = base + x;
+        for (int k = 0; k < count; ++k, sample += row_bytes) {
+            sum += *sample * weights[k];
+        }
+        output[x] = toByte(sum);
+    }
+}
+
+#ifdef FP_RESAMPLE_X86
+
+// Um pixel RGB(A) em 4 lanes int32; o quarto byte de RGB é ignorado
+__attribute__((target("sse4.1")))
+inline __m128 loadPixelSse41(const uint8_t* pixel, const uint8_t* end, int channels) {
+    int32_t packed = 0;
+    std::memcpy(&packed, pixel, pixel + 4 <= end ? 4 : channels);
+    return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed)));
+}
+
+__attribute__((target("sse4.1")))
+inline void storePixelSse41(__m128 sums, uint8_t* output, int channels) {
+    __m128i values = _mm_cvtps_epi32(sums);
+    values = _mm_packus_epi32(values, values);
+    values = _mm_packus_epi16(values, values);
+    int32_t packed = _mm_cvtsi128_si32(values);
+    std::memcpy(output, &packed, channels);
+}
+
+__attribute__((target("sse4.1")))
+void horizontalSse41(const uint8_t* row, const uint8_t* end, uint8_t* output,
+                     int width, int channels, const Contributions& contributions) {
+    for (int x = 0; x < width; ++x) {
+        const float* weights = contributions.weightsFor(x);
+        const uint8_t* pixel = row + static_cast<size_t>(contributions.first[x]) * channels;
+        __m128 sums = _mm_setzero_ps();
+        for (int k = 0; k < contributions.count[x]; ++k, pixel += channels) {
+            sums = _mm_add_ps(sums, _mm_mul_ps(loadPixelSse41(pixel, end, channels),
+                                               _mm_set1_ps(weights[k])));
+        }
+        storePixelSse41(sums, output + static_cast<size_t>(x) * channels, channels);
+    }
+}
+
+__attribute__((target("sse4.1")))
+void verticalSse41(const uint8_t* rows, size_t row_bytes, uint8_t* output,
+                   int first, int count, const float* weights) {
+    const uint8_t* base = rows + static_cast<size_t>(first) * row_bytes;
+    size_t x = 0;
+    for (; x + 4 <= row_bytes; x += 4) {
+        __m128 sums = _mm_setzero_ps();
+        const uint8_t* sample = base + x;
+        for (int k = 0; k < count; ++k, sample += row_bytes) {
+            int32_t packed;
+            std::memcpy(&packed, sample, 4);
+            __m128 values = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed)));
+            sums = _mm_add_ps(sums, _mm_mul_ps(values, _mm_set1_ps(weights[k])));
+        }
+        storePixelSse41(sums, output + x, 4);
+    }
+    for (; x < row_bytes; ++x) {
+        float sum = 0.0f;
+        const uint8_t* sample = base + x;
+        for (int k = 0; k < count; ++k, sample += row_bytes) {
+            sum += *sample * weights[k];
+        }
+        output[x] = toByte(sum);
+    }
+}
+
+// Dois taps por iteração: 8 bytes viram 2 pixels em um registrador de 256 bits
+__attribute__((target("avx2,fma")))
+void horizontalAvx2(const uint8_t* row, const uint8_t* end, uint8_t* output,
+                    int width, int channels, const Contributions& contributions) {
+    // RGB: bytes 0-2 e 3-5 espalhados em duas lanes de 4 (alfa zerado)
+    const __m128i rgb_shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1,
+                                              -1, -1, -1, -1, -1, -1, -1, -1);
+    for (int x = 0; x < width; ++x) {
+        const float* weights = contributions.weightsFor(x);
+        const int count = contributions.count[x];
+        const uint8_t* pixel = row + static_cast<size_t>(contributions.first[x]) * channels;
+
+        __m256 sums = _mm256_setzero_ps();
+        int k = 0;
+        for (; k + 1 < count && pixel + 8 <= end; k += 2, pixel += 2 * channels) {
+            __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pixel));
+            if (channels == 3) {
+                bytes = _mm_shuffle_epi8(bytes, rgb_shuffle);
+            }
+            __m256 values = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+            __m256 pair = _mm256_insertf128_ps(
+                _mm256_castps128_ps256(_mm_set1_ps(weights[k])),
+                _mm_set1_ps(weights[k + 1]), 1);
+            sums = _mm256_fmadd_ps(values, pair, sums);
+        }
+
+        __m128 total = _mm_add_ps(_mm256_castps256_ps128(sums),
+                                  _mm256_extractf128_ps(sums, 1));
+        for (; k < count; ++k, pixel += channels) {
+            total = _mm_fmadd_ps(loadPixelSse41(pixel, end, channels),
+                                 _mm_set1_ps(weights[k]), total);
+        }
+        storePixelSse41(total, output + static_cast<size_t>(x) * channels, channels);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+void verticalAvx2(const uint8_t* rows, size_t row_bytes, uint8_t* output,
+                  int first, int count, const float* weights) {
+    const uint8_t* base = rows + static_cast<size_t>(first) * row_bytes;
+    size_t x = 0;
+    for (; x + 8 <= row_bytes; x += 8) {
+        __m256 sums = _mm256_setzero_ps();
+        const uint8_t* sample = base + x;
+        for (int k = 0; k < count; ++k, sample += row_bytes) {
+            __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(sample));
+            sums = _mm256_fmadd_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes)),
+                                   _mm256_set1_ps(weights[k]), sums);
+        }
+        __m256i values = _mm256_cvtps_epi32(sums);
+        __m128i words = _mm_packus_epi32(_mm256_castsi256_si128(values),
+                                         _mm256_extracti128_si256(values, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(output + x),
+                         _mm_packus_epi16(words, words));
+    }
+    for (; x < row_bytes; ++x) {
+        float sum = 0.0f;
+        const uint8_t* sample = base + x;
+        for (int k = 0; k < count; ++k, sample += row_bytes) {
+            sum += *sample * weights[k];
+        }
+        output[x] = toByte(sum);
+    }
+}
+
+#endif // FP_RESAMPLE_X86
+
+// Dividir rows linhas em faixas executadas via parallel_for
+void forEachBand(int rows, size_t pixels, const ImageResampler::ParallelFor& parallel_for,
+                 const std::function<void(int, int)>& body) {
+    int bands = 1;
+    if (parallel_for && pixels >= kParallelMinPixels) {
+        bands = std::min(kMaxBands, rows / kMinBandRows);
+    }
+    if (bands <= 1) {
+        body(0, rows);
+        return;
+    }
+
+    parallel_for(static_cast<size_t>(bands), [&](size_t band) {
+        int begin = static_cast<int>(static_cast<long long>(rows) * band / bands);
+        int end = static_cast<int>(static_cast<long long>(rows) * (band + 1) / bands);
+        body(begin, end);
+    });
+}
+
+} // namespace
+
+bool ImageResampler::filterFromName(const std::string& name, ResampleFilter& filter) {
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    if (lower == "bilinear" || lower == "triangle") {
+        filter = ResampleFilter::BILINEAR;
+    } else if (lower == "bicubic" || lower == "catrom") {
+        filter = ResampleFilter::BICUBIC;
+    } else if (lower == "lanczos") {
+        filter = ResampleFilter::LANCZOS;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* ImageResampler::filterName(ResampleFilter filter) {
+    switch (filter) {
+        case ResampleFilter::BILINEAR: return "bilinear";
+        case ResampleFilter::BICUBIC: return "bicubic";
+        case ResampleFilter::LANCZOS: return "lanczos";
+    }
+    return "unknown";
+}
+
+const char* ImageResampler::instructionSet() {
+    switch (activeInstructionSet()) {
+        case InstructionSet::AVX2: return "avx2";
+        case InstructionSet::SSE41: return "sse4.1";
+        case InstructionSet::SCALAR: return "scalar";
+    }
+    return "scalar";
+}
+
+void ImageResampler::setSimdEnabled(bool enabled) {
+    g_simd_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void ImageResampler::resample(const uint8_t* source, int source_width, int source_height,
+                              int channels, uint8_t* destination, int width, int height,
+                              ResampleFilter filter, const ParallelFor& parallel_for) {
+    const size_t source_row = static_cast<size_t>(source_width) * channels;
+    const size_t output_row = static_cast<size_t>(width) * channels;
+    if (width == source_width && height == source_height) {
+        std::memcpy(destination, source, source_row * source_height);
+        return;
+    }
+
+    HorizontalRow horizontal = horizontalScalar;
+    VerticalRow vertical = verticalScalar;
+#ifdef FP_RESAMPLE_X86
+    switch (activeInstructionSet()) {
+        case InstructionSet::AVX2:
+            horizontal = channels >= 3 ? horizontalAvx2 : horizontalScalar;
+            vertical = verticalAvx2;
+            break;
+        case InstructionSet::SSE41:
+            horizontal = channels >= 3 ? horizontalSse41 : horizontalScalar;
+            vertical = verticalSse41;
+            break;
+        case InstructionSet::SCALAR:
+            break;
+    }
+#endif
+
+    const size_t pixels = static_cast<size_t>(source_width) * source_height;
+    const uint8_t* source_end = source + source_row * source_height;
+
+    Contributions columns;
+    if (width != source_width) {
+        columns = computeContributions(source_width, width, filter);
+    }
+
+    // Só a passada horizontal: grava direto no destino
+    if (height == source_height) {
+        forEachBand(height, pixels, parallel_for, [&](int begin, int end) {
+            for (int y = begin; y < end; ++y) {
+                horizontal(source + y * source_row, source_end,
+                           destination + y * output_row, width, channels, columns);
+            }
+        });
+        return;
+    }
+
+    Contributions rows = computeContributions(source_height, height, filter);
+
+    // Intermediário: largura de destino x altura de origem (só as linhas usadas)
+    const uint8_t* intermediate = source;
+    std::vector<uint8_t> buffer;
+    if (width != source_width) {
+        const int first_row = rows.first.front();
+        const int last_row = rows.first.back() + rows.count.back();
+        buffer.resize(output_row * source_height);
+        forEachBand(last_row - first_row, pixels, parallel_for, [&](int begin, int end) {
+            for (int y = first_row + begin; y < first_row + end; ++y) {
+                horizontal(source + y * source_row, source_end,
+                           buffer.data() + y * output_row, width, channels, columns);
+            }
+        });
+        intermediate = buffer.data();
+    }
+
+    forEachBand(height, pixels, parallel_for, [&](int begin, int end) {
+        for (int y = begin; y < end; ++y) {
+            vertical(intermediate, output_row, destination + y * output_row,
+                     rows.first[y], rows.count[y], rows.weightsFor(y));
+        }
+    });
+}
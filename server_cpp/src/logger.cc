@@ -0,0 +1,319 @@
+#include "logger.h"
+#include "server_config.h"
+
+#include <algorithm>
+#include <cctype>
+#include <ctime>
+#include <iostream>
+#include <utility>
+
+namespace {
+// Registros gravados por lote antes de liberar o arquivo
+const size_t kMaxBatchRecords = 256;
+// Intervalo máximo de espera da thread de fundo sem ser acordada
+const auto kWriterIdleWait = std::chrono::milliseconds(50);
+
+size_t roundUpPowerOfTwo(size_t value) {
+    size_t capacity = 2;
+    while (capacity < value) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+}
+
+Logger::Logger()
+    : mask_(0),
+      low_priority_limit_(0),
+      enqueue_pos_(0),
+      dequeue_pos_(0),
+      min_level_(static_cast<int>(LogLevel::INFO_LEVEL)),
+      dropped_(0),
+      written_(0),
+      writer_sleeping_(false),
+      stopping_(false),
+      log_file_path_("server.log"),
+      reopen_file_(true),
+      log_file_(nullptr) {
+    const ServerConfig& config = ServerConfig::getInstance();
+    setMinLevel(parseLevel(config.log_level, LogLevel::INFO_LEVEL));
+
+    size_t capacity = roundUpPowerOfTwo(std::max<size_t>(config.log_queue_size, 2));
+    slots_.reset(new Slot[capacity]);
+    for (size_t i = 0; i < capacity; ++i) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    mask_ = capacity - 1;
+    low_priority_limit_ = capacity - capacity / 4;
+
+    writer_ = std::thread(&Logger::writerLoop, this);
+}
+
+Logger::~Logger() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_ = true;
+    }
+    wake_cv_.notify_one();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+    if (log_file_ != nullptr) {
+        std::fclose(log_file_);
+    }
+}
+
+void Logger::setLogFile(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    log_file_path_ = filename;
+    reopen_file_ = true;
+}
+
+LogLevel Logger::parseLevel(const std::string& name, LogLevel default_level) {
+    std::string lower_name = name;
+    std::transform(lower_name.begin(), lower_name.end(), lower_name.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    if (lower_name == "info") return LogLevel::INFO_LEVEL;
+    if (lower_name == "success") return LogLevel::SUCCESS_LEVEL;
+    if (lower_name == "warning") return LogLevel::WARNING_LEVEL;
+    if (lower_name == "error") return LogLevel::ERROR_LEVEL;
+    return default_level;
+}
+
+void Logger::log(LogLevel level, const std::string& service_name,
+                 const std::string& file_name, const std::string& message) {
+    if (!isEnabled(level)) {
+        return;
+    }
+
+    // Sob pressão, o último quarto da fila fica reservado para WARNING/ERROR
+    if (level < LogLevel::WARNING_LEVEL &&
+        enqueue_pos_.load(std::memory_order_relaxed) -
+            written_.load(std::memory_order_relaxed) >= low_priority_limit_) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Record record;
+    record.level = level;
+    record.time = std::chrono::system_clock::now();
+    record.service_name = service_name;
+    record.file_name = file_name;
+    record.message = message;
+
+    if (!tryEnqueue(record)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if (writer_sleeping_.load()) {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        wake_cv_.notify_one();
+    }
+}
+
+bool Logger::tryEnqueue(Record& record) {
+    size_t position = enqueue_pos_.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+        slot = &slots_[position & mask_];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        intptr_t difference = static_cast<intptr_t>(sequence) -
+                              static_cast<intptr_t>(position);
+        if (difference == 0) {
+            if (enqueue_pos_.compare_exchange_weak(position, position + 1,
+                                                   std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // Fila cheia
+            return false;
+        } else {
+            position = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->record = std::move(record);
+    // seq_cst: pareado com a marcação writer_sleeping_ da thread de fundo
+    slot->sequence.store(position + 1);
+    return true;
+}
+
+bool Logger::tryDequeue(Record& record) {
+    // Consumidor único: só a thread de fundo avança dequeue_pos_
+    Slot* slot = &slots_[dequeue_pos_ & mask_];
+    if (slot->sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1) {
+        return false;
+    }
+
+    record = std::move(slot->record);
+    slot->sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+    ++dequeue_pos_;
+    return true;
+}
+
+void Logger::flush() {
+    const uint64_t target = enqueue_pos_.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    wake_cv_.notify_one();
+    // Registros descartados nunca chegam ao ring, então a posição basta
+    flushed_cv_.wait(lock, [this, target] {
+        return stopping_ || written_.load(std::memory_order_acquire) >= target;
+    });
+}
+
+void Logger::writerLoop() {
+    std::string file_batch;
+    std::string console_batch;
+    std::string line;
+    uint64_t reported_drops = 0;
+    Record record;
+
+    while (true) {
+        size_t count = 0;
+        while (count < kMaxBatchRecords && tryDequeue(record)) {
+            formatRecord(record, line);
+            file_batch += line;
+            file_batch += '\n';
+            console_batch += getColorCode(record.level);
+            console_batch += line;
+            console_batch += "\033[0m\n";
+            ++count;
+        }
+
+        // Descartes são informados assim que a fila volta a ter espaço
+        uint64_t drops = dropped_.load(std::memory_order_relaxed);
+        if (drops != reported_drops) {
+            Record notice;
+            notice.level = LogLevel::WARNING_LEVEL;
+            notice.time = std::chrono::system_clock::now();
+            notice.service_name = "Logger";
+            notice.file_name = "N/A";
+            notice.message = "Log queue full, dropped " +
+                             std::to_string(drops - reported_drops) + " records";
+            formatRecord(notice, line);
+            file_batch += line;
+            file_batch += '\n';
+            console_batch += getColorCode(notice.level);
+            console_batch += line;
+            console_batch += "\033[0m\n";
+            reported_drops = drops;
+        }
+
+        if (!file_batch.empty()) {
+            writeBatch(file_batch, console_batch);
+        }
+        if (count > 0) {
+            {
+                std::lock_guard<std::mutex> lock(wake_mutex_);
+                written_.fetch_add(count, std::memory_order_release);
+            }
+            flushed_cv_.notify_all();
+        }
+        if (count == kMaxBatchRecords) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        Slot* next = &slots_[dequeue_pos_ & mask_];
+        bool ready = next->sequence.load(std::memory_order_acquire) == dequeue_pos_ + 1;
+        if (stopping_ && !ready) {
+            // Tudo que foi enfileirado antes do encerramento já foi gravado
+            flushed_cv_.notify_all();
+            return;
+        }
+        if (ready) {
+            continue;
+        }
+
+        // seq_cst em ambos os lados: o produtor vê a marcação ou a thread
+        // vê o registro publicado logo após o último dequeue
+        writer_sleeping_.store(true);
+        if (next->sequence.load() != dequeue_pos_ + 1) {
+            wake_cv_.wait_for(lock, kWriterIdleWait);
+        }
+        writer_sleeping_.store(false, std::memory_order_relaxed);
+    }
+}
+
+void Logger::writeBatch(std::string& file_batch, std::string& console_batch) {
+    {
+        std::lock_guard<std::mutex> lock(file_mutex_);
+        if (reopen_file_) {
+            openLogFile();
+        }
+        if (log_file_ != nullptr) {
+            std::fwrite(file_batch.data(), 1, file_batch.size(), log_file_);
+            std::fflush(log_file_);
+        }
+    }
+
+    if (!console_batch.empty()) {
+        std::cout.write(console_batch.data(),
+                        static_cast<std::streamsize>(console_batch.size()));
+        std::cout.flush();
+    }
+
+    file_batch.clear();
+    console_batch.clear();
+}
+
+void Logger::openLogFile() {
+    if (log_file_ != nullptr) {
+        std::fclose(log_file_);
+    }
+    log_file_ = std::fopen(log_file_path_.c_str(), "a");
+    reopen_file_ = false;
+}
+
+void Logger::formatRecord(const Record& record, std::string& line) {
+    auto time_t_value = std::chrono::system_clock::to_time_t(record.time);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        record.time.time_since_epoch()) % 1000;
+
+    std::tm tm_value;
+#ifdef _WIN32
+    localtime_s(&tm_value, &time_t_value);
+#else
+    localtime_r(&time_t_value, &tm_value);
+#endif
+
+    char timestamp[32];
+    size_t length = std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S",
+                                  &tm_value);
+    std::snprintf(timestamp + length, sizeof(timestamp) - length, ".%03d",
+                  static_cast<int>(ms.count()));
+
+    line.clear();
+    line += '[';
+    line += timestamp;
+    line += "] [";
+    line += getLevelString(record.level);
+    line += "] Service: ";
+    line += record.service_name;
+    line += " | File: ";
+    line += record.file_name;
+    line += " | Message: ";
+    line += record.message;
+}
+
+const char* Logger::getLevelString(LogLevel level) {
+    switch (level) {
+        case LogLevel::INFO_LEVEL: return "INFO";
+        case LogLevel::SUCCESS_LEVEL: return "SUCCESS";
+        case LogLevel::WARNING_LEVEL: return "WARNING";
+        case LogLevel::ERROR_LEVEL: return "ERROR";
+        default: return "UNKNOWN";
+    }
+}
+
+const char* Logger::getColorCode(LogLevel level) {
+    switch (level) {
+        case LogLevel::INFO_LEVEL: return "\033[36m";      // Cyan
+        case LogLevel::SUCCESS_LEVEL: return "\033[32m";   // Green
+        case LogLevel::WARNING_LEVEL: return "\033[33m";   // Yellow
+        case LogLevel::ERROR_LEVEL: return "\033[31m";     // Red
+        default: return "\033[0m";                   // Reset
+    }
+}
@@ -0,0 +1,160 @@
+#include "metrics.h"
+
+#include <cstdio>
+
+const double LatencyHistogram::kBucketBounds[LatencyHistogram::kBucketCount] = {
+    0.001, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60};
+
+namespace {
+const char* const kPhaseNames[] = {"receive", "process", "send"};
+
+std::string formatValue(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+    return buffer;
+}
+
+void appendHeader(std::string& output, const std::string& name,
+                  const std::string& help, const char* type) {
+    output += "# HELP " + name + " " + help + "\n";
+    output += "# TYPE " + name + " " + type + "\n";
+}
+}
+
+LatencyHistogram::LatencyHistogram() : sum_microseconds_(0) {
+    for (auto& count : counts_) {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::observe(double seconds) {
+    size_t bucket = 0;
+    while (bucket < kBucketCount && seconds > kBucketBounds[bucket]) {
+        ++bucket;
+    }
+    counts_[bucket].fetch_add(1, std::memory_order_relaxed);
+    sum_microseconds_.fetch_add(static_cast<uint64_t>(seconds * 1e6),
+                                std::memory_order_relaxed);
+}
+
+void LatencyHistogram::render(const std::string& name, const std::string& labels,
+                              std::string& output) const {
+    // Buckets cumulativos; o total sai da soma para manter a consistência
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i <= kBucketCount; ++i) {
+        cumulative += counts_[i].load(std::memory_order_relaxed);
+        std::string bound = i < kBucketCount ? formatValue(kBucketBounds[i]) : "+Inf";
+        output += name + "_bucket{" + labels + ",le=\"" + bound + "\"} " +
+                  std::to_string(cumulative) + "\n";
+    }
+    output += name + "_sum{" + labels + "} " +
+              formatValue(sum_microseconds_.load(std::memory_order_relaxed) / 1e6) + "\n";
+    output += name + "_count{" + labels + "} " + std::to_string(cumulative) + "\n";
+}
+
+Metrics::Metrics() {
+    for (const char* name : {"CompressPDF", "ConvertToTXT", "ConvertImageFormat",
+                             "ResizeImage", "other"}) {
+        operations_[name] = std::make_unique<OperationMetrics>();
+    }
+}
+
+OperationMetrics& Metrics::operation(const std::string& name) {
+    auto it = operations_.find(name);
+    return it != operations_.end() ? *it->second : *operations_.at("other");
+}
+
+void Metrics::addGauge(const void* owner, const std::string& name,
+                       const std::string& help, const std::string& labels,
+                       GaugeFunction function, bool is_counter) {
+    std::lock_guard<std::mutex> lock(gauges_mutex_);
+    gauges_.push_back({owner, name, help, labels, std::move(function), is_counter});
+}
+
+void Metrics::removeGauges(const void* owner) {
+    std::lock_guard<std::mutex> lock(gauges_mutex_);
+    std::vector<Gauge> remaining;
+    for (Gauge& gauge : gauges_) {
+        if (gauge.owner != owner) {
+            remaining.push_back(std::move(gauge));
+        }
+    }
+    gauges_.swap(remaining);
+}
+
+std::string Metrics::render() const {
+    std::string output;
+
+    struct CounterField {
+        const char* name;
+        const char* help;
+        std::atomic<uint64_t> OperationMetrics::*field;
+    };
+    const CounterField counters[] = {
+        {"fp_requests_total", "Requests received per operation",
+         &OperationMetrics::requests},
+        {"fp_errors_total", "Requests finished with an error status",
+         &OperationMetrics::errors},
+        {"fp_cache_hits_total", "Requests served from the result cache",
+         &OperationMetrics::cache_hits},
+        {"fp_bytes_in_total", "Bytes received from clients",
+         &OperationMetrics::bytes_in},
+        {"fp_bytes_out_total", "Bytes sent to clients",
+         &OperationMetrics::bytes_out},
+        {"fp_compressed_bytes_total", "Response bytes sent with gRPC compression",
+         &OperationMetrics::compressed_bytes},
+        {"fp_compressed_wire_bytes_total",
+         "Estimated size of the compressed response bytes on the wire",
+         &OperationMetrics::compressed_wire_bytes},
+        {"fp_abandoned_jobs_total",
+         "Jobs that ran for a call already cancelled or past its deadline",
+         &OperationMetrics::abandoned_jobs},
+    };
+
+    for (const CounterField& counter : counters) {
+        appendHeader(output, counter.name, counter.help, "counter");
+        for (const auto& entry : operations_) {
+            output += std::string(counter.name) + "{operation=\"" + entry.first + "\"} " +
+                      std::to_string((entry.second.get()->*counter.field)
+                                         .load(std::memory_order_relaxed)) + "\n";
+        }
+    }
+
+    appendHeader(output, "fp_wasted_process_seconds_total",
+                 "Processing time spent on calls already cancelled or past their deadline",
+                 "counter");
+    for (const auto& entry : operations_) {
+        output += "fp_wasted_process_seconds_total{operation=\"" + entry.first + "\"} " +
+                  formatValue(entry.second->wasted_process_microseconds.load(
+                      std::memory_order_relaxed) / 1e6) + "\n";
+    }
+
+    const std::string histogram = "fp_request_phase_duration_seconds";
+    appendHeader(output, histogram,
+                 "Request latency per phase (receive, process, send)", "histogram");
+    for (const auto& entry : operations_) {
+        for (size_t phase = 0; phase < 3; ++phase) {
+            entry.second->phases[phase].render(
+                histogram,
+                "operation=\"" + entry.first + "\",phase=\"" + kPhaseNames[phase] + "\"",
+                output);
+        }
+    }
+
+    // Gauges com o mesmo nome compartilham o cabeçalho HELP/TYPE
+    std::lock_guard<std::mutex> lock(gauges_mutex_);
+    std::map<std::string, std::vector<const Gauge*>> by_name;
+    for (const Gauge& gauge : gauges_) {
+        by_name[gauge.name].push_back(&gauge);
+    }
+    for (const auto& entry : by_name) {
+        const Gauge& first = *entry.second.front();
+        appendHeader(output, entry.first, first.help,
+                     first.is_counter ? "counter" : "gauge");
+        for (const Gauge* gauge : entry.second) {
+            output += entry.first + (gauge->labels.empty() ? "" : "{" + gauge->labels + "}") +
+                      " " + formatValue(gauge->function()) + "\n";
+        }
+    }
+    return output;
+}
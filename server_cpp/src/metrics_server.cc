@@ -0,0 +1,192 @@
+#include "metrics_server.h"
+#include "metrics.h"
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#endif
+
+namespace {
+// Intervalo do poll para perceber stop()
+const int kPollIntervalMs = 200;
+// Cabeçalhos de requisição maiores que isso são recusados
+const size_t kMaxRequestBytes = 8192;
+
+#ifndef _WIN32
+bool sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t result = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        sent += static_cast<size_t>(result);
+    }
+    return true;
+}
+
+std::string response(const std::string& status, const std::string& content_type,
+                     const std::string& body) {
+    return "HTTP/1.1 " + status + "\r\n"
+           "Content-Type: " + content_type + "\r\n"
+           "Content-Length: " + std::to_string(body.size()) + "\r\n"
+           "Connection: close\r\n\r\n" + body;
+}
+#endif
+}
+
+MetricsServer::MetricsServer() : listen_fd_(-1), port_(0), stopping_(false) {}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start(const std::string& address, int port,
+                          std::string& error_message) {
+#ifndef _WIN32
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        error_message = std::string("socket failed: ") + std::strerror(errno);
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+        error_message = "Invalid metrics address: " + address;
+        close(fd);
+        return false;
+    }
+
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(fd, 16) != 0) {
+        error_message = "Failed to listen on " + address + ":" + std::to_string(port) +
+                        ": " + std::strerror(errno);
+        close(fd);
+        return false;
+    }
+
+    // Porta 0: a efetiva é escolhida pelo sistema
+    socklen_t length = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &length);
+    port_ = ntohs(addr.sin_port);
+
+    listen_fd_ = fd;
+    stopping_.store(false);
+    thread_ = std::thread(&MetricsServer::serveLoop, this);
+    return true;
+#else
+    (void)address;
+    (void)port;
+    error_message = "Metrics endpoint not supported on this platform";
+    return false;
+#endif
+}
+
+void MetricsServer::stop() {
+    stopping_.store(true);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+#ifndef _WIN32
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+    }
+#endif
+    listen_fd_ = -1;
+}
+
+void MetricsServer::serveLoop() {
+#ifndef _WIN32
+    // Sinais de shutdown são recebidos pela thread de shutdown do servidor
+    sigset_t signals;
+    sigfillset(&signals);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    while (!stopping_.load()) {
+        pollfd entry;
+        entry.fd = listen_fd_;
+        entry.events = POLLIN;
+        entry.revents = 0;
+        if (poll(&entry, 1, kPollIntervalMs) <= 0) {
+            continue;
+        }
+
+        int client_fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client_fd < 0) {
+            continue;
+        }
+        handleConnection(client_fd);
+        close(client_fd);
+    }
+#endif
+}
+
+void MetricsServer::handleConnection(int client_fd) {
+#ifndef _WIN32
+    // Cliente lento não pode segurar a thread indefinidamente
+    timeval timeout;
+    timeout.tv_sec = 2;
+    timeout.tv_usec = 0;
+    setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client_fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos &&
+           request.size() < kMaxRequestBytes) {
+        ssize_t result = recv(client_fd, buffer, sizeof(buffer), 0);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            break;
+        }
+        request.append(buffer, static_cast<size_t>(result));
+    }
+
+    // Linha de requisição: "<método> <caminho>[?query] HTTP/1.x"
+    std::string line = request.substr(0, request.find("\r\n"));
+    size_t method_end = line.find(' ');
+    size_t path_end = line.find_first_of(" ?", method_end + 1);
+    if (method_end == std::string::npos || path_end == std::string::npos) {
+        sendAll(client_fd, response("400 Bad Request", "text/plain", "Bad Request\n"));
+        return;
+    }
+
+    std::string method = line.substr(0, method_end);
+    std::string path = line.substr(method_end + 1, path_end - method_end - 1);
+    if (method != "GET" && method != "HEAD") {
+        sendAll(client_fd, response("405 Method Not Allowed", "text/plain",
+                                    "Method Not Allowed\n"));
+    } else if (path != "/metrics") {
+        sendAll(client_fd, response("404 Not Found", "text/plain", "Not Found\n"));
+    } else {
+        std::string body = Metrics::getInstance().render();
+        std::string reply = response("200 OK", "text/plain; version=0.0.4; charset=utf-8",
+                                     body);
+        if (method == "HEAD") {
+            reply.resize(reply.size() - body.size());
+        }
+        sendAll(client_fd, reply);
+    }
+#else
+    (void)client_fd;
+#endif
+}
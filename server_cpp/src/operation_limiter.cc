@@ -0,0 +1,179 @@
+#include "operation_limiter.h"
+
+#include <algorithm>
+#include <utility>
+
+OperationLimiter::OperationLimiter(const std::string& name,
+                                   WorkStealingExecutor& executor,
+                                   size_t max_concurrent, size_t queue_depth)
+    : name_(name),
+      executor_(executor),
+      max_concurrent_(std::max<size_t>(1, max_concurrent)),
+      queue_depth_(queue_depth),
+      active_(0),
+      sequence_(0) {
+    for (auto& counter : dropped_) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+const char* OperationLimiter::dropReasonName(DropReason reason) {
+    switch (reason) {
+        case DropReason::DEADLINE: return "deadline";
+        case DropReason::CANCELLED: return "cancelled";
+        default: return "other";
+    }
+}
+
+bool OperationLimiter::shouldDrop(const std::shared_ptr<JobContext>& context,
+                                  DropReason& reason) {
+    if (!context) {
+        return false;
+    }
+    // Prazo vencido também cancela a chamada no gRPC: verificado primeiro
+    if (context->expired()) {
+        reason = DropReason::DEADLINE;
+        return true;
+    }
+    if (context->cancelled()) {
+        reason = DropReason::CANCELLED;
+        return true;
+    }
+    return false;
+}
+
+bool OperationLimiter::submit(Job job, std::shared_ptr<JobContext> context,
+                              DropHandler dropped, WorkStealingExecutor* executor) {
+    DroppedJobs dropped_jobs;
+    DropReason reason;
+    if (shouldDrop(context, reason)) {
+        dropped_jobs.emplace_back(Waiting{std::move(job), std::move(context),
+                                          std::move(dropped), executor}, reason);
+        notifyDropped(dropped_jobs);
+        return true;
+    }
+
+    bool run_now = false;
+    bool queued = false;
+    std::shared_ptr<JobContext> listener_context;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (active_ < max_concurrent_) {
+            ++active_;
+            run_now = true;
+        } else {
+            if (waiting_.size() >= queue_depth_) {
+                purgeLocked(dropped_jobs);
+            }
+            if (waiting_.size() < queue_depth_) {
+                listener_context = context;
+                int priority = context ? context->priority() : 0;
+                auto deadline = context ? context->deadline()
+                                        : JobContext::Clock::time_point::max();
+                waiting_.emplace(Key(-priority, deadline, sequence_++),
+                                 Waiting{std::move(job), std::move(context),
+                                         std::move(dropped), executor});
+                queued = true;
+            }
+        }
+    }
+
+    notifyDropped(dropped_jobs);
+    if (run_now) {
+        dispatch(std::move(job), std::move(context), executor);
+    } else if (queued && listener_context) {
+        // Fora do mutex: se a chamada já foi cancelada, o listener roda aqui
+        listener_context->addCancelListener(this, [this]() { purgeAbandoned(); });
+    }
+    return run_now || queued;
+}
+
+size_t OperationLimiter::active() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return active_;
+}
+
+size_t OperationLimiter::queued() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return waiting_.size();
+}
+
+void OperationLimiter::purgeLocked(DroppedJobs& dropped) {
+    for (auto it = waiting_.begin(); it != waiting_.end();) {
+        DropReason reason;
+        if (shouldDrop(it->second.context, reason)) {
+            dropped.emplace_back(std::move(it->second), reason);
+            it = waiting_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void OperationLimiter::purgeAbandoned() {
+    DroppedJobs dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        purgeLocked(dropped);
+    }
+    notifyDropped(dropped);
+}
+
+void OperationLimiter::notifyDropped(DroppedJobs& dropped) {
+    for (auto& entry : dropped) {
+        dropped_[static_cast<size_t>(entry.second)].fetch_add(1, std::memory_order_relaxed);
+        if (entry.first.dropped) {
+            try {
+                entry.first.dropped(entry.second);
+            } catch (...) {
+            }
+        }
+    }
+    dropped.clear();
+}
+
+void OperationLimiter::dispatch(Job job, std::shared_ptr<JobContext> context,
+                                WorkStealingExecutor* executor) {
+    WorkStealingExecutor& target = executor != nullptr ? *executor : executor_;
+    target.submit([this, job = std::move(job), context = std::move(context)]() {
+        {
+            JobContext::Scope scope(context.get());
+            try {
+                job();
+            } catch (...) {
+            }
+        }
+        onJobDone();
+    });
+}
+
+void OperationLimiter::onJobDone() {
+    DroppedJobs dropped;
+    Waiting next;
+    bool found = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // O slot passa direto para o próximo da fila que ainda vale a pena
+        while (!waiting_.empty()) {
+            auto it = waiting_.begin();
+            DropReason reason;
+            if (shouldDrop(it->second.context, reason)) {
+                dropped.emplace_back(std::move(it->second), reason);
+                waiting_.erase(it);
+                continue;
+            }
+            next = std::move(it->second);
+            waiting_.erase(it);
+            found = true;
+            break;
+        }
+        if (!found) {
+            --active_;
+        }
+    }
+
+    notifyDropped(dropped);
+    if (found) {
+        dispatch(std::move(next.job), std::move(next.context), next.executor);
+    }
+}
@@ -0,0 +1,278 @@
+#include "pdf_sharder.h"
+#include "file_processor_utils.h"
+#include "job_context.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+namespace {
+// Faixas menores que isso não compensam subir mais um processo
+const int kMinPagesPerShard = 16;
+
+// Estado compartilhado entre o job que dividiu o documento e as faixas
+// enfileiradas no executor (que podem rodar depois do retorno do job)
+struct ShardGroup {
+    std::function<bool(size_t, std::string&)> task;
+    std::unique_ptr<std::atomic<bool>[]> claimed;
+    std::vector<char> succeeded;
+    std::vector<std::string> errors;
+    std::mutex mutex;
+    std::condition_variable done_cv;
+    size_t remaining;
+};
+
+void runShard(ShardGroup& group, size_t index) {
+    // Cada faixa roda uma única vez: no executor ou no job que aguarda
+    if (group.claimed[index].exchange(true)) {
+        return;
+    }
+
+    std::string error;
+    bool ok = false;
+    try {
+        ok = group.task(index, error);
+    } catch (const std::exception& e) {
+        error = e.what();
+    } catch (...) {
+        error = "unknown exception";
+    }
+
+    std::lock_guard<std::mutex> lock(group.mutex);
+    group.succeeded[index] = ok ? 1 : 0;
+    group.errors[index] = error;
+    if (--group.remaining == 0) {
+        group.done_cv.notify_all();
+    }
+}
+
+std::string rangeText(const PdfSharder::PageRange& range) {
+    return std::to_string(range.first) + "-" + std::to_string(range.last);
+}
+}
+
+PdfSharder::PdfSharder(WorkStealingExecutor& executor, size_t min_pages,
+                       size_t max_shards)
+    : executor_(executor),
+      min_pages_(min_pages),
+      max_shards_(max_shards > 0 ? max_shards : executor.threadCount()) {}
+
+bool PdfSharder::worthCounting(size_t file_size) const {
+    return enabled() && file_size >= min_pages_ * kMinBytesPerPage;
+}
+
+int PdfSharder::countPages(const std::string& pdf_path) {
+    // qpdf só lê a tabela de páginas; pdfinfo também extrai os metadados
+    if (qpdfAvailable()) {
+        auto result = FileProcessorUtils::executeCommand({"qpdf", "--show-npages", pdf_path});
+        if (result.exit_code == 0 || result.exit_code == 3) {
+            return std::max(0, std::atoi(result.output.c_str()));
+        }
+    }
+
+    auto result = FileProcessorUtils::executeCommand({"pdfinfo", pdf_path});
+    if (result.exit_code != 0) {
+        return 0;
+    }
+
+    std::istringstream lines(result.output);
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (line.compare(0, 6, "Pages:") == 0) {
+            return std::max(0, std::atoi(line.c_str() + 6));
+        }
+    }
+    return 0;
+}
+
+std::vector<PdfSharder::PageRange> PdfSharder::planShards(int page_count) const {
+    if (!enabled() || page_count < static_cast<int>(min_pages_)) {
+        return {{1, std::max(page_count, 1)}};
+    }
+
+    size_t shards = std::min(max_shards_,
+                             static_cast<size_t>(page_count / kMinPagesPerShard));
+    return splitPages(page_count, std::max<size_t>(shards, 1));
+}
+
+std::vector<PdfSharder::PageRange> PdfSharder::splitPages(int page_count, size_t shards) {
+    std::vector<PageRange> ranges;
+    if (page_count <= 0 || shards == 0) {
+        return ranges;
+    }
+    shards = std::min(shards, static_cast<size_t>(page_count));
+
+    // As primeiras faixas recebem uma página a mais quando a divisão não é exata
+    int base = page_count / static_cast<int>(shards);
+    int extra = page_count % static_cast<int>(shards);
+    int first = 1;
+    for (size_t i = 0; i < shards; ++i) {
+        int length = base + (static_cast<int>(i) < extra ? 1 : 0);
+        ranges.push_back({first, first + length - 1});
+        first += length;
+    }
+    return ranges;
+}
+
+bool PdfSharder::runShards(size_t count, const ShardTask& task,
+                           std::string& error_message) {
+    auto group = std::make_shared<ShardGroup>();
+    group->task = task;
+    group->claimed.reset(new std::atomic<bool>[count]);
+    for (size_t i = 0; i < count; ++i) {
+        group->claimed[i].store(false);
+    }
+    group->succeeded.assign(count, 0);
+    group->errors.assign(count, std::string());
+    group->remaining = count;
+
+    // As faixas acompanham a chamada do job, que espera por todas aqui
+    JobContext* job = JobContext::current();
+    for (size_t i = 1; i < count; ++i) {
+        executor_.submit([group, i, job]() {
+            JobContext::Scope scope(job);
+            runShard(*group, i);
+        });
+    }
+
+    // Executar aqui as faixas que nenhum worker pegou ainda
+    for (size_t i = 0; i < count; ++i) {
+        runShard(*group, i);
+    }
+
+    std::unique_lock<std::mutex> lock(group->mutex);
+    group->done_cv.wait(lock, [&group] { return group->remaining == 0; });
+
+    for (size_t i = 0; i < count; ++i) {
+        if (!group->succeeded[i]) {
+            error_message = group->errors[i];
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PdfSharder::compress(const std::string& input_path, const std::string& output_path,
+                          const std::vector<PageRange>& ranges,
+                          std::string& error_message) {
+    const std::string base = FileProcessorUtils::generateTempFileName("shard", "");
+    std::vector<std::string> parts;
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        parts.push_back(base + "_" + std::to_string(i) + ".pdf");
+    }
+
+    bool ok = runShards(ranges.size(), [&](size_t index, std::string& error) {
+        auto result = FileProcessorUtils::executeCommand({
+            "gs", "-sDEVICE=pdfwrite", "-dCompatibilityLevel=1.4",
+            "-dPDFSETTINGS=/ebook", "-dNOPAUSE", "-dQUIET", "-dBATCH",
+            "-dFirstPage=" + std::to_string(ranges[index].first),
+            "-dLastPage=" + std::to_string(ranges[index].last),
+            "-sOutputFile=" + parts[index], input_path});
+        if (result.exit_code != 0) {
+            error = "Ghostscript failed on pages " + rangeText(ranges[index]) +
+                    " with code " + std::to_string(result.exit_code) + ": " +
+                    result.diagnostics();
+            return false;
+        }
+        return true;
+    }, error_message);
+
+    if (ok) {
+        ok = mergePdfs(parts, output_path, error_message);
+    }
+
+    for (const std::string& part : parts) {
+        FileProcessorUtils::cleanupFile(part);
+    }
+    return ok;
+}
+
+bool PdfSharder::mergePdfs(const std::vector<std::string>& parts,
+                           const std::string& output_path,
+                           std::string& error_message) {
+    // qpdf só copia os objetos; o gs redestila as páginas já comprimidas.
+    // A primeira faixa é o documento base do qpdf, então metadados, sumário
+    // e links dela são mantidos (os das outras faixas se perdem)
+    std::vector<std::string> command;
+    if (qpdfAvailable()) {
+        command = {"qpdf", parts.front(), "--pages"};
+        command.insert(command.end(), parts.begin(), parts.end());
+        command.push_back("--");
+        command.push_back(output_path);
+    } else {
+        command = {"gs", "-sDEVICE=pdfwrite", "-dCompatibilityLevel=1.4",
+                   "-dPDFSETTINGS=/ebook", "-dNOPAUSE", "-dQUIET", "-dBATCH",
+                   "-sOutputFile=" + output_path};
+        command.insert(command.end(), parts.begin(), parts.end());
+    }
+
+    // qpdf retorna 3 quando só emitiu avisos (arquivo gerado)
+    auto result = FileProcessorUtils::executeCommand(command);
+    if (result.exit_code != 0 && !(result.exit_code == 3 && qpdfAvailable())) {
+        error_message = "Failed to merge PDF shards (code " +
+                        std::to_string(result.exit_code) + "): " + result.diagnostics();
+        return false;
+    }
+    return true;
+}
+
+bool PdfSharder::extractText(const std::string& input_path,
+                             const std::string& output_path,
+                             const std::vector<PageRange>& ranges,
+                             std::string& error_message) {
+    const std::string base = FileProcessorUtils::generateTempFileName("shard", "");
+    std::vector<std::string> parts;
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        parts.push_back(base + "_" + std::to_string(i) + ".txt");
+    }
+
+    bool ok = runShards(ranges.size(), [&](size_t index, std::string& error) {
+        auto result = FileProcessorUtils::executeCommand({
+            "pdftotext", "-f", std::to_string(ranges[index].first),
+            "-l", std::to_string(ranges[index].last), input_path, parts[index]});
+        if (result.exit_code != 0) {
+            error = "pdftotext failed on pages " + rangeText(ranges[index]) +
+                    " with code " + std::to_string(result.exit_code) + ": " +
+                    result.diagnostics();
+            return false;
+        }
+        return true;
+    }, error_message);
+
+    // Cada faixa termina com form feed de página, então basta concatenar
+    if (ok) {
+        std::ofstream output(output_path, std::ios::binary | std::ios::trunc);
+        for (const std::string& part : parts) {
+            std::ifstream input(part, std::ios::binary);
+            if (!input.is_open()) {
+                error_message = "Text shard was not created: " + part;
+                ok = false;
+                break;
+            }
+            // Faixa sem texto gera arquivo vazio (e << falharia)
+            if (input.peek() != std::ifstream::traits_type::eof()) {
+                output << input.rdbuf();
+            }
+        }
+        if (ok && !output.good()) {
+            error_message = "Failed to write merged text";
+            ok = false;
+        }
+    }
+
+    for (const std::string& part : parts) {
+        FileProcessorUtils::cleanupFile(part);
+    }
+    return ok;
+}
+
+bool PdfSharder::qpdfAvailable() {
+    static const bool available =
+        FileProcessorUtils::executeCommand({"qpdf", "--version"}).exit_code == 0;
+    return available;
+}
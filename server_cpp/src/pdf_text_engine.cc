@@ -0,0 +1,335 @@
+#include "pdf_text_engine.h"
+#include "job_context.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#ifdef FP_HAVE_POPPLER_CPP
+#include <poppler-document.h>
+#include <poppler-global.h>
+#include <poppler-page.h>
+#include <poppler-version.h>
+#endif
+
+namespace {
+// Cada participante a mais abre (e analisa) o documento de novo
+const int kMinPagesPerWorker = 4;
+// Páginas extraídas à frente da próxima a ser entregue, por participante
+const size_t kPagesAheadPerWorker = 4;
+// Espera máxima sem conferir se a chamada foi abandonada
+const auto kAbandonPollInterval = std::chrono::milliseconds(100);
+
+#ifdef FP_HAVE_POPPLER_CPP
+// Ordem de leitura do pdftotext sem -layout (disponível a partir do 0.88)
+#if POPPLER_VERSION_MAJOR > 0 || POPPLER_VERSION_MINOR >= 88
+const poppler::page::text_layout_enum kTextLayout =
+    poppler::page::non_raw_non_physical_layout;
+#else
+const poppler::page::text_layout_enum kTextLayout = poppler::page::raw_order_layout;
+#endif
+
+// Avisos do poppler sobre PDFs malformados iriam para o stderr a cada página
+void ignorePopplerMessage(const std::string&, void*) {}
+#endif
+
+// Leitor padrão (poppler-cpp)
+class PopplerPageReader : public PdfTextEngine::PageReader {
+public:
+    bool open(const char* data, size_t size, const std::string& path,
+              std::string& error_message) override {
+#ifdef FP_HAVE_POPPLER_CPP
+        static std::once_flag silence_once;
+        std::call_once(silence_once, []() {
+            poppler::set_debug_error_function(ignorePopplerMessage, nullptr);
+        });
+
+        if (data != nullptr) {
+            if (size > static_cast<size_t>(INT_MAX)) {
+                error_message = "PDF too large to load from memory";
+                return false;
+            }
+            document_.reset(poppler::document::load_from_raw_data(
+                data, static_cast<int>(size)));
+        } else {
+            document_.reset(poppler::document::load_from_file(path));
+        }
+        if (!document_) {
+            error_message = "Failed to parse PDF";
+            return false;
+        }
+        if (document_->is_locked()) {
+            error_message = "PDF is encrypted";
+            return false;
+        }
+        return true;
+#else
+        (void)data;
+        (void)size;
+        (void)path;
+        error_message = "Built without poppler-cpp";
+        return false;
+#endif
+    }
+
+    int pageCount() const override {
+#ifdef FP_HAVE_POPPLER_CPP
+        return document_ ? document_->pages() : 0;
+#else
+        return 0;
+#endif
+    }
+
+    bool pageText(int index, std::string& text, std::string& error_message) override {
+#ifdef FP_HAVE_POPPLER_CPP
+        std::unique_ptr<poppler::page> page(document_->create_page(index));
+        if (!page) {
+            error_message = "Failed to read page " + std::to_string(index + 1);
+            return false;
+        }
+        poppler::byte_array utf8 = page->text(poppler::rectf(), kTextLayout).to_utf8();
+        text.assign(utf8.begin(), utf8.end());
+        text += '\f';
+        return true;
+#else
+        (void)index;
+        (void)text;
+        error_message = "Built without poppler-cpp";
+        return false;
+#endif
+    }
+
+private:
+#ifdef FP_HAVE_POPPLER_CPP
+    std::unique_ptr<poppler::document> document_;
+#endif
+};
+
+// Estado compartilhado entre o job que entrega as páginas e os
+// participantes no executor (que podem começar depois do retorno do job)
+struct ExtractionGroup {
+    PdfTextEngine::ReaderFactory reader_factory;
+    const char* data = nullptr;
+    size_t size = 0;
+    std::string path;
+    int page_count = 0;
+    int window = 0;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    int next_claim = 0;
+    int next_emit = 0;
+    std::vector<std::string> texts;
+    std::vector<char> ready;
+    std::string error;
+    bool stopped = false;
+    // Participantes com o documento aberto (referenciam data)
+    size_t active = 0;
+
+    // Próxima página livre dentro da janela; -1 se não há (com o mutex)
+    int claim() {
+        if (stopped || next_claim >= page_count || next_claim >= next_emit + window) {
+            return -1;
+        }
+        return next_claim++;
+    }
+
+    // Registrar o resultado de uma página (com o mutex)
+    void complete(int page, bool ok, std::string& text, const std::string& page_error) {
+        if (!ok) {
+            if (error.empty()) {
+                error = page_error;
+            }
+            stopped = true;
+        } else {
+            texts[page] = std::move(text);
+            ready[page] = 1;
+        }
+        cv.notify_all();
+    }
+};
+
+void runWorker(ExtractionGroup& group) {
+    {
+        std::lock_guard<std::mutex> lock(group.mutex);
+        if (group.stopped || group.next_claim >= group.page_count) {
+            return;
+        }
+        ++group.active;
+    }
+
+    {
+        // Documento próprio; sem ele as páginas ficam para os demais
+        JobContext* job = JobContext::current();
+        std::unique_ptr<PdfTextEngine::PageReader> reader = group.reader_factory();
+        std::string error;
+        if (reader->open(group.data, group.size, group.path, error)) {
+            std::unique_lock<std::mutex> lock(group.mutex);
+            while (true) {
+                // Chamada abandonada: o job que entrega também desiste
+                if (job != nullptr && job->abandoned()) {
+                    break;
+                }
+                int page = group.claim();
+                if (page < 0) {
+                    if (group.stopped || group.next_claim >= group.page_count) {
+                        break;
+                    }
+                    // Janela cheia: esperar a entrega avançar
+                    group.cv.wait_for(lock, kAbandonPollInterval);
+                    continue;
+                }
+                lock.unlock();
+                std::string text;
+                bool ok = false;
+                try {
+                    ok = reader->pageText(page, text, error);
+                } catch (const std::exception& e) {
+                    error = e.what();
+                }
+                lock.lock();
+                group.complete(page, ok, text, error);
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(group.mutex);
+    --group.active;
+    group.cv.notify_all();
+}
+}
+
+PdfTextEngine::PdfTextEngine(WorkStealingExecutor& executor, size_t max_workers,
+                             ReaderFactory reader_factory)
+    : executor_(executor),
+      max_workers_(max_workers > 0 ? max_workers : executor.threadCount()),
+      reader_factory_(std::move(reader_factory)) {
+    if (!reader_factory_) {
+        reader_factory_ = []() { return std::make_unique<PopplerPageReader>(); };
+    }
+}
+
+bool PdfTextEngine::isAvailable() {
+#ifdef FP_HAVE_POPPLER_CPP
+    return true;
+#else
+    return false;
+#endif
+}
+
+size_t PdfTextEngine::workersFor(int page_count) const {
+    size_t by_pages = static_cast<size_t>(std::max(page_count / kMinPagesPerWorker, 1));
+    return std::max<size_t>(1, std::min(max_workers_, by_pages));
+}
+
+bool PdfTextEngine::extract(const char* data, size_t size, const PageSink& sink,
+                            int& page_count, std::string& error_message) {
+    Input input;
+    input.data = data;
+    input.size = size;
+    return run(input, sink, page_count, error_message);
+}
+
+bool PdfTextEngine::extractFile(const std::string& path, const PageSink& sink,
+                                int& page_count, std::string& error_message) {
+    Input input;
+    input.path = path;
+    return run(input, sink, page_count, error_message);
+}
+
+bool PdfTextEngine::run(const Input& input, const PageSink& sink, int& page_count,
+                        std::string& error_message) {
+    page_count = 0;
+    std::unique_ptr<PageReader> reader = reader_factory_();
+    if (!reader->open(input.data, input.size, input.path, error_message)) {
+        return false;
+    }
+    page_count = reader->pageCount();
+
+    const size_t workers = workersFor(page_count);
+    auto group = std::make_shared<ExtractionGroup>();
+    group->reader_factory = reader_factory_;
+    group->data = input.data;
+    group->size = input.size;
+    group->path = input.path;
+    group->page_count = page_count;
+    group->window = static_cast<int>(workers * kPagesAheadPerWorker);
+    group->texts.resize(static_cast<size_t>(page_count));
+    group->ready.assign(static_cast<size_t>(page_count), 0);
+
+    // Os participantes acompanham a chamada do job
+    JobContext* job = JobContext::current();
+    for (size_t i = 1; i < workers; ++i) {
+        executor_.submit([group, job]() {
+            JobContext::Scope scope(job);
+            runWorker(*group);
+        });
+    }
+
+    bool ok = true;
+    std::unique_lock<std::mutex> lock(group->mutex);
+    while (group->next_emit < page_count) {
+        if (job != nullptr && job->abandoned()) {
+            error_message = "Text extraction interrupted: request cancelled or deadline exceeded";
+            ok = false;
+            break;
+        }
+        if (!group->error.empty()) {
+            error_message = group->error;
+            ok = false;
+            break;
+        }
+
+        // Próxima página pronta: entregar fora do mutex
+        const int page = group->next_emit;
+        if (group->ready[page]) {
+            std::string text = std::move(group->texts[page]);
+            group->texts[page] = std::string();
+            ++group->next_emit;
+            bool more_ready = group->next_emit < page_count && group->ready[group->next_emit];
+            group->cv.notify_all();
+            lock.unlock();
+            bool delivered = sink(text, more_ready, error_message);
+            lock.lock();
+            if (!delivered) {
+                ok = false;
+                break;
+            }
+            continue;
+        }
+
+        // Senão, extrair aqui a próxima página livre (a que falta, se
+        // nenhum worker começou) em vez de só esperar
+        int claimed = group->claim();
+        if (claimed >= 0) {
+            lock.unlock();
+            std::string text;
+            std::string page_error;
+            bool page_ok = false;
+            try {
+                page_ok = reader->pageText(claimed, text, page_error);
+            } catch (const std::exception& e) {
+                page_error = e.what();
+            }
+            lock.lock();
+            group->complete(claimed, page_ok, text, page_error);
+            continue;
+        }
+
+        // Página em extração por outro participante; o cancelamento não
+        // gera notificação, então a espera é limitada
+        group->cv.wait_for(lock, kAbandonPollInterval);
+    }
+
+    // Participantes ainda com o documento aberto usam data: esperar por eles
+    group->stopped = true;
+    group->cv.notify_all();
+    group->cv.wait(lock, [&group] { return group->active == 0; });
+    return ok;
+}
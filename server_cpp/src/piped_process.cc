@@ -0,0 +1,334 @@
+#include "piped_process.h"
+#include "job_context.h"
+#include "process_runner.h"
+
+#include <algorithm>
+#include <chrono>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#endif
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+PipedProcess::PipedProcess()
+    :
+#ifndef _WIN32
+      pid_(-1),
+#endif
+      stdin_fd_(-1),
+      stdout_fd_(-1),
+      stderr_fd_(-1),
+      waited_(false),
+      exit_code_(-1),
+      interrupted_(false),
+      input_nonblocking_(false) {}
+
+PipedProcess::~PipedProcess() {
+#ifndef _WIN32
+    if (pid_ > 0 && !waited_) {
+        kill();
+        wait();
+    }
+#endif
+    ProcessRunner::closeFd(stdin_fd_);
+    ProcessRunner::closeFd(stdout_fd_);
+    ProcessRunner::closeFd(stderr_fd_);
+}
+
+bool PipedProcess::isSupported() {
+#ifdef _WIN32
+    return false;
+#else
+    return true;
+#endif
+}
+
+#ifndef _WIN32
+namespace {
+
+// Arquivo anônimo para o stderr: memfd no Linux, tmpfile() nos demais
+int createErrorSink() {
+#ifdef __linux__
+    int memfd = memfd_create("piped_process_stderr", MFD_CLOEXEC);
+    if (memfd >= 0) {
+        return memfd;
+    }
+#endif
+    FILE* file = tmpfile();
+    if (file == nullptr) {
+        return -1;
+    }
+    int fd = dup(fileno(file));
+    fclose(file);
+    if (fd >= 0) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    return fd;
+}
+
+} // namespace
+#endif
+
+bool PipedProcess::start(const std::vector<std::string>& argv,
+                         std::string& error_message) {
+#ifdef _WIN32
+    (void)argv;
+    error_message = "Piped processes are not supported on this platform";
+    return false;
+#else
+    if (argv.empty()) {
+        error_message = "Empty command";
+        return false;
+    }
+
+    int stdin_pipe[2];
+    int stdout_pipe[2];
+    if (!ProcessRunner::makePipe(stdin_pipe)) {
+        error_message = std::string("pipe failed: ") + std::strerror(errno);
+        return false;
+    }
+    if (!ProcessRunner::makePipe(stdout_pipe)) {
+        error_message = std::string("pipe failed: ") + std::strerror(errno);
+        close(stdin_pipe[0]);
+        close(stdin_pipe[1]);
+        return false;
+    }
+    stderr_fd_ = createErrorSink();
+
+    // Só o limite de memória: o de CPU é acumulado e encerraria os
+    // processos de vida longa (workers do pool Ghostscript)
+    ProcessRunner::Limits limits;
+    limits.memory_bytes = ProcessRunner::defaultLimits().memory_bytes;
+    bool started = ProcessRunner::spawn(argv, stdin_pipe[0], stdout_pipe[1], stderr_fd_,
+                                        limits, pid_, error_message);
+    close(stdin_pipe[0]);
+    close(stdout_pipe[1]);
+    if (!started) {
+        pid_ = -1;
+        close(stdin_pipe[1]);
+        close(stdout_pipe[0]);
+        return false;
+    }
+    stdin_fd_ = stdin_pipe[1];
+    stdout_fd_ = stdout_pipe[0];
+    return true;
+#endif
+}
+
+bool PipedProcess::writeInput(const char* data, size_t size) {
+#ifdef _WIN32
+    (void)data;
+    (void)size;
+    return false;
+#else
+    // Requer SIGPIPE ignorado: processo que fecha o stdin resulta em EPIPE
+    size_t written = 0;
+    while (written < size) {
+        ssize_t result = write(stdin_fd_, data + written, size - written);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        written += static_cast<size_t>(result);
+    }
+    return true;
+#endif
+}
+
+long PipedProcess::writeInputAvailable(const char* data, size_t size) {
+#ifdef _WIN32
+    (void)data;
+    (void)size;
+    return -1;
+#else
+    if (stdin_fd_ < 0) {
+        return -1;
+    }
+    if (!input_nonblocking_) {
+        fcntl(stdin_fd_, F_SETFL, fcntl(stdin_fd_, F_GETFL) | O_NONBLOCK);
+        input_nonblocking_ = true;
+    }
+    while (true) {
+        ssize_t result = write(stdin_fd_, data, size);
+        if (result >= 0) {
+            return static_cast<long>(result);
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        }
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+#endif
+}
+
+void PipedProcess::closeInput() {
+    ProcessRunner::closeFd(stdin_fd_);
+}
+
+long PipedProcess::readOutput(char* buffer, size_t size) {
+#ifdef _WIN32
+    (void)buffer;
+    (void)size;
+    return -1;
+#else
+    if (!waitForOutput()) {
+        return -1;
+    }
+    while (true) {
+        ssize_t result = read(stdout_fd_, buffer, size);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        return static_cast<long>(result);
+    }
+#endif
+}
+
+int PipedProcess::wait() {
+#ifndef _WIN32
+    if (pid_ <= 0 || waited_) {
+        return exit_code_;
+    }
+
+    int status = 0;
+    while (waitpid(pid_, &status, 0) < 0) {
+        if (errno != EINTR) {
+            waited_ = true;
+            return exit_code_;
+        }
+    }
+
+    waited_ = true;
+    exit_code_ = ProcessRunner::exitCodeFromStatus(status);
+#endif
+    return exit_code_;
+}
+
+void PipedProcess::kill() {
+#ifndef _WIN32
+    signalGroup(SIGKILL);
+#endif
+}
+
+void PipedProcess::signalGroup(int signal) {
+#ifndef _WIN32
+    if (pid_ > 0 && !waited_) {
+        ProcessRunner::signalGroup(pid_, signal);
+    }
+#else
+    (void)signal;
+#endif
+}
+
+bool PipedProcess::stopIfAbandoned() {
+    JobContext* job = JobContext::current();
+    if (job == nullptr || !job->abandoned()) {
+        return false;
+    }
+    interrupt();
+    return true;
+}
+
+bool PipedProcess::waitForOutput() {
+#ifndef _WIN32
+    JobContext* job = JobContext::current();
+    if (job == nullptr) {
+        return true;
+    }
+
+    // O cancelamento não acorda o poll: a chamada é conferida a cada intervalo
+    struct pollfd fd = {stdout_fd_, POLLIN, 0};
+    while (true) {
+        if (job->abandoned()) {
+            interrupt();
+            return false;
+        }
+        int result = poll(&fd, 1, ProcessRunner::kPollIntervalMs);
+        // Dados, fim da saída ou erro: read() decide
+        if (result > 0 || (result < 0 && errno != EINTR)) {
+            return true;
+        }
+    }
+#else
+    return true;
+#endif
+}
+
+void PipedProcess::interrupt() {
+#ifndef _WIN32
+    if (pid_ <= 0 || waited_ || interrupted_) {
+        return;
+    }
+    interrupted_ = true;
+    ProcessRunner::countInterrupted();
+
+    JobContext* job = JobContext::current();
+    auto deadline = std::chrono::steady_clock::now() +
+                    (job != nullptr ? job->killGrace() : std::chrono::milliseconds(0));
+    signalGroup(SIGTERM);
+
+    // Descartar a saída (o processo não pode travar com o pipe cheio) até
+    // ele terminar; passado o prazo, SIGKILL
+    char buffer[4096];
+    bool output_closed = false;
+    while (true) {
+        int status = 0;
+        if (output_closed && waitpid(pid_, &status, WNOHANG) == pid_) {
+            waited_ = true;
+            exit_code_ = ProcessRunner::exitCodeFromStatus(status);
+            return;
+        }
+
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) {
+            signalGroup(SIGKILL);
+            return;
+        }
+
+        if (output_closed) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(
+                std::min<long long>(remaining, 10)));
+            continue;
+        }
+        struct pollfd fd = {stdout_fd_, POLLIN, 0};
+        int wait_ms = static_cast<int>(
+            std::min<long long>(remaining, ProcessRunner::kPollIntervalMs));
+        if (poll(&fd, 1, wait_ms) > 0) {
+            ssize_t length = read(stdout_fd_, buffer, sizeof(buffer));
+            output_closed = length == 0 || (length < 0 && errno != EINTR);
+        }
+    }
+#endif
+}
+
+std::string PipedProcess::errorOutput(size_t max_size) const {
+    std::string output;
+#ifndef _WIN32
+    if (stderr_fd_ < 0) {
+        return output;
+    }
+
+    output.resize(max_size);
+    ssize_t result = pread(stderr_fd_, &output[0], max_size, 0);
+    output.resize(result > 0 ? static_cast<size_t>(result) : 0);
+#else
+    (void)max_size;
+#endif
+    return output;
+}
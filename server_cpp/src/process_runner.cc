@@ -0,0 +1,400 @@
+#include "process_runner.h"
+#include "chunk_buffer_pool.h"
+#include "job_context.h"
+
+#include <algorithm>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+extern char** environ;
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Bloco de leitura das saídas (o popen antigo lia linhas de até 128 bytes)
+const size_t kReadBufferSize = 64 * 1024;
+
+std::mutex& defaultLimitsMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+ProcessRunner::Limits& defaultLimitsSlot() {
+    static ProcessRunner::Limits limits;
+    return limits;
+}
+
+#ifndef _WIN32
+bool hasResourceLimits(const ProcessRunner::Limits& limits) {
+    return limits.cpu_seconds > 0 || limits.memory_bytes > 0;
+}
+
+// No filho (antes do exec) ou, no Linux, no processo já iniciado
+bool applyResourceLimits(pid_t pid, const ProcessRunner::Limits& limits) {
+    struct rlimit cpu = {static_cast<rlim_t>(limits.cpu_seconds),
+                         static_cast<rlim_t>(limits.cpu_seconds + 1)};
+    struct rlimit memory = {static_cast<rlim_t>(limits.memory_bytes),
+                            static_cast<rlim_t>(limits.memory_bytes)};
+    bool ok = true;
+#ifdef __linux__
+    if (limits.cpu_seconds > 0) {
+        ok = prlimit(pid, RLIMIT_CPU, &cpu, nullptr) == 0 && ok;
+    }
+    if (limits.memory_bytes > 0) {
+        ok = prlimit(pid, RLIMIT_AS, &memory, nullptr) == 0 && ok;
+    }
+#else
+    (void)pid;
+    if (limits.cpu_seconds > 0) {
+        ok = setrlimit(RLIMIT_CPU, &cpu) == 0 && ok;
+    }
+    if (limits.memory_bytes > 0) {
+        ok = setrlimit(RLIMIT_AS, &memory) == 0 && ok;
+    }
+#endif
+    return ok;
+}
+
+int remainingMs(Clock::time_point until, Clock::time_point now) {
+    if (until == Clock::time_point::max()) {
+        return -1;
+    }
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(until - now).count();
+    return static_cast<int>(std::min<long long>(std::max<long long>(remaining, 0), INT32_MAX));
+}
+#endif
+
+} // namespace
+
+ProcessRunner::ProcessRunner()
+    :
+#ifndef _WIN32
+      pid_(-1),
+#endif
+      kill_requested_(false) {}
+
+bool ProcessRunner::isSupported() {
+#ifdef _WIN32
+    return false;
+#else
+    return true;
+#endif
+}
+
+void ProcessRunner::setDefaultLimits(const Limits& limits) {
+    std::lock_guard<std::mutex> lock(defaultLimitsMutex());
+    defaultLimitsSlot() = limits;
+}
+
+ProcessRunner::Limits ProcessRunner::defaultLimits() {
+    std::lock_guard<std::mutex> lock(defaultLimitsMutex());
+    return defaultLimitsSlot();
+}
+
+void ProcessRunner::kill() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    kill_requested_ = true;
+#ifndef _WIN32
+    if (pid_ > 0) {
+        signalGroup(pid_, SIGKILL);
+    }
+#endif
+}
+
+void ProcessRunner::closeFd(int& fd) {
+#ifndef _WIN32
+    if (fd >= 0) {
+        close(fd);
+    }
+#endif
+    fd = -1;
+}
+
+#ifndef _WIN32
+bool ProcessRunner::makePipe(int fds[2]) {
+#ifdef __linux__
+    // Atômico: um spawn em outra thread não herda as pontas do pipe
+    return pipe2(fds, O_CLOEXEC) == 0;
+#else
+    if (pipe(fds) != 0) {
+        return false;
+    }
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return true;
+#endif
+}
+
+int ProcessRunner::exitCodeFromStatus(int status) {
+    if (WIFEXITED(status)) {
+        return WEXITSTATUS(status);
+    }
+    if (WIFSIGNALED(status)) {
+        return 128 + WTERMSIG(status);
+    }
+    return -1;
+}
+
+void ProcessRunner::signalGroup(pid_t pid, int signal) {
+    if (::kill(-pid, signal) != 0) {
+        ::kill(pid, signal);
+    }
+}
+
+bool ProcessRunner::spawn(const std::vector<std::string>& argv,
+                          int stdin_fd, int stdout_fd, int stderr_fd,
+                          const Limits& limits, pid_t& pid,
+                          std::string& error_message) {
+    if (argv.empty()) {
+        error_message = "Empty command";
+        return false;
+    }
+
+    std::vector<char*> args;
+    for (const std::string& arg : argv) {
+        args.push_back(const_cast<char*>(arg.c_str()));
+    }
+    args.push_back(nullptr);
+
+#ifndef __linux__
+    // Sem prlimit, os limites só podem ser aplicados no filho, antes do exec
+    if (hasResourceLimits(limits)) {
+        pid = fork();
+        if (pid < 0) {
+            error_message = std::string("fork failed: ") + std::strerror(errno);
+            return false;
+        }
+        if (pid == 0) {
+            setpgid(0, 0);
+            int null_fd = open("/dev/null", O_RDWR);
+            dup2(stdin_fd >= 0 ? stdin_fd : null_fd, STDIN_FILENO);
+            dup2(stdout_fd >= 0 ? stdout_fd : null_fd, STDOUT_FILENO);
+            dup2(stderr_fd >= 0 ? stderr_fd : null_fd, STDERR_FILENO);
+            applyResourceLimits(0, limits);
+            // Como no posix_spawn: sem a máscara de sinais do servidor
+            sigset_t signals;
+            sigemptyset(&signals);
+            sigprocmask(SIG_SETMASK, &signals, nullptr);
+            signal(SIGPIPE, SIG_DFL);
+            execvp(args[0], args.data());
+            _exit(127);
+        }
+        setpgid(pid, pid);
+        counters().spawned.fetch_add(1);
+        return true;
+    }
+#endif
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    const int fds[3] = {stdin_fd, stdout_fd, stderr_fd};
+    for (int target = 0; target < 3; ++target) {
+        if (fds[target] >= 0) {
+            posix_spawn_file_actions_adddup2(&actions, fds[target], target);
+        } else {
+            posix_spawn_file_actions_addopen(&actions, target, "/dev/null",
+                                             target == 0 ? O_RDONLY : O_WRONLY, 0);
+        }
+    }
+
+    // Grupo próprio (sinais alcançam os filhos da ferramenta), sem a máscara
+    // de sinais da thread e sem herdar o SIGPIPE ignorado pelo servidor
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP |
+                                          POSIX_SPAWN_SETSIGMASK |
+                                          POSIX_SPAWN_SETSIGDEF);
+    posix_spawnattr_setpgroup(&attributes, 0);
+    sigset_t signals;
+    sigemptyset(&signals);
+    posix_spawnattr_setsigmask(&attributes, &signals);
+    sigaddset(&signals, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attributes, &signals);
+
+    int result = posix_spawnp(&pid, args[0], &actions, &attributes, args.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attributes);
+    if (result != 0) {
+        error_message = "Failed to start " + argv[0] + ": " + std::strerror(result);
+        return false;
+    }
+    counters().spawned.fetch_add(1);
+
+#ifdef __linux__
+    // Aplicados logo após o exec: a janela até aqui é só a carga do binário
+    if (hasResourceLimits(limits)) {
+        applyResourceLimits(pid, limits);
+    }
+#endif
+    return true;
+}
+#endif
+
+ProcessRunner::Result ProcessRunner::run(const std::vector<std::string>& argv) {
+    return run(argv, defaultLimits());
+}
+
+ProcessRunner::Result ProcessRunner::run(const std::vector<std::string>& argv,
+                                         const Limits& limits) {
+    Result result;
+#ifdef _WIN32
+    (void)argv;
+    (void)limits;
+    result.error = "Process runner is not supported on this platform";
+    return result;
+#else
+    int stdout_pipe[2];
+    int stderr_pipe[2];
+    if (!makePipe(stdout_pipe)) {
+        result.error = std::string("pipe failed: ") + std::strerror(errno);
+        return result;
+    }
+    if (!makePipe(stderr_pipe)) {
+        result.error = std::string("pipe failed: ") + std::strerror(errno);
+        close(stdout_pipe[0]);
+        close(stdout_pipe[1]);
+        return result;
+    }
+
+    pid_t pid = -1;
+    bool started = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (kill_requested_) {
+            result.killed = true;
+            result.error = "Command killed";
+        } else {
+            started = spawn(argv, -1, stdout_pipe[1], stderr_pipe[1], limits, pid,
+                            result.error);
+            pid_ = started ? pid : -1;
+        }
+    }
+    close(stdout_pipe[1]);
+    close(stderr_pipe[1]);
+    if (!started) {
+        close(stdout_pipe[0]);
+        close(stderr_pipe[0]);
+        return result;
+    }
+
+    JobContext* job = JobContext::current();
+    const Clock::time_point no_deadline = Clock::time_point::max();
+    const Clock::time_point timeout_at = limits.timeout.count() > 0
+        ? Clock::now() + limits.timeout : no_deadline;
+    Clock::time_point kill_at = no_deadline;
+    bool terminating = false;
+
+    struct pollfd fds[2] = {{stdout_pipe[0], POLLIN, 0}, {stderr_pipe[0], POLLIN, 0}};
+    std::string* sinks[2] = {&result.output, &result.error_output};
+    ChunkBufferPool::Buffer buffer = ChunkBufferPool::getInstance().acquire(kReadBufferSize);
+
+    while (true) {
+        Clock::time_point now = Clock::now();
+        if (!terminating) {
+            std::chrono::milliseconds grace = job != nullptr ? job->killGrace()
+                                                             : limits.kill_grace;
+            if (job != nullptr && job->abandoned()) {
+                result.interrupted = true;
+            } else if (now >= timeout_at) {
+                result.timed_out = true;
+            }
+            // SIGTERM primeiro: a ferramenta pode limpar seus temporários
+            if (result.interrupted || result.timed_out) {
+                terminating = true;
+                signalGroup(pid, SIGTERM);
+                kill_at = now + grace;
+            }
+        }
+        if (terminating && kill_at != no_deadline && now >= kill_at) {
+            signalGroup(pid, SIGKILL);
+            kill_at = no_deadline;
+            // Um neto fora do grupo poderia manter os pipes abertos
+            closeFd(fds[0].fd);
+            closeFd(fds[1].fd);
+        }
+
+        int wait_ms = remainingMs(terminating ? kill_at : timeout_at, now);
+        if (job != nullptr && !terminating) {
+            wait_ms = wait_ms < 0 ? kPollIntervalMs : std::min(wait_ms, kPollIntervalMs);
+        }
+
+        if (fds[0].fd >= 0 || fds[1].fd >= 0) {
+            // fds negativos são ignorados pelo poll
+            int ready = poll(fds, 2, wait_ms);
+            if (ready < 0 && errno != EINTR) {
+                closeFd(fds[0].fd);
+                closeFd(fds[1].fd);
+            }
+            for (int i = 0; ready > 0 && i < 2; ++i) {
+                if (fds[i].fd < 0 || fds[i].revents == 0) {
+                    continue;
+                }
+                ssize_t length = read(fds[i].fd, buffer.data(), buffer.size());
+                if (length > 0) {
+                    std::string& sink = *sinks[i];
+                    size_t room = limits.max_output_bytes > sink.size()
+                        ? limits.max_output_bytes - sink.size() : 0;
+                    size_t kept = std::min(room, static_cast<size_t>(length));
+                    sink.append(buffer.data(), kept);
+                    result.truncated = result.truncated || kept < static_cast<size_t>(length);
+                } else if (length == 0 || (errno != EINTR && errno != EAGAIN)) {
+                    closeFd(fds[i].fd);
+                }
+            }
+            continue;
+        }
+
+        // Saídas fechadas: aguardar o término sem colher o processo, para
+        // que kill() não sinalize um pid já reaproveitado
+        siginfo_t info;
+        std::memset(&info, 0, sizeof(info));
+        if (wait_ms < 0) {
+            while (waitid(P_PID, pid, &info, WEXITED | WNOWAIT) != 0 && errno == EINTR) {
+            }
+            break;
+        }
+        if (waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) != 0 ||
+            info.si_pid == pid) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(std::min(wait_ms, 10)));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pid_ = -1;
+        result.killed = kill_requested_;
+    }
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    result.exit_code = exitCodeFromStatus(status);
+
+    if (result.interrupted) {
+        countInterrupted();
+        result.exit_code = -1;
+        result.error = "Command interrupted: request cancelled or deadline exceeded";
+    } else if (result.timed_out) {
+        counters().timed_out.fetch_add(1);
+        result.exit_code = -1;
+        result.error = "Command timed out after " +
+                       std::to_string(limits.timeout.count()) + "ms";
+    } else if (result.killed) {
+        result.exit_code = -1;
+        result.error = "Command killed";
+    }
+    return result;
+#endif
+}
@@ -0,0 +1,265 @@
+#include "result_cache.h"
+#include "content_hash.h"
+#include "server_config.h"
+#include "transfer_buffer.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+ResultCache& ResultCache::getInstance() {
+    static ResultCache instance(ServerConfig::getInstance().cache_memory_bytes,
+                                ServerConfig::getInstance().cache_dir,
+                                ServerConfig::getInstance().cache_disk_bytes);
+    return instance;
+}
+
+ResultCache::ResultCache(size_t memory_capacity, const std::string& disk_dir,
+                         size_t disk_capacity)
+    : memory_capacity_(memory_capacity),
+      disk_dir_(disk_dir),
+      disk_capacity_(disk_capacity),
+      memory_bytes_(0),
+      disk_bytes_(0),
+      memory_hits_(0),
+      disk_hits_(0),
+      misses_(0),
+      stores_(0),
+      evictions_(0) {
+    if (hasDiskTier()) {
+        std::error_code error;
+        fs::create_directories(disk_dir_, error);
+        if (error) {
+            disk_dir_.clear();
+        } else {
+            loadDiskIndex();
+        }
+    }
+}
+
+std::string ResultCache::makeKey(const std::string& operation,
+                                 const std::string& parameters,
+                                 uint64_t content_hash, size_t content_size) {
+    return operation + "|" + parameters + "|" + ContentHasher::toHex(content_hash) +
+           "|" + std::to_string(content_size);
+}
+
+size_t ResultCache::maxEntryBytes() const {
+    // Uma entrada não pode ocupar mais que 1/4 da camada
+    return std::max(memory_capacity_, hasDiskTier() ? disk_capacity_ : 0) / 4;
+}
+
+bool ResultCache::lookup(const std::string& key, std::string& content,
+                         bool include_disk) {
+    {
+        std::lock_guard<std::mutex> lock(memory_mutex_);
+        auto it = memory_index_.find(key);
+        if (it != memory_index_.end()) {
+            memory_lru_.splice(memory_lru_.begin(), memory_lru_, it->second);
+            content = *it->second->second;
+            memory_hits_.fetch_add(1);
+            return true;
+        }
+    }
+
+    if (include_disk && hasDiskTier() && lookupDisk(key, content)) {
+        disk_hits_.fetch_add(1);
+        // Promover para a memória
+        if (memory_capacity_ > 0 && content.size() <= memory_capacity_ / 4) {
+            storeMemory(key, std::make_shared<const std::string>(content));
+        }
+        return true;
+    }
+
+    if (include_disk || !hasDiskTier()) {
+        misses_.fetch_add(1);
+    }
+    return false;
+}
+
+void ResultCache::store(const std::string& key, const std::string& content) {
+    if (!enabled() || content.size() > maxEntryBytes()) {
+        return;
+    }
+
+    stores_.fetch_add(1);
+    if (memory_capacity_ > 0 && content.size() <= memory_capacity_ / 4) {
+        storeMemory(key, std::make_shared<const std::string>(content));
+    }
+    if (hasDiskTier() && content.size() <= disk_capacity_ / 4) {
+        storeDisk(key, content);
+    }
+}
+
+void ResultCache::storeOutput(const std::string& key, TransferBuffer& output) {
+    if (key.empty() || output.size() > maxEntryBytes()) {
+        return;
+    }
+
+    if (output.inMemory()) {
+        store(key, output.memory());
+        return;
+    }
+
+    std::string content;
+    if (output.readAll(content)) {
+        store(key, content);
+    }
+}
+
+void ResultCache::storeMemory(const std::string& key,
+                              std::shared_ptr<const std::string> content) {
+    std::lock_guard<std::mutex> lock(memory_mutex_);
+
+    auto existing = memory_index_.find(key);
+    if (existing != memory_index_.end()) {
+        memory_bytes_ -= existing->second->second->size();
+        memory_lru_.erase(existing->second);
+        memory_index_.erase(existing);
+    }
+
+    memory_bytes_ += content->size();
+    memory_lru_.emplace_front(key, std::move(content));
+    memory_index_[key] = memory_lru_.begin();
+
+    while (memory_bytes_ > memory_capacity_ && !memory_lru_.empty()) {
+        const Entry& victim = memory_lru_.back();
+        memory_bytes_ -= victim.second->size();
+        memory_index_.erase(victim.first);
+        memory_lru_.pop_back();
+        evictions_.fetch_add(1);
+    }
+}
+
+std::string ResultCache::diskFileName(const std::string& key) const {
+    return ContentHasher::toHex(ContentHasher::hash(key.data(), key.size())) + ".cache";
+}
+
+bool ResultCache::lookupDisk(const std::string& key, std::string& content) {
+    const std::string file_name = diskFileName(key);
+    {
+        std::lock_guard<std::mutex> lock(disk_mutex_);
+        auto it = disk_index_.find(file_name);
+        if (it == disk_index_.end()) {
+            return false;
+        }
+        disk_lru_.splice(disk_lru_.begin(), disk_lru_, it->second);
+    }
+
+    // Arquivo = chave completa na primeira linha + resultado
+    std::ifstream file((fs::path(disk_dir_) / file_name).string(), std::ios::binary);
+    std::string stored_key;
+    if (!file.is_open() || !std::getline(file, stored_key) || stored_key != key) {
+        return false;
+    }
+    content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !file.bad();
+}
+
+void ResultCache::storeDisk(const std::string& key, const std::string& content) {
+    const std::string file_name = diskFileName(key);
+    const fs::path final_path = fs::path(disk_dir_) / file_name;
+    const fs::path temp_path = fs::path(disk_dir_) / (file_name + ".tmp");
+
+    {
+        std::ofstream file(temp_path.string(), std::ios::binary | std::ios::trunc);
+        file << key << '\n';
+        file.write(content.data(), static_cast<std::streamsize>(content.size()));
+        if (!file.good()) {
+            std::error_code error;
+            fs::remove(temp_path, error);
+            return;
+        }
+    }
+
+    std::error_code error;
+    fs::rename(temp_path, final_path, error);
+    if (error) {
+        fs::remove(temp_path, error);
+        return;
+    }
+
+    const size_t file_size = key.size() + 1 + content.size();
+    std::lock_guard<std::mutex> lock(disk_mutex_);
+
+    auto existing = disk_index_.find(file_name);
+    if (existing != disk_index_.end()) {
+        disk_bytes_ -= existing->second->second;
+        disk_lru_.erase(existing->second);
+        disk_index_.erase(existing);
+    }
+
+    disk_bytes_ += file_size;
+    disk_lru_.emplace_front(file_name, file_size);
+    disk_index_[file_name] = disk_lru_.begin();
+
+    while (disk_bytes_ > disk_capacity_ && !disk_lru_.empty()) {
+        const DiskEntry& victim = disk_lru_.back();
+        fs::remove(fs::path(disk_dir_) / victim.first, error);
+        disk_bytes_ -= victim.second;
+        disk_index_.erase(victim.first);
+        disk_lru_.pop_back();
+        evictions_.fetch_add(1);
+    }
+}
+
+void ResultCache::loadDiskIndex() {
+    // Entradas de execuções anteriores, da mais antiga para a mais recente
+    std::vector<std::pair<fs::file_time_type, DiskEntry>> entries;
+    std::error_code error;
+    for (const auto& item : fs::directory_iterator(disk_dir_, error)) {
+        const fs::path& path = item.path();
+        if (!item.is_regular_file(error)) {
+            continue;
+        }
+        if (path.extension() == ".tmp") {
+            fs::remove(path, error);
+            continue;
+        }
+        if (path.extension() != ".cache") {
+            continue;
+        }
+        entries.push_back({item.last_write_time(error),
+                           {path.filename().string(),
+                            static_cast<size_t>(item.file_size(error))}});
+    }
+
+    std::sort(entries.begin(), entries.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    for (const auto& entry : entries) {
+        disk_lru_.push_front(entry.second);
+        disk_index_[entry.second.first] = disk_lru_.begin();
+        disk_bytes_ += entry.second.second;
+    }
+
+    while (disk_bytes_ > disk_capacity_ && !disk_lru_.empty()) {
+        fs::remove(fs::path(disk_dir_) / disk_lru_.back().first, error);
+        disk_bytes_ -= disk_lru_.back().second;
+        disk_index_.erase(disk_lru_.back().first);
+        disk_lru_.pop_back();
+    }
+}
+
+ResultCache::Stats ResultCache::stats() const {
+    Stats stats;
+    stats.memory_hits = memory_hits_.load();
+    stats.disk_hits = disk_hits_.load();
+    stats.misses = misses_.load();
+    stats.stores = stores_.load();
+    stats.evictions = evictions_.load();
+    {
+        std::lock_guard<std::mutex> lock(memory_mutex_);
+        stats.memory_bytes = memory_bytes_;
+        stats.memory_entries = memory_lru_.size();
+    }
+    {
+        std::lock_guard<std::mutex> lock(disk_mutex_);
+        stats.disk_bytes = disk_bytes_;
+        stats.disk_entries = disk_lru_.size();
+    }
+    return stats;
+}
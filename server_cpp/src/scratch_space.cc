@@ -0,0 +1,319 @@
+#include "scratch_space.h"
+#include "server_config.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <process.h>
+#define getpid _getpid
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+// Diretório de cada processo: <raiz>/fp-XXXXXX, lock em <raiz>/fp-XXXXXX.lock
+const char kEntryPrefix[] = "fp-";
+const char kLockExtension[] = ".lock";
+const int kCreateAttempts = 8;
+
+bool startsWith(const std::string& value, const std::string& prefix) {
+    return value.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool endsWith(const std::string& value, const std::string& suffix) {
+    return value.size() >= suffix.size() &&
+           value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Remover a árvore e retornar os bytes dos arquivos que havia nela
+uint64_t removeTree(const fs::path& path) {
+    std::error_code error;
+    uint64_t bytes = 0;
+    for (fs::recursive_directory_iterator it(path, error), end; !error && it != end;
+         it.increment(error)) {
+        std::error_code size_error;
+        if (it->is_regular_file(size_error)) {
+            uint64_t size = it->file_size(size_error);
+            bytes += size_error ? 0 : size;
+        }
+    }
+    fs::remove_all(path, error);
+    return bytes;
+}
+}
+
+ScratchSpace& ScratchSpace::getInstance() {
+    const ServerConfig& config = ServerConfig::getInstance();
+    static ScratchSpace instance(config.scratch_dir, config.scratch_max_bytes,
+                                 config.scratch_request_quota_bytes);
+    return instance;
+}
+
+ScratchSpace::ScratchSpace(const std::string& root, size_t max_bytes,
+                           size_t request_quota_bytes)
+    : lock_fd_(-1),
+      max_bytes_(max_bytes),
+      request_quota_bytes_(request_quota_bytes) {
+    std::error_code error;
+    fs::path temp_dir = fs::temp_directory_path(error);
+    if (error) {
+        temp_dir = ".";
+    }
+    root_ = root.empty() ? (temp_dir / "fp_scratch").string() : root;
+    directory_ = temp_dir.string();
+
+    fs::create_directories(root_, error);
+    if (error) {
+        setup_error_ = "Cannot create scratch directory " + root_ + ": " + error.message();
+        return;
+    }
+
+    // Antes de criar o próprio diretório, para não varrê-lo
+    removeOrphans();
+    createPrivateDirectory(setup_error_);
+}
+
+ScratchSpace::~ScratchSpace() {
+#ifndef _WIN32
+    if (lock_fd_ >= 0) {
+        std::error_code error;
+        fs::remove_all(directory_, error);
+        unlink(lock_path_.c_str());
+        close(lock_fd_);
+    }
+#endif
+}
+
+bool ScratchSpace::createPrivateDirectory(std::string& error_message) {
+#ifndef _WIN32
+    for (int attempt = 0; attempt < kCreateAttempts; ++attempt) {
+        std::string lock_path = (fs::path(root_) / kEntryPrefix).string() + "XXXXXX" +
+                                kLockExtension;
+        std::vector<char> name(lock_path.begin(), lock_path.end());
+        name.push_back('\0');
+        int fd = mkostemps(name.data(), static_cast<int>(std::strlen(kLockExtension)),
+                           O_CLOEXEC);
+        if (fd < 0) {
+            error_message = "Cannot create scratch lock in " + root_ + ": " +
+                            std::strerror(errno);
+            return false;
+        }
+        lock_path.assign(name.data());
+
+        // Uma varredura concorrente pode ter pego o lock (e removido o
+        // arquivo) entre a criação e o flock: tentar outro nome
+        struct stat by_fd;
+        struct stat by_path;
+        if (flock(fd, LOCK_EX | LOCK_NB) != 0 || fstat(fd, &by_fd) != 0 ||
+            stat(lock_path.c_str(), &by_path) != 0 || by_fd.st_ino != by_path.st_ino ||
+            by_fd.st_dev != by_path.st_dev) {
+            close(fd);
+            continue;
+        }
+
+        std::string directory = lock_path.substr(0, lock_path.size() -
+                                                    std::strlen(kLockExtension));
+        if (mkdir(directory.c_str(), 0700) != 0) {
+            error_message = "Cannot create scratch directory " + directory + ": " +
+                            std::strerror(errno);
+            unlink(lock_path.c_str());
+            close(fd);
+            return false;
+        }
+
+        lock_fd_ = fd;
+        lock_path_ = lock_path;
+        directory_ = directory;
+        return true;
+    }
+    error_message = "Cannot lock a scratch directory in " + root_;
+    return false;
+#else
+    // Sem flock: arquivos direto na raiz, com o pid no nome
+    directory_ = root_;
+    error_message = "Private scratch directories are not supported on this platform";
+    return false;
+#endif
+}
+
+void ScratchSpace::removeOrphans() {
+#ifndef _WIN32
+    // Listar antes de remover (a iteração não acompanha remoções)
+    std::vector<fs::path> locks;
+    std::vector<fs::path> directories;
+    std::error_code error;
+    for (fs::directory_iterator it(root_, error), end; !error && it != end;
+         it.increment(error)) {
+        const std::string name = it->path().filename().string();
+        if (!startsWith(name, kEntryPrefix)) {
+            continue;
+        }
+        std::error_code type_error;
+        if (endsWith(name, kLockExtension) && it->is_regular_file(type_error)) {
+            locks.push_back(it->path());
+        } else if (it->is_directory(type_error)) {
+            directories.push_back(it->path());
+        }
+    }
+
+    // Lock livre: o dono terminou (o kernel solta o flock até num crash)
+    for (const fs::path& lock_path : locks) {
+        int fd = open(lock_path.c_str(), O_RDWR | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        if (flock(fd, LOCK_EX | LOCK_NB) == 0) {
+            std::string directory = lock_path.string();
+            directory.resize(directory.size() - std::strlen(kLockExtension));
+            std::error_code exists_error;
+            if (fs::exists(directory, exists_error)) {
+                orphan_bytes_removed_ += removeTree(directory);
+                ++orphans_removed_;
+            }
+            unlink(lock_path.c_str());
+        }
+        close(fd);
+    }
+
+    // Diretório sem lock: varredura anterior interrompida (o dono cria o
+    // lock antes do diretório e só o remove depois dele)
+    for (const fs::path& directory : directories) {
+        std::error_code exists_error;
+        if (fs::exists(directory, exists_error) &&
+            !fs::exists(directory.string() + kLockExtension, exists_error) && !exists_error) {
+            orphan_bytes_removed_ += removeTree(directory);
+            ++orphans_removed_;
+        }
+    }
+#endif
+}
+
+std::shared_ptr<ScratchSpace::Quota> ScratchSpace::newQuota() const {
+    if (request_quota_bytes_ == 0) {
+        return nullptr;
+    }
+    return std::make_shared<Quota>(request_quota_bytes_);
+}
+
+std::string ScratchSpace::uniquePath(const std::string& prefix,
+                                     const std::string& extension) {
+    // No diretório privado o contador basta; fora dele, o pid evita
+    // colisões com outros processos
+    std::string name = prefix + "_";
+    if (!isPrivate()) {
+        name += std::to_string(getpid()) + "_";
+    }
+    name += std::to_string(sequence_.fetch_add(1, std::memory_order_relaxed)) + extension;
+    return (fs::path(directory_) / name).string();
+}
+
+bool ScratchSpace::createFile(const std::string& prefix, const std::string& extension,
+                              std::string& path, std::string& error_message) {
+#ifndef _WIN32
+    std::string pattern = (fs::path(directory_) / (prefix + "_XXXXXX")).string() + extension;
+    std::vector<char> name(pattern.begin(), pattern.end());
+    name.push_back('\0');
+    int fd = mkostemps(name.data(), static_cast<int>(extension.size()), O_CLOEXEC);
+    if (fd < 0) {
+        error_message = "Failed to create temporary file in " + directory_ + ": " +
+                        std::strerror(errno);
+        return false;
+    }
+    close(fd);
+    path.assign(name.data());
+    return true;
+#else
+    path = uniquePath(prefix, extension);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        error_message = "Failed to create temporary file: " + path;
+        return false;
+    }
+    return true;
+#endif
+}
+
+int ScratchSpace::createAnonymous(std::string& error_message) {
+#if defined(__linux__) && defined(O_TMPFILE)
+    int fd = open(directory_.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        error_message = std::string("O_TMPFILE failed: ") + std::strerror(errno);
+    }
+    return fd;
+#else
+    error_message = "O_TMPFILE not supported on this platform";
+    return -1;
+#endif
+}
+
+bool ScratchSpace::reserve(Quota* quota, size_t bytes, std::string& error_message) {
+    if (bytes == 0) {
+        return true;
+    }
+
+    size_t total = used_bytes_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    if (max_bytes_ > 0 && total > max_bytes_) {
+        used_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+        quota_rejections_.fetch_add(1, std::memory_order_relaxed);
+        error_message = "Scratch space limit of " + std::to_string(max_bytes_) +
+                        " bytes reached";
+        return false;
+    }
+
+    if (quota != nullptr) {
+        size_t used = quota->used_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        if (quota->limit_ > 0 && used > quota->limit_) {
+            quota->used_.fetch_sub(bytes, std::memory_order_relaxed);
+            used_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+            quota_rejections_.fetch_add(1, std::memory_order_relaxed);
+            error_message = "Request exceeds its scratch quota of " +
+                            std::to_string(quota->limit_) + " bytes";
+            return false;
+        }
+    }
+    return true;
+}
+
+void ScratchSpace::charge(Quota* quota, size_t bytes) {
+    used_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    if (quota != nullptr) {
+        quota->used_.fetch_add(bytes, std::memory_order_relaxed);
+    }
+}
+
+void ScratchSpace::release(Quota* quota, size_t bytes) {
+    used_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+    if (quota != nullptr) {
+        quota->used_.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+}
+
+bool ScratchSpace::space(size_t& capacity, size_t& available) const {
+    std::error_code error;
+    fs::space_info info = fs::space(directory_, error);
+    if (error) {
+        return false;
+    }
+    capacity = static_cast<size_t>(info.capacity);
+    available = static_cast<size_t>(info.available);
+    return true;
+}
+
+ScratchSpace::Stats ScratchSpace::stats() const {
+    Stats stats;
+    stats.used_bytes = used_bytes_.load(std::memory_order_relaxed);
+    stats.quota_rejections = quota_rejections_.load(std::memory_order_relaxed);
+    stats.orphans_removed = orphans_removed_;
+    stats.orphan_bytes_removed = orphan_bytes_removed_;
+    return stats;
+}
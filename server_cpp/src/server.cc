@@ -1,22 +1,62 @@
-﻿#include <iostream>
+﻿#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
 #include <memory>
 #include <string>
+#include <thread>
 #include <csignal>
+#ifndef _WIN32
+#include <pthread.h>
+#include <signal.h>
+#endif
 #include <grpcpp/grpcpp.h>
 #include <grpcpp/health_check_service_interface.h>
 #include <grpcpp/ext/proto_server_reflection_plugin.h>
 
 #include "file_processor_service_impl.h"
 #include "logger.h"
+#include "metrics_server.h"
+#include "server_config.h"
 
 std::unique_ptr<grpc::Server> server;
 
+// O shutdown não roda num handler de sinal: log e Shutdown() alocam e
+// tomam mutexes, que a thread interrompida pode estar segurando. No POSIX,
+// SIGINT/SIGTERM ficam bloqueados em todas as threads (a máscara é
+// herdada) e uma thread comum os recebe com sigwait; no Windows, o handler
+// só marca o sinal e essa thread o observa
+#ifdef _WIN32
+std::atomic<int> pending_signal(0);
+
 void signalHandler(int signal) {
+    pending_signal.store(signal);
+}
+#else
+sigset_t shutdownSignals() {
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    return signals;
+}
+#endif
+
+void waitForShutdownSignal() {
+#ifdef _WIN32
+    while (pending_signal.load() == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+#else
+    sigset_t signals = shutdownSignals();
+    int signal = 0;
+    while (sigwait(&signals, &signal) != 0) {
+    }
+#endif
     Logger::getInstance().log(LogLevel::INFO_LEVEL, "System", "N/A",
                              "Shutdown signal received");
-    if (server) {
-        server->Shutdown();
-    }
+    server->Shutdown();
 }
 
 void RunServer(const std::string& server_address) {
@@ -47,11 +87,49 @@ void RunServer(const std::string& server_address) {
     builder.SetMaxReceiveMessageSize(100 * 1024 * 1024); // 100MB
     builder.SetMaxSendMessageSize(100 * 1024 * 1024);    // 100MB
     
+    // Controle de fluxo HTTP/2 (janelas e buffer de escrita) para enlaces
+    // com BDP alto; zeros mantêm os padrões do gRPC
+    const ServerConfig& config = ServerConfig::getInstance();
+    builder.AddChannelArgument(GRPC_ARG_HTTP2_BDP_PROBE,
+                               config.http2_bdp_probe ? 1 : 0);
+    if (config.http2_window_bytes > 0) {
+        builder.AddChannelArgument(GRPC_ARG_HTTP2_STREAM_LOOKAHEAD_BYTES,
+                                   static_cast<int>(std::min<size_t>(
+                                       config.http2_window_bytes, INT32_MAX)));
+    }
+    if (config.http2_write_buffer_bytes > 0) {
+        builder.AddChannelArgument(GRPC_ARG_HTTP2_WRITE_BUFFER_SIZE,
+                                   static_cast<int>(std::min<size_t>(
+                                       config.http2_write_buffer_bytes, INT32_MAX)));
+    }
+    if (config.http2_max_frame_bytes > 0) {
+        // HTTP/2 aceita quadros de 16KB a 16MB
+        builder.AddChannelArgument(GRPC_ARG_HTTP2_MAX_FRAME_SIZE,
+                                   static_cast<int>(std::min<size_t>(std::max<size_t>(
+                                       config.http2_max_frame_bytes, 16384),
+                                       16777215)));
+    }
+    
     server = builder.BuildAndStart();
     
     logger.log(LogLevel::SUCCESS_LEVEL, "System", "N/A",
               "Server listening on " + server_address);
     
+    // Endpoint de métricas; falha não impede o servidor de atender
+    MetricsServer metrics_server;
+    if (config.metrics_port > 0) {
+        std::string error_msg;
+        if (metrics_server.start(config.metrics_address,
+                                 static_cast<int>(config.metrics_port), error_msg)) {
+            logger.log(LogLevel::INFO_LEVEL, "System", "N/A",
+                      "Metrics available at http://" + config.metrics_address + ":" +
+                      std::to_string(metrics_server.port()) + "/metrics");
+        } else {
+            logger.log(LogLevel::WARNING_LEVEL, "System", "N/A",
+                      "Metrics endpoint disabled: " + error_msg);
+        }
+    }
+    
     std::cout << "\n";
     std::cout << "╔════════════════════════════════════════════╗\n";
     std::cout << "║   File Processor gRPC Server Started       ║\n";
@@ -65,7 +143,9 @@ void RunServer(const std::string& server_address) {
     std::cout << "╚════════════════════════════════════════════╝\n";
     std::cout << "\n";
     
+    std::thread shutdown_thread(waitForShutdownSignal);
     server->Wait();
+    shutdown_thread.join();
     
     logger.log(LogLevel::INFO_LEVEL, "System", "N/A", "Server shutdown complete");
 }
@@ -77,9 +157,17 @@ int main(int argc, char** argv) {
         server_address = argv[1];
     }
     
-    // Registrar handler de sinal para shutdown gracioso
+    // Sinais de shutdown gracioso, tratados por waitForShutdownSignal
+#ifdef _WIN32
     std::signal(SIGINT, signalHandler);
     std::signal(SIGTERM, signalHandler);
+#else
+    // Antes de qualquer thread, para que todas herdem o bloqueio
+    sigset_t signals = shutdownSignals();
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    // Ferramenta em pipeline que encerra cedo não deve derrubar o servidor
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
     
     try {
         RunServer(server_address);
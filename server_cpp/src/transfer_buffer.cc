@@ -0,0 +1,434 @@
+#include "transfer_buffer.h"
+#include "file_processor_utils.h"
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace {
+
+// Pool de buffers em memória: reaproveita a capacidade já alocada entre
+// requisições em vez de devolver (e depois pedir de novo) ao alocador
+class StringPool {
+public:
+    static StringPool& getInstance() {
+        static StringPool instance;
+        return instance;
+    }
+
+    std::string acquire() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_buffers_.empty()) {
+            return std::string();
+        }
+        std::string buffer = std::move(free_buffers_.back());
+        free_buffers_.pop_back();
+        pooled_bytes_ -= buffer.capacity();
+        buffer.clear();
+        return buffer;
+    }
+
+    void release(std::string&& buffer) {
+        const size_t capacity = buffer.capacity();
+        if (capacity < kMinPooledCapacity || capacity > kMaxPooledCapacity) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pooled_bytes_ + capacity > kMaxPooledBytes) {
+            return;
+        }
+        pooled_bytes_ += capacity;
+        free_buffers_.push_back(std::move(buffer));
+    }
+
+private:
+    static constexpr size_t kMinPooledCapacity = 64 * 1024;
+    static constexpr size_t kMaxPooledCapacity = 4 * 1024 * 1024;
+    static constexpr size_t kMaxPooledBytes = 32 * 1024 * 1024;
+
+    std::mutex mutex_;
+    std::vector<std::string> free_buffers_;
+    size_t pooled_bytes_ = 0;
+};
+
+} // namespace
+
+TransferBuffer::TransferBuffer(size_t spill_threshold,
+                               std::shared_ptr<ScratchSpace::Quota> quota)
+    : spill_threshold_(spill_threshold),
+      quota_(std::move(quota)),
+      storage_(Storage::MEMORY),
+      size_(0),
+      memory_(StringPool::getInstance().acquire()),
+      fd_(-1),
+      disk_accounted_(0),
+      quota_exceeded_(false) {}
+
+TransferBuffer::~TransferBuffer() {
+    release();
+}
+
+void TransferBuffer::release() {
+#ifdef __linux__
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+#endif
+    fd_ = -1;
+
+    if (disk_stream_.is_open()) {
+        disk_stream_.close();
+    }
+    if (!disk_path_.empty()) {
+        FileProcessorUtils::cleanupFile(disk_path_);
+        disk_path_.clear();
+    }
+    std::string unused;
+    accountDisk(0, false, unused);
+
+    StringPool::getInstance().release(std::move(memory_));
+    memory_ = std::string();
+    storage_ = Storage::MEMORY;
+    size_ = 0;
+}
+
+bool TransferBuffer::adoptFile(const std::string& path, std::string& error_message) {
+    release();
+
+    disk_path_ = path;
+    storage_ = Storage::DISK;
+    disk_stream_.open(disk_path_, std::ios::in | std::ios::out | std::ios::binary |
+                                  std::ios::ate);
+    if (!disk_stream_.is_open()) {
+        error_message = "Failed to open file: " + disk_path_;
+        return false;
+    }
+
+    // Já está em disco (upload concluído): só entra na contagem
+    size_ = FileProcessorUtils::getFileSize(disk_path_);
+    accountDisk(size_, false, error_message);
+    return true;
+}
+
+void TransferBuffer::reserve(size_t size) {
+    if (storage_ == Storage::MEMORY && size <= spill_threshold_) {
+        memory_.reserve(size);
+    }
+}
+
+bool TransferBuffer::append(const char* data, size_t size,
+                            std::string& error_message) {
+    if (storage_ == Storage::MEMORY && size_ + size > spill_threshold_) {
+        if (!spillToDisk(".tmp", error_message)) {
+            return false;
+        }
+    }
+    if (onDisk() && !accountDisk(size_ + size, true, error_message)) {
+        return false;
+    }
+
+    switch (storage_) {
+        case Storage::MEMORY:
+            memory_.append(data, size);
+            break;
+        case Storage::DISK:
+            disk_stream_.write(data, static_cast<std::streamsize>(size));
+            if (!disk_stream_.good()) {
+                error_message = "Error writing to file";
+                return false;
+            }
+            break;
+        case Storage::MEMFD:
+        case Storage::TMPFILE:
+            if (!writeFd(data, size, error_message)) {
+                return false;
+            }
+            break;
+    }
+
+    size_ += size;
+    return true;
+}
+
+bool TransferBuffer::writeFd(const char* data, size_t size, std::string& error_message) {
+#ifdef __linux__
+    for (size_t written = 0; written < size;) {
+        ssize_t result = write(fd_, data + written, size - written);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error_message = "Error writing to " + description() + ": " +
+                            std::strerror(errno);
+            return false;
+        }
+        written += static_cast<size_t>(result);
+    }
+    return true;
+#else
+    (void)data;
+    (void)size;
+    error_message = "File descriptors not supported on this platform";
+    return false;
+#endif
+}
+
+bool TransferBuffer::assign(std::string content, std::string& error_message) {
+    release();
+    if (content.size() > spill_threshold_) {
+        return append(content.data(), content.size(), error_message);
+    }
+
+    size_ = content.size();
+    memory_ = std::move(content);
+    return true;
+}
+
+bool TransferBuffer::readAll(std::string& content) {
+    if (storage_ == Storage::MEMORY) {
+        content = memory_;
+        return true;
+    }
+
+    content.resize(size_);
+    size_t offset = 0;
+    while (offset < size_) {
+        size_t read = readAt(offset, &content[offset], size_ - offset);
+        if (read == 0) {
+            return false;
+        }
+        offset += read;
+    }
+    return true;
+}
+
+size_t TransferBuffer::readAt(size_t offset, char* buffer, size_t length) {
+    if (offset >= size_) {
+        return 0;
+    }
+    length = std::min(length, size_ - offset);
+
+    switch (storage_) {
+        case Storage::MEMORY:
+            memory_.copy(buffer, length, offset);
+            return length;
+        case Storage::DISK:
+            disk_stream_.flush();
+            disk_stream_.clear();
+            disk_stream_.seekg(static_cast<std::streamoff>(offset));
+            disk_stream_.read(buffer, static_cast<std::streamsize>(length));
+            return static_cast<size_t>(disk_stream_.gcount());
+        case Storage::MEMFD:
+        case Storage::TMPFILE:
+#ifdef __linux__
+            while (true) {
+                ssize_t result = pread(fd_, buffer, length,
+                                       static_cast<off_t>(offset));
+                if (result < 0 && errno == EINTR) {
+                    continue;
+                }
+                return result < 0 ? 0 : static_cast<size_t>(result);
+            }
+#endif
+            break;
+    }
+    return 0;
+}
+
+bool TransferBuffer::inputPath(std::string& path, std::string& error_message) {
+    if (storage_ == Storage::MEMORY) {
+        // Expor o conteúdo em memória via memfd; sem suporte, gravar em disco
+        std::string memfd_error;
+        if (createMemfd(memfd_error)) {
+            std::string content = std::move(memory_);
+            memory_ = std::string();
+            size_ = 0;
+            bool written = append(content.data(), content.size(), error_message);
+            StringPool::getInstance().release(std::move(content));
+            if (!written) {
+                return false;
+            }
+        } else if (!spillToDisk(".tmp", error_message)) {
+            return false;
+        }
+    }
+
+    if (storage_ == Storage::DISK) {
+        disk_stream_.flush();
+        if (!disk_stream_.good()) {
+            error_message = "Error writing to file";
+            return false;
+        }
+        path = disk_path_;
+        return true;
+    }
+
+    path = fdPath();
+    return true;
+}
+
+bool TransferBuffer::prepareOutput(bool prefer_disk, const std::string& extension,
+                                   std::string& path, std::string& error_message) {
+    release();
+
+    std::string fd_error;
+    if (!prefer_disk && createMemfd(fd_error)) {
+        path = fdPath();
+        return true;
+    }
+
+    // Saída grande: arquivo sem nome no ScratchSpace, gravado pelo caminho
+    // em /proc como o memfd (não sobra nada se o processo cair)
+    ScratchSpace& scratch = ScratchSpace::getInstance();
+    int fd = scratch.createAnonymous(fd_error);
+    if (fd >= 0) {
+        fd_ = fd;
+        storage_ = Storage::TMPFILE;
+        path = fdPath();
+        return true;
+    }
+
+    // O processo externo cria o arquivo; ele é aberto em commitOutput()
+    disk_path_ = scratch.uniquePath("output", extension);
+    storage_ = Storage::DISK;
+    path = disk_path_;
+    (void)error_message;
+    return true;
+}
+
+bool TransferBuffer::commitOutput(std::string& error_message) {
+    if (storage_ == Storage::DISK) {
+        if (!FileProcessorUtils::fileExists(disk_path_)) {
+            error_message = "Output file was not created";
+            return false;
+        }
+
+        size_ = FileProcessorUtils::getFileSize(disk_path_);
+        if (!accountDisk(size_, true, error_message)) {
+            return false;
+        }
+        disk_stream_.open(disk_path_, std::ios::in | std::ios::binary);
+        if (!disk_stream_.is_open()) {
+            error_message = "Failed to open output file: " + disk_path_;
+            return false;
+        }
+        return true;
+    }
+
+#ifdef __linux__
+    if (storage_ == Storage::MEMFD || storage_ == Storage::TMPFILE) {
+        struct stat file_stat;
+        if (fstat(fd_, &file_stat) != 0) {
+            error_message = "Failed to stat " + description() + ": " + std::strerror(errno);
+            return false;
+        }
+        size_ = static_cast<size_t>(file_stat.st_size);
+        if (storage_ == Storage::TMPFILE && !accountDisk(size_, true, error_message)) {
+            return false;
+        }
+        return true;
+    }
+#endif
+
+    return true;
+}
+
+std::string TransferBuffer::description() const {
+    switch (storage_) {
+        case Storage::MEMORY: return "memory";
+        case Storage::MEMFD: return "memfd";
+        case Storage::TMPFILE: return "tmpfile";
+        case Storage::DISK: return disk_path_;
+    }
+    return "unknown";
+}
+
+std::string TransferBuffer::fdPath() const {
+#ifdef __linux__
+    return "/proc/" + std::to_string(getpid()) + "/fd/" + std::to_string(fd_);
+#else
+    return std::string();
+#endif
+}
+
+bool TransferBuffer::accountDisk(size_t bytes, bool enforce, std::string& error_message) {
+    ScratchSpace& scratch = ScratchSpace::getInstance();
+    if (bytes < disk_accounted_) {
+        scratch.release(quota_.get(), disk_accounted_ - bytes);
+    } else if (!enforce) {
+        scratch.charge(quota_.get(), bytes - disk_accounted_);
+    } else if (!scratch.reserve(quota_.get(), bytes - disk_accounted_, error_message)) {
+        quota_exceeded_ = true;
+        return false;
+    }
+    disk_accounted_ = bytes;
+    return true;
+}
+
+bool TransferBuffer::spillToDisk(const std::string& extension,
+                                 std::string& error_message) {
+    if (!accountDisk(memory_.size(), true, error_message)) {
+        return false;
+    }
+
+    // Preferir arquivo sem nome: o kernel o libera com o descritor, mesmo
+    // que o processo caia
+    ScratchSpace& scratch = ScratchSpace::getInstance();
+    std::string tmpfile_error;
+    int fd = scratch.createAnonymous(tmpfile_error);
+    if (fd >= 0) {
+        fd_ = fd;
+        storage_ = Storage::TMPFILE;
+        if (!writeFd(memory_.data(), memory_.size(), error_message)) {
+            return false;
+        }
+    } else {
+        if (!scratch.createFile("transfer", extension, disk_path_, error_message)) {
+            return false;
+        }
+        disk_stream_.open(disk_path_, std::ios::in | std::ios::out |
+                                      std::ios::binary | std::ios::trunc);
+        if (!disk_stream_.is_open()) {
+            error_message = "Failed to create temporary file: " + disk_path_;
+            return false;
+        }
+        storage_ = Storage::DISK;
+
+        disk_stream_.write(memory_.data(), static_cast<std::streamsize>(memory_.size()));
+        if (!disk_stream_.good()) {
+            error_message = "Error writing to file";
+            return false;
+        }
+    }
+
+    StringPool::getInstance().release(std::move(memory_));
+    memory_ = std::string();
+    return true;
+}
+
+bool TransferBuffer::createMemfd(std::string& error_message) {
+#ifdef __linux__
+    int fd = memfd_create("file_processor", MFD_CLOEXEC);
+    if (fd < 0) {
+        error_message = std::string("memfd_create failed: ") + std::strerror(errno);
+        return false;
+    }
+    fd_ = fd;
+    storage_ = Storage::MEMFD;
+    return true;
+#else
+    error_message = "memfd not supported on this platform";
+    return false;
+#endif
+}
@@ -0,0 +1,301 @@
+#include "upload_store.h"
+#include "scratch_space.h"
+#include "server_config.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+
+namespace fs = std::filesystem;
+
+namespace {
+// Varredura de partes expiradas no máximo uma vez por intervalo
+const std::chrono::seconds kSweepInterval(60);
+
+std::atomic<uint64_t> g_completed_sequence{0};
+}
+
+UploadStore& UploadStore::getInstance() {
+    const ServerConfig& config = ServerConfig::getInstance();
+    static UploadStore instance(
+        !config.resumable_uploads_enabled ? std::string()
+            : !config.upload_dir.empty() ? config.upload_dir
+            : (fs::temp_directory_path() / "fp_uploads").string(),
+        std::chrono::seconds(config.upload_ttl_seconds));
+    return instance;
+}
+
+UploadStore::UploadStore(const std::string& directory, std::chrono::seconds ttl)
+    : directory_(directory),
+      ttl_(ttl),
+      last_sweep_(std::chrono::steady_clock::now()) {
+    if (enabled()) {
+        std::error_code error;
+        fs::create_directories(directory_, error);
+        if (error) {
+            directory_.clear();
+        } else {
+            // Partes de execuções anteriores continuam retomáveis até o TTL
+            // (contabilizadas antes da varredura, que desconta as removidas)
+            uint64_t existing = 0;
+            for (fs::directory_iterator it(directory_, error), end; !error && it != end;
+                 it.increment(error)) {
+                std::error_code file_error;
+                if (it->path().extension() == ".part") {
+                    uintmax_t size = fs::file_size(it->path(), file_error);
+                    existing += file_error ? 0 : static_cast<uint64_t>(size);
+                }
+            }
+            park(existing);
+            ScratchSpace::getInstance().charge(nullptr, static_cast<size_t>(existing));
+            removeExpired();
+        }
+    }
+}
+
+std::string UploadStore::newToken() {
+    // O token é a única credencial da parte: gerador do sistema, não um PRNG
+    std::random_device random;
+    char token[33];
+    std::snprintf(token, sizeof(token), "%08x%08x%08x%08x",
+                  static_cast<unsigned>(random()), static_cast<unsigned>(random()),
+                  static_cast<unsigned>(random()), static_cast<unsigned>(random()));
+    return token;
+}
+
+void UploadStore::park(uint64_t bytes) {
+    parked_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void UploadStore::unpark(uint64_t bytes) {
+    uint64_t current = parked_bytes_.load(std::memory_order_relaxed);
+    while (!parked_bytes_.compare_exchange_weak(current, current - std::min(current, bytes),
+                                                std::memory_order_relaxed)) {
+    }
+}
+
+bool UploadStore::isValidId(const std::string& upload_id) {
+    // O id compõe o nome do arquivo: sem separadores de caminho
+    return !upload_id.empty() && upload_id.size() <= 128 &&
+           std::all_of(upload_id.begin(), upload_id.end(), [](unsigned char c) {
+               return std::isalnum(c) != 0 || c == '-' || c == '_';
+           });
+}
+
+std::string UploadStore::partPath(const std::string& upload_id,
+                                  uint64_t file_size) const {
+    return (fs::path(directory_) /
+            (upload_id + "_" + std::to_string(file_size) + ".part")).string();
+}
+
+bool UploadStore::open(const std::string& requested_id, uint64_t file_size,
+                       std::string& upload_id, uint64_t& committed_offset,
+                       std::string& error_message) {
+    if (!enabled()) {
+        error_message = "Resumable uploads are disabled";
+        return false;
+    }
+
+    // Só um token emitido antes (com a parte ainda guardada) retoma
+    bool sweep = false;
+    auto upload = std::make_unique<ActiveUpload>();
+    upload->path = partPath(requested_id, file_size);
+    std::error_code exists_error;
+    bool known = fs::exists(upload->path, exists_error);
+    std::string token = known ? requested_id : newToken();
+    if (!known) {
+        upload->path = partPath(token, file_size);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (active_.count(token) > 0) {
+            error_message = "Upload " + requested_id + " is already in progress";
+            return false;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_sweep_ >= std::min<std::chrono::seconds>(ttl_, kSweepInterval)) {
+            last_sweep_ = now;
+            sweep = true;
+        }
+        active_[token] = nullptr;
+    }
+    if (sweep) {
+        removeExpired();
+    }
+
+    // Parte maior que o arquivo anunciado não é retomável: recomeçar
+    std::error_code error;
+    uint64_t on_disk = fs::exists(upload->path, error)
+        ? static_cast<uint64_t>(fs::file_size(upload->path, error)) : 0;
+    if (error) {
+        on_disk = 0;
+    }
+    uint64_t existing = on_disk > file_size ? 0 : on_disk;
+
+    upload->stream.open(upload->path, std::ios::binary |
+                        (existing > 0 ? std::ios::app : std::ios::trunc));
+    if (!upload->stream.is_open()) {
+        error_message = "Failed to open upload file: " + upload->path;
+        std::lock_guard<std::mutex> lock(mutex_);
+        active_.erase(token);
+        return false;
+    }
+
+    // A parte deixa de estar parada: o stream reserva o tamanho anunciado
+    unpark(on_disk);
+    if (on_disk > existing) {
+        ScratchSpace::getInstance().release(nullptr, static_cast<size_t>(on_disk));
+    }
+
+    committed_offset = existing;
+    upload->bytes = existing;
+    upload_id = token;
+    std::lock_guard<std::mutex> lock(mutex_);
+    active_[token] = std::move(upload);
+    return true;
+}
+
+bool UploadStore::append(const std::string& upload_id, const char* data, size_t size,
+                         std::string& error_message, bool* space_exhausted) {
+    ActiveUpload* upload = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = active_.find(upload_id);
+        if (it != active_.end()) {
+            upload = it->second.get();
+        }
+    }
+    if (upload == nullptr) {
+        error_message = "Upload " + upload_id + " is not open";
+        return false;
+    }
+
+    // Partes contam no limite total do espaço temporário
+    if (!ScratchSpace::getInstance().reserve(nullptr, size, error_message)) {
+        if (space_exhausted != nullptr) {
+            *space_exhausted = true;
+        }
+        return false;
+    }
+
+    // Só quem abriu o upload escreve nele: sem lock durante o I/O
+    upload->stream.write(data, static_cast<std::streamsize>(size));
+    upload->bytes += size;
+    if (!upload->stream.good()) {
+        error_message = "Error writing to upload file: " + upload->path;
+        return false;
+    }
+    return true;
+}
+
+void UploadStore::release(const std::string& upload_id) {
+    std::unique_ptr<ActiveUpload> upload;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = active_.find(upload_id);
+        if (it == active_.end()) {
+            return;
+        }
+        upload = std::move(it->second);
+        active_.erase(it);
+    }
+    // O destrutor do ofstream grava o que ainda estiver no buffer
+    if (upload) {
+        park(upload->bytes);
+    }
+}
+
+bool UploadStore::complete(const std::string& upload_id, std::string& path,
+                           std::string& error_message) {
+    std::unique_ptr<ActiveUpload> upload;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = active_.find(upload_id);
+        if (it == active_.end() || !it->second) {
+            error_message = "Upload " + upload_id + " is not open";
+            return false;
+        }
+        upload = std::move(it->second);
+        active_.erase(it);
+    }
+
+    // O arquivo passa para quem chamou (contabilizado no TransferBuffer)
+    upload->stream.close();
+    ScratchSpace::getInstance().release(nullptr, static_cast<size_t>(upload->bytes));
+    if (upload->stream.fail()) {
+        error_message = "Error writing to upload file: " + upload->path;
+        std::error_code remove_error;
+        fs::remove(upload->path, remove_error);
+        return false;
+    }
+
+    // Novo nome no mesmo diretório (rename atômico, sem cópia); a extensão
+    // .done também é varrida pelo TTL caso o processo termine antes
+    path = (fs::path(directory_) /
+            (upload_id + "." + std::to_string(g_completed_sequence.fetch_add(1)) +
+             ".done")).string();
+    std::error_code error;
+    fs::rename(upload->path, path, error);
+    if (error) {
+        error_message = "Failed to finalize upload: " + error.message();
+        std::error_code remove_error;
+        fs::remove(upload->path, remove_error);
+        return false;
+    }
+    return true;
+}
+
+size_t UploadStore::removeExpired() {
+    if (!enabled()) {
+        return 0;
+    }
+
+    std::error_code error;
+    auto cutoff = fs::file_time_type::clock::now() - ttl_;
+    size_t removed = 0;
+
+    for (fs::directory_iterator it(directory_, error), end; !error && it != end;
+         it.increment(error)) {
+        const fs::path& file = it->path();
+        std::string extension = file.extension().string();
+        if (extension != ".part" && extension != ".done") {
+            continue;
+        }
+
+        std::error_code file_error;
+        auto modified = fs::last_write_time(file, file_error);
+        if (file_error || modified >= cutoff) {
+            continue;
+        }
+
+        // Partes em uso ficam, mesmo que o cliente esteja lento
+        uint64_t size = 0;
+        if (extension == ".part") {
+            std::string name = file.stem().string();
+            std::string upload_id = name.substr(0, name.rfind('_'));
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (active_.count(upload_id) > 0) {
+                continue;
+            }
+            size = static_cast<uint64_t>(fs::file_size(file, file_error));
+            if (file_error) {
+                size = 0;
+            }
+        }
+        if (fs::remove(file, file_error)) {
+            ++removed;
+            unpark(size);
+            ScratchSpace::getInstance().release(nullptr, static_cast<size_t>(size));
+        }
+    }
+    return removed;
+}
+
+size_t UploadStore::activeUploads() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return active_.size();
+}
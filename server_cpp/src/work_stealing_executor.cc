@@ -0,0 +1,192 @@
+#include "work_stealing_executor.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <utility>
+
+namespace {
+
+// Executor e índice do worker da thread atual (para submissões internas)
+thread_local const WorkStealingExecutor* current_executor = nullptr;
+thread_local size_t current_worker = 0;
+
+// Cota de CPU do cgroup (v2: cpu.max, v1: cfs_quota/cfs_period); 0 se ilimitada
+size_t cgroupCpuLimit() {
+    long long quota = -1;
+    long long period = 0;
+
+    std::ifstream cpu_max("/sys/fs/cgroup/cpu.max");
+    if (cpu_max.is_open()) {
+        std::string quota_text;
+        cpu_max >> quota_text >> period;
+        if (quota_text != "max" && !quota_text.empty()) {
+            quota = std::atoll(quota_text.c_str());
+        }
+    } else {
+        std::ifstream quota_file("/sys/fs/cgroup/cpu/cpu.cfs_quota_us");
+        std::ifstream period_file("/sys/fs/cgroup/cpu/cpu.cfs_period_us");
+        if (quota_file.is_open() && period_file.is_open()) {
+            quota_file >> quota;
+            period_file >> period;
+        }
+    }
+
+    if (quota <= 0 || period <= 0) {
+        return 0;
+    }
+    return static_cast<size_t>(std::max<long long>(1, (quota + period - 1) / period));
+}
+
+} // namespace
+
+WorkStealingExecutor::WorkStealingExecutor(size_t num_threads)
+    : pending_(0), next_worker_(0), stopping_(false) {
+    if (num_threads == 0) {
+        num_threads = defaultThreadCount();
+    }
+
+    for (size_t i = 0; i < num_threads; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < num_threads; ++i) {
+        threads_.emplace_back(&WorkStealingExecutor::workerLoop, this, i);
+    }
+}
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+    shutdown();
+}
+
+size_t WorkStealingExecutor::defaultThreadCount() {
+    size_t cores = std::thread::hardware_concurrency();
+    size_t cgroup_limit = cgroupCpuLimit();
+    if (cgroup_limit > 0 && (cores == 0 || cgroup_limit < cores)) {
+        cores = cgroup_limit;
+    }
+    return std::max<size_t>(1, cores);
+}
+
+void WorkStealingExecutor::submit(Task task) {
+    size_t index;
+    if (current_executor == this) {
+        index = current_worker;
+    } else {
+        index = next_worker_.fetch_add(1) % workers_.size();
+    }
+
+    // Contar antes de publicar: quem retirar a tarefa já pode decrementar
+    pending_.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+        workers_[index]->tasks.push_back(std::move(task));
+    }
+
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    wake_cv_.notify_one();
+}
+
+void WorkStealingExecutor::parallelFor(size_t count,
+                                       const std::function<void(size_t)>& body) {
+    // Tarefas que rodarem depois do retorno só encontram o contador esgotado
+    // e não tocam em body
+    struct State {
+        std::atomic<size_t> next{0};
+        size_t completed = 0;
+        std::mutex mutex;
+        std::condition_variable done_cv;
+    };
+    auto state = std::make_shared<State>();
+    const std::function<void(size_t)>* task_body = &body;
+
+    auto drain = [state, task_body, count]() {
+        size_t index;
+        while ((index = state->next.fetch_add(1)) < count) {
+            try {
+                (*task_body)(index);
+            } catch (...) {
+                // Mesmo tratamento de submit(): falha não derruba o worker
+            }
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (++state->completed == count) {
+                state->done_cv.notify_all();
+            }
+        }
+    };
+
+    const size_t helpers = std::min(count, workers_.size()) - (count > 0 ? 1 : 0);
+    for (size_t i = 0; i < helpers; ++i) {
+        submit(drain);
+    }
+    drain();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done_cv.wait(lock, [&state, count] { return state->completed == count; });
+}
+
+void WorkStealingExecutor::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        if (stopping_) {
+            return;
+        }
+        stopping_ = true;
+    }
+    wake_cv_.notify_all();
+
+    for (std::thread& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+bool WorkStealingExecutor::popTask(size_t index, Task& task) {
+    // Própria fila: mais recente primeiro
+    {
+        Worker& own = *workers_[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Roubo: mais antiga primeiro, a partir do próximo worker
+    for (size_t offset = 1; offset < workers_.size(); ++offset) {
+        Worker& victim = *workers_[(index + offset) % workers_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingExecutor::workerLoop(size_t index) {
+    current_executor = this;
+    current_worker = index;
+
+    while (true) {
+        Task task;
+        if (popTask(index, task)) {
+            pending_.fetch_sub(1);
+            try {
+                task();
+            } catch (...) {
+                // Falha de uma tarefa não derruba o worker
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        wake_cv_.wait(lock, [this] { return pending_.load() > 0 || stopping_; });
+        if (stopping_ && pending_.load() == 0) {
+            return;
+        }
+    }
+}
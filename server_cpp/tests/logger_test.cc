@@ -0,0 +1,213 @@
+// Teste de carga da fila MPSC do Logger: vários produtores concorrentes,
+// sem perda abaixo da capacidade, contador de descartes coerente com os
+// avisos gravados e ordem preservada por produtor. A saída de console vai
+// para um pipe que o teste pode parar de esvaziar, o que trava a thread de
+// fundo e enche a fila. Roda sob o ThreadSanitizer quando disponível.
+//
+// Uso: logger_test (código de saída != 0 em falha)
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "logger.h"
+#include "test_check.h"
+
+namespace {
+// Capacidade do ring configurada para o teste (potência de 2)
+const size_t kQueueSize = 1024;
+const int kProducers = 4;
+
+// Esvazia o pipe que substitui o stdout; pausado, o pipe enche e a thread
+// de fundo do Logger bloqueia na escrita do console
+class ConsoleDrain {
+public:
+    ConsoleDrain() : paused_(false) {
+        int fds[2];
+        if (pipe(fds) != 0) {
+            std::perror("pipe");
+            std::exit(1);
+        }
+        std::fflush(stdout);
+        saved_stdout_ = dup(STDOUT_FILENO);
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[1]);
+        read_fd_ = fds[0];
+        thread_ = std::thread(&ConsoleDrain::run, this);
+    }
+
+    ~ConsoleDrain() {
+        // Com o stdout restaurado não sobra escritor e o read devolve 0
+        paused_ = false;
+        std::fflush(stdout);
+        dup2(saved_stdout_, STDOUT_FILENO);
+        close(saved_stdout_);
+        thread_.join();
+        close(read_fd_);
+    }
+
+    void pause() { paused_ = true; }
+    void resume() { paused_ = false; }
+
+private:
+    void run() {
+        char buffer[4096];
+        while (true) {
+            if (paused_) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            if (read(read_fd_, buffer, sizeof(buffer)) <= 0) {
+                return;
+            }
+        }
+    }
+
+    std::atomic<bool> paused_;
+    int saved_stdout_;
+    int read_fd_;
+    std::thread thread_;
+};
+
+struct LogContents {
+    // Sequências gravadas de cada produtor, na ordem do arquivo
+    std::map<int, std::vector<long>> sequences;
+    uint64_t reported_drops = 0;
+};
+
+LogContents readLog(const std::string& path, const std::string& tag) {
+    LogContents contents;
+    std::ifstream file(path);
+    std::string line;
+    const std::string drop_notice = "Log queue full, dropped ";
+    const std::string message_prefix = "| Message: " + tag + " p";
+    while (std::getline(file, line)) {
+        size_t position = line.find(drop_notice);
+        if (position != std::string::npos) {
+            contents.reported_drops +=
+                std::strtoull(line.c_str() + position + drop_notice.size(), nullptr, 10);
+            continue;
+        }
+        position = line.find(message_prefix);
+        if (position == std::string::npos) {
+            continue;
+        }
+        char* end = nullptr;
+        int producer = static_cast<int>(
+            std::strtol(line.c_str() + position + message_prefix.size(), &end, 10));
+        long sequence = std::strtol(end, nullptr, 10);
+        contents.sequences[producer].push_back(sequence);
+    }
+    return contents;
+}
+
+void produce(const std::string& tag, int records_per_producer) {
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&tag, p, records_per_producer]() {
+            Logger& logger = Logger::getInstance();
+            for (int i = 0; i < records_per_producer; ++i) {
+                logger.log(LogLevel::WARNING_LEVEL, "LoggerTest", "N/A",
+                           tag + " p" + std::to_string(p) + " " + std::to_string(i));
+            }
+        });
+    }
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+}
+
+bool strictlyIncreasing(const std::vector<long>& sequence) {
+    for (size_t i = 1; i < sequence.size(); ++i) {
+        if (sequence[i] <= sequence[i - 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Abaixo da capacidade nada é descartado e cada produtor sai na ordem
+void testNoLossBelowCapacity(const std::string& path) {
+    Logger& logger = Logger::getInstance();
+    const int per_producer = static_cast<int>(kQueueSize / 2) / kProducers;
+    uint64_t drops_before = logger.droppedCount();
+
+    produce("fit", per_producer);
+    logger.flush();
+
+    CHECK(logger.droppedCount() == drops_before);
+    LogContents contents = readLog(path, "fit");
+    CHECK(contents.sequences.size() == static_cast<size_t>(kProducers));
+    for (const auto& entry : contents.sequences) {
+        CHECK(entry.second.size() == static_cast<size_t>(per_producer));
+        CHECK(strictlyIncreasing(entry.second));
+    }
+}
+
+// Com a thread de fundo travada, o excesso é descartado, contado e
+// informado; o que entrou na fila sai inteiro e em ordem
+void testOverflow(const std::string& path, ConsoleDrain& drain) {
+    Logger& logger = Logger::getInstance();
+    const int per_producer = 5000;
+    uint64_t drops_before = logger.droppedCount();
+
+    drain.pause();
+    produce("burst", per_producer);
+    uint64_t dropped = logger.droppedCount() - drops_before;
+    drain.resume();
+
+    // Todos os descartes aconteceram antes do marcador, então o aviso deles
+    // é gravado no mesmo lote ou antes
+    logger.flush();
+    logger.log(LogLevel::WARNING_LEVEL, "LoggerTest", "N/A", "marker");
+    logger.flush();
+
+    CHECK(dropped > 0);
+    CHECK(logger.droppedCount() - drops_before == dropped);
+
+    LogContents contents = readLog(path, "burst");
+    size_t written = 0;
+    for (const auto& entry : contents.sequences) {
+        written += entry.second.size();
+        CHECK(strictlyIncreasing(entry.second));
+    }
+    CHECK(written + dropped == static_cast<size_t>(kProducers * per_producer));
+    CHECK(written >= kQueueSize);
+    CHECK(contents.reported_drops == dropped);
+}
+}
+
+int main() {
+    // Precisa valer antes da primeira chamada a Logger::getInstance()
+    setenv("FP_LOG_QUEUE_SIZE", std::to_string(kQueueSize).c_str(), 1);
+    setenv("FP_LOG_LEVEL", "info", 1);
+
+    char path_template[] = "/tmp/logger_test_XXXXXX";
+    int fd = mkstemp(path_template);
+    if (fd < 0) {
+        std::perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+    const std::string path = path_template;
+
+    {
+        ConsoleDrain drain;
+        Logger& logger = Logger::getInstance();
+        logger.setLogFile(path);
+
+        testNoLossBelowCapacity(path);
+        testOverflow(path, drain);
+    }
+
+    std::remove(path.c_str());
+    return testExitCode("logger_test");
+}
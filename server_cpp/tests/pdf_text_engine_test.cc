@@ -0,0 +1,207 @@
+// Teste do agendamento de páginas do PdfTextEngine com um leitor falso (sem
+// poppler-cpp): ordem de entrega, falhas de página e do sink, participantes
+// que não abrem o documento e cancelamento da chamada. Com
+// FP_TEST_THREAD_SANITIZER (padrão quando o compilador suporta), roda sob
+// o ThreadSanitizer, que acusa corridas no estado compartilhado.
+//
+// Uso: pdf_text_engine_test (código de saída != 0 em falha)
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "job_context.h"
+#include "pdf_text_engine.h"
+#include "test_check.h"
+#include "work_stealing_executor.h"
+
+namespace {
+std::string pageTextFor(int index) {
+    return "page " + std::to_string(index + 1) + "\f";
+}
+
+// Documento de pages páginas; tempos de extração variados para embaralhar
+// a ordem em que as páginas ficam prontas
+struct FakeDocument {
+    int pages = 0;
+    int failing_page = -1;
+    bool workers_fail_open = false;
+    std::chrono::microseconds page_time{0};
+
+    std::atomic<int> opened{0};
+    std::atomic<int> extracted{0};
+};
+
+class FakePageReader : public PdfTextEngine::PageReader {
+public:
+    explicit FakePageReader(FakeDocument& document) : document_(document) {}
+
+    bool open(const char*, size_t, const std::string&, std::string& error_message) override {
+        // O primeiro leitor é o do job que chama
+        if (document_.opened.fetch_add(1) > 0 && document_.workers_fail_open) {
+            error_message = "open failed";
+            return false;
+        }
+        return true;
+    }
+
+    int pageCount() const override { return document_.pages; }
+
+    bool pageText(int index, std::string& text, std::string& error_message) override {
+        std::this_thread::sleep_for(document_.page_time * (1 + (index * 7) % 5));
+        document_.extracted.fetch_add(1);
+        if (index == document_.failing_page) {
+            error_message = "bad page " + std::to_string(index + 1);
+            return false;
+        }
+        text = pageTextFor(index);
+        return true;
+    }
+
+private:
+    FakeDocument& document_;
+};
+
+PdfTextEngine::ReaderFactory factoryFor(FakeDocument& document) {
+    return [&document]() { return std::make_unique<FakePageReader>(document); };
+}
+
+std::string expectedText(int pages) {
+    std::string text;
+    for (int i = 0; i < pages; ++i) {
+        text += pageTextFor(i);
+    }
+    return text;
+}
+
+void testPagesInOrder(WorkStealingExecutor& executor) {
+    FakeDocument document;
+    document.pages = 100;
+    document.page_time = std::chrono::microseconds(200);
+    PdfTextEngine engine(executor, 4, factoryFor(document));
+
+    std::string output;
+    int deliveries = 0;
+    PdfTextEngine::PageSink sink = [&](const std::string& text, bool, std::string&) {
+        output += text;
+        ++deliveries;
+        return true;
+    };
+    int page_count = 0;
+    std::string error;
+    CHECK(engine.extract("x", 1, sink, page_count, error));
+    CHECK(page_count == 100);
+    CHECK(deliveries == 100);
+    CHECK(output == expectedText(100));
+    CHECK(document.extracted.load() == 100);
+    CHECK(document.opened.load() <= static_cast<int>(engine.workersFor(100)));
+}
+
+void testPageFailure(WorkStealingExecutor& executor) {
+    FakeDocument document;
+    document.pages = 60;
+    document.failing_page = 37;
+    document.page_time = std::chrono::microseconds(100);
+    PdfTextEngine engine(executor, 4, factoryFor(document));
+
+    int deliveries = 0;
+    PdfTextEngine::PageSink sink = [&](const std::string&, bool, std::string&) {
+        ++deliveries;
+        return true;
+    };
+    int page_count = 0;
+    std::string error;
+    CHECK(!engine.extract("x", 1, sink, page_count, error));
+    CHECK(error == "bad page 38");
+    CHECK(deliveries <= 37);
+}
+
+void testSinkFailure(WorkStealingExecutor& executor) {
+    FakeDocument document;
+    document.pages = 60;
+    document.page_time = std::chrono::microseconds(100);
+    PdfTextEngine engine(executor, 4, factoryFor(document));
+
+    int deliveries = 0;
+    PdfTextEngine::PageSink sink = [&](const std::string&, bool, std::string& error) {
+        if (++deliveries == 10) {
+            error = "sink closed";
+            return false;
+        }
+        return true;
+    };
+    int page_count = 0;
+    std::string error;
+    CHECK(!engine.extract("x", 1, sink, page_count, error));
+    CHECK(error == "sink closed");
+    CHECK(deliveries == 10);
+    // Nada além da janela à frente da última página entregue
+    CHECK(document.extracted.load() < 60);
+}
+
+void testWorkersWithoutDocument(WorkStealingExecutor& executor) {
+    FakeDocument document;
+    document.pages = 40;
+    document.workers_fail_open = true;
+    PdfTextEngine engine(executor, 4, factoryFor(document));
+
+    std::string output;
+    PdfTextEngine::PageSink sink = [&](const std::string& text, bool, std::string&) {
+        output += text;
+        return true;
+    };
+    int page_count = 0;
+    std::string error;
+    CHECK(engine.extract("x", 1, sink, page_count, error));
+    CHECK(output == expectedText(40));
+}
+
+void testCancelledCall(WorkStealingExecutor& executor) {
+    FakeDocument document;
+    document.pages = 400;
+    document.page_time = std::chrono::milliseconds(2);
+    PdfTextEngine engine(executor, 4, factoryFor(document));
+
+    JobContext job(JobContext::Clock::time_point::max(), 0, std::chrono::milliseconds(0));
+    std::thread canceller([&job]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        job.cancel();
+    });
+
+    PdfTextEngine::PageSink sink = [](const std::string&, bool, std::string&) {
+        return true;
+    };
+    int page_count = 0;
+    std::string error;
+    bool ok;
+    auto start = std::chrono::steady_clock::now();
+    {
+        JobContext::Scope scope(&job);
+        ok = engine.extract("x", 1, sink, page_count, error);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    canceller.join();
+
+    CHECK(!ok);
+    CHECK(error.find("interrupted") != std::string::npos);
+    // A extração toda levaria mais de um segundo
+    CHECK(elapsed < std::chrono::milliseconds(600));
+    CHECK(document.extracted.load() < 400);
+}
+}
+
+int main() {
+    WorkStealingExecutor executor(4);
+    for (int round = 0; round < 5; ++round) {
+        testPagesInOrder(executor);
+        testPageFailure(executor);
+        testSinkFailure(executor);
+        testWorkersWithoutDocument(executor);
+    }
+    testCancelledCall(executor);
+    executor.shutdown();
+    return testExitCode("pdf_text_engine_test");
+}
@@ -0,0 +1,32 @@
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <iostream>
+
+// Verificação dos testes do servidor: registra a falha e segue, para que
+// um teste relate todas as verificações que falharam; main devolve
+// testExitCode()
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: "      \
+                      << #condition << std::endl;                               \
+            ++testFailures();                                                   \
+        }                                                                       \
+    } while (0)
+
+inline int testExitCode(const char* name) {
+    if (testFailures() > 0) {
+        std::cerr << name << ": " << testFailures() << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << name << ": OK" << std::endl;
+    return 0;
+}
+
+#endif // TEST_CHECK_H
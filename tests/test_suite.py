@@ -7,8 +7,10 @@ Suite de testes para o File Processor gRPC Service
 
 import os
 import sys
+import threading
 import time
 import unittest
+import zlib
 from pathlib import Path
 
 # Adicionar diretório do cliente ao path
@@ -22,7 +24,10 @@ if not os.path.exists(generated_path):
     sys.exit(1)
 
 try:
-    from client import FileProcessorClient
+    import grpc
+    from client import FileProcessorClient, batch_output_names
+    # Módulos gerados (o client.py adiciona generated/ ao path)
+    import file_processor_pb2
 except ImportError as e:
     print(f"❌ Erro ao importar cliente: {e}")
     print("Certifique-se de que o código protobuf foi gerado corretamente.")
@@ -253,6 +258,274 @@ class FileProcessorTestCase(unittest.TestCase):
             self.fail("Redimensionamento de imagem falhou")
 
 
+    def _find_files(self, patterns):
+        """Arquivos de teste que casam com algum dos padrões"""
+        files = []
+        for pattern in patterns:
+            files.extend(sorted(self.test_files_dir.glob(pattern)))
+        return files
+
+    def test_07_batch_mixed_operations_with_invalid_header(self):
+        """Lote com operações diferentes e arquivos com cabeçalho inválido"""
+        print("\n[TEST] ProcessBatch Mixed Operations + Invalid Header")
+        print("-" * 60)
+
+        pdf_files = self._find_files(['*.pdf'])
+        image_files = self._find_files(['*.jpg', '*.jpeg', '*.png', '*.gif', '*.bmp'])
+        if not pdf_files or not image_files:
+            print("⚠️  É preciso um PDF e uma imagem - teste pulado")
+            self.skipTest("PDF e imagem necessários para o lote misto")
+
+        Operation = file_processor_pb2.Operation
+        # file_id -> (cabeçalho, conteúdo, status esperado)
+        files = {
+            1: (file_processor_pb2.BatchFileHeader(
+                    operation=Operation.Value('CONVERT_TO_TXT'),
+                    file_name=pdf_files[0].name),
+                pdf_files[0].read_bytes(), grpc.StatusCode.OK),
+            2: (file_processor_pb2.BatchFileHeader(
+                    operation=Operation.Value('CONVERT_IMAGE_FORMAT'),
+                    file_name=image_files[0].name, output_format='png'),
+                image_files[0].read_bytes(), grpc.StatusCode.OK),
+            # Operação não especificada
+            3: (file_processor_pb2.BatchFileHeader(
+                    operation=Operation.Value('OPERATION_UNSPECIFIED'),
+                    file_name='unspecified.pdf'),
+                b'%PDF-1.4', grpc.StatusCode.INVALID_ARGUMENT),
+            # Primeira mensagem sem cabeçalho
+            4: (None, b'no header', grpc.StatusCode.INVALID_ARGUMENT),
+        }
+
+        def requests():
+            # Chunks dos arquivos intercalados; cabeçalho só na primeira mensagem
+            chunk_size = 16 * 1024
+            offsets = {file_id: 0 for file_id in files}
+            while offsets:
+                for file_id in list(offsets):
+                    header, content, _ = files[file_id]
+                    offset = offsets[file_id]
+                    chunk = content[offset:offset + chunk_size]
+                    yield file_processor_pb2.BatchRequest(
+                        file_id=file_id,
+                        header=header if offset == 0 else None,
+                        content=chunk,
+                        end_of_file=offset + len(chunk) >= len(content))
+                    if offset + len(chunk) >= len(content):
+                        del offsets[file_id]
+                    else:
+                        offsets[file_id] = offset + len(chunk)
+
+        statuses = {}
+        outputs = {}
+        for response in self.client.stub.ProcessBatch(requests(), timeout=120):
+            outputs[response.file_id] = (outputs.get(response.file_id, b'') +
+                                         response.content)
+            if response.end_of_file:
+                statuses[response.file_id] = response.status_code
+                print(f"   file {response.file_id}: status {response.status_code} "
+                      f"{response.status_message}")
+
+        self.assertEqual(sorted(statuses), sorted(files))
+        for file_id, (_, _, expected) in files.items():
+            self.assertEqual(statuses[file_id], expected.value[0],
+                             f"Status inesperado para o arquivo {file_id}")
+        self.assertGreater(len(outputs.get(1, b'')), 0)
+        self.assertTrue(outputs.get(2, b'').startswith(b'\x89PNG'))
+        print("✅ Arquivos válidos processados e inválidos recusados no mesmo lote")
+
+    def test_08_resume_after_dropped_stream(self):
+        """Upload retomável: o stream cai no meio e uma nova chamada continua"""
+        print("\n[TEST] Resumable Upload After Dropped Stream")
+        print("-" * 60)
+
+        # Imagens não passam pelo modo pipeline, em que o offset é sempre 0
+        image_files = self._find_files(['*.jpg', '*.jpeg', '*.png', '*.gif', '*.bmp'])
+        if not image_files:
+            print("⚠️  Nenhuma imagem encontrada - teste pulado")
+            self.skipTest("Nenhuma imagem disponível para teste")
+
+        content = image_files[0].read_bytes()
+        if len(content) < 4:
+            self.skipTest("Imagem pequena demais para dividir o upload")
+        # A primeira chamada pede um upload novo; o servidor devolve o token
+        upload = {'id': "new"}
+        half = len(content) // 2
+        chunk_size = max(1, half // 4)
+
+        def header_chunk():
+            header = file_processor_pb2.RequestHeader(
+                convert_image_format=file_processor_pb2.ConvertImageFormatRequest(
+                    metadata=file_processor_pb2.FileMetadata(
+                        file_name=image_files[0].name, file_size=len(content)),
+                    output_format='png'),
+                upload_id=upload['id'])
+            return file_processor_pb2.FileChunk(header=header)
+
+        def data_chunks(state, end, hold=None):
+            # Dados só depois do UploadStatus, a partir do offset confirmado;
+            # hold mantém o stream aberto
+            yield header_chunk()
+            state['ready'].wait(timeout=10)
+            offset = state['offset']
+            while offset < end:
+                chunk = content[offset:min(offset + chunk_size, end)]
+                yield file_processor_pb2.FileChunk(
+                    content=chunk,
+                    integrity=file_processor_pb2.ChunkIntegrity(
+                        offset=offset, crc32=zlib.crc32(chunk)))
+                offset += len(chunk)
+            if hold is not None:
+                hold.wait(timeout=30)
+
+        # Primeira chamada: metade do arquivo e o stream é cancelado
+        first = {'ready': threading.Event(), 'offset': 0}
+        hold = threading.Event()
+        call = self.client.stub.ConvertImageFormat(
+            data_chunks(first, half, hold), timeout=60)
+        status = next(call)
+        self.assertTrue(status.HasField('upload_status'))
+        self.assertEqual(status.upload_status.committed_offset, 0)
+        token = status.upload_status.upload_id
+        self.assertTrue(token)
+        self.assertNotEqual(token, "new")
+        upload['id'] = token
+        first['ready'].set()
+        time.sleep(1.0)
+        call.cancel()
+        hold.set()
+        print(f"   Stream cancelado após {half} de {len(content)} bytes")
+
+        # Segunda chamada: o servidor pode ainda estar liberando o upload
+        for attempt in range(10):
+            second = {'ready': threading.Event(), 'offset': 0}
+            call = self.client.stub.ConvertImageFormat(
+                data_chunks(second, len(content)), timeout=60)
+            try:
+                status = next(call)
+                break
+            except grpc.RpcError as e:
+                second['ready'].set()
+                if e.code() != grpc.StatusCode.ABORTED or attempt == 9:
+                    raise
+                time.sleep(0.2)
+
+        committed = status.upload_status.committed_offset
+        print(f"   Retomado a partir de {committed} bytes")
+        self.assertGreater(committed, 0)
+        self.assertLessEqual(committed, half)
+        self.assertEqual(status.upload_status.upload_id, token)
+        second['offset'] = committed
+        second['ready'].set()
+
+        output = b''.join(chunk.content for chunk in call)
+        self.assertTrue(output.startswith(b'\x89PNG'))
+        print(f"✅ Upload retomado e convertido ({len(output):,} bytes)")
+
+    def test_09_resource_exhausted_carries_retry_after(self):
+        """Servidor saturado recusa com RESOURCE_EXHAUSTED e fp-retry-after-ms"""
+        print("\n[TEST] RESOURCE_EXHAUSTED With fp-retry-after-ms")
+        print("-" * 60)
+
+        # Chamadas que mandam só o cabeçalho e ficam abertas ocupam o
+        # controle de admissão até a próxima ser recusada
+        max_calls = int(os.environ.get('FP_TEST_MAX_OPEN_CALLS', '256'))
+        release = threading.Event()
+
+        def held_upload():
+            yield file_processor_pb2.FileChunk(
+                header=file_processor_pb2.RequestHeader(
+                    convert_to_txt=file_processor_pb2.ConvertToTXTRequest(
+                        metadata=file_processor_pb2.FileMetadata(
+                            file_name='held.pdf', file_size=1024))))
+            release.wait(timeout=60)
+
+        calls = []
+        rejected = None
+        try:
+            for _ in range(max_calls):
+                done = threading.Event()
+                call = self.client.stub.ConvertToTXT(held_upload(), timeout=60)
+                call.add_done_callback(lambda _call, done=done: done.set())
+                calls.append(call)
+                if done.wait(timeout=0.1) and call.code() == grpc.StatusCode.RESOURCE_EXHAUSTED:
+                    rejected = call
+                    break
+        finally:
+            for call in calls:
+                call.cancel()
+            release.set()
+
+        if rejected is None:
+            print(f"⚠️  Servidor aceitou {max_calls} chamadas - teste pulado")
+            print("   Inicie o servidor com FP_ADMISSION_MAX_JOBS baixo (ex.: 4)")
+            self.skipTest("Servidor não saturou")
+
+        metadata = dict(rejected.trailing_metadata() or ())
+        print(f"   Recusada após {len(calls) - 1} chamadas abertas: {rejected.details()}")
+        self.assertIn('fp-retry-after-ms', metadata)
+        self.assertGreater(int(metadata['fp-retry-after-ms']), 0)
+        self.assertGreater(FileProcessorClient._retry_after(rejected), 0)
+        print(f"✅ fp-retry-after-ms = {metadata['fp-retry-after-ms']}")
+
+    def test_10_batch_limits_open_files(self):
+        """Lote que abre muitos arquivos sem end_of_file é encerrado"""
+        print("\n[TEST] ProcessBatch Many Interleaved Open Files")
+        print("-" * 60)
+
+        # Muito acima de FP_BATCH_MAX_IN_FLIGHT: cada arquivo recebe o
+        # cabeçalho e alguns chunks intercalados, e nenhum termina
+        open_files = 2000
+        rounds = 3
+        chunk = b'%PDF-1.4\n' + b'\0' * (32 * 1024)
+        sent = {'messages': 0}
+
+        def requests():
+            for round_index in range(rounds):
+                for file_id in range(1, open_files + 1):
+                    header = None
+                    if round_index == 0:
+                        header = file_processor_pb2.BatchFileHeader(
+                            operation=file_processor_pb2.Operation.Value('CONVERT_TO_TXT'),
+                            file_name=f'open-{file_id}.pdf')
+                    sent['messages'] += 1
+                    yield file_processor_pb2.BatchRequest(
+                        file_id=file_id, header=header, content=chunk)
+
+        statuses = {}
+        with self.assertRaises(grpc.RpcError) as error:
+            for response in self.client.stub.ProcessBatch(requests(), timeout=120):
+                if response.end_of_file:
+                    statuses[response.file_id] = response.status_code
+
+        print(f"   {error.exception.code()}: {error.exception.details()}")
+        print(f"   {len(statuses)} arquivos abertos recusados, "
+              f"{sent['messages']} de {open_files * rounds} mensagens enviadas")
+        self.assertEqual(error.exception.code(), grpc.StatusCode.RESOURCE_EXHAUSTED)
+        # Só os arquivos que chegaram a abrir voltam, todos com erro
+        self.assertGreater(len(statuses), 0)
+        self.assertLess(len(statuses), open_files)
+        self.assertTrue(all(code != grpc.StatusCode.OK.value[0]
+                            for code in statuses.values()))
+        self.assertLess(sent['messages'], open_files * rounds)
+        print("✅ Arquivos abertos limitados; lote encerrado com RESOURCE_EXHAUSTED")
+
+    def test_11_batch_output_names_reserve_literal_names(self):
+        """Sufixos dos nomes repetidos não tomam o nome literal de outra entrada"""
+        print("\n[TEST] Batch Output Names")
+        print("-" * 60)
+
+        self.assertEqual(batch_output_names(['a/x.pdf', 'b/x.pdf', 'c/x.pdf'], '.txt'),
+                         ['x.txt', 'x-2.txt', 'x-3.txt'])
+        self.assertEqual(batch_output_names(['a/x.pdf', 'b/x.pdf', 'c/x-2.pdf'], '.txt'),
+                         ['x.txt', 'x-3.txt', 'x-2.txt'])
+        self.assertEqual(batch_output_names(['c/x-2.pdf', 'a/x.pdf', 'b/x.pdf'], '.txt'),
+                         ['x-2.txt', 'x.txt', 'x-3.txt'])
+        self.assertEqual(
+            batch_output_names(['a/x.pdf', 'b/x.pdf', 'c/x-2.pdf', 'd/x-2.pdf'], '.txt'),
+            ['x.txt', 'x-3.txt', 'x-2.txt', 'x-2-2.txt'])
+        print("✅ Nomes literais reservados antes dos sufixos")
+
+
 def run_tests():
     """Executa suite de testes"""
     # Criar test suite